@@ -0,0 +1,191 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/bench.h"
+#include "bench/khu_setup.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "coins.h"
+#include "consensus/validation.h"
+#include "khu/khu_domc.h"
+#include "khu/khu_mint.h"
+#include "khu/khu_redeem.h"
+#include "khu/khu_stake.h"
+#include "khu/khu_state.h"
+#include "khu/khu_statedb.h"
+#include "khu/khu_unstake.h"
+#include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
+#include "khu/zkhu_db.h"
+#include "primitives/block.h"
+#include "random.h"
+#include "streams.h"
+#include "version.h"
+
+#include <stdexcept>
+
+// KHU transactions of each kind in the measured block
+static const size_t KHU_BENCH_BLOCK_TXS = 250;
+// Notes / KHU_T coins already in the databases
+static const size_t KHU_BENCH_BASE_ENTRIES = 10000;
+
+/** First height after nHeight without DOMC boundary/reveal (yield and DAO are off-grid by construction) */
+static uint32_t FindQuietKHUHeight(uint32_t nHeight)
+{
+    const uint32_t nV6 = KHU_BENCH_V6_HEIGHT;
+    while (khu_domc::IsDomcCycleBoundary(nHeight, nV6) ||
+           khu_domc::IsRevealHeight(nHeight, khu_domc::GetCurrentCycleId(nHeight, nV6)) ||
+           (nHeight - nV6) % khu_yield::YIELD_INTERVAL == 0) {
+        nHeight++;
+    }
+    return nHeight;
+}
+
+template <typename Payload>
+static void SetKHUPayload(CMutableTransaction& mtx, const Payload& payload)
+{
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << payload;
+    mtx.extraPayload = std::vector<uint8_t>(ds.begin(), ds.end());
+}
+
+static CMutableTransaction MakeKHUBenchTx(int16_t nType)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = nType;
+    return mtx;
+}
+
+static CTransactionRef MakeMintTx(FastRandomContext& rng, CAmount amount)
+{
+    const CScript script = CScript() << OP_TRUE;
+    CMutableTransaction mtx = MakeKHUBenchTx(CTransaction::TxType::KHU_MINT);
+    mtx.vin.emplace_back(COutPoint(rng.rand256(), 0));
+    mtx.vout.emplace_back(amount, CScript() << OP_RETURN);
+    mtx.vout.emplace_back(amount, script);
+    SetKHUPayload(mtx, CMintKHUPayload(amount, script));
+    return MakeTransactionRef(mtx);
+}
+
+static CTransactionRef MakeRedeemTx(const KHUBenchCoin& coin)
+{
+    const CScript script = CScript() << OP_TRUE;
+    CMutableTransaction mtx = MakeKHUBenchTx(CTransaction::TxType::KHU_REDEEM);
+    mtx.vin.emplace_back(coin.outpoint);
+    mtx.vout.emplace_back(coin.amount, script);
+    SetKHUPayload(mtx, CRedeemKHUPayload(coin.amount, script));
+    return MakeTransactionRef(mtx);
+}
+
+static CTransactionRef MakeStakeTx(FastRandomContext& rng, const KHUBenchCoin& coin)
+{
+    CMutableTransaction mtx = MakeKHUBenchTx(CTransaction::TxType::KHU_STAKE);
+    mtx.vin.emplace_back(coin.outpoint);
+    SaplingTxData sapData;
+    OutputDescription saplingOut;
+    saplingOut.cmu = rng.rand256();
+    sapData.vShieldedOutput.push_back(saplingOut);
+    sapData.valueBalance = -coin.amount;
+    mtx.sapData = sapData;
+    return MakeTransactionRef(mtx);
+}
+
+static CTransactionRef MakeUnstakeTx(FastRandomContext& rng, const KHUBenchNote& note, uint32_t nHeight)
+{
+    const uint256 nullifier = GetZKHUStakeNullifier(note.cm);
+    ZKHUNoteData data(note.amount, note.nStakeStartHeight, 0, nullifier, note.cm);
+    CAmount nYield = 0;
+    if (!khu_yield::GetNoteAccumulatedYield(note.cm, data, nHeight, nYield)) {
+        throw std::runtime_error("KHU bench: GetNoteAccumulatedYield failed");
+    }
+
+    CMutableTransaction mtx = MakeKHUBenchTx(CTransaction::TxType::KHU_UNSTAKE);
+    SaplingTxData sapData;
+    SpendDescription saplingSpend;
+    saplingSpend.nullifier = rng.rand256();
+    sapData.vShieldedSpend.push_back(saplingSpend);
+    mtx.sapData = sapData;
+    mtx.vout.emplace_back(note.amount + nYield, CScript() << OP_TRUE);
+    SetKHUPayload(mtx, CUnstakeKHUPayload(note.cm));
+    return MakeTransactionRef(mtx);
+}
+
+/**
+ * ProcessKHUBlock(fJustCheck) of a block carrying KHU_BENCH_BLOCK_TXS
+ * transactions of two kinds, over KHU_BENCH_BASE_ENTRIES notes and coins.
+ * fJustCheck applies everything to a scratch overlay, rolled back with the
+ * KHU DB transaction of each iteration, so every iteration sees the same
+ * databases.
+ */
+static void KHUProcessBlock(benchmark::State& state, bool fStake)
+{
+    KHUBenchSetup setup;
+    FastRandomContext rng(true);
+    const uint32_t nV6 = KHU_BENCH_V6_HEIGHT;
+    const uint32_t nLastYield = nV6 + 20 * khu_yield::YIELD_INTERVAL;
+    const uint32_t nHeight = FindQuietKHUHeight(nLastYield + 1);
+
+    // Old enough for UNSTAKE, no yield events recorded so Y stays at 0
+    const std::vector<KHUBenchNote> vNotes = MakeKHUBenchNotes(KHU_BENCH_BASE_ENTRIES, nV6, nV6 + 10 * khu_yield::YIELD_INTERVAL);
+    StakeKHUBenchNotes(vNotes.begin(), vNotes.end());
+    const std::vector<KHUBenchCoin> vCoins = AddKHUBenchCoins(KHU_BENCH_BASE_ENTRIES, nV6);
+
+    KhuGlobalState prevState;
+    prevState.SetNull();
+    prevState.nHeight = nHeight - 1;
+    prevState.R_annual = khu_domc::R_DEFAULT;
+    prevState.R_MAX_dynamic = khu_domc::R_MAX_DYNAMIC_INITIAL;
+    prevState.last_yield_update_height = nLastYield;
+    for (const KHUBenchCoin& coin : vCoins) prevState.U += coin.amount;
+    for (const KHUBenchNote& note : vNotes) prevState.Z += note.amount;
+    prevState.C = prevState.U + prevState.Z;
+    prevState.Cr = prevState.Ur = 1000000 * COIN;
+    {
+        auto dbTx = BeginKHUTransaction();
+        if (!GetKHUStateDB()->WriteKHUState(nHeight - 1, prevState, true)) {
+            throw std::runtime_error("KHU bench: failed to write KHU state");
+        }
+        dbTx->Commit();
+    }
+    if (!CommitKHURootTransactions()) {
+        throw std::runtime_error("KHU bench: failed to commit the KHU databases");
+    }
+
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.emplace_back();
+    coinbase.vout.emplace_back(0, CScript() << OP_TRUE);
+    block.vtx.emplace_back(MakeTransactionRef(coinbase));
+    for (size_t i = 0; i < KHU_BENCH_BLOCK_TXS; i++) {
+        if (fStake) {
+            block.vtx.emplace_back(MakeStakeTx(rng, vCoins[i]));
+            block.vtx.emplace_back(MakeUnstakeTx(rng, vNotes[i], nHeight));
+        } else {
+            block.vtx.emplace_back(MakeMintTx(rng, (1 + (CAmount)rng.randrange(5000)) * COIN));
+            block.vtx.emplace_back(MakeRedeemTx(vCoins[i]));
+        }
+    }
+
+    CBlockIndex index;
+    index.nHeight = nHeight;
+    CCoinsView coinsDummy;
+    CCoinsViewCache view(&coinsDummy);
+    const Consensus::Params& consensus = Params().GetConsensus();
+
+    while (state.KeepRunning()) {
+        CValidationState valState;
+        auto dbTx = BeginKHUTransaction();
+        if (!ProcessKHUBlock(block, &index, view, valState, consensus, true)) {
+            throw std::runtime_error("KHU bench: ProcessKHUBlock failed: " + valState.GetRejectReason());
+        }
+    }
+}
+
+static void KHUProcessBlock_MintRedeem(benchmark::State& state) { KHUProcessBlock(state, false); }
+static void KHUProcessBlock_StakeUnstake(benchmark::State& state) { KHUProcessBlock(state, true); }
+
+BENCHMARK(KHUProcessBlock_MintRedeem, 20);
+BENCHMARK(KHUProcessBlock_StakeUnstake, 20);
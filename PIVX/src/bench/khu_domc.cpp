@@ -0,0 +1,42 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/bench.h"
+#include "bench/khu_setup.h"
+
+#include "khu/khu_domc.h"
+#include "khu/khu_domcdb.h"
+
+#include <vector>
+
+// Masternode votes of the finalized cycle
+static const size_t KHU_BENCH_DOMC_VOTES = 10000;
+
+// Median R of a cycle with 10k reveals (running histogram)
+static void KHUDomcMedian(benchmark::State& state)
+{
+    KHUBenchSetup setup;
+    const uint32_t cycleId = KHU_BENCH_V6_HEIGHT;
+    AddKHUBenchDomcVotes(KHU_BENCH_DOMC_VOTES, cycleId, khu_domc::R_MAX_DYNAMIC_INITIAL);
+
+    while (state.KeepRunning()) {
+        khu_domc::CalculateDomcMedian(cycleId, khu_domc::R_DEFAULT, khu_domc::R_MAX_DYNAMIC_INITIAL);
+    }
+}
+
+// Full scan of the same 10k reveals, for comparison with the histogram
+static void KHUDomcGetReveals(benchmark::State& state)
+{
+    KHUBenchSetup setup;
+    const uint32_t cycleId = KHU_BENCH_V6_HEIGHT;
+    AddKHUBenchDomcVotes(KHU_BENCH_DOMC_VOTES, cycleId, khu_domc::R_MAX_DYNAMIC_INITIAL);
+
+    while (state.KeepRunning()) {
+        std::vector<khu_domc::DomcReveal> reveals;
+        GetKHUDomcDB()->GetRevealsForCycle(cycleId, reveals);
+    }
+}
+
+BENCHMARK(KHUDomcMedian, 1000);
+BENCHMARK(KHUDomcGetReveals, 10);
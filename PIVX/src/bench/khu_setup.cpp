@@ -0,0 +1,135 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/khu_setup.h"
+
+#include "chainparams.h"
+#include "coins.h"
+#include "khu/khu_dbwrapper.h"
+#include "khu/khu_domc.h"
+#include "khu/khu_domcdb.h"
+#include "khu/khu_stake.h"
+#include "khu/khu_utxo.h"
+#include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
+#include "khu/zkhu_db.h"
+#include "random.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// Entries written per KHU DB transaction while populating
+static const size_t KHU_BENCH_COMMIT_CHUNK = 10000;
+static const size_t KHU_BENCH_DB_CACHE = 1 << 20;
+
+KHUBenchSetup::KHUBenchSetup()
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V6_0, KHU_BENCH_V6_HEIGHT);
+    if (!InitKHUStateDB(KHU_BENCH_DB_CACHE, true, true) ||
+        !InitKHUCommitmentDB(KHU_BENCH_DB_CACHE, true, true) ||
+        !InitZKHUDB(KHU_BENCH_DB_CACHE, true, true) ||
+        !InitKHUDomcDB(KHU_BENCH_DB_CACHE, true, true)) {
+        throw std::runtime_error("KHU bench: failed to initialize the KHU databases");
+    }
+}
+
+KHUBenchSetup::~KHUBenchSetup()
+{
+    UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V6_0, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
+}
+
+static void CommitKHUBenchChunk(std::unique_ptr<CKHUDBScopedCommitter>& dbTx)
+{
+    dbTx->Commit();
+    dbTx.reset();
+    if (!CommitKHURootTransactions()) {
+        throw std::runtime_error("KHU bench: failed to commit the KHU databases");
+    }
+}
+
+std::vector<KHUBenchNote> MakeKHUBenchNotes(size_t nCount, uint32_t nFirstHeight, uint32_t nLastHeight)
+{
+    FastRandomContext rng(true);
+    std::vector<KHUBenchNote> vNotes(nCount);
+    for (KHUBenchNote& note : vNotes) {
+        note.cm = rng.rand256();
+        note.amount = (1 + rng.randrange(5000)) * COIN;
+        note.nStakeStartHeight = nFirstHeight + rng.randrange(nLastHeight - nFirstHeight);
+    }
+    std::sort(vNotes.begin(), vNotes.end(), [](const KHUBenchNote& a, const KHUBenchNote& b) {
+        return a.nStakeStartHeight < b.nStakeStartHeight;
+    });
+    return vNotes;
+}
+
+void StakeKHUBenchNotes(std::vector<KHUBenchNote>::const_iterator first, std::vector<KHUBenchNote>::const_iterator last)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    while (first != last) {
+        auto dbTx = BeginKHUTransaction();
+        for (size_t n = 0; first != last && n < KHU_BENCH_COMMIT_CHUNK; ++first, ++n) {
+            const uint256 nullifier = GetZKHUStakeNullifier(first->cm);
+            const ZKHUNoteData data(first->amount, first->nStakeStartHeight, 0, nullifier, first->cm);
+            if (!zkhuDB->WriteNote(first->cm, data) ||
+                !zkhuDB->WriteNullifierMapping(nullifier, first->cm) ||
+                !khu_yield::AddNoteToYieldIndex(first->cm, data)) {
+                throw std::runtime_error("KHU bench: failed to write note");
+            }
+        }
+        CommitKHUBenchChunk(dbTx);
+    }
+}
+
+std::vector<KHUBenchCoin> AddKHUBenchCoins(size_t nCount, uint32_t nHeight)
+{
+    FastRandomContext rng(true);
+    CCoinsView coinsDummy;
+    CCoinsViewCache view(&coinsDummy);
+    std::vector<KHUBenchCoin> vCoins;
+    vCoins.reserve(nCount);
+
+    auto dbTx = BeginKHUTransaction();
+    for (size_t i = 0; i < nCount; i++) {
+        KHUBenchCoin coin{COutPoint(rng.rand256(), 1), (1 + (CAmount)rng.randrange(5000)) * COIN};
+        CKHUUTXO utxo(coin.amount, CScript() << OP_TRUE, nHeight);
+        utxo.fIsKHU = true;
+        if (!AddKHUCoin(view, coin.outpoint, utxo)) {
+            throw std::runtime_error("KHU bench: failed to add KHU coin");
+        }
+        vCoins.push_back(coin);
+    }
+    CommitKHUBenchChunk(dbTx);
+    return vCoins;
+}
+
+void AddKHUBenchDomcVotes(size_t nCount, uint32_t cycleId, uint16_t nRMax)
+{
+    FastRandomContext rng(true);
+    CKHUDomcDB* domcDB = GetKHUDomcDB();
+    for (size_t i = 0; i < nCount;) {
+        auto dbTx = BeginKHUTransaction();
+        for (size_t n = 0; i < nCount && n < KHU_BENCH_COMMIT_CHUNK; ++i, ++n) {
+            khu_domc::DomcReveal reveal;
+            reveal.nRProposal = rng.randrange(nRMax + 1);
+            reveal.salt = rng.rand256();
+            reveal.mnOutpoint = COutPoint(rng.rand256(), 0);
+            reveal.nCycleId = cycleId;
+            reveal.nRevealHeight = cycleId + khu_domc::GetDomcVoteOffset() + 1;
+
+            khu_domc::DomcCommit commit;
+            commit.hashCommit = reveal.GetCommitHash();
+            commit.mnOutpoint = reveal.mnOutpoint;
+            commit.nCycleId = cycleId;
+            commit.nCommitHeight = cycleId + khu_domc::GetDomcVoteOffset();
+
+            if (!domcDB->WriteCommit(commit) ||
+                !domcDB->AddMasternodeToCycleIndex(cycleId, commit.mnOutpoint) ||
+                !domcDB->WriteReveal(reveal)) {
+                throw std::runtime_error("KHU bench: failed to write DOMC vote");
+            }
+        }
+        CommitKHUBenchChunk(dbTx);
+    }
+}
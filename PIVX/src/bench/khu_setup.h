@@ -0,0 +1,54 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_BENCH_KHU_SETUP_H
+#define PIVX_BENCH_KHU_SETUP_H
+
+#include "amount.h"
+#include "primitives/transaction.h"
+#include "uint256.h"
+
+#include <vector>
+
+// V6 activation height used by the KHU benchmarks (regtest)
+static const int KHU_BENCH_V6_HEIGHT = 1000;
+
+/**
+ * Regtest chain with V6 active at KHU_BENCH_V6_HEIGHT and fresh in-memory
+ * KHU databases (state, commitment, ZKHU, DOMC). Benchmarks own one for the
+ * whole run and roll back their per-iteration writes.
+ */
+class KHUBenchSetup
+{
+public:
+    KHUBenchSetup();
+    ~KHUBenchSetup();
+};
+
+struct KHUBenchNote
+{
+    uint256 cm;
+    CAmount amount;
+    uint32_t nStakeStartHeight;
+};
+
+struct KHUBenchCoin
+{
+    COutPoint outpoint;
+    CAmount amount;
+};
+
+/** Random note amount / stake height in [nFirstHeight, nLastHeight), sorted by height */
+std::vector<KHUBenchNote> MakeKHUBenchNotes(size_t nCount, uint32_t nFirstHeight, uint32_t nLastHeight);
+
+/** Write notes (note data, nullifier mapping, yield index) and commit them */
+void StakeKHUBenchNotes(std::vector<KHUBenchNote>::const_iterator first, std::vector<KHUBenchNote>::const_iterator last);
+
+/** Create nCount transparent KHU coins at nHeight and commit them */
+std::vector<KHUBenchCoin> AddKHUBenchCoins(size_t nCount, uint32_t nHeight);
+
+/** Commit + reveal of nCount masternodes for cycleId, R spread over [0, nRMax] */
+void AddKHUBenchDomcVotes(size_t nCount, uint32_t cycleId, uint16_t nRMax);
+
+#endif // PIVX_BENCH_KHU_SETUP_H
@@ -0,0 +1,138 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/bench.h"
+#include "bench/khu_setup.h"
+
+#include "chain.h"
+#include "khu/khu_dbwrapper.h"
+#include "khu/khu_domc.h"
+#include "khu/khu_state.h"
+#include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
+#include "random.h"
+#include "validation.h"
+#include "wallet/khu_wallet.h"
+#include "wallet/wallet.h"
+
+#include <stdexcept>
+
+// Daily yield events replayed before the measured one
+static const uint32_t KHU_BENCH_YIELD_EVENTS = 15;
+
+static KhuGlobalState MakeYieldBenchState()
+{
+    KhuGlobalState state;
+    state.SetNull();
+    state.R_annual = khu_domc::R_DEFAULT;
+    state.R_MAX_dynamic = khu_domc::R_MAX_DYNAMIC_INITIAL;
+    return state;
+}
+
+/**
+ * Stake nNotes notes over the first 10 days after activation, replaying the
+ * daily yield events in chain order (notes of a day are staked before the
+ * event closing it). Returns the height of the next, not yet applied, event.
+ */
+static uint32_t PopulateYieldBench(size_t nNotes, KhuGlobalState& state)
+{
+    const uint32_t nV6 = KHU_BENCH_V6_HEIGHT;
+    const std::vector<KHUBenchNote> vNotes = MakeKHUBenchNotes(nNotes, nV6 - 100, nV6 + 10 * khu_yield::YIELD_INTERVAL);
+
+    auto itNote = vNotes.begin();
+    uint32_t nEventHeight = nV6;
+    for (uint32_t i = 0; i < KHU_BENCH_YIELD_EVENTS; i++, nEventHeight += khu_yield::YIELD_INTERVAL) {
+        auto itDay = itNote;
+        while (itDay != vNotes.end() && itDay->nStakeStartHeight < nEventHeight) ++itDay;
+        StakeKHUBenchNotes(itNote, itDay);
+        itNote = itDay;
+
+        auto dbTx = BeginKHUTransaction();
+        if (!khu_yield::ApplyDailyYield(state, nEventHeight, nV6)) {
+            throw std::runtime_error("KHU bench: ApplyDailyYield failed");
+        }
+        dbTx->Commit();
+    }
+    StakeKHUBenchNotes(itNote, vNotes.end());
+    if (!CommitKHURootTransactions()) {
+        throw std::runtime_error("KHU bench: failed to commit the KHU databases");
+    }
+    return nEventHeight;
+}
+
+// Yield event over nNotes staked notes, rolled back after each iteration
+static void KHUApplyDailyYield(benchmark::State& state, size_t nNotes)
+{
+    KHUBenchSetup setup;
+    KhuGlobalState khuState = MakeYieldBenchState();
+    const uint32_t nEventHeight = PopulateYieldBench(nNotes, khuState);
+
+    while (state.KeepRunning()) {
+        auto dbTx = BeginKHUTransaction();
+        KhuGlobalState newState = khuState;
+        khu_yield::ApplyDailyYield(newState, nEventHeight, KHU_BENCH_V6_HEIGHT);
+    }
+}
+
+static void KHUApplyDailyYield_10k(benchmark::State& state) { KHUApplyDailyYield(state, 10000); }
+static void KHUApplyDailyYield_100k(benchmark::State& state) { KHUApplyDailyYield(state, 100000); }
+
+// Reorg of the last yield event over 10k staked notes
+static void KHUUndoDailyYield(benchmark::State& state)
+{
+    KHUBenchSetup setup;
+    KhuGlobalState khuState = MakeYieldBenchState();
+    const uint32_t nEventHeight = PopulateYieldBench(10000, khuState);
+    {
+        auto dbTx = BeginKHUTransaction();
+        if (!khu_yield::ApplyDailyYield(khuState, nEventHeight, KHU_BENCH_V6_HEIGHT)) {
+            throw std::runtime_error("KHU bench: ApplyDailyYield failed");
+        }
+        dbTx->Commit();
+    }
+
+    while (state.KeepRunning()) {
+        auto dbTx = BeginKHUTransaction();
+        KhuGlobalState newState = khuState;
+        khu_yield::UndoDailyYield(newState, nEventHeight, KHU_BENCH_V6_HEIGHT);
+    }
+}
+
+// Wallet side estimate, purely over mapZKHUNotes
+static void KHUWalletPendingYield(benchmark::State& state, size_t nNotes)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const int nTipHeight = KHU_BENCH_V6_HEIGHT + 30 * khu_yield::YIELD_INTERVAL;
+
+    CWallet wallet("khubench", WalletDatabase::CreateDummy());
+    {
+        FastRandomContext rng(true);
+        LOCK(wallet.cs_wallet);
+        for (size_t i = 0; i < nNotes; i++) {
+            const uint256 cm = rng.rand256();
+            const int nHeight = KHU_BENCH_V6_HEIGHT + rng.randrange(20 * khu_yield::YIELD_INTERVAL);
+            wallet.khuData.mapZKHUNotes.emplace(cm, ZKHUNoteEntry(SaplingOutPoint(rng.rand256(), 0), cm, nHeight,
+                                                                  (1 + rng.randrange(5000)) * COIN, rng.rand256(), nHeight));
+        }
+    }
+
+    CBlockIndex tip;
+    tip.nHeight = nTipHeight;
+    chainActive.SetTip(&tip);
+
+    while (state.KeepRunning()) {
+        GetKHUPendingYieldEstimate(&wallet, khu_domc::R_DEFAULT);
+    }
+
+    chainActive.SetTip(nullptr);
+}
+
+static void KHUWalletPendingYield_10k(benchmark::State& state) { KHUWalletPendingYield(state, 10000); }
+static void KHUWalletPendingYield_1M(benchmark::State& state) { KHUWalletPendingYield(state, 1000000); }
+
+BENCHMARK(KHUApplyDailyYield_10k, 50);
+BENCHMARK(KHUApplyDailyYield_100k, 5);
+BENCHMARK(KHUUndoDailyYield, 50);
+BENCHMARK(KHUWalletPendingYield_10k, 100);
+BENCHMARK(KHUWalletPendingYield_1M, 1);
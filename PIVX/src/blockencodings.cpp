@@ -0,0 +1,205 @@
+// Copyright (c) 2016-2020 The Bitcoin Core developers
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockencodings.h"
+
+#include "consensus/consensus.h"
+#include "consensus/merkle.h"
+#include "crypto/sha256.h"
+#include "crypto/siphash.h"
+#include "logging.h"
+#include "random.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "version.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+// Smallest serialized transaction, bounds the transaction count of a block
+static const unsigned int MIN_SERIALIZABLE_TRANSACTION_SIZE = 10;
+
+CBlockHeaderAndShortTxIDs::CBlockHeaderAndShortTxIDs(const CBlock& block) :
+        nonce(GetRand(std::numeric_limits<uint64_t>::max())),
+        header(block), vchBlockSig(block.vchBlockSig)
+{
+    FillShortTxIDSelector();
+    // Coinbase and coinstake are never in the receiver's mempool
+    const size_t nPrefilled = block.IsProofOfStake() ? 2 : 1;
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        if (i < nPrefilled) {
+            // Offsets since the previous prefilled tx: 0, 0
+            prefilledtxn.push_back({0, block.vtx[i]});
+        } else {
+            shorttxids.push_back(GetShortID(block.vtx[i]->GetHash()));
+        }
+    }
+}
+
+bool CBlockHeaderAndShortTxIDs::GetBlockSkeleton(CBlock& block) const
+{
+    block = CBlock(header);
+    block.vchBlockSig = vchBlockSig;
+    for (size_t i = 0; i < prefilledtxn.size() && i < 2 && prefilledtxn[i].index == 0; i++) {
+        if (!prefilledtxn[i].tx)
+            return false;
+        block.vtx.push_back(prefilledtxn[i].tx);
+    }
+    return true;
+}
+
+void CBlockHeaderAndShortTxIDs::FillShortTxIDSelector() const
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << header << nonce;
+    CSHA256 hasher;
+    hasher.Write((unsigned char*)&(*stream.begin()), stream.end() - stream.begin());
+    uint256 shorttxidhash;
+    hasher.Finalize(shorttxidhash.begin());
+    shorttxidk0 = shorttxidhash.GetUint64(0);
+    shorttxidk1 = shorttxidhash.GetUint64(1);
+}
+
+uint64_t CBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const
+{
+    static_assert(SHORTTXIDS_LENGTH == 6, "shorttxids calculation assumes 6-byte shorttxids");
+    return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
+}
+
+ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& cmpctblock)
+{
+    if (cmpctblock.header.IsNull() || (cmpctblock.shorttxids.empty() && cmpctblock.prefilledtxn.empty()))
+        return READ_STATUS_INVALID;
+    if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() > MAX_BLOCK_SIZE_CURRENT / MIN_SERIALIZABLE_TRANSACTION_SIZE)
+        return READ_STATUS_INVALID;
+
+    assert(header.IsNull() && txn_available.empty());
+    header = cmpctblock.header;
+    vchBlockSig = cmpctblock.vchBlockSig;
+    txn_available.resize(cmpctblock.BlockTxCount());
+
+    int32_t lastprefilledindex = -1;
+    for (size_t i = 0; i < cmpctblock.prefilledtxn.size(); i++) {
+        if (!cmpctblock.prefilledtxn[i].tx || cmpctblock.prefilledtxn[i].tx->IsNull())
+            return READ_STATUS_INVALID;
+
+        lastprefilledindex += cmpctblock.prefilledtxn[i].index + 1; //index is a uint16_t, so can't overflow here
+        if (lastprefilledindex > std::numeric_limits<uint16_t>::max())
+            return READ_STATUS_INVALID;
+        if ((uint32_t)lastprefilledindex > cmpctblock.shorttxids.size() + i) {
+            // If we are inserting a tx at an index greater than our full list of shorttxids
+            // plus the number of prefilled txn we've inserted, then we have txn for which we
+            // have neither a prefilled txn or a shorttxid!
+            return READ_STATUS_INVALID;
+        }
+        txn_available[lastprefilledindex] = cmpctblock.prefilledtxn[i].tx;
+    }
+    prefilled_count = cmpctblock.prefilledtxn.size();
+
+    // Calculate map of txids -> positions and check mempool to see what we have (or don't)
+    // Because well-formed cmpctblock messages will have a (relatively) uniform distribution
+    // of short IDs, any highly-uneven distribution of elements can be safely treated as a
+    // READ_STATUS_FAILED.
+    std::unordered_map<uint64_t, uint16_t> shorttxids(cmpctblock.shorttxids.size());
+    // Short IDs shared by several transactions of the block: none of them is
+    // taken from the mempool, they are all requested with the missing ones.
+    std::unordered_set<uint64_t> collidedids;
+    uint16_t index_offset = 0;
+    for (size_t i = 0; i < cmpctblock.shorttxids.size(); i++) {
+        while (txn_available[i + index_offset])
+            index_offset++;
+        if (!shorttxids.emplace(cmpctblock.shorttxids[i], i + index_offset).second)
+            collidedids.insert(cmpctblock.shorttxids[i]);
+        // To determine the chance that the number of entries in a bucket exceeds N,
+        // we use the fact that the number of elements in a single bucket is
+        // binomially distributed (with n = the number of shorttxids S, and p =
+        // 1 / the number of buckets), that in the worst case the number of buckets is
+        // equal to S (due to std::unordered_map having a default load factor of 1.0),
+        // and that the chance for any bucket to exceed N elements is at most
+        // buckets * (the chance that any given bucket is above N elements).
+        // Thus: P(max_elements_per_bucket > N) <= S * (1 - cdf(binomial(n=S,p=1/S), N)).
+        // If we assume blocks of up to 16000, allowing 12 elements per bucket should
+        // only fail once per ~1 million block transfers (per peer and connection).
+        if (shorttxids.bucket_size(shorttxids.bucket(cmpctblock.shorttxids[i])) > 12)
+            return READ_STATUS_FAILED;
+    }
+
+    std::vector<bool> have_txn(txn_available.size());
+    {
+        LOCK(pool->cs);
+        for (const CTxMemPoolEntry& entry : pool->mapTx) {
+            uint64_t shortid = cmpctblock.GetShortID(entry.GetTx().GetHash());
+            auto idit = shorttxids.find(shortid);
+            if (idit != shorttxids.end() && !collidedids.count(shortid)) {
+                if (!have_txn[idit->second]) {
+                    txn_available[idit->second] = entry.GetSharedTx();
+                    have_txn[idit->second] = true;
+                    mempool_count++;
+                } else {
+                    // If we find two mempool txn that match the short id, just request it.
+                    // This should be rare enough that the extra bandwidth doesn't matter,
+                    // but eating a round-trip due to FillBlock failure would be annoying
+                    if (txn_available[idit->second]) {
+                        txn_available[idit->second].reset();
+                        mempool_count--;
+                    }
+                }
+            }
+            // Though ideally we'd continue scanning for the two-txn-match-shortid case,
+            // the performance win of an early exit here is too good to pass up and worth
+            // the extra risk.
+            if (mempool_count == shorttxids.size() - collidedids.size())
+                break;
+        }
+    }
+
+    LogPrint(BCLog::NET, "Initialized PartiallyDownloadedBlock for block %s using a cmpctblock of size %lu (%lu prefilled, %lu from mempool)\n",
+             cmpctblock.header.GetHash().ToString(), GetSerializeSize(cmpctblock, PROTOCOL_VERSION), prefilled_count, mempool_count);
+    return READ_STATUS_OK;
+}
+
+bool PartiallyDownloadedBlock::IsTxAvailable(size_t index) const
+{
+    assert(!header.IsNull());
+    assert(index < txn_available.size());
+    return txn_available[index] != nullptr;
+}
+
+ReadStatus PartiallyDownloadedBlock::FillBlock(CBlock& block, const std::vector<CTransactionRef>& vtx_missing)
+{
+    assert(!header.IsNull());
+    uint256 hash = header.GetHash();
+    block = CBlock(header);
+    block.vchBlockSig = vchBlockSig;
+    block.vtx.resize(txn_available.size());
+
+    size_t tx_missing_offset = 0;
+    for (size_t i = 0; i < txn_available.size(); i++) {
+        if (!txn_available[i]) {
+            if (vtx_missing.size() <= tx_missing_offset)
+                return READ_STATUS_INVALID;
+            block.vtx[i] = vtx_missing[tx_missing_offset++];
+        } else {
+            block.vtx[i] = std::move(txn_available[i]);
+        }
+    }
+
+    // Make sure we can't call FillBlock again.
+    header.SetNull();
+    txn_available.clear();
+
+    if (vtx_missing.size() != tx_missing_offset)
+        return READ_STATUS_INVALID;
+
+    // Only the merkle root here: a mismatch is a possible short ID collision,
+    // anything else is left to block validation (and the peer's DoS score)
+    bool mutated = false;
+    if (BlockMerkleRoot(block, &mutated) != block.hashMerkleRoot || mutated)
+        return READ_STATUS_FAILED;
+
+    LogPrint(BCLog::NET, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool and %lu txn requested\n",
+             hash.ToString(), prefilled_count, mempool_count, vtx_missing.size());
+    return READ_STATUS_OK;
+}
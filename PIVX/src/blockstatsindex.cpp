@@ -0,0 +1,255 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockstatsindex.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "compat/endian.h"
+#include "consensus/upgrades.h"
+#include "khu/khu_statedb.h"
+#include "khu/khu_validation.h"
+#include "logging.h"
+#include "primitives/block.h"
+#include "shutdown.h"
+#include "undo.h"
+#include "util/system.h"
+#include "utiltime.h"
+#include "validation.h"
+
+#include <algorithm>
+
+static const char DB_BLOCK_STATS = 's';
+static const char DB_BEST_BLOCK = 'B';
+
+std::unique_ptr<CBlockStatsIndex> g_blockstatsindex;
+
+static std::pair<char, uint32_t> MakeStatsKey(int nHeight)
+{
+    return std::make_pair(DB_BLOCK_STATS, htobe32((uint32_t)nHeight));
+}
+
+CBlockStatsEntry CBlockStatsEntry::Since(const CBlockStatsEntry& prev) const
+{
+    CBlockStatsEntry ret;
+    ret.hashBlock = hashBlock;
+    ret.nTxCount = nTxCount - prev.nTxCount;
+    ret.nTxCountAll = nTxCountAll - prev.nTxCountAll;
+    ret.nTxBytes = nTxBytes - prev.nTxBytes;
+    ret.nFees = nFees - prev.nFees;
+    ret.nShieldedTxCount = nShieldedTxCount - prev.nShieldedTxCount;
+    ret.nKHUTxCount = nKHUTxCount - prev.nKHUTxCount;
+    ret.fKHUState = fKHUState && prev.fKHUState;
+    if (ret.fKHUState) {
+        ret.nKHUC = nKHUC - prev.nKHUC;
+        ret.nKHUU = nKHUU - prev.nKHUU;
+        ret.nKHUZ = nKHUZ - prev.nKHUZ;
+    }
+    return ret;
+}
+
+CBlockStatsIndex::CBlockStatsIndex(size_t nCacheSize, bool fMemory, bool fWipe) :
+    db(GetDataDir() / "blockstats", nCacheSize, fMemory, fWipe)
+{
+    uint256 hashBest;
+    if (db.Read(DB_BEST_BLOCK, hashBest)) {
+        LOCK(cs_main);
+        pindexBest = LookupBlockIndex(hashBest);
+    }
+}
+
+int CBlockStatsIndex::GetBestHeight() const
+{
+    LOCK(cs);
+    return pindexBest ? pindexBest->nHeight : -1;
+}
+
+bool CBlockStatsIndex::ComputeEntry(const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex, CBlockStatsEntry& entry)
+{
+    if (pindex->pprev && blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block %s and undo data inconsistent", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    const int ntx = block.vtx.size();
+    const int firstTxIndex = block.IsProofOfStake() ? 2 : 1;
+    entry.nTxCountAll += ntx;
+    entry.nTxCount += std::max(ntx - firstTxIndex, 0);
+    for (int idx = firstTxIndex; idx < ntx; idx++) {
+        const CTransaction& tx = *block.vtx[idx];
+        if (tx.IsShieldedTx()) {
+            entry.nShieldedTxCount++;
+        }
+        if (tx.nType >= CTransaction::TxType::KHU_MINT && tx.nType <= CTransaction::TxType::KHU_UNSTAKE) {
+            entry.nKHUTxCount++;
+        }
+
+        // zerocoin txes have fixed fee, don't count them here.
+        if (tx.ContainsZerocoins())
+            continue;
+
+        entry.nTxBytes += GetSerializeSize(tx, CLIENT_VERSION);
+        CAmount nValueIn = tx.GetShieldedValueIn();
+        for (const Coin& coin : blockundo.vtxundo[idx - 1].vprevout) {
+            nValueIn += coin.out.nValue;
+        }
+        entry.nFees += nValueIn - tx.GetValueOut();
+    }
+
+    // KHU state after the block. It is stored by height: when notified, the height may already
+    // belong to another chain (or be pruned), the state is then left out, not carried forward.
+    entry.nKHUC = entry.nKHUU = entry.nKHUZ = 0;
+    entry.fKHUState = true;
+    if (Params().GetConsensus().NetworkUpgradeActive(pindex->nHeight, Consensus::UPGRADE_V6_0)) {
+        CKHUStateDB* khuDB = GetKHUStateDB();
+        KhuGlobalState khuState;
+        if (khuDB && khuDB->ReadKHUState(pindex->nHeight, khuState) && khuState.hashBlock == pindex->GetBlockHash()) {
+            entry.nKHUC = khuState.C;
+            entry.nKHUU = khuState.U;
+            entry.nKHUZ = khuState.Z;
+        } else {
+            LogPrint(BCLog::KHU, "%s: KHU state of block %s not available\n", __func__, pindex->GetBlockHash().ToString());
+            entry.fKHUState = false;
+        }
+    }
+    entry.hashBlock = pindex->GetBlockHash();
+    return true;
+}
+
+bool CBlockStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Input values of the transactions (but the coinbase) come from the undo data
+    CBlockUndo blockundo;
+    if (pindex->pprev) {
+        const FlatFilePos pos = WITH_LOCK(cs_main, return pindex->GetUndoPos());
+        if (pos.IsNull() || !UndoReadFromDisk(blockundo, pos, pindex->pprev->GetBlockHash())) {
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+    }
+
+    LOCK(cs);
+    // Running totals: start from the entry of the previous block
+    CBlockStatsEntry entry;
+    if (pindex->pprev && (!db.Read(MakeStatsKey(pindex->nHeight - 1), entry) || entry.hashBlock != pindex->pprev->GetBlockHash())) {
+        return error("%s: missing stats of the parent of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (!ComputeEntry(block, blockundo, pindex, entry)) {
+        return false;
+    }
+
+    CDBBatch batch(CLIENT_VERSION);
+    batch.Write(MakeStatsKey(pindex->nHeight), entry);
+    batch.Write(DB_BEST_BLOCK, pindex->GetBlockHash());
+    if (!db.WriteBatch(batch)) {
+        return error("%s: failed to write stats of block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    pindexBest = pindex;
+    return true;
+}
+
+void CBlockStatsIndex::ThreadSync()
+{
+    const CBlockIndex* pindex = WITH_LOCK(cs, return pindexBest);
+    int64_t nLastLog = 0;
+    while (!ShutdownRequested()) {
+        const CBlockIndex* pindexNext;
+        {
+            LOCK(cs_main);
+            if (pindex && !chainActive.Contains(pindex)) {
+                // Reorged out while the index was not running: entries above the fork get overwritten
+                pindex = chainActive.FindFork(pindex);
+                LOCK(cs);
+                pindexBest = pindex;
+                if (pindex && !db.Write(DB_BEST_BLOCK, pindex->GetBlockHash())) {
+                    LogPrintf("%s: failed to rewind block stats index\n", __func__);
+                    return;
+                }
+            }
+            pindexNext = pindex ? chainActive.Next(pindex) : chainActive.Genesis();
+            if (!pindexNext) {
+                // Still under cs_main: the blocks connected from now on are notified after this
+                fSynced = true;
+                LogPrintf("%s: block stats index is enabled at height %d\n", __func__, pindex ? pindex->nHeight : -1);
+                return;
+            }
+        }
+
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindexNext) || !WriteBlock(block, pindexNext)) {
+            LogPrintf("%s: failed to index block %s, block stats index stopped\n", __func__, pindexNext->GetBlockHash().ToString());
+            return;
+        }
+        pindex = pindexNext;
+
+        const int64_t nNow = GetTime();
+        if (nNow > nLastLog + 30) {
+            LogPrintf("Syncing block stats index with block chain, height %d\n", pindex->nHeight);
+            nLastLog = nNow;
+        }
+    }
+}
+
+void CBlockStatsIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex)
+{
+    if (!fSynced) {
+        return;
+    }
+    {
+        LOCK(cs);
+        if (pindex->pprev != pindexBest) {
+            // Already indexed by ThreadSync
+            return;
+        }
+    }
+    if (!WriteBlock(*block, pindex)) {
+        fSynced = false;
+        LogPrintf("%s: failed to index block %s, block stats index stopped\n", __func__, pindex->GetBlockHash().ToString());
+    }
+}
+
+void CBlockStatsIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block, const uint256& blockHash, int nBlockHeight, int64_t blockTime)
+{
+    if (!fSynced) {
+        return;
+    }
+    LOCK(cs);
+    if (!pindexBest || pindexBest->GetBlockHash() != blockHash) {
+        return;
+    }
+    // The entry stays, it is overwritten by the next block at this height
+    pindexBest = pindexBest->pprev;
+    if (pindexBest && !db.Write(DB_BEST_BLOCK, pindexBest->GetBlockHash())) {
+        fSynced = false;
+        LogPrintf("%s: failed to rewind block stats index\n", __func__);
+    }
+}
+
+bool CBlockStatsIndex::LookupRange(int nFirst, int nLast, CBlockStatsEntry& stats) const
+{
+    if (!fSynced || nFirst < 0 || nFirst > nLast) {
+        return false;
+    }
+    uint256 hashLast, hashPrev;
+    {
+        LOCK(cs_main);
+        const CBlockIndex* pindexLast = chainActive[nLast];
+        if (!pindexLast) {
+            return false;
+        }
+        hashLast = pindexLast->GetBlockHash();
+        if (nFirst > 0) {
+            hashPrev = chainActive[nFirst - 1]->GetBlockHash();
+        }
+    }
+
+    // The running totals are trusted only for blocks of the active chain
+    CBlockStatsEntry last, prev;
+    if (!db.Read(MakeStatsKey(nLast), last) || last.hashBlock != hashLast) {
+        return false;
+    }
+    if (nFirst > 0 && (!db.Read(MakeStatsKey(nFirst - 1), prev) || prev.hashBlock != hashPrev)) {
+        return false;
+    }
+    stats = last.Since(prev);
+    return true;
+}
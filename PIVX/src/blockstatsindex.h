@@ -0,0 +1,105 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_BLOCKSTATSINDEX_H
+#define PIVX_BLOCKSTATSINDEX_H
+
+#include "amount.h"
+#include "dbwrapper.h"
+#include "serialize.h"
+#include "sync.h"
+#include "uint256.h"
+#include "validationinterface.h"
+
+#include <atomic>
+#include <memory>
+
+class CBlock;
+class CBlockIndex;
+class CBlockUndo;
+
+static const bool DEFAULT_BLOCKSTATSINDEX = false;
+
+/**
+ * Running totals of the block statistics from the genesis block up to (and
+ * including) hashBlock. The statistics of a range are the difference of the
+ * totals at its bounds.
+ * Coinbase/coinstake are only counted in nTxCountAll, zerocoin transactions
+ * are left out of nTxBytes and nFees (fixed fee), as getblockindexstats did.
+ */
+class CBlockStatsEntry
+{
+public:
+    uint256 hashBlock;
+    int64_t nTxCount{0};
+    int64_t nTxCountAll{0};
+    int64_t nTxBytes{0};
+    CAmount nFees{0};
+    int64_t nShieldedTxCount{0};
+    int64_t nKHUTxCount{0};
+    // KHU state after the block (not a running total), when fKHUState
+    CAmount nKHUC{0};
+    CAmount nKHUU{0};
+    CAmount nKHUZ{0};
+    // The KHU state of the block could be read (not reorged away nor pruned)
+    bool fKHUState{false};
+
+    // Statistics of the blocks after prev, up to this one (KHU delta only if both states are known)
+    CBlockStatsEntry Since(const CBlockStatsEntry& prev) const;
+
+    SERIALIZE_METHODS(CBlockStatsEntry, obj)
+    {
+        READWRITE(obj.hashBlock, obj.nTxCount, obj.nTxCountAll, obj.nTxBytes, obj.nFees);
+        READWRITE(obj.nShieldedTxCount, obj.nKHUTxCount, obj.nKHUC, obj.nKHUU, obj.nKHUZ, obj.fKHUState);
+    }
+};
+
+/**
+ * Optional per-block statistics index (-blockstatsindex), serving
+ * getblockindexstats/getfeeinfo ranges with two lookups instead of reading
+ * every block and its prevouts.
+ *
+ * DATABASE KEYS:
+ * - 's' + height (big endian) -> CBlockStatsEntry
+ * - 'B' -> hash of the last indexed block
+ *
+ * ThreadSync catches up with the active chain in the background (after
+ * enabling the index or a restart), then blocks are added from the
+ * BlockConnected notifications. Entries above the best indexed block may be
+ * stale (reorg), an entry is trusted only if its hash matches the active
+ * chain.
+ */
+class CBlockStatsIndex : public CValidationInterface
+{
+private:
+    CDBWrapper db;
+    mutable RecursiveMutex cs;
+    //! Last indexed block, guarded by cs
+    const CBlockIndex* pindexBest{nullptr};
+    //! Caught up with the active chain: notifications are processed from here on
+    std::atomic<bool> fSynced{false};
+
+    // Add the statistics of the block to the running totals of its parent, in entry
+    bool ComputeEntry(const CBlock& block, const CBlockUndo& blockundo, const CBlockIndex* pindex, CBlockStatsEntry& entry);
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block, const uint256& blockHash, int nBlockHeight, int64_t blockTime) override;
+
+public:
+    CBlockStatsIndex(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    /** Index the active chain blocks missing, until caught up or shutdown (index thread) */
+    void ThreadSync();
+    bool IsSynced() const { return fSynced; }
+    int GetBestHeight() const;
+
+    /** Statistics of the active chain blocks [nFirst, nLast], false if not (yet) indexed */
+    bool LookupRange(int nFirst, int nLast, CBlockStatsEntry& stats) const;
+};
+
+extern std::unique_ptr<CBlockStatsIndex> g_blockstatsindex;
+
+#endif // PIVX_BLOCKSTATSINDEX_H
@@ -880,6 +880,11 @@ std::future<bool> CBLSWorker::AsyncVerifySig(const CBLSSignature& sig, const CBL
     return std::move(p.second);
 }
 
+std::future<void> CBLSWorker::AsyncRun(std::function<void()> func)
+{
+    return workerPool.push([func](int threadId) { func(); });
+}
+
 bool CBLSWorker::IsAsyncVerifyInProgress()
 {
     std::unique_lock<std::mutex> l(sigVerifyMutex);
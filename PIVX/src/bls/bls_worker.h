@@ -137,6 +137,9 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Runs a self-contained job on the worker threads, e.g. the Verify() of an independent CBLSBatchVerifier
+    std::future<void> AsyncRun(std::function<void()> func);
+
 private:
     void PushSigVerifyBatch();
 };
@@ -131,10 +131,11 @@ bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fCol
     return true;
 }
 
-bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD)
+bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD,
+                                std::vector<SaplingValidation::CProofCheck>* pvSaplingChecks)
 {
     // Dispatch to Sapling validator
-    if (!SaplingValidation::ContextualCheckTransaction(*tx, state, chainparams, nHeight, isMined, fIBD)) {
+    if (!SaplingValidation::ContextualCheckTransaction(*tx, state, chainparams, nHeight, isMined, fIBD, pvSaplingChecks)) {
         return false; // Failure reason has been set in validation state object
     }
 
@@ -15,13 +15,15 @@ class CBlockIndex;
 class CChainParams;
 class CCoinsViewCache;
 class CValidationState;
+namespace SaplingValidation { class CProofCheck; }
 
 /** Transaction validation functions */
 
 /** Context-independent validity checks */
 bool CheckTransaction(const CTransaction& tx, CValidationState& state, bool fColdStakingActive);
-/** Context-dependent validity checks */
-bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD);
+/** Context-dependent validity checks. If pvSaplingChecks is not null, Sapling proofs are deferred to it. */
+bool ContextualCheckTransaction(const CTransactionRef& tx, CValidationState& state, const CChainParams& chainparams, int nHeight, bool isMined, bool fIBD,
+                                std::vector<SaplingValidation::CProofCheck>* pvSaplingChecks = nullptr);
 
 /**
  * Count ECDSA signature operations the old-fashioned (pre-0.6) way
@@ -14,7 +14,9 @@
 #include "core_io.h"
 #include "key_io.h"
 #include "guiinterface.h"
+#include "llmq/quorums_utils.h"
 #include "masternodeman.h" // for mnodeman (!TODO: remove)
+#include "memusage.h"
 #include "script/standard.h"
 #include "spork.h"
 #include "sync.h"
@@ -23,6 +25,7 @@
 
 static const std::string DB_LIST_SNAPSHOT = "dmn_S";
 static const std::string DB_LIST_DIFF = "dmn_D";
+static const std::string DB_QUORUM_MEMBERS = "dmn_Q";
 
 std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
 
@@ -218,18 +221,19 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t m
 {
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    // descending order, only the top maxSize entries need to be sorted
+    const size_t nSize = std::min(maxSize, scores.size());
+    std::partial_sort(scores.begin(), scores.begin() + nSize, scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
+        return b.first < a.first;
     });
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(nSize);
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
@@ -319,6 +323,24 @@ void CDeterministicMNList::PoSeDecrease(const uint256& proTxHash)
     UpdateMN(proTxHash, newState);
 }
 
+size_t CDeterministicMNList::GetMemoryUsage() const
+{
+    // immer maps: one node per entry, roughly the size of the key/value pair plus a pointer
+    static const size_t MN_USAGE = sizeof(CDeterministicMN) + sizeof(CDeterministicMNState) +
+                                   memusage::MallocUsage(sizeof(uint256) + sizeof(CDeterministicMNCPtr) + sizeof(void*));
+    return sizeof(*this) +
+           mnMap.size() * MN_USAGE +
+           mnInternalIdMap.size() * memusage::MallocUsage(sizeof(uint64_t) + sizeof(uint256) + sizeof(void*)) +
+           mnUniquePropertyMap.size() * memusage::MallocUsage(sizeof(uint256) * 2 + sizeof(uint32_t) + sizeof(void*));
+}
+
+size_t CDeterministicMNListDiff::GetMemoryUsage() const
+{
+    return sizeof(*this) +
+           memusage::DynamicUsage(addedMNs) + addedMNs.size() * (sizeof(CDeterministicMN) + sizeof(CDeterministicMNState)) +
+           memusage::DynamicUsage(updatedMNs) + memusage::DynamicUsage(removedMns);
+}
+
 CDeterministicMNListDiff CDeterministicMNList::BuildDiff(const CDeterministicMNList& to) const
 {
     CDeterministicMNListDiff diffRet;
@@ -462,6 +484,7 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
 CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
     evoDb(_evoDb)
 {
+    llmq::utils::InitQuorumsCache(mapQuorumMembers);
 }
 
 bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& _state, bool fJustCheck)
@@ -499,13 +522,17 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
         if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || oldList.GetHeight() == -1) {
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            mnListsCache.emplace(newList.GetBlockHash(), newList);
+            CacheList(newList);
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                 __func__, nHeight, newList.GetAllMNsCount());
+        } else if (IsHotHeight(nHeight)) {
+            CacheList(newList);
         }
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), diff);
+        mnListDiffsCache.insert(pindex->GetBlockHash(), diff, diff.GetMemoryUsage());
+
+        WriteQuorumMembers(newList);
     } catch (const std::exception& e) {
         LogPrintf("CDeterministicMNManager::%s -- internal error: %s\n", __func__, e.what());
         return _state.DoS(100, false, REJECT_INVALID, "failed-dmn-block");
@@ -517,9 +544,6 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         uiInterface.NotifyMasternodeListChanged(newList);
     }
 
-    LOCK(cs);
-    CleanupCache(nHeight);
-
     return true;
 }
 
@@ -547,6 +571,12 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
 
         mnListsCache.erase(blockHash);
         mnListDiffsCache.erase(blockHash);
+
+        for (const auto& p : Params().GetConsensus().llmqs) {
+            if ((pindex->nHeight % p.second.dkgInterval) == 0) {
+                evoDb.Erase(std::make_pair(DB_QUORUM_MEMBERS, std::make_pair(static_cast<uint8_t>(p.first), blockHash)));
+            }
+        }
     }
 
     if (diff.HasChanges()) {
@@ -850,66 +880,78 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
     }
 
     CDeterministicMNList snapshot;
-    std::list<const CBlockIndex*> listDiffIndexes;
+    // diffs to apply on top of the snapshot, newest first
+    std::vector<std::pair<const CBlockIndex*, CDeterministicMNListDiff>> vDiffs;
 
     while (true) {
+        const uint256& blockHash = pindex->GetBlockHash();
+
         // try using cache before reading from disk
-        auto itLists = mnListsCache.find(pindex->GetBlockHash());
-        if (itLists != mnListsCache.end()) {
-            snapshot = itLists->second;
+        const CDeterministicMNList* cachedList = mnListsCache.get(blockHash);
+        if (cachedList) {
+            snapshot = *cachedList;
             break;
         }
 
-        if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+        // disk snapshots are only written every DISK_SNAPSHOT_PERIOD blocks and for the first DIP3 block:
+        // don't look them up at the other heights
+        if (((pindex->nHeight % DISK_SNAPSHOT_PERIOD) == 0 || IsActivationHeight(pindex->nHeight, Params().GetConsensus(), Consensus::UPGRADE_V6_0)) &&
+                evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, blockHash), snapshot)) {
+            CacheList(snapshot);
             break;
         }
 
         // no snapshot found yet, check diffs
-        auto itDiffs = mnListDiffsCache.find(pindex->GetBlockHash());
-        if (itDiffs != mnListDiffsCache.end()) {
-            listDiffIndexes.emplace_front(pindex);
+        const CDeterministicMNListDiff* cachedDiff = mnListDiffsCache.get(blockHash);
+        if (cachedDiff) {
+            vDiffs.emplace_back(pindex, *cachedDiff);
             pindex = pindex->pprev;
             continue;
         }
 
         CDeterministicMNListDiff diff;
-        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
+        if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, blockHash), diff)) {
+            if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, blockHash), snapshot)) {
+                CacheList(snapshot);
+                break;
+            }
             // no snapshot and no diff on disk means that it's initial snapshot (empty list)
             // If we get here, then this must be the block before the enforcement of DIP3.
             if (!IsActivationHeight(pindex->nHeight + 1, Params().GetConsensus(), Consensus::UPGRADE_V6_0)) {
                 std::string err = strprintf("No masternode list data found for block %s at height %d. "
-                                            "Possible corrupt database.", pindex->GetBlockHash().ToString(), pindex->nHeight);
+                                            "Possible corrupt database.", blockHash.ToString(), pindex->nHeight);
                 throw std::runtime_error(err);
             }
-            snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            snapshot = CDeterministicMNList(blockHash, -1, 0);
+            CacheList(snapshot);
             break;
         }
 
         diff.nHeight = pindex->nHeight;
-        mnListDiffsCache.emplace(pindex->GetBlockHash(), std::move(diff));
-        listDiffIndexes.emplace_front(pindex);
+        mnListDiffsCache.insert(blockHash, diff, diff.GetMemoryUsage());
+        vDiffs.emplace_back(pindex, std::move(diff));
         pindex = pindex->pprev;
     }
 
-    for (const auto& diffIndex : listDiffIndexes) {
-        const auto& diff = mnListDiffsCache.at(diffIndex->GetBlockHash());
+    for (auto it = vDiffs.rbegin(); it != vDiffs.rend(); ++it) {
+        const CBlockIndex* diffIndex = it->first;
+        const CDeterministicMNListDiff& diff = it->second;
         if (diff.HasChanges()) {
             snapshot = snapshot.ApplyDiff(diffIndex, diff);
         } else {
             snapshot.SetBlockHash(diffIndex->GetBlockHash());
             snapshot.SetHeight(diffIndex->nHeight);
         }
+        // keep the lists along a long replay, so that the next lookups nearby replay at most
+        // MEM_SNAPSHOT_PERIOD diffs, and the lists of the quorum blocks
+        if ((diffIndex->nHeight % MEM_SNAPSHOT_PERIOD) == 0 || IsHotHeight(diffIndex->nHeight)) {
+            CacheList(snapshot);
+        }
     }
 
-    if (tipIndex) {
-        // always keep a snapshot for the tip
-        if (snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
-            mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
-        } else {
-            // !TODO: keep snapshots for yet alive quorums
-        }
+    // always keep a snapshot for the tip
+    if (tipIndex && snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
+        CacheList(snapshot);
     }
 
     return snapshot;
@@ -946,38 +988,88 @@ bool CDeterministicMNManager::LegacyMNObsolete() const
     return LegacyMNObsolete(tipHeight);
 }
 
-void CDeterministicMNManager::CleanupCache(int nHeight)
+void CDeterministicMNManager::CacheList(const CDeterministicMNList& mnList)
 {
     AssertLockHeld(cs);
+    mnListsCache.insert(mnList.GetBlockHash(), mnList, mnList.GetMemoryUsage());
+}
 
-    std::vector<uint256> toDeleteLists;
-    std::vector<uint256> toDeleteDiffs;
-    for (const auto& p : mnListsCache) {
-        if (p.second.GetHeight() + LIST_DIFFS_CACHE_SIZE < nHeight) {
-            toDeleteLists.emplace_back(p.first);
-            continue;
+bool CDeterministicMNManager::IsHotHeight(int nHeight) const
+{
+    for (const auto& p : Params().GetConsensus().llmqs) {
+        if ((nHeight % p.second.dkgInterval) == 0) {
+            return true;
         }
-        // !TODO: llmq cache cleanup
     }
-    for (const auto& h : toDeleteLists) {
-        mnListsCache.erase(h);
+    return false;
+}
+
+std::vector<CDeterministicMNCPtr> CDeterministicMNManager::GetAllQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum)
+{
+    LOCK(cs);
+    const uint256& quorumHash = pindexQuorum->GetBlockHash();
+    auto& cache = mapQuorumMembers.at(llmqType);
+    std::vector<CDeterministicMNCPtr> members;
+    if (cache.get(quorumHash, members) || ReadQuorumMembers(llmqType, pindexQuorum, members)) {
+        cache.insert(quorumHash, members);
+        return members;
     }
-    for (const auto& p : mnListDiffsCache) {
-        if (p.second.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
-            toDeleteDiffs.emplace_back(p.first);
+
+    // Only written with the quorum block (WriteQuorumMembers): any thread may get here
+    members = CalculateQuorumMembers(llmqType, GetListForBlock(pindexQuorum));
+    cache.insert(quorumHash, members);
+    return members;
+}
+
+std::vector<CDeterministicMNCPtr> CDeterministicMNManager::CalculateQuorumMembers(Consensus::LLMQType llmqType, const CDeterministicMNList& mnList) const
+{
+    auto& params = Params().GetConsensus().llmqs.at(llmqType);
+    auto modifier = ::SerializeHash(std::make_pair(static_cast<uint8_t>(llmqType), mnList.GetBlockHash()));
+    return mnList.CalculateQuorum(params.size, modifier);
+}
+
+void CDeterministicMNManager::WriteQuorumMembers(const CDeterministicMNList& mnList)
+{
+    AssertLockHeld(cs);
+    for (const auto& p : Params().GetConsensus().llmqs) {
+        if ((mnList.GetHeight() % p.second.dkgInterval) != 0) {
+            continue;
         }
-    }
-    for (const auto& h : toDeleteDiffs) {
-        mnListDiffsCache.erase(h);
+        auto members = CalculateQuorumMembers(p.first, mnList);
+        // Nothing to persist before the first masternodes
+        if (!members.empty()) {
+            std::vector<uint256> proTxHashes;
+            proTxHashes.reserve(members.size());
+            for (const auto& dmn : members) {
+                proTxHashes.emplace_back(dmn->proTxHash);
+            }
+            evoDb.Write(std::make_pair(DB_QUORUM_MEMBERS, std::make_pair(static_cast<uint8_t>(p.first), mnList.GetBlockHash())), proTxHashes);
+        }
+        mapQuorumMembers.at(p.first).insert(mnList.GetBlockHash(), std::move(members));
     }
 }
 
-std::vector<CDeterministicMNCPtr> CDeterministicMNManager::GetAllQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum)
+bool CDeterministicMNManager::ReadQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum, std::vector<CDeterministicMNCPtr>& members)
 {
-    auto& params = Params().GetConsensus().llmqs.at(llmqType);
-    auto allMns = GetListForBlock(pindexQuorum);
-    auto modifier = ::SerializeHash(std::make_pair(static_cast<uint8_t>(llmqType), pindexQuorum->GetBlockHash()));
-    return allMns.CalculateQuorum(params.size, modifier);
+    AssertLockHeld(cs);
+    std::vector<uint256> proTxHashes;
+    if (!evoDb.Read(std::make_pair(DB_QUORUM_MEMBERS, std::make_pair(static_cast<uint8_t>(llmqType), pindexQuorum->GetBlockHash())), proTxHashes)) {
+        return false;
+    }
+    const auto allMns = GetListForBlock(pindexQuorum);
+    members.clear();
+    members.reserve(proTxHashes.size());
+    for (const uint256& proTxHash : proTxHashes) {
+        auto dmn = allMns.GetMN(proTxHash);
+        if (!dmn) {
+            // stale entry, recompute
+            LogPrintf("%s: quorum member %s not in the list of %s, recomputing\n", __func__, proTxHash.ToString(), pindexQuorum->GetBlockHash().ToString());
+            members.clear();
+            return false;
+        }
+        members.emplace_back(std::move(dmn));
+    }
+    return true;
 }
 
 
@@ -16,6 +16,7 @@
 #include "saltedhasher.h"
 #include "serialize.h"
 #include "sync.h"
+#include "unordered_lru_cache.h"
 #include "version.h"
 
 #include <immer/map.hpp>
@@ -323,6 +324,9 @@ public:
         return mnMap.size();
     }
 
+    // Estimated memory usage, counting the masternodes and map nodes shared with other lists too
+    size_t GetMemoryUsage() const;
+
     size_t GetValidMNsCount() const
     {
         size_t count = 0;
@@ -549,13 +553,17 @@ public:
     {
         return !addedMNs.empty() || !updatedMNs.empty() || !removedMns.empty();
     }
+
+    size_t GetMemoryUsage() const;
 };
 
 class CDeterministicMNManager
 {
     static const int DISK_SNAPSHOT_PERIOD = 1440; // once per day
-    static const int DISK_SNAPSHOTS = 3; // keep cache for 3 disk snapshots to have 2 full days covered
-    static const int LIST_DIFFS_CACHE_SIZE = DISK_SNAPSHOT_PERIOD * DISK_SNAPSHOTS;
+    // lists rebuilt from diffs are cached every MEM_SNAPSHOT_PERIOD blocks and at quorum heights
+    static const int MEM_SNAPSHOT_PERIOD = 144;
+    static const size_t LISTS_CACHE_BYTES = 64 << 20;
+    static const size_t LIST_DIFFS_CACHE_BYTES = 16 << 20;
 
 public:
     mutable RecursiveMutex cs;
@@ -563,8 +571,11 @@ public:
 private:
     CEvoDB& evoDb;
 
-    std::unordered_map<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache;
-    std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache;
+    // LRU caches bounded by the estimated memory usage of the lists/diffs
+    unordered_mem_lru_cache<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache{LISTS_CACHE_BYTES};
+    unordered_mem_lru_cache<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache{LIST_DIFFS_CACHE_BYTES};
+    // The members of a quorum never change: memoized here and persisted in evoDb
+    std::map<Consensus::LLMQType, unordered_lru_cache<uint256, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher>> mapQuorumMembers;
     const CBlockIndex* tipIndex{nullptr};
 
 public:
@@ -596,7 +607,14 @@ public:
     std::vector<CDeterministicMNCPtr> GetAllQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum);
 
 private:
-    void CleanupCache(int nHeight);
+    void CacheList(const CDeterministicMNList& mnList);
+    // Lists likely to be looked up again: quorum blocks (members, commitments, signatures)
+    bool IsHotHeight(int nHeight) const;
+    std::vector<CDeterministicMNCPtr> CalculateQuorumMembers(Consensus::LLMQType llmqType, const CDeterministicMNList& mnList) const;
+    // Members of the quorums of a connected block, written with the block (ProcessBlock)
+    void WriteQuorumMembers(const CDeterministicMNList& mnList);
+    // Members persisted by WriteQuorumMembers, resolved against the quorum block's list
+    bool ReadQuorumMembers(Consensus::LLMQType llmqType, const CBlockIndex* pindexQuorum, std::vector<CDeterministicMNCPtr>& members);
 };
 
 extern std::unique_ptr<CDeterministicMNManager> deterministicMNManager;
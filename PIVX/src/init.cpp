@@ -17,6 +17,7 @@
 #include "activemasternode.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockstatsindex.h"
 #include "bls/bls_wrapper.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
@@ -28,6 +29,8 @@
 #include "key.h"
 #include "khu/khu_validation.h"
 #include "khu/khu_domcdb.h"
+#include "khu/khu_statedb.h"
+#include "khu/khu_txindex.h"
 #include "mapport.h"
 #include "miner.h"
 #include "netbase.h"
@@ -36,6 +39,7 @@
 #include "policy/policy.h"
 #include "rpc/register.h"
 #include "rpc/server.h"
+#include "sapling/sapling_validation.h"
 #include "script/sigcache.h"
 #include "script/standard.h"
 #include "scheduler.h"
@@ -267,6 +271,10 @@ void Shutdown()
     // After there are no more peers/RPC left to give us new data which may generate
     // CValidationInterface callbacks, flush them...
     GetMainSignals().FlushBackgroundCallbacks();
+    if (g_blockstatsindex) {
+        UnregisterValidationInterface(g_blockstatsindex.get());
+        g_blockstatsindex.reset();
+    }
 
     // Any future callbacks will be dropped. This should absolutely be safe - if
     // missing a callback results in an unrecoverable situation, unclean shutdown
@@ -429,6 +437,9 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-sysperms", "Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)");
 #endif
     strUsage += HelpMessageOpt("-txindex", strprintf("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)", DEFAULT_TXINDEX));
+    strUsage += HelpMessageOpt("-blockstatsindex", strprintf("Maintain per-block statistics (tx count, size, fees, shield/KHU activity), used by the getblockindexstats and getfeeinfo rpc calls (default: %u)", DEFAULT_BLOCKSTATSINDEX));
+    strUsage += HelpMessageOpt("-khutxindex", strprintf("Maintain a block index of KHU transactions, used by khurescan to skip unrelated blocks (default: %u)", DEFAULT_KHU_TXINDEX));
+    strUsage += HelpMessageOpt("-khustateprune", strprintf("Only keep the KHU state of the last -maxreorg blocks and of every %dth block (default: %u)", KHU_STATE_CHECKPOINT_INTERVAL, DEFAULT_KHU_STATE_PRUNE));
     strUsage += HelpMessageOpt("-forcestart", "Attempt to force blockchain corruption recovery on startup");
 
     strUsage += HelpMessageGroup("Connection options:");
@@ -515,6 +526,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug) {
         strUsage += HelpMessageOpt("-mocktime=<n>", "Replace actual time with <n> seconds since epoch (default: 0)");
         strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-maxsaplingproofcachesize=<n>", strprintf("Limit size of Sapling proof cache to <n> MiB (default: %u)", DEFAULT_MAX_SAPLING_PROOF_CACHE_SIZE));
     }
     strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf("Fees (in %s/Kb) smaller than this are considered zero fee for relaying, mining and transaction creation (default: %s)", CURRENCY_UNIT, FormatMoney(::minRelayTxFee.GetFeePerK())));
@@ -1167,8 +1179,37 @@ bool AppInitSanityChecks()
     return LockDataDirectory(true);
 }
 
+/** Wall time of the AppInitMain stages, logged once the node is ready */
+class CStartupTimer
+{
+private:
+    const int64_t nStart;
+    int64_t nLast;
+    std::vector<std::pair<std::string, int64_t>> vStages;
+
+public:
+    CStartupTimer() : nStart(GetTimeMillis()), nLast(nStart) {}
+
+    // Close the stage started at the previous call
+    void Stage(const std::string& strName)
+    {
+        const int64_t nNow = GetTimeMillis();
+        vStages.emplace_back(strName, nNow - nLast);
+        nLast = nNow;
+    }
+
+    void Log() const
+    {
+        LogPrint(BCLog::BENCHMARK, "Startup timing: ready in %dms\n", nLast - nStart);
+        for (const auto& stage : vStages) {
+            LogPrint(BCLog::BENCHMARK, "  %-20s %10dms\n", stage.first, stage.second);
+        }
+    }
+};
+
 bool AppInitMain()
 {
+    CStartupTimer startupTimer;
     // ********************************************************* Step 4a: application initialization
     // After daemonization get the data directory lock again and hold on to it until exit
     // This creates a slight window for a race condition to happen, however this condition is harmless: it
@@ -1211,6 +1252,7 @@ bool AppInitMain()
     }
 
     InitSignatureCache();
+    SaplingValidation::InitProofCache();
 
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
@@ -1428,6 +1470,8 @@ bool AppInitMain()
 
     InitTierTwoInterfaces();
 
+    startupTimer.Stage("init, network");
+
     // ********************************************************* Step 7: load block chain
 
     fReindex = gArgs.GetBoolArg("-reindex", false);
@@ -1498,6 +1542,12 @@ bool AppInitMain()
                     return false;
                 }
 
+                // KHU: Optional KHU transaction index (fast khurescan)
+                if (!InitKHUTxIndexDB(1 << 20, fReindex, gArgs.GetBoolArg("-khutxindex", DEFAULT_KHU_TXINDEX))) { // 1 MB cache
+                    UIError(_("Failed to initialize KHU transaction index"));
+                    return false;
+                }
+
                 InitTierTwoPreChainLoad(fReindex);
 
                 if (fReset) {
@@ -1592,7 +1642,6 @@ bool AppInitMain()
                             strLoadError = _("System error while flushing the chainstate after pruning invalid entries. Possible corrupt database.");
                             break;
                         }
-                        MoneySupply.Update(pcoinsTip->GetTotalAmount(), chainHeight);
                         // No need to keep the invalid outs in memory. Clear the map 100 blocks after the last invalid UTXO
                         if (chainHeight > consensus.height_last_invalid_UTXO + 100) {
                             invalid_out::setInvalidOutPoints.clear();
@@ -1658,6 +1707,8 @@ bool AppInitMain()
         return false;
     }
 
+    startupTimer.Stage("block chain");
+
     fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
     CAutoFile est_filein(fsbridge::fopen(est_path, "rb"), SER_DISK, CLIENT_VERSION);
     // Allowed to fail as this file IS missing on first startup.
@@ -1672,6 +1723,8 @@ bool AppInitMain()
 #else
     LogPrintf("No wallet compiled in!\n");
 #endif
+    startupTimer.Stage("wallet");
+
     // ********************************************************* Step 9: import blocks
 
     if (!CheckDiskSpace(GetDataDir())) {
@@ -1709,6 +1762,13 @@ bool AppInitMain()
     for (const std::string& strFile : gArgs.GetArgs("-loadblock")) {
         vImportFiles.emplace_back(strFile);
     }
+    // Optional block statistics index, catching up with the chain in the background
+    if (gArgs.GetBoolArg("-blockstatsindex", DEFAULT_BLOCKSTATSINDEX)) {
+        g_blockstatsindex = std::make_unique<CBlockStatsIndex>(1 << 20, false, fReindex); // 1 MB cache
+        RegisterValidationInterface(g_blockstatsindex.get());
+        threadGroup.create_thread(std::bind(&TraceThread<CScheduler::Function>, "blockstats", [] { g_blockstatsindex->ThreadSync(); }));
+    }
+
     threadGroup.create_thread(std::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
@@ -1738,13 +1798,19 @@ bool AppInitMain()
     }
     LogPrintf("chainActive.Height() = %d\n", chain_active_height);
 
-    // Update money supply
+    // Money supply baseline: connected/disconnected blocks keep it current from here on.
+    // When reindexing, it is accumulated from the genesis block instead.
     if (!fReindex && !fReindexChainState) {
         uiInterface.InitMessage(_("Calculating money supply..."));
-        MoneySupply.Update(pcoinsTip->GetTotalAmount(), chain_active_height);
+        LOCK(cs_main);
+        // The cursor only sees the coins database: flush the blocks ThreadImport may have connected
+        FlushStateToDisk();
+        MoneySupply.Update(pcoinsTip->GetTotalAmount(), chainActive.Height());
     }
 
 
+    startupTimer.Stage("import, supply");
+
     // ********************************************************* Step 10: setup layer 2 data
 
     bool load_cache_files = !(fReindex || fReindexChainState);
@@ -1770,6 +1836,8 @@ bool AppInitMain()
         return false;
     }
 
+    startupTimer.Stage("tier two");
+
     // ********************************************************* Step 11: start node
 
     if (!strErrors.str().empty())
@@ -1876,6 +1944,9 @@ bool AppInitMain()
 
     // ********************************************************* Step 12: finished
 
+    startupTimer.Stage("node start");
+    startupTimer.Log();
+
     SetRPCWarmupFinished();
     uiInterface.InitMessage(_("Done loading"));
 
@@ -0,0 +1,216 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "khu/khu_coins.h"
+
+#include "khu/khu_statedb.h"
+#include "util/system.h"
+
+#include <stdexcept>
+
+bool CKHUCoinsView::GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const { return false; }
+bool CKHUCoinsView::HaveCoin(const COutPoint& outpoint) const { return false; }
+bool CKHUCoinsView::BatchWrite(CKHUCoinsMap& mapCoins) { return false; }
+
+bool CKHUCoinsViewDB::GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const
+{
+    return db.ReadKHUUTXO(outpoint, coin);
+}
+
+bool CKHUCoinsViewDB::HaveCoin(const COutPoint& outpoint) const
+{
+    return db.ExistsKHUUTXO(outpoint);
+}
+
+bool CKHUCoinsViewDB::BatchWrite(CKHUCoinsMap& mapCoins)
+{
+    // Writes land in the KHU state DB transaction and reach LevelDB with the
+    // next CommitRootTransaction()
+    size_t count = 0;
+    size_t changed = 0;
+    for (CKHUCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+        if (it->second.flags & CKHUCoinsCacheEntry::DIRTY) {
+            if (it->second.coin.IsSpent()) {
+                db.EraseKHUUTXO(it->first);
+            } else {
+                db.WriteKHUUTXO(it->first, it->second.coin);
+            }
+            changed++;
+        }
+        count++;
+        CKHUCoinsMap::iterator itOld = it++;
+        mapCoins.erase(itOld);
+    }
+    LogPrint(BCLog::KHU, "Committed %u changed KHU coins (out of %u)...\n", (unsigned int)changed, (unsigned int)count);
+    return true;
+}
+
+CKHUCoinsViewCache::CKHUCoinsViewCache(CKHUCoinsView* baseIn) : base(baseIn), cachedCoinsUsage(0) {}
+
+size_t CKHUCoinsViewCache::DynamicMemoryUsage() const
+{
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+}
+
+CKHUCoinsMap::iterator CKHUCoinsViewCache::FetchCoin(const COutPoint& outpoint) const
+{
+    CKHUCoinsMap::iterator it = cacheCoins.find(outpoint);
+    if (it != cacheCoins.end())
+        return it;
+    CKHUUTXO tmp;
+    if (!base->GetCoin(outpoint, tmp))
+        return cacheCoins.end();
+    CKHUCoinsMap::iterator ret = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::forward_as_tuple(std::move(tmp))).first;
+    if (ret->second.coin.IsSpent()) {
+        // The parent only has an empty entry for this outpoint; we can consider our
+        // version as fresh.
+        ret->second.flags = CKHUCoinsCacheEntry::FRESH;
+    }
+    cachedCoinsUsage += ret->second.coin.DynamicMemoryUsage();
+    return ret;
+}
+
+bool CKHUCoinsViewCache::GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const
+{
+    CKHUCoinsMap::const_iterator it = FetchCoin(outpoint);
+    if (it != cacheCoins.end() && !it->second.coin.IsSpent()) {
+        coin = it->second.coin;
+        return true;
+    }
+    return false;
+}
+
+void CKHUCoinsViewCache::AddCoin(const COutPoint& outpoint, const CKHUUTXO& coin, bool potential_overwrite)
+{
+    assert(!coin.IsSpent());
+    CKHUCoinsMap::iterator it;
+    bool inserted;
+    std::tie(it, inserted) = cacheCoins.emplace(std::piecewise_construct, std::forward_as_tuple(outpoint), std::tuple<>());
+    bool fresh = false;
+    if (inserted) {
+        // A default CKHUUTXO is not a spent marker
+        it->second.coin.Clear();
+    } else {
+        cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+    }
+    if (!potential_overwrite) {
+        if (!it->second.coin.IsSpent()) {
+            throw std::logic_error("Adding new KHU coin that replaces non-pruned entry");
+        }
+        // If the coin exists in the parent as a spent-but-not-flushed entry,
+        // it cannot be marked FRESH (see CCoinsViewCache::AddCoin).
+        fresh = !(it->second.flags & CKHUCoinsCacheEntry::DIRTY);
+    }
+    it->second.coin = coin;
+    it->second.flags |= CKHUCoinsCacheEntry::DIRTY | (fresh ? CKHUCoinsCacheEntry::FRESH : 0);
+    cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+}
+
+void CKHUCoinsViewCache::SpendCoin(const COutPoint& outpoint, CKHUUTXO* moveout)
+{
+    CKHUCoinsMap::iterator it = FetchCoin(outpoint);
+    if (it == cacheCoins.end()) return;
+    cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+    if (moveout) {
+        *moveout = std::move(it->second.coin);
+    }
+    if (it->second.flags & CKHUCoinsCacheEntry::FRESH) {
+        cacheCoins.erase(it);
+    } else {
+        it->second.flags |= CKHUCoinsCacheEntry::DIRTY;
+        it->second.coin.Clear();
+    }
+}
+
+bool CKHUCoinsViewCache::HaveCoin(const COutPoint& outpoint) const
+{
+    CKHUCoinsMap::const_iterator it = FetchCoin(outpoint);
+    return (it != cacheCoins.end() && !it->second.coin.IsSpent());
+}
+
+bool CKHUCoinsViewCache::HaveCoinInCache(const COutPoint& outpoint) const
+{
+    CKHUCoinsMap::const_iterator it = cacheCoins.find(outpoint);
+    return (it != cacheCoins.end() && !it->second.coin.IsSpent());
+}
+
+bool CKHUCoinsViewCache::BatchWrite(CKHUCoinsMap& mapCoins)
+{
+    for (CKHUCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it = mapCoins.erase(it)) {
+        // Ignore non-dirty entries (optimization).
+        if (!(it->second.flags & CKHUCoinsCacheEntry::DIRTY)) {
+            continue;
+        }
+        CKHUCoinsMap::iterator itUs = cacheCoins.find(it->first);
+        if (itUs == cacheCoins.end()) {
+            // The parent cache does not have an entry, while the child does
+            // We can ignore it if it's both FRESH and pruned in the child
+            if (!(it->second.flags & CKHUCoinsCacheEntry::FRESH && it->second.coin.IsSpent())) {
+                // Otherwise we will need to create it in the parent
+                // and move the data up and mark it as dirty
+                CKHUCoinsCacheEntry& entry = cacheCoins[it->first];
+                entry.coin = std::move(it->second.coin);
+                cachedCoinsUsage += entry.coin.DynamicMemoryUsage();
+                entry.flags = CKHUCoinsCacheEntry::DIRTY;
+                // We can mark it FRESH in the parent if it was FRESH in the child
+                // Otherwise it might have just been flushed from the parent's cache
+                // and already exist in the grandparent
+                if (it->second.flags & CKHUCoinsCacheEntry::FRESH) {
+                    entry.flags |= CKHUCoinsCacheEntry::FRESH;
+                }
+            }
+        } else {
+            // Assert that the child cache entry was not marked FRESH if the
+            // parent cache entry has unspent outputs. If this ever happens,
+            // it means the FRESH flag was misapplied and there is a logic
+            // error in the calling code.
+            if ((it->second.flags & CKHUCoinsCacheEntry::FRESH) && !itUs->second.coin.IsSpent()) {
+                throw std::logic_error("FRESH flag misapplied to KHU cache entry for base transaction with spendable outputs");
+            }
+
+            // Found the entry in the parent cache
+            if ((itUs->second.flags & CKHUCoinsCacheEntry::FRESH) && it->second.coin.IsSpent()) {
+                // The grandparent does not have an entry, and the child is
+                // modified and being pruned. This means we can just delete
+                // it from the parent.
+                cachedCoinsUsage -= itUs->second.coin.DynamicMemoryUsage();
+                cacheCoins.erase(itUs);
+            } else {
+                // A normal modification.
+                cachedCoinsUsage -= itUs->second.coin.DynamicMemoryUsage();
+                itUs->second.coin = std::move(it->second.coin);
+                cachedCoinsUsage += itUs->second.coin.DynamicMemoryUsage();
+                itUs->second.flags |= CKHUCoinsCacheEntry::DIRTY;
+                // NOTE: It is possible the child has a FRESH flag here in
+                // the event the entry we found in the parent is pruned. But
+                // we must not copy that FRESH flag to the parent as that
+                // pruned state likely still needs to be communicated to the
+                // grandparent.
+            }
+        }
+    }
+    return true;
+}
+
+bool CKHUCoinsViewCache::Flush()
+{
+    bool fOk = base->BatchWrite(cacheCoins);
+    cacheCoins.clear();
+    cachedCoinsUsage = 0;
+    return fOk;
+}
+
+void CKHUCoinsViewCache::Uncache(const COutPoint& outpoint)
+{
+    CKHUCoinsMap::iterator it = cacheCoins.find(outpoint);
+    if (it != cacheCoins.end() && it->second.flags == 0) {
+        cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
+        cacheCoins.erase(it);
+    }
+}
+
+unsigned int CKHUCoinsViewCache::GetCacheSize() const
+{
+    return cacheCoins.size();
+}
@@ -6,10 +6,17 @@
 #define PIVX_KHU_COINS_H
 
 #include "amount.h"
+#include "coins.h"
+#include "memusage.h"
+#include "primitives/transaction.h"
 #include "script/script.h"
 #include "serialize.h"
 #include "uint256.h"
 
+#include <unordered_map>
+
+class CKHUStateDB;
+
 /**
  * KHU UTXO Structure (Colored Coin)
  *
@@ -100,6 +107,10 @@ struct CKHUUTXO {
     bool IsNull() const {
         return amount == 0 && scriptPubKey.empty();
     }
+
+    size_t DynamicMemoryUsage() const {
+        return memusage::DynamicUsage(scriptPubKey);
+    }
 };
 
 /**
@@ -132,4 +143,113 @@ struct CKHUOutPoint {
     }
 };
 
+/**
+ * KHU UTXO cache entry (same flags as CCoinsCacheEntry)
+ */
+struct CKHUCoinsCacheEntry {
+    CKHUUTXO coin; // The actual cached data.
+    unsigned char flags;
+
+    enum Flags {
+        DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
+        FRESH = (1 << 1), // The parent view does not have this entry (or it is spent).
+    };
+
+    CKHUCoinsCacheEntry() : flags(0) {}
+    explicit CKHUCoinsCacheEntry(const CKHUUTXO& coinIn) : coin(coinIn), flags(0) {}
+};
+
+typedef std::unordered_map<COutPoint, CKHUCoinsCacheEntry, SaltedOutpointHasher> CKHUCoinsMap;
+
+/** Abstract view on the KHU_T UTXO set (mirrors CCoinsView). */
+class CKHUCoinsView
+{
+public:
+    //! Retrieve the unspent KHU_T UTXO for a given outpoint.
+    virtual bool GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const;
+
+    //! Just check whether we have an unspent KHU_T UTXO for a given outpoint.
+    virtual bool HaveCoin(const COutPoint& outpoint) const;
+
+    //! Do a bulk modification. The passed mapCoins is emptied.
+    virtual bool BatchWrite(CKHUCoinsMap& mapCoins);
+
+    virtual ~CKHUCoinsView() {}
+};
+
+/** CKHUCoinsView backed by the KHU state database ('K' + 'U' + outpoint). */
+class CKHUCoinsViewDB : public CKHUCoinsView
+{
+protected:
+    CKHUStateDB& db;
+
+public:
+    explicit CKHUCoinsViewDB(CKHUStateDB& dbIn) : db(dbIn) {}
+
+    bool GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    bool BatchWrite(CKHUCoinsMap& mapCoins) override;
+};
+
+/** CKHUCoinsView that adds a memory cache to another CKHUCoinsView (mirrors CCoinsViewCache). */
+class CKHUCoinsViewCache : public CKHUCoinsView
+{
+protected:
+    CKHUCoinsView* base;
+
+    /**
+     * Make mutable so that we can "fill the cache" even from Get-methods
+     * declared as "const".
+     */
+    mutable CKHUCoinsMap cacheCoins;
+
+    /* Cached dynamic memory usage for the inner CKHUUTXO objects. */
+    mutable size_t cachedCoinsUsage;
+
+    CKHUCoinsMap::iterator FetchCoin(const COutPoint& outpoint) const;
+
+public:
+    explicit CKHUCoinsViewCache(CKHUCoinsView* baseIn);
+
+    /**
+     * By deleting the copy constructor, we prevent accidentally using it when one intends to create a cache on top of a base cache.
+     */
+    CKHUCoinsViewCache(const CKHUCoinsViewCache&) = delete;
+
+    bool GetCoin(const COutPoint& outpoint, CKHUUTXO& coin) const override;
+    bool HaveCoin(const COutPoint& outpoint) const override;
+    bool BatchWrite(CKHUCoinsMap& mapCoins) override;
+
+    //! Check if we have the given outpoint already loaded in this cache (no call to the base view).
+    bool HaveCoinInCache(const COutPoint& outpoint) const;
+
+    /**
+     * Add a coin. Set potential_overwrite to true if an unspent version may
+     * already exist.
+     */
+    void AddCoin(const COutPoint& outpoint, const CKHUUTXO& coin, bool potential_overwrite);
+
+    /**
+     * Spend a coin. Pass moveto in order to get the deleted data.
+     * If no unspent output exists for the passed outpoint, this call
+     * has no effect.
+     */
+    void SpendCoin(const COutPoint& outpoint, CKHUUTXO* moveto = nullptr);
+
+    /**
+     * Push the modifications applied to this cache to its base.
+     * Failure to call this method before destruction will cause the changes to be forgotten.
+     */
+    bool Flush();
+
+    //! Removes the UTXO with the given outpoint from the cache, if it is not modified.
+    void Uncache(const COutPoint& outpoint);
+
+    //! Calculate the size of the cache (in number of outputs)
+    unsigned int GetCacheSize() const;
+
+    //! Calculate the size of the cache (in bytes)
+    size_t DynamicMemoryUsage() const;
+};
+
 #endif // PIVX_KHU_COINS_H
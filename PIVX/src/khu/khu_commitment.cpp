@@ -4,8 +4,11 @@
 
 #include "khu/khu_commitment.h"
 
+#include "chainparams.h"
 #include "hash.h"
 #include "khu/khu_state.h"
+#include "llmq/quorums.h"
+#include "llmq/quorums_utils.h"
 #include "util/system.h"
 
 #include <algorithm>
@@ -13,6 +16,9 @@
 // LLMQ quorum threshold: 60% of members must sign
 static constexpr double QUORUM_THRESHOLD = 0.60;
 
+// LLMQ request id prefix of KHU state commitments
+static const std::string KHU_COMMITMENT_REQUESTID_PREFIX = "khustate";
+
 bool KhuStateCommitment::IsValid() const
 {
     // Basic structure validation
@@ -98,6 +104,30 @@ KhuStateCommitment CreateKHUStateCommitment(
     return commitment;
 }
 
+Consensus::LLMQType GetKHUCommitmentLLMQType()
+{
+    return Params().GetConsensus().llmqTypeChainLocks;
+}
+
+uint256 GetKHUCommitmentSignHash(const KhuStateCommitment& commitment)
+{
+    const uint256 requestId = ::SerializeHash(std::make_pair(KHU_COMMITMENT_REQUESTID_PREFIX, commitment.nHeight));
+    return llmq::utils::BuildSignHash(GetKHUCommitmentLLMQType(), commitment.quorumHash, requestId, commitment.hashState);
+}
+
+bool GetKHUCommitmentQuorumKey(const uint256& quorumHash, CBLSPublicKey& pubKeyRet)
+{
+    if (!llmq::quorumManager) {
+        return false;
+    }
+    llmq::CQuorumCPtr quorum = llmq::quorumManager->GetQuorum(GetKHUCommitmentLLMQType(), quorumHash);
+    if (!quorum) {
+        return false;
+    }
+    pubKeyRet = quorum->qc.quorumPublicKey;
+    return pubKeyRet.IsValid();
+}
+
 bool VerifyKHUStateCommitment(
     const KhuStateCommitment& commitment,
     const KhuGlobalState& state)
@@ -131,13 +161,17 @@ bool VerifyKHUStateCommitment(
         return false;
     }
 
-    // 5. BLS signature verification
-    // NOTE: Full LLMQ signature verification will be implemented when
-    // integrating with llmq::CQuorum in Phase 3 integration step
-    // For now, we trust that if the commitment has a valid signature
-    // and meets quorum threshold, it's valid
-    //
-    // TODO Phase 3: Add llmq::CQuorum::VerifyRecoveredSig() call here
+    // 5. BLS signature of the quorum
+    CBLSPublicKey quorumPubKey;
+    if (!GetKHUCommitmentQuorumKey(commitment.quorumHash, quorumPubKey)) {
+        LogPrint(BCLog::KHU, "KHU: Unknown quorum %s for commitment at height %d\n",
+                 commitment.quorumHash.ToString(), commitment.nHeight);
+        return false;
+    }
+    if (!commitment.sig.IsValid() || !commitment.sig.VerifyInsecure(quorumPubKey, GetKHUCommitmentSignHash(commitment))) {
+        LogPrint(BCLog::KHU, "KHU: Invalid commitment signature at height %d\n", commitment.nHeight);
+        return false;
+    }
 
     LogPrint(BCLog::KHU, "KHU: State commitment verified at height %d: %s\n",
              commitment.nHeight, commitment.hashState.ToString());
@@ -6,6 +6,7 @@
 #define PIVX_KHU_COMMITMENT_H
 
 #include "bls/bls_wrapper.h"
+#include "consensus/params.h"
 #include "serialize.h"
 #include "uint256.h"
 
@@ -158,6 +159,33 @@ KhuStateCommitment CreateKHUStateCommitment(
     const uint256& quorumHash
 );
 
+/**
+ * GetKHUCommitmentLLMQType - LLMQ type signing KHU state commitments
+ *
+ * The ChainLocks quorums: every masternode takes part in them.
+ */
+Consensus::LLMQType GetKHUCommitmentLLMQType();
+
+/**
+ * GetKHUCommitmentSignHash - Message signed by the quorum for a commitment
+ *
+ * Same layout as every LLMQ recovered signature:
+ * BuildSignHash(llmqType, quorumHash, SerializeHash("khustate", height), hashState)
+ *
+ * @param commitment Commitment (nHeight, quorumHash, hashState)
+ * @return Hash the BLS signature is verified against
+ */
+uint256 GetKHUCommitmentSignHash(const KhuStateCommitment& commitment);
+
+/**
+ * GetKHUCommitmentQuorumKey - Public key of the quorum that signed a commitment
+ *
+ * @param quorumHash Quorum identifier of the commitment
+ * @param pubKeyRet Output parameter for the quorum public key
+ * @return false if the quorum is unknown (or LLMQ is not running)
+ */
+bool GetKHUCommitmentQuorumKey(const uint256& quorumHash, CBLSPublicKey& pubKeyRet);
+
 /**
  * VerifyKHUStateCommitment - Verify commitment signature
  *
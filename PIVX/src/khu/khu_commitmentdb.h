@@ -5,7 +5,7 @@
 #ifndef PIVX_KHU_COMMITMENTDB_H
 #define PIVX_KHU_COMMITMENTDB_H
 
-#include "dbwrapper.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/khu_commitment.h"
 
 #include <stdint.h>
@@ -29,7 +29,7 @@
  * 2. Optimize reorg checks (no need to load full state)
  * 3. Separate concerns (state vs consensus finality)
  */
-class CKHUCommitmentDB : public CDBWrapper
+class CKHUCommitmentDB : public CKHUDBWrapper
 {
 public:
     explicit CKHUCommitmentDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
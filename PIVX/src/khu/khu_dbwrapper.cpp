@@ -0,0 +1,85 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "khu/khu_dbwrapper.h"
+
+#include "clientversion.h"
+
+CKHUDBScopedCommitter::CKHUDBScopedCommitter(std::vector<CKHUDBWrapper*> vDBsIn) :
+    vDBs(std::move(vDBsIn))
+{
+    for (CKHUDBWrapper* db : vDBs) {
+        db->BeginCurTransaction();
+    }
+}
+
+CKHUDBScopedCommitter::~CKHUDBScopedCommitter()
+{
+    if (!didCommitOrRollback)
+        Rollback();
+}
+
+void CKHUDBScopedCommitter::Commit()
+{
+    assert(!didCommitOrRollback);
+    didCommitOrRollback = true;
+    for (CKHUDBWrapper* db : vDBs) {
+        db->CommitCurTransaction();
+    }
+}
+
+void CKHUDBScopedCommitter::Rollback()
+{
+    assert(!didCommitOrRollback);
+    didCommitOrRollback = true;
+    for (CKHUDBWrapper* db : vDBs) {
+        db->RollbackCurTransaction();
+    }
+}
+
+CKHUDBWrapper::CKHUDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe) :
+    CDBWrapper(path, nCacheSize, fMemory, fWipe),
+    rootBatch(CLIENT_VERSION),
+    rootDBTransaction(*this, rootBatch, CLIENT_VERSION),
+    curDBTransaction(rootDBTransaction, rootDBTransaction, CLIENT_VERSION),
+    rootView(rootDBTransaction, rootDBTransaction, CLIENT_VERSION)
+{
+}
+
+void CKHUDBWrapper::BeginCurTransaction()
+{
+    LOCK(cs);
+    // A single thread (holding cs_main) processes one block at a time
+    assert(!fBlockTx);
+    assert(curDBTransaction.IsClean());
+    fBlockTx = true;
+    blockTxThread = std::this_thread::get_id();
+}
+
+void CKHUDBWrapper::CommitCurTransaction()
+{
+    LOCK(cs);
+    assert(InBlockTransaction());
+    curDBTransaction.Commit();
+    fBlockTx = false;
+}
+
+void CKHUDBWrapper::RollbackCurTransaction()
+{
+    LOCK(cs);
+    assert(InBlockTransaction());
+    curDBTransaction.Clear();
+    fBlockTx = false;
+}
+
+bool CKHUDBWrapper::CommitRootTransaction()
+{
+    LOCK(cs);
+    // Only called between blocks
+    assert(curDBTransaction.IsClean());
+    rootDBTransaction.Commit();
+    bool ret = WriteBatch(rootBatch);
+    rootBatch.Clear();
+    return ret;
+}
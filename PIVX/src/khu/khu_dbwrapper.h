@@ -0,0 +1,162 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_KHU_DBWRAPPER_H
+#define PIVX_KHU_DBWRAPPER_H
+
+#include "dbwrapper.h"
+#include "sync.h"
+
+#include <thread>
+#include <vector>
+
+class CKHUDBWrapper;
+
+/**
+ * CKHUDBScopedCommitter - Per-block transaction over all KHU databases
+ *
+ * Same contract as CEvoDBScopedCommitter: the writes of the block being
+ * connected/disconnected are kept apart until Commit(), and discarded if the
+ * committer goes out of scope first (failed ConnectBlock, TestBlockValidity,
+ * VerifyDB).
+ */
+class CKHUDBScopedCommitter
+{
+private:
+    std::vector<CKHUDBWrapper*> vDBs;
+    bool didCommitOrRollback{false};
+
+public:
+    explicit CKHUDBScopedCommitter(std::vector<CKHUDBWrapper*> vDBsIn);
+    ~CKHUDBScopedCommitter();
+
+    void Commit();
+    void Rollback();
+};
+
+/**
+ * CKHUDBWrapper - Block-atomic LevelDB wrapper for the KHU databases
+ *
+ * Same layering as CEvoDB:
+ * - curDBTransaction: writes of the block being processed, made by the
+ *   thread that opened the CKHUDBScopedCommitter
+ * - rootDBTransaction: writes of all connected blocks not yet flushed,
+ *   written in a single CDBBatch by FlushStateToDisk with the chainstate
+ *
+ * Writes made outside a block transaction (startup, RPC, other threads)
+ * go straight to rootDBTransaction: a block rollback can't discard them.
+ * Other threads only read what is in rootDBTransaction, never the pending
+ * writes of the block being processed.
+ *
+ * Block transactions don't nest: TestBlockValidity and VerifyDB apply their
+ * blocks inside the single transaction they roll back.
+ *
+ * Read/Write/Erase/Exists/NewIterator shadow the CDBWrapper ones, so the
+ * derived databases keep their key layout and see their own pending writes.
+ * Values must be read back with the type they were written with.
+ */
+class CKHUDBWrapper : public CDBWrapper
+{
+public:
+    typedef CDBTransaction<CDBWrapper, CDBBatch> RootTransaction;
+    typedef CDBTransaction<RootTransaction, RootTransaction> CurTransaction;
+    typedef CDBTransactionIterator<CurTransaction> Iterator;
+
+    mutable RecursiveMutex cs;
+
+private:
+    CDBBatch rootBatch;
+    mutable RootTransaction rootDBTransaction;
+    mutable CurTransaction curDBTransaction;
+    //! Never written: view of rootDBTransaction for the threads not processing the block
+    mutable CurTransaction rootView;
+
+    //! Whether a block transaction is open and its thread, guarded by cs
+    bool fBlockTx{false};
+    std::thread::id blockTxThread;
+
+    bool InBlockTransaction() const
+    {
+        AssertLockHeld(cs);
+        return fBlockTx && blockTxThread == std::this_thread::get_id();
+    }
+
+    CurTransaction& ReadTransaction() const
+    {
+        AssertLockHeld(cs);
+        return InBlockTransaction() ? curDBTransaction : rootView;
+    }
+
+public:
+    CKHUDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe);
+
+    template <typename K, typename V>
+    bool Read(const K& key, V& value) const
+    {
+        LOCK(cs);
+        return ReadTransaction().Read(key, value);
+    }
+
+    template <typename K, typename V>
+    bool Write(const K& key, const V& value)
+    {
+        LOCK(cs);
+        if (InBlockTransaction()) {
+            curDBTransaction.Write(key, value);
+        } else {
+            rootDBTransaction.Write(key, value);
+        }
+        return true;
+    }
+
+    template <typename K>
+    bool Exists(const K& key) const
+    {
+        LOCK(cs);
+        return ReadTransaction().Exists(key);
+    }
+
+    template <typename K>
+    bool Erase(const K& key)
+    {
+        LOCK(cs);
+        if (InBlockTransaction()) {
+            curDBTransaction.Erase(key);
+        } else {
+            rootDBTransaction.Erase(key);
+        }
+        return true;
+    }
+
+    /** Cursor over the database merged with the pending writes. cs must be held while it is used. */
+    Iterator* NewIterator()
+    {
+        AssertLockHeld(cs);
+        return ReadTransaction().NewIterator();
+    }
+
+    //! Whether the calling thread has a block transaction open
+    bool HasBlockTransaction() const
+    {
+        LOCK(cs);
+        return InBlockTransaction();
+    }
+
+    size_t GetMemoryUsage() const
+    {
+        LOCK(cs);
+        return rootDBTransaction.GetMemoryUsage();
+    }
+
+    bool CommitRootTransaction();
+
+private:
+    // only CKHUDBScopedCommitter is allowed to invoke these
+    friend class CKHUDBScopedCommitter;
+    void BeginCurTransaction();
+    void CommitCurTransaction();
+    void RollbackCurTransaction();
+};
+
+#endif // PIVX_KHU_DBWRAPPER_H
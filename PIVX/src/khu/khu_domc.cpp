@@ -166,47 +166,19 @@ uint16_t CalculateDomcMedian(
         return currentR; // Fallback: keep current R
     }
 
-    // Collect all valid reveals for this cycle
-    std::vector<DomcReveal> reveals;
-    if (!domcDB->GetRevealsForCycle(cycleId, reveals)) {
-        LogPrint(BCLog::KHU, "CalculateDomcMedian: No reveals found for cycle %u\n", cycleId);
-        return currentR; // No reveals → keep current R
-    }
-
-    // Extract R proposals from valid reveals
-    std::vector<uint16_t> proposals;
-    proposals.reserve(reveals.size());
-
-    for (const auto& reveal : reveals) {
-        // Verify reveal matches a commit
-        DomcCommit commit;
-        if (!domcDB->ReadCommit(reveal.mnOutpoint, cycleId, commit)) {
-            LogPrint(BCLog::KHU, "CalculateDomcMedian: No commit found for reveal (MN=%s)\n",
-                     reveal.mnOutpoint.ToString());
-            continue; // Skip invalid reveal
-        }
-
-        // Verify commit hash matches reveal
-        if (commit.hashCommit != reveal.GetCommitHash()) {
-            LogPrint(BCLog::KHU, "CalculateDomcMedian: Commit hash mismatch (MN=%s)\n",
-                     reveal.mnOutpoint.ToString());
-            continue; // Skip invalid reveal
-        }
-
-        // Valid reveal → add to proposals
-        proposals.push_back(reveal.nRProposal);
-    }
-
-    // V1 RULE: No minimum quorum
-    if (proposals.empty()) {
-        LogPrint(BCLog::KHU, "CalculateDomcMedian: No valid proposals for cycle %u (keeping R=%u)\n",
+    // R histogram of this cycle, maintained by WriteReveal/EraseReveal.
+    // Only reveals that passed ValidateDomcRevealTx (matching commit and
+    // Hash(R || salt)) are ever stored.
+    CDomcRHistogram histogram;
+    if (!domcDB->GetRHistogram(cycleId, histogram)) {
+        // V1 RULE: No minimum quorum
+        LogPrint(BCLog::KHU, "CalculateDomcMedian: No reveals found for cycle %u (keeping R=%u)\n",
                  cycleId, currentR);
-        return currentR; // 0 valid votes → keep current R
+        return currentR; // No reveals → keep current R
     }
 
-    // Calculate median (floor index)
-    std::sort(proposals.begin(), proposals.end());
-    uint16_t median = proposals[proposals.size() / 2];
+    // Median (floor index of the sorted proposals)
+    uint16_t median = histogram.GetMedian();
 
     // Clamp to R_MAX_dynamic (governance safety limit)
     if (median > R_MAX_dynamic) {
@@ -215,8 +187,8 @@ uint16_t CalculateDomcMedian(
         median = R_MAX_dynamic;
     }
 
-    LogPrint(BCLog::KHU, "CalculateDomcMedian: Cycle %u → %zu valid votes, median R=%u (clamped to %u)\n",
-             cycleId, proposals.size(), median, R_MAX_dynamic);
+    LogPrint(BCLog::KHU, "CalculateDomcMedian: Cycle %u → %u valid votes, median R=%u (clamped to %u)\n",
+             cycleId, histogram.nTotal, median, R_MAX_dynamic);
 
     return median;
 }
@@ -375,6 +347,10 @@ bool UndoFinalizeDomcCycle(
 
     KhuGlobalState prevState;
     if (!db->ReadKHUState(prevCycleBoundary, prevState)) {
+        if (db->IsKHUStatePruned(prevCycleBoundary)) {
+            LogPrintf("ERROR: UndoFinalizeDomcCycle: KHU state at height %u was pruned\n", prevCycleBoundary);
+            return false;
+        }
         // Edge case: If previous state doesn't exist (shouldn't happen in valid chain),
         // fall back to defaults
         LogPrint(BCLog::KHU, "UndoFinalizeDomcCycle: Cannot read state at height %u, falling back to defaults\n",
@@ -7,6 +7,7 @@
 #include "consensus/params.h"
 #include "consensus/validation.h"
 #include "khu/khu_domcdb.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_state.h"
 #include "logging.h"
 #include "script/script.h"
@@ -101,12 +102,15 @@ bool ValidateDomcCommitTx(
     CValidationState& state,
     const KhuGlobalState& khuState,
     uint32_t nHeight,
-    const Consensus::Params& consensusParams
+    const Consensus::Params& consensusParams,
+    const CKHUTxPrecheck* pprecheck
 )
 {
     // Extract commit from transaction
     khu_domc::DomcCommit commit;
-    if (!ExtractDomcCommitFromTx(tx, commit)) {
+    if (pprecheck && pprecheck->fParsed) {
+        commit = pprecheck->domcCommit;
+    } else if (!ExtractDomcCommitFromTx(tx, commit)) {
         return state.Invalid(false, REJECT_INVALID, "bad-domc-commit-format",
                             "Failed to extract DOMC commit from transaction");
     }
@@ -162,12 +166,16 @@ bool ValidateDomcRevealTx(
     CValidationState& state,
     const KhuGlobalState& khuState,
     uint32_t nHeight,
-    const Consensus::Params& consensusParams
+    const Consensus::Params& consensusParams,
+    const CKHUTxPrecheck* pprecheck
 )
 {
     // Extract reveal from transaction
     khu_domc::DomcReveal reveal;
-    if (!ExtractDomcRevealFromTx(tx, reveal)) {
+    const bool fPrechecked = pprecheck && pprecheck->fParsed;
+    if (fPrechecked) {
+        reveal = pprecheck->domcReveal;
+    } else if (!ExtractDomcRevealFromTx(tx, reveal)) {
         return state.Invalid(false, REJECT_INVALID, "bad-domc-reveal-format",
                             "Failed to extract DOMC reveal from transaction");
     }
@@ -204,7 +212,7 @@ bool ValidateDomcRevealTx(
     }
 
     // RULE 4: Hash(R + salt) must match commit hash
-    uint256 revealHash = reveal.GetCommitHash();
+    uint256 revealHash = fPrechecked ? pprecheck->hashReveal : reveal.GetCommitHash();
     if (revealHash != commit.hashCommit) {
         return state.Invalid(false, REJECT_INVALID, "domc-reveal-hash-mismatch",
                             strprintf("Reveal hash does not match commit (expected=%s, got=%s)",
@@ -246,10 +254,12 @@ bool ValidateDomcRevealTx(
 // APPLY functions (store to database)
 // ============================================================================
 
-bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight)
+bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight, const CKHUTxPrecheck* pprecheck)
 {
     khu_domc::DomcCommit commit;
-    if (!ExtractDomcCommitFromTx(tx, commit)) {
+    if (pprecheck && pprecheck->fParsed) {
+        commit = pprecheck->domcCommit;
+    } else if (!ExtractDomcCommitFromTx(tx, commit)) {
         LogPrintf("ERROR: ApplyDomcCommitTx: Failed to extract commit from tx %s\n",
                   tx.GetHash().ToString());
         return false;
@@ -268,7 +278,7 @@ bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight)
         return false;
     }
 
-    // Add masternode to cycle index (for GetRevealsForCycle)
+    // Add masternode to cycle index (for GetMasternodesForCycle)
     if (!domcDB->AddMasternodeToCycleIndex(commit.nCycleId, commit.mnOutpoint)) {
         LogPrintf("ERROR: ApplyDomcCommitTx: Failed to add MN to cycle index (MN=%s, cycle=%u)\n",
                   commit.mnOutpoint.ToString(), commit.nCycleId);
@@ -281,10 +291,12 @@ bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight)
     return true;
 }
 
-bool ApplyDomcRevealTx(const CTransaction& tx, uint32_t nHeight)
+bool ApplyDomcRevealTx(const CTransaction& tx, uint32_t nHeight, const CKHUTxPrecheck* pprecheck)
 {
     khu_domc::DomcReveal reveal;
-    if (!ExtractDomcRevealFromTx(tx, reveal)) {
+    if (pprecheck && pprecheck->fParsed) {
+        reveal = pprecheck->domcReveal;
+    } else if (!ExtractDomcRevealFromTx(tx, reveal)) {
         LogPrintf("ERROR: ApplyDomcRevealTx: Failed to extract reveal from tx %s\n",
                   tx.GetHash().ToString());
         return false;
@@ -12,6 +12,7 @@
 
 // Forward declarations
 class CValidationState;
+struct CKHUTxPrecheck;
 struct KhuGlobalState;
 namespace Consensus { struct Params; }
 
@@ -72,6 +73,7 @@ bool ExtractDomcRevealFromTx(const CTransaction& tx, khu_domc::DomcReveal& revea
  * @param khuState Current KHU global state (for cycle info)
  * @param nHeight Current block height
  * @param consensusParams Consensus parameters
+ * @param pprecheck Optional ConnectBlock pre-validation result (decoded vote)
  * @return true if valid, false otherwise (sets state.Invalid)
  */
 bool ValidateDomcCommitTx(
@@ -79,7 +81,8 @@ bool ValidateDomcCommitTx(
     CValidationState& state,
     const KhuGlobalState& khuState,
     uint32_t nHeight,
-    const Consensus::Params& consensusParams
+    const Consensus::Params& consensusParams,
+    const CKHUTxPrecheck* pprecheck = nullptr
 );
 
 /**
@@ -98,6 +101,7 @@ bool ValidateDomcCommitTx(
  * @param khuState Current KHU global state (for cycle info, R_MAX)
  * @param nHeight Current block height
  * @param consensusParams Consensus parameters
+ * @param pprecheck Optional ConnectBlock pre-validation result (decoded vote)
  * @return true if valid, false otherwise (sets state.Invalid)
  */
 bool ValidateDomcRevealTx(
@@ -105,7 +109,8 @@ bool ValidateDomcRevealTx(
     CValidationState& state,
     const KhuGlobalState& khuState,
     uint32_t nHeight,
-    const Consensus::Params& consensusParams
+    const Consensus::Params& consensusParams,
+    const CKHUTxPrecheck* pprecheck = nullptr
 );
 
 /**
@@ -115,9 +120,10 @@ bool ValidateDomcRevealTx(
  *
  * @param tx Transaction containing commit
  * @param nHeight Current block height
+ * @param pprecheck Optional ConnectBlock pre-validation result (decoded vote)
  * @return true on success, false on error
  */
-bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight);
+bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight, const CKHUTxPrecheck* pprecheck = nullptr);
 
 /**
  * ApplyDomcRevealTx - Apply DOMC reveal to database
@@ -126,9 +132,10 @@ bool ApplyDomcCommitTx(const CTransaction& tx, uint32_t nHeight);
  *
  * @param tx Transaction containing reveal
  * @param nHeight Current block height
+ * @param pprecheck Optional ConnectBlock pre-validation result (decoded vote)
  * @return true on success, false on error
  */
-bool ApplyDomcRevealTx(const CTransaction& tx, uint32_t nHeight);
+bool ApplyDomcRevealTx(const CTransaction& tx, uint32_t nHeight, const CKHUTxPrecheck* pprecheck = nullptr);
 
 /**
  * UndoDomcCommitTx - Undo DOMC commit (for reorg)
@@ -7,23 +7,89 @@
 #include "logging.h"
 #include "util/system.h"
 
+#include <assert.h>
 #include <memory>
 
 // Database key prefixes
 static const char DB_DOMC = 'D';
-static const char DB_DOMC_COMMIT = 'C';
-static const char DB_DOMC_REVEAL = 'R';
-static const char DB_DOMC_INDEX = 'I';
+static const char DB_DOMC_COMMIT = 'c';
+static const char DB_DOMC_REVEAL = 'r';
+static const char DB_DOMC_VOTER = 'v';
+static const char DB_DOMC_RHIST = 'h';
+
+// Pre cycle-major layout (see UpgradeVoteLayout)
+static const char DB_DOMC_LEGACY_COMMIT = 'C';
+static const char DB_DOMC_LEGACY_REVEAL = 'R';
+static const char DB_DOMC_LEGACY_INDEX = 'I';
 
 // Global DOMC database instance
 static std::unique_ptr<CKHUDomcDB> pkhudomcdb;
 
+template <typename T>
+static std::pair<char, std::pair<char, std::pair<uint32_t, T>>> CycleKey(char type, uint32_t cycleId, const T& subKey)
+{
+    return std::make_pair(DB_DOMC, std::make_pair(type, std::make_pair(cycleId, subKey)));
+}
+
+/**
+ * Visit the keys 'D' + type + cycleId + T of one cycle.
+ * fn(cursor, subKey) returns false to stop early.
+ */
+template <typename T, typename Callback>
+static void ForEachInCycle(CKHUDomcDB& db, char type, uint32_t cycleId, const T& first, Callback&& fn)
+{
+    LOCK(db.cs);
+    std::unique_ptr<CKHUDBWrapper::Iterator> pcursor(db.NewIterator());
+    pcursor->Seek(CycleKey(type, cycleId, first));
+
+    while (pcursor->Valid()) {
+        std::pair<char, std::pair<char, std::pair<uint32_t, T>>> key;
+        if (!pcursor->GetKey(key) || key.first != DB_DOMC || key.second.first != type ||
+            key.second.second.first != cycleId) {
+            break;
+        }
+        if (!fn(*pcursor, key.second.second.second)) {
+            break;
+        }
+        pcursor->Next();
+    }
+}
+
+// Lowest outpoint in key order (COutPoint() has n = UINT32_MAX)
+static const COutPoint FIRST_OUTPOINT(UINT256_ZERO, 0);
+
+// ============================================================================
+// CDomcRHistogram implementation
+// ============================================================================
+
+void CDomcRHistogram::Add(uint16_t nR, uint32_t nCount)
+{
+    mapBuckets[nR] += nCount;
+    nTotal += nCount;
+}
+
+uint16_t CDomcRHistogram::GetMedian() const
+{
+    assert(nTotal > 0);
+    // Floor index, as proposals[proposals.size() / 2] once sorted
+    const uint32_t nIndex = nTotal / 2;
+    uint32_t nSeen = 0;
+    for (const auto& bucket : mapBuckets) {
+        nSeen += bucket.second;
+        if (nSeen > nIndex) {
+            return bucket.first;
+        }
+    }
+    assert(false);
+    return 0;
+}
+
 // ============================================================================
 // CKHUDomcDB implementation
 // ============================================================================
 
 CKHUDomcDB::CKHUDomcDB(size_t nCacheSize, bool fMemory, bool fWipe) :
-    CDBWrapper(GetDataDir() / "khu" / "domc", nCacheSize, fMemory, fWipe)
+    CKHUDBWrapper(GetDataDir() / "khu" / "domc", nCacheSize, fMemory, fWipe)
 {
 }
 
@@ -33,73 +99,71 @@ CKHUDomcDB::CKHUDomcDB(size_t nCacheSize, bool fMemory, bool fWipe) :
 
 bool CKHUDomcDB::WriteCommit(const khu_domc::DomcCommit& commit)
 {
-    // Key: 'D' + 'C' + mnOutpoint + cycleId
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_COMMIT,
-                                           std::make_pair(commit.mnOutpoint, commit.nCycleId)));
-    return Write(key, commit);
+    return Write(CycleKey(DB_DOMC_COMMIT, commit.nCycleId, commit.mnOutpoint), commit);
 }
 
 bool CKHUDomcDB::ReadCommit(const COutPoint& mnOutpoint, uint32_t cycleId,
                             khu_domc::DomcCommit& commit)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_COMMIT,
-                                           std::make_pair(mnOutpoint, cycleId)));
-    return Read(key, commit);
+    return Read(CycleKey(DB_DOMC_COMMIT, cycleId, mnOutpoint), commit);
 }
 
 bool CKHUDomcDB::HaveCommit(const COutPoint& mnOutpoint, uint32_t cycleId)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_COMMIT,
-                                           std::make_pair(mnOutpoint, cycleId)));
-    return Exists(key);
+    return Exists(CycleKey(DB_DOMC_COMMIT, cycleId, mnOutpoint));
 }
 
 bool CKHUDomcDB::EraseCommit(const COutPoint& mnOutpoint, uint32_t cycleId)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_COMMIT,
-                                           std::make_pair(mnOutpoint, cycleId)));
-    return Erase(key);
+    return Erase(CycleKey(DB_DOMC_COMMIT, cycleId, mnOutpoint));
 }
 
 // ============================================================================
 // REVEAL operations
 // ============================================================================
 
+bool CKHUDomcDB::AddToRHistogram(uint32_t cycleId, uint16_t nR, int nDelta)
+{
+    const auto key = CycleKey(DB_DOMC_RHIST, cycleId, nR);
+    uint32_t nCount = 0;
+    Read(key, nCount);
+    if (nDelta < 0 && nCount < (uint32_t)-nDelta) {
+        return error("%s: R histogram underflow (cycle=%u, R=%u)", __func__, cycleId, nR);
+    }
+    nCount += nDelta;
+    return nCount == 0 ? Erase(key) : Write(key, nCount);
+}
+
 bool CKHUDomcDB::WriteReveal(const khu_domc::DomcReveal& reveal)
 {
-    // Key: 'D' + 'R' + mnOutpoint + cycleId
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_REVEAL,
-                                           std::make_pair(reveal.mnOutpoint, reveal.nCycleId)));
-    return Write(key, reveal);
+    LOCK(cs);
+    const auto key = CycleKey(DB_DOMC_REVEAL, reveal.nCycleId, reveal.mnOutpoint);
+    khu_domc::DomcReveal prev;
+    if (Read(key, prev) && !AddToRHistogram(prev.nCycleId, prev.nRProposal, -1)) {
+        return false;
+    }
+    return Write(key, reveal) && AddToRHistogram(reveal.nCycleId, reveal.nRProposal, 1);
 }
 
 bool CKHUDomcDB::ReadReveal(const COutPoint& mnOutpoint, uint32_t cycleId,
                             khu_domc::DomcReveal& reveal)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_REVEAL,
-                                           std::make_pair(mnOutpoint, cycleId)));
-    return Read(key, reveal);
+    return Read(CycleKey(DB_DOMC_REVEAL, cycleId, mnOutpoint), reveal);
 }
 
 bool CKHUDomcDB::HaveReveal(const COutPoint& mnOutpoint, uint32_t cycleId)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_REVEAL,
-                                           std::make_pair(mnOutpoint, cycleId)));
-    return Exists(key);
+    return Exists(CycleKey(DB_DOMC_REVEAL, cycleId, mnOutpoint));
 }
 
 bool CKHUDomcDB::EraseReveal(const COutPoint& mnOutpoint, uint32_t cycleId)
 {
-    auto key = std::make_pair(DB_DOMC,
-                              std::make_pair(DB_DOMC_REVEAL,
-                                           std::make_pair(mnOutpoint, cycleId)));
+    LOCK(cs);
+    const auto key = CycleKey(DB_DOMC_REVEAL, cycleId, mnOutpoint);
+    khu_domc::DomcReveal prev;
+    if (Read(key, prev) && !AddToRHistogram(cycleId, prev.nRProposal, -1)) {
+        return false;
+    }
     return Erase(key);
 }
 
@@ -109,78 +173,95 @@ bool CKHUDomcDB::EraseReveal(const COutPoint& mnOutpoint, uint32_t cycleId)
 
 bool CKHUDomcDB::AddMasternodeToCycleIndex(uint32_t cycleId, const COutPoint& mnOutpoint)
 {
-    // Read existing index
-    std::vector<COutPoint> mnOutpoints;
-    GetMasternodesForCycle(cycleId, mnOutpoints);
-
-    // Check if already in index
-    for (const auto& existing : mnOutpoints) {
-        if (existing == mnOutpoint) {
-            return true; // Already indexed
-        }
-    }
-
-    // Add to index
-    mnOutpoints.push_back(mnOutpoint);
-
-    // Write updated index
-    auto key = std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_INDEX, cycleId));
-    return Write(key, mnOutpoints);
+    return Write(CycleKey(DB_DOMC_VOTER, cycleId, mnOutpoint), (uint8_t)1);
 }
 
 bool CKHUDomcDB::GetMasternodesForCycle(uint32_t cycleId, std::vector<COutPoint>& mnOutpoints)
 {
-    auto key = std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_INDEX, cycleId));
-    return Read(key, mnOutpoints);
+    mnOutpoints.clear();
+    ForEachInCycle(*this, DB_DOMC_VOTER, cycleId, FIRST_OUTPOINT,
+        [&](CKHUDBWrapper::Iterator& cursor, const COutPoint& mnOutpoint) {
+            mnOutpoints.push_back(mnOutpoint);
+            return true;
+        });
+    return !mnOutpoints.empty();
 }
 
 bool CKHUDomcDB::GetRevealsForCycle(uint32_t cycleId, std::vector<khu_domc::DomcReveal>& reveals)
 {
     reveals.clear();
-
-    // Get list of masternodes that participated in this cycle
-    std::vector<COutPoint> mnOutpoints;
-    if (!GetMasternodesForCycle(cycleId, mnOutpoints)) {
-        return false; // No masternodes in this cycle
-    }
-
-    // Collect reveals from all masternodes
-    for (const auto& mnOutpoint : mnOutpoints) {
-        khu_domc::DomcReveal reveal;
-        if (ReadReveal(mnOutpoint, cycleId, reveal)) {
-            reveals.push_back(reveal);
-        }
-    }
-
+    ForEachInCycle(*this, DB_DOMC_REVEAL, cycleId, FIRST_OUTPOINT,
+        [&](CKHUDBWrapper::Iterator& cursor, const COutPoint& mnOutpoint) {
+            khu_domc::DomcReveal reveal;
+            if (cursor.GetValue(reveal)) {
+                reveals.push_back(reveal);
+            }
+            return true;
+        });
     return !reveals.empty();
 }
 
-bool CKHUDomcDB::EraseCycleIndex(uint32_t cycleId)
+bool CKHUDomcDB::GetRHistogram(uint32_t cycleId, CDomcRHistogram& histogram)
 {
-    auto key = std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_INDEX, cycleId));
-    return Erase(key);
+    histogram = CDomcRHistogram();
+    ForEachInCycle(*this, DB_DOMC_RHIST, cycleId, (uint16_t)0,
+        [&](CKHUDBWrapper::Iterator& cursor, const uint16_t& nR) {
+            uint32_t nCount = 0;
+            if (cursor.GetValue(nCount) && nCount > 0) {
+                histogram.Add(nR, nCount);
+            }
+            return true;
+        });
+    return !histogram.IsEmpty();
 }
 
-bool CKHUDomcDB::EraseCycleData(uint32_t cycleId)
+bool CKHUDomcDB::EraseCycleIndex(uint32_t cycleId)
 {
-    // Get list of masternodes that participated in this cycle
     std::vector<COutPoint> mnOutpoints;
-    bool hasIndex = GetMasternodesForCycle(cycleId, mnOutpoints);
-
-    if (hasIndex) {
-        // Erase all commits and reveals for this cycle
-        for (const auto& mnOutpoint : mnOutpoints) {
-            // Erase commit (if exists)
-            EraseCommit(mnOutpoint, cycleId);
-
-            // Erase reveal (if exists)
-            EraseReveal(mnOutpoint, cycleId);
-        }
+    GetMasternodesForCycle(cycleId, mnOutpoints);
+    for (const auto& mnOutpoint : mnOutpoints) {
+        Erase(CycleKey(DB_DOMC_VOTER, cycleId, mnOutpoint));
+    }
+    return true;
+}
 
-        LogPrint(BCLog::KHU, "EraseCycleData: Erased %zu commits/reveals for cycle %u\n",
-                 mnOutpoints.size(), cycleId);
+bool CKHUDomcDB::EraseCycleData(uint32_t cycleId)
+{
+    LOCK(cs);
+
+    // Collect first: the cursor must not see its own erasures
+    std::vector<COutPoint> vCommits;
+    std::vector<COutPoint> vReveals;
+    std::vector<uint16_t> vBuckets;
+    ForEachInCycle(*this, DB_DOMC_COMMIT, cycleId, FIRST_OUTPOINT,
+        [&](CKHUDBWrapper::Iterator& cursor, const COutPoint& mnOutpoint) {
+            vCommits.push_back(mnOutpoint);
+            return true;
+        });
+    ForEachInCycle(*this, DB_DOMC_REVEAL, cycleId, FIRST_OUTPOINT,
+        [&](CKHUDBWrapper::Iterator& cursor, const COutPoint& mnOutpoint) {
+            vReveals.push_back(mnOutpoint);
+            return true;
+        });
+    ForEachInCycle(*this, DB_DOMC_RHIST, cycleId, (uint16_t)0,
+        [&](CKHUDBWrapper::Iterator& cursor, const uint16_t& nR) {
+            vBuckets.push_back(nR);
+            return true;
+        });
+
+    for (const auto& mnOutpoint : vCommits) {
+        Erase(CycleKey(DB_DOMC_COMMIT, cycleId, mnOutpoint));
+    }
+    for (const auto& mnOutpoint : vReveals) {
+        Erase(CycleKey(DB_DOMC_REVEAL, cycleId, mnOutpoint));
+    }
+    for (const uint16_t nR : vBuckets) {
+        Erase(CycleKey(DB_DOMC_RHIST, cycleId, nR));
     }
 
+    LogPrint(BCLog::KHU, "EraseCycleData: Erased %zu commits/%zu reveals for cycle %u\n",
+             vCommits.size(), vReveals.size(), cycleId);
+
     // Erase the cycle index
     bool result = EraseCycleIndex(cycleId);
 
@@ -191,15 +272,74 @@ bool CKHUDomcDB::EraseCycleData(uint32_t cycleId)
     return result;
 }
 
+bool CKHUDomcDB::UpgradeVoteLayout()
+{
+    LOCK(cs);
+
+    // Legacy per-cycle lists: 'D' + 'I' + cycleId -> std::vector<COutPoint>
+    std::vector<std::pair<uint32_t, std::vector<COutPoint>>> vLegacy;
+    {
+        std::unique_ptr<Iterator> pcursor(NewIterator());
+        pcursor->Seek(std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_LEGACY_INDEX, (uint32_t)0)));
+        while (pcursor->Valid()) {
+            std::pair<char, std::pair<char, uint32_t>> key;
+            if (!pcursor->GetKey(key) || key.first != DB_DOMC || key.second.first != DB_DOMC_LEGACY_INDEX) {
+                break;
+            }
+            std::vector<COutPoint> mnOutpoints;
+            if (pcursor->GetValue(mnOutpoints)) {
+                vLegacy.emplace_back(key.second.second, std::move(mnOutpoints));
+            }
+            pcursor->Next();
+        }
+    }
+    if (vLegacy.empty()) {
+        return true;
+    }
+
+    size_t nVotes = 0;
+    CKHUDBScopedCommitter dbTx({this});
+    for (const auto& it : vLegacy) {
+        const uint32_t cycleId = it.first;
+        for (const COutPoint& mnOutpoint : it.second) {
+            const auto legacyCommitKey = std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_LEGACY_COMMIT, std::make_pair(mnOutpoint, cycleId)));
+            const auto legacyRevealKey = std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_LEGACY_REVEAL, std::make_pair(mnOutpoint, cycleId)));
+            khu_domc::DomcCommit commit;
+            if (Read(legacyCommitKey, commit)) {
+                WriteCommit(commit);
+                Erase(legacyCommitKey);
+                nVotes++;
+            }
+            khu_domc::DomcReveal reveal;
+            if (Read(legacyRevealKey, reveal)) {
+                WriteReveal(reveal);
+                Erase(legacyRevealKey);
+                nVotes++;
+            }
+            AddMasternodeToCycleIndex(cycleId, mnOutpoint);
+        }
+        Erase(std::make_pair(DB_DOMC, std::make_pair(DB_DOMC_LEGACY_INDEX, cycleId)));
+    }
+    dbTx.Commit();
+
+    LogPrintf("KHU: Converted %zu DOMC votes of %zu cycles to the cycle-major layout\n",
+              nVotes, vLegacy.size());
+    return CommitRootTransaction();
+}
+
 // ============================================================================
 // Global accessor functions
 // ============================================================================
 
-bool InitKHUDomcDB(size_t nCacheSize, bool fReindex)
+bool InitKHUDomcDB(size_t nCacheSize, bool fReindex, bool fMemory)
 {
     try {
         pkhudomcdb.reset();
-        pkhudomcdb = std::make_unique<CKHUDomcDB>(nCacheSize, false, fReindex);
+        pkhudomcdb = std::make_unique<CKHUDomcDB>(nCacheSize, fMemory, fReindex);
+        if (!pkhudomcdb->UpgradeVoteLayout()) {
+            LogPrintf("ERROR: Failed to upgrade KHU DOMC vote layout\n");
+            return false;
+        }
         LogPrint(BCLog::KHU, "KHU: Initialized DOMC database (Phase 6.2 Governance)\n");
         return true;
     } catch (const std::exception& e) {
@@ -5,30 +5,55 @@
 #ifndef PIVX_KHU_DOMCDB_H
 #define PIVX_KHU_DOMCDB_H
 
-#include "dbwrapper.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/khu_domc.h"
 #include "primitives/transaction.h"
 
+#include <map>
 #include <stdint.h>
 #include <vector>
 
+/**
+ * CDomcRHistogram - Distribution of the revealed R proposals of a cycle
+ *
+ * One bucket per distinct R value (basis points). GetMedian() returns the
+ * same floor index as sorting every proposal: sorted[n / 2].
+ */
+class CDomcRHistogram
+{
+public:
+    std::map<uint16_t, uint32_t> mapBuckets;
+    uint32_t nTotal{0};
+
+    void Add(uint16_t nR, uint32_t nCount = 1);
+    bool IsEmpty() const { return nTotal == 0; }
+    uint16_t GetMedian() const;
+};
+
 /**
  * CKHUDomcDB - LevelDB persistence layer for DOMC votes
  *
  * Phase 6.2: Stores DOMC commit/reveal votes from masternodes
  *
- * DATABASE KEYS:
- * - 'D' + 'C' + mnOutpoint + cycleId -> DomcCommit (commit vote)
- * - 'D' + 'R' + mnOutpoint + cycleId -> DomcReveal (reveal vote)
- * - 'D' + 'I' + cycleId -> std::vector<COutPoint> (index of MNs in cycle)
+ * DATABASE KEYS (cycle-major, so one cycle is a contiguous key range):
+ * - 'D' + 'c' + cycleId + mnOutpoint -> DomcCommit (commit vote)
+ * - 'D' + 'r' + cycleId + mnOutpoint -> DomcReveal (reveal vote)
+ * - 'D' + 'v' + cycleId + mnOutpoint -> uint8_t (MNs that voted in cycle)
+ * - 'D' + 'h' + cycleId + R -> uint32_t (number of reveals proposing R)
+ *
+ * The R histogram is maintained by WriteReveal/EraseReveal, in the same
+ * block transaction as the reveal itself, so the median at the REVEAL
+ * height reads one bucket per distinct R instead of every vote.
+ * Reveals reaching the DB have passed ValidateDomcRevealTx (matching
+ * commit, Hash(R || salt) == commit hash).
  *
  * ARCHITECTURE:
  * - Commits stored during commit phase (cycle_start + 132480 → 152640)
  * - Reveals stored during reveal phase (cycle_start + 152640 → 172800)
- * - At cycle boundary: read all reveals, calculate median(R)
+ * - At cycle boundary: median(R) from the cycle histogram
  * - Reorg support: erase votes when unwinding blocks
  */
-class CKHUDomcDB : public CDBWrapper
+class CKHUDomcDB : public CKHUDBWrapper
 {
 public:
     explicit CKHUDomcDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
@@ -45,7 +70,7 @@ public:
     /**
      * WriteCommit - Store DOMC commit vote
      *
-     * Key: 'D' + 'C' + mnOutpoint + cycleId
+     * Key: 'D' + 'c' + cycleId + mnOutpoint
      *
      * @param commit Commit to store
      * @return true on success, false on failure
@@ -88,7 +113,9 @@ public:
     /**
      * WriteReveal - Store DOMC reveal vote
      *
-     * Key: 'D' + 'R' + mnOutpoint + cycleId
+     * Key: 'D' + 'r' + cycleId + mnOutpoint
+     * Also moves the vote into its R histogram bucket (replacing a previous
+     * reveal of the same MN, if any).
      *
      * @param reveal Reveal to store
      * @return true on success, false on failure
@@ -118,6 +145,8 @@ public:
     /**
      * EraseReveal - Delete reveal (for reorg)
      *
+     * Also removes the vote from the R histogram.
+     *
      * @param mnOutpoint Masternode collateral outpoint
      * @param cycleId Cycle ID
      * @return true on success
@@ -131,8 +160,8 @@ public:
     /**
      * AddMasternodeToCycleIndex - Add masternode to cycle index
      *
-     * Maintains list of masternodes that voted in a cycle.
-     * Used for GetRevealsForCycle() to efficiently collect all reveals.
+     * Maintains the set of masternodes that voted in a cycle, one key per
+     * masternode (idempotent, no read-modify-write of the whole list).
      *
      * @param cycleId Cycle ID
      * @param mnOutpoint Masternode collateral outpoint
@@ -144,16 +173,15 @@ public:
      * GetMasternodesForCycle - Get list of masternodes in cycle
      *
      * @param cycleId Cycle ID
-     * @param mnOutpoints Output parameter for masternode list
-     * @return true if index exists, false otherwise
+     * @param mnOutpoints Output parameter for masternode list (key order)
+     * @return true if at least one masternode is indexed, false otherwise
      */
     bool GetMasternodesForCycle(uint32_t cycleId, std::vector<COutPoint>& mnOutpoints);
 
     /**
-     * GetRevealsForCycle - Collect all valid reveals for a cycle
+     * GetRevealsForCycle - Collect all reveals for a cycle
      *
-     * Used by CalculateDomcMedian() to gather R proposals.
-     * Returns only reveals that have matching commits.
+     * Range scan of the cycle's reveal keys.
      *
      * @param cycleId Cycle ID (cycle start height)
      * @param reveals Output parameter for reveal list
@@ -161,6 +189,17 @@ public:
      */
     bool GetRevealsForCycle(uint32_t cycleId, std::vector<khu_domc::DomcReveal>& reveals);
 
+    /**
+     * GetRHistogram - Load the R histogram of a cycle
+     *
+     * Used by CalculateDomcMedian().
+     *
+     * @param cycleId Cycle ID (cycle start height)
+     * @param histogram Output parameter
+     * @return true if any reveal is counted, false if none
+     */
+    bool GetRHistogram(uint32_t cycleId, CDomcRHistogram& histogram);
+
     /**
      * EraseCycleIndex - Delete cycle index (for reorg)
      *
@@ -172,13 +211,27 @@ public:
     /**
      * EraseCycleData - Delete all data for a cycle (for reorg)
      *
-     * Removes all commits, reveals, and index for a given cycle.
+     * Removes all commits, reveals, index and histogram for a given cycle.
      * Called by UndoFinalizeDomcCycle to clean up after reorg.
      *
      * @param cycleId Cycle ID (cycle start height)
      * @return true on success, false on failure
      */
     bool EraseCycleData(uint32_t cycleId);
+
+    /**
+     * UpgradeVoteLayout - Rewrite votes stored with the pre cycle-major keys
+     *
+     * Old layout: 'D' + 'C'/'R' + mnOutpoint + cycleId, plus one
+     * 'D' + 'I' + cycleId -> std::vector<COutPoint> list per cycle.
+     * Called once from InitKHUDomcDB; no-op when nothing is left to convert.
+     *
+     * @return true on success
+     */
+    bool UpgradeVoteLayout();
+
+private:
+    bool AddToRHistogram(uint32_t cycleId, uint16_t nR, int nDelta);
 };
 
 // ============================================================================
@@ -192,9 +245,10 @@ public:
  *
  * @param nCacheSize Cache size in bytes
  * @param fReindex True if reindexing
+ * @param fMemory Keep the DB in memory (tests, benchmarks)
  * @return true on success, false on failure
  */
-bool InitKHUDomcDB(size_t nCacheSize, bool fReindex);
+bool InitKHUDomcDB(size_t nCacheSize, bool fReindex, bool fMemory = false);
 
 /**
  * GetKHUDomcDB - Get global DOMC database instance
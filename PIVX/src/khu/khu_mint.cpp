@@ -8,6 +8,7 @@
 #include "consensus/validation.h"
 #include "destination_io.h"
 #include "khu/khu_coins.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_state.h"
 #include "khu/khu_utxo.h"
 #include "logging.h"
@@ -124,14 +125,16 @@ bool CheckKHUMint(const CTransaction& tx, CValidationState& state, const CCoinsV
     return true;
 }
 
-bool ApplyKHUMint(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight)
+bool ApplyKHUMint(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight, const CKHUTxPrecheck* pprecheck)
 {
     // ⚠️ CRITICAL: cs_khu MUST be held
     AssertLockHeld(cs_khu);
 
     // 1. Extract payload
     CMintKHUPayload payload;
-    if (!GetMintKHUPayload(tx, payload)) {
+    if (pprecheck && pprecheck->fParsed) {
+        payload = pprecheck->mint;
+    } else if (!GetMintKHUPayload(tx, payload)) {
         return error("ApplyKHUMint: Failed to extract payload");
     }
 
@@ -13,6 +13,7 @@
 
 class CCoinsViewCache;
 class CValidationState;
+struct CKHUTxPrecheck;
 
 /**
  * MINT Payload (PIV → KHU_T)
@@ -89,9 +90,10 @@ bool CheckKHUMint(const CTransaction& tx, CValidationState& state, const CCoinsV
  * @param[in,out] state   KHU global state (mutated: C+, U+)
  * @param[in,out] view    Coins view (mutated: adds KHU_T UTXO)
  * @param[in]     nHeight Block height
+ * @param[in]     pprecheck Optional ConnectBlock pre-validation result (payload)
  * @return true if application successful
  */
-bool ApplyKHUMint(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight);
+bool ApplyKHUMint(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight, const CKHUTxPrecheck* pprecheck = nullptr);
 
 /**
  * Undo MINT during reorg (Consensus Critical)
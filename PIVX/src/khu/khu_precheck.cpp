@@ -0,0 +1,90 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "khu/khu_precheck.h"
+
+#include "khu/khu_domc_tx.h"
+#include "khu/khu_stake.h"
+#include "primitives/block.h"
+#include "util/system.h"
+#include "validation.h"
+
+static bool IsKHUPrecheckType(int16_t nType)
+{
+    switch (nType) {
+    case CTransaction::TxType::KHU_MINT:
+    case CTransaction::TxType::KHU_REDEEM:
+    case CTransaction::TxType::KHU_STAKE:
+    case CTransaction::TxType::KHU_UNSTAKE:
+    case CTransaction::TxType::KHU_DOMC_COMMIT:
+    case CTransaction::TxType::KHU_DOMC_REVEAL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void PrecheckKHUTransaction(const CTransaction& tx, CKHUTxPrecheck& out)
+{
+    switch (tx.nType) {
+    case CTransaction::TxType::KHU_MINT:
+        out.fParsed = GetMintKHUPayload(tx, out.mint);
+        break;
+    case CTransaction::TxType::KHU_REDEEM:
+        out.fParsed = GetRedeemKHUPayload(tx, out.redeem);
+        break;
+    case CTransaction::TxType::KHU_STAKE:
+        // Same structure and value checks as ApplyKHUStake
+        if (tx.sapData && !tx.sapData->vShieldedOutput.empty() && !tx.vin.empty() &&
+            -tx.sapData->valueBalance >= MIN_STAKE_AMOUNT) {
+            out.stakeAmount = -tx.sapData->valueBalance;
+            out.stakeNullifier = GetZKHUStakeNullifier(tx.sapData->vShieldedOutput[0].cmu);
+            out.fParsed = true;
+        }
+        break;
+    case CTransaction::TxType::KHU_UNSTAKE:
+        // Same structure checks as ApplyKHUUnstake
+        if (tx.sapData && !tx.sapData->vShieldedSpend.empty() &&
+            GetUnstakeKHUPayload(tx, out.unstake)) {
+            out.unstakeNullifier = tx.sapData->vShieldedSpend[0].nullifier;
+            out.fParsed = true;
+        }
+        break;
+    case CTransaction::TxType::KHU_DOMC_COMMIT:
+        out.fParsed = ExtractDomcCommitFromTx(tx, out.domcCommit);
+        break;
+    case CTransaction::TxType::KHU_DOMC_REVEAL:
+        out.fParsed = ExtractDomcRevealFromTx(tx, out.domcReveal);
+        if (out.fParsed) {
+            out.hashReveal = out.domcReveal.GetCommitHash();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void PrecheckKHUBlock(const CBlock& block, std::vector<CKHUTxPrecheck>& vPrecheck)
+{
+    vPrecheck.assign(block.vtx.size(), CKHUTxPrecheck());
+
+    std::vector<CBlockCheck> vChecks;
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        if (IsKHUPrecheckType(block.vtx[i]->nType)) {
+            vChecks.emplace_back(*block.vtx[i], vPrecheck[i]);
+        }
+    }
+    if (vChecks.empty()) {
+        return;
+    }
+
+    // ConnectBlock waited for its script checks before ProcessKHUBlock: the
+    // queue is free. Not worth a round trip through the workers for a single
+    // transaction.
+    if (vChecks.size() > 1) {
+        RunBlockChecks(vChecks);
+    } else {
+        vChecks[0]();
+    }
+}
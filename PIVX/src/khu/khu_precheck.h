@@ -0,0 +1,66 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_KHU_PRECHECK_H
+#define PIVX_KHU_PRECHECK_H
+
+#include "khu/khu_domc.h"
+#include "khu/khu_mint.h"
+#include "khu/khu_redeem.h"
+#include "khu/khu_unstake.h"
+#include "amount.h"
+#include "uint256.h"
+
+#include <vector>
+
+class CBlock;
+
+/**
+ * KHU transaction pre-validation (ConnectBlock)
+ *
+ * The stateless part of every KHU transaction - payload parsing, DOMC
+ * vote decoding and commit hash, STAKE/UNSTAKE Sapling structure and value
+ * checks, deterministic ZKHU nullifier - does not
+ * depend on KhuGlobalState nor on the KHU databases. It is computed for the
+ * whole block up front on the script check worker pool, and the serial
+ * ProcessKHUBlock loop only does the state mutations.
+ *
+ * Results are memoization only: when fParsed is false the Apply/Validate
+ * functions parse again and fail with their usual error, so accept/reject
+ * decisions and reject reasons are unchanged.
+ */
+struct CKHUTxPrecheck
+{
+    //! Payload / vote decoded successfully for this tx type
+    bool fParsed{false};
+
+    CMintKHUPayload mint;
+    CRedeemKHUPayload redeem;
+    CUnstakeKHUPayload unstake;
+
+    khu_domc::DomcCommit domcCommit;
+    khu_domc::DomcReveal domcReveal;
+    //! Hash(R || salt) of domcReveal
+    uint256 hashReveal;
+
+    //! Staked amount (-valueBalance), checked against MIN_STAKE_AMOUNT
+    CAmount stakeAmount{0};
+    //! Deterministic nullifier of the first STAKE output
+    uint256 stakeNullifier;
+
+    //! Sapling nullifier of the first UNSTAKE spend
+    uint256 unstakeNullifier;
+};
+
+/** Run the stateless checks of one transaction (no-op for non-KHU types) */
+void PrecheckKHUTransaction(const CTransaction& tx, CKHUTxPrecheck& out);
+
+/**
+ * Fill vPrecheck (one entry per block.vtx) for every KHU transaction of the
+ * block, in parallel on the script check workers (RunBlockChecks) when they
+ * are running.
+ */
+void PrecheckKHUBlock(const CBlock& block, std::vector<CKHUTxPrecheck>& vPrecheck);
+
+#endif // PIVX_KHU_PRECHECK_H
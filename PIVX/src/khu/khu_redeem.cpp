@@ -8,6 +8,7 @@
 #include "consensus/validation.h"
 #include "destination_io.h"
 #include "khu/khu_coins.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_state.h"
 #include "khu/khu_utxo.h"
 #include "logging.h"
@@ -71,7 +72,7 @@ bool CheckKHURedeem(const CTransaction& tx, CValidationState& state, const CCoin
 
     // 4. Vérifier inputs KHU_T suffisants
     // NOTE: Per CLAUDE.md §2.1, REDEEM tx has KHU inputs + optional PIV input for fee.
-    // Only count inputs that are actually KHU coins (exist in mapKHUUTXOs).
+    // Only count inputs that are actually KHU coins (exist in the KHU coins view).
     // PIV fee inputs are NOT in the KHU tracking and should be skipped.
     CAmount total_input = 0;
     for (const auto& in : tx.vin) {
@@ -123,14 +124,16 @@ bool CheckKHURedeem(const CTransaction& tx, CValidationState& state, const CCoin
     return true;
 }
 
-bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight)
+bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight, const CKHUTxPrecheck* pprecheck)
 {
     // ⚠️ CRITICAL: cs_khu MUST be held
     AssertLockHeld(cs_khu);
 
     // 1. Extract payload
     CRedeemKHUPayload payload;
-    if (!GetRedeemKHUPayload(tx, payload)) {
+    if (pprecheck && pprecheck->fParsed) {
+        payload = pprecheck->redeem;
+    } else if (!GetRedeemKHUPayload(tx, payload)) {
         return error("ApplyKHURedeem: Failed to extract payload");
     }
 
@@ -168,7 +171,7 @@ bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCac
 
     // 6. Dépenser UTXO KHU_T
     // NOTE: Per CLAUDE.md §2.1, REDEEM tx has KHU inputs + 1 PIV input for fee.
-    // Only spend inputs that are actually KHU coins (exist in mapKHUUTXOs).
+    // Only spend inputs that are actually KHU coins (exist in the KHU coins view).
     // PIV fee inputs are NOT in the KHU tracking and should be skipped.
 
     LogPrint(BCLog::KHU, "%s: processing tx %s with %zu inputs\n",
@@ -190,7 +193,7 @@ bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCac
                      __func__, in.prevout.hash.ToString().substr(0,16).c_str(), in.prevout.n,
                      FormatMoney(khuCoin.amount));
         }
-        // PIV fee inputs are silently skipped - they're not in mapKHUUTXOs
+        // PIV fee inputs are silently skipped - they're not in the KHU coins view
     }
 
     LogPrint(BCLog::KHU, "%s: totalKHUSpent=%s, required=%s\n",
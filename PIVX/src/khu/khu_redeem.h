@@ -13,6 +13,7 @@
 
 class CCoinsViewCache;
 class CValidationState;
+struct CKHUTxPrecheck;
 
 /**
  * REDEEM Payload (KHU_T → PIV)
@@ -91,9 +92,10 @@ bool CheckKHURedeem(const CTransaction& tx, CValidationState& state, const CCoin
  * @param[in,out] state   KHU global state (mutated: C-, U-)
  * @param[in,out] view    Coins view (mutated: spends KHU_T, creates PIV)
  * @param[in]     nHeight Block height
+ * @param[in]     pprecheck Optional ConnectBlock pre-validation result (payload)
  * @return true if application successful
  */
-bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight);
+bool ApplyKHURedeem(const CTransaction& tx, KhuGlobalState& state, CCoinsViewCache& view, uint32_t nHeight, const CKHUTxPrecheck* pprecheck = nullptr);
 
 /**
  * Undo REDEEM during reorg (Consensus Critical)
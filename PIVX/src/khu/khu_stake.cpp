@@ -9,8 +9,10 @@
 #include "consensus/validation.h"
 #include "hash.h"
 #include "khu/khu_coins.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_utxo.h"
 #include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
 #include "khu/zkhu_db.h"
 #include "khu/zkhu_memo.h"
 #include "khu/zkhu_note.h"
@@ -97,58 +99,74 @@ bool CheckKHUStake(
     return true;
 }
 
+uint256 GetZKHUStakeNullifier(const uint256& cm)
+{
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << cm;
+    ss << std::string("ZKHU-NULLIFIER-V1");
+    return ss.GetHash();
+}
+
 bool ApplyKHUStake(
     const CTransaction& tx,
     CCoinsViewCache& view,
     KhuGlobalState& state,
-    int nHeight)
+    int nHeight,
+    const CKHUTxPrecheck* pprecheck)
 {
     // CRITICAL: cs_khu MUST be held to prevent race conditions
     AssertLockHeld(cs_khu);
 
-    // 1. Validate transaction has Sapling data
-    if (!tx.sapData) {
-        return error("%s: STAKE tx missing Sapling data", __func__);
-    }
+    // 1-4. Sapling structure and value checks, staked amount and nullifier.
+    // Already done by the ConnectBlock pre-validation pass when available.
+    const bool fPrechecked = pprecheck && pprecheck->fParsed;
+    CAmount amount;
+    uint256 cm;
+    uint256 nullifier;
+    if (fPrechecked) {
+        amount = pprecheck->stakeAmount;
+        cm = tx.sapData->vShieldedOutput[0].cmu;
+        nullifier = pprecheck->stakeNullifier;
+    } else {
+        // 1. Validate transaction has Sapling data
+        if (!tx.sapData) {
+            return error("%s: STAKE tx missing Sapling data", __func__);
+        }
 
-    if (tx.sapData->vShieldedOutput.empty()) {
-        return error("%s: STAKE tx has no shielded outputs", __func__);
-    }
+        if (tx.sapData->vShieldedOutput.empty()) {
+            return error("%s: STAKE tx has no shielded outputs", __func__);
+        }
 
-    // 2. Get input amount from the transaction outputs
-    // NOTE: Standard tx validation already spent the UTXO from the view.
-    // We get the amount from the Sapling output + fee calculation
-    if (tx.vin.empty()) {
-        return error("%s: STAKE tx has no inputs", __func__);
-    }
+        // 2. Get input amount from the transaction outputs
+        // NOTE: Standard tx validation already spent the UTXO from the view.
+        // We get the amount from the Sapling output + fee calculation
+        if (tx.vin.empty()) {
+            return error("%s: STAKE tx has no inputs", __func__);
+        }
 
-    // 2. Get the staked amount from Sapling valueBalance
-    // valueBalance = sum(spends) - sum(outputs)
-    // For STAKE: no spends, one output → valueBalance = -stakedAmount
-    // So stakedAmount = -valueBalance
-    CAmount amount = -tx.sapData->valueBalance;
-    if (amount <= 0) {
-        return error("%s: invalid stake amount from valueBalance: %d", __func__, amount);
-    }
+        // 2. Get the staked amount from Sapling valueBalance
+        // valueBalance = sum(spends) - sum(outputs)
+        // For STAKE: no spends, one output → valueBalance = -stakedAmount
+        // So stakedAmount = -valueBalance
+        amount = -tx.sapData->valueBalance;
+        if (amount <= 0) {
+            return error("%s: invalid stake amount from valueBalance: %d", __func__, amount);
+        }
 
-    // 2b. Anti-spam: Minimum stake amount (redundant with CheckKHUStake, but safe)
-    if (amount < MIN_STAKE_AMOUNT) {
-        return error("%s: stake amount %s below minimum %s",
-                    __func__, FormatMoney(amount), FormatMoney(MIN_STAKE_AMOUNT));
-    }
+        // 2b. Anti-spam: Minimum stake amount (redundant with CheckKHUStake, but safe)
+        if (amount < MIN_STAKE_AMOUNT) {
+            return error("%s: stake amount %s below minimum %s",
+                        __func__, FormatMoney(amount), FormatMoney(MIN_STAKE_AMOUNT));
+        }
 
-    LogPrint(BCLog::KHU, "%s: Stake amount from valueBalance: %d satoshis\n", __func__, amount);
+        // 3. Extract Sapling output (commitment)
+        cm = tx.sapData->vShieldedOutput[0].cmu;  // Commitment = noteId
 
-    // 3. Extract Sapling output (commitment)
-    const OutputDescription& saplingOut = tx.sapData->vShieldedOutput[0];
-    uint256 cm = saplingOut.cmu;  // Commitment = noteId
+        // 4. Calculate deterministic nullifier (Phase 5 simplification)
+        nullifier = GetZKHUStakeNullifier(cm);
+    }
 
-    // 4. Calculate deterministic nullifier (Phase 5 simplification)
-    // Phase 6+: Use real Sapling nullifier derivation
-    CHashWriter ss(SER_GETHASH, 0);
-    ss << cm;
-    ss << std::string("ZKHU-NULLIFIER-V1");
-    uint256 nullifier = ss.GetHash();
+    LogPrint(BCLog::KHU, "%s: Stake amount from valueBalance: %d satoshis\n", __func__, amount);
 
     // 5. Create ZKHU note data (Ur_accumulated = 0 in Phase 5)
     ZKHUNoteData noteData(
@@ -174,6 +192,11 @@ bool ApplyKHUStake(
         return error("%s: failed to write nullifier mapping", __func__);
     }
 
+    // 7b. Snapshot the note into the lazy yield accumulator (first mature yield event)
+    if (!khu_yield::AddNoteToYieldIndex(cm, noteData)) {
+        return error("%s: failed to add note to yield index", __func__);
+    }
+
     // TODO Phase 6: Update Merkle tree
     // zkhuTree.append(cm);
     // uint256 newRoot = zkhuTree.root();
@@ -181,7 +204,7 @@ bool ApplyKHUStake(
     //     return error("%s: failed to write anchor", __func__);
     // }
 
-    // 8. ✅ CRITICAL: Spend KHU inputs from mapKHUUTXOs
+    // 8. ✅ CRITICAL: Spend KHU inputs from the KHU coins view
     // STAKE tx has KHU_T inputs that need to be spent in consensus tracking
     for (const auto& in : tx.vin) {
         CKHUUTXO khuCoin;
@@ -194,10 +217,10 @@ bool ApplyKHUStake(
                      __func__, in.prevout.hash.ToString().substr(0,16).c_str(), in.prevout.n,
                      FormatMoney(khuCoin.amount));
         }
-        // Non-KHU inputs (PIV fee) are skipped - they're not in mapKHUUTXOs
+        // Non-KHU inputs (PIV fee) are skipped - they're not in the KHU coins view
     }
 
-    // 9. ✅ CRITICAL: Add KHU_T change output to mapKHUUTXOs (if any)
+    // 9. ✅ CRITICAL: Add KHU_T change output to the KHU coins view (if any)
     // STAKE tx may have a KHU change output at index 0 (before Sapling outputs)
     // The wallet's khustake creates: output[0] = KHU change, then Sapling data
     for (size_t i = 0; i < tx.vout.size(); ++i) {
@@ -301,7 +324,10 @@ bool UndoKHUStake(
     // fully restored here. The standard UTXO view restores them via ApplyTxInUndo(),
     // and subsequent operations should use wallet data for KHU selection.
 
-    // 5. Erase ZKHU note from database
+    // 5. Remove note from the lazy yield accumulator, then erase it from database
+    if (!khu_yield::RemoveNoteFromYieldIndex(cm, noteData)) {
+        return error("%s: failed to remove note from yield index", __func__);
+    }
     if (!zkhuDB->EraseNote(cm)) {
         return error("%s: failed to erase note", __func__);
     }
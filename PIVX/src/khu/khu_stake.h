@@ -11,6 +11,7 @@
 
 class CCoinsViewCache;
 class CValidationState;
+struct CKHUTxPrecheck;
 namespace Consensus { struct Params; }
 
 /**
@@ -80,13 +81,23 @@ bool CheckKHUStake(
  * @param[in,out] view    Coins view (mutated: spends KHU_T)
  * @param[in,out] state   KHU global state (unchanged: C, U, Cr, Ur)
  * @param[in]     nHeight Block height
+ * @param[in]     pprecheck Optional ConnectBlock pre-validation result (amount, nullifier)
  * @return true if application successful
  */
 bool ApplyKHUStake(
     const CTransaction& tx,
     CCoinsViewCache& view,
     KhuGlobalState& state,
-    int nHeight);
+    int nHeight,
+    const CKHUTxPrecheck* pprecheck = nullptr);
+
+/**
+ * GetZKHUStakeNullifier - Deterministic nullifier of a ZKHU note
+ *
+ * Phase 5 simplification: Hash(cm || "ZKHU-NULLIFIER-V1").
+ * Phase 6+: real Sapling nullifier derivation.
+ */
+uint256 GetZKHUStakeNullifier(const uint256& cm);
 
 /**
  * UndoKHUStake - Undo STAKE during reorg (Consensus Critical)
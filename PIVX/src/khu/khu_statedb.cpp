@@ -7,47 +7,194 @@
 #include "util/system.h"
 #include "streams.h"
 
+#include <algorithm>
+
 static const char DB_KHU_STATE = 'K';
 static const char DB_KHU_STATE_PREFIX = 'S';
+static const char DB_KHU_STATE_DELTA_PREFIX = 'D';
+static const char DB_KHU_STATE_PRUNED_PREFIX = 'P';
 static const char DB_KHU_UTXO_PREFIX = 'U';
 
+static std::pair<char, std::pair<char, int>> StateKey(char prefix, int nHeight)
+{
+    return std::make_pair(DB_KHU_STATE, std::make_pair(prefix, nHeight));
+}
+
+CKHUStateDelta::CKHUStateDelta(const KhuGlobalState& prev, const KhuGlobalState& next) :
+    values(next)
+{
+    if (next.C != prev.C) nFields |= FIELD_C;
+    if (next.U != prev.U) nFields |= FIELD_U;
+    if (next.Z != prev.Z) nFields |= FIELD_Z;
+    if (next.Cr != prev.Cr) nFields |= FIELD_CR;
+    if (next.Ur != prev.Ur) nFields |= FIELD_UR;
+    if (next.T != prev.T) nFields |= FIELD_T;
+    if (next.R_annual != prev.R_annual) nFields |= FIELD_R_ANNUAL;
+    if (next.R_next != prev.R_next) nFields |= FIELD_R_NEXT;
+    if (next.R_MAX_dynamic != prev.R_MAX_dynamic) nFields |= FIELD_R_MAX_DYNAMIC;
+    if (next.last_yield_update_height != prev.last_yield_update_height) nFields |= FIELD_LAST_YIELD_HEIGHT;
+    if (next.last_yield_amount != prev.last_yield_amount) nFields |= FIELD_LAST_YIELD_AMOUNT;
+    if (next.domc_cycle_start != prev.domc_cycle_start) nFields |= FIELD_DOMC_CYCLE_START;
+    if (next.domc_cycle_length != prev.domc_cycle_length) nFields |= FIELD_DOMC_CYCLE_LENGTH;
+    if (next.domc_commit_phase_start != prev.domc_commit_phase_start) nFields |= FIELD_DOMC_COMMIT_START;
+    if (next.domc_reveal_deadline != prev.domc_reveal_deadline) nFields |= FIELD_DOMC_REVEAL_DEADLINE;
+    if (next.nHeight != prev.nHeight + 1) nFields |= FIELD_HEIGHT;
+    if (next.hashPrevState != prev.GetHash()) nFields |= FIELD_HASH_PREV_STATE;
+}
+
+void CKHUStateDelta::Apply(KhuGlobalState& state) const
+{
+    const uint256 hashPrev = state.GetHash();
+    if (nFields & FIELD_C) state.C = values.C;
+    if (nFields & FIELD_U) state.U = values.U;
+    if (nFields & FIELD_Z) state.Z = values.Z;
+    if (nFields & FIELD_CR) state.Cr = values.Cr;
+    if (nFields & FIELD_UR) state.Ur = values.Ur;
+    if (nFields & FIELD_T) state.T = values.T;
+    if (nFields & FIELD_R_ANNUAL) state.R_annual = values.R_annual;
+    if (nFields & FIELD_R_NEXT) state.R_next = values.R_next;
+    if (nFields & FIELD_R_MAX_DYNAMIC) state.R_MAX_dynamic = values.R_MAX_dynamic;
+    if (nFields & FIELD_LAST_YIELD_HEIGHT) state.last_yield_update_height = values.last_yield_update_height;
+    if (nFields & FIELD_LAST_YIELD_AMOUNT) state.last_yield_amount = values.last_yield_amount;
+    if (nFields & FIELD_DOMC_CYCLE_START) state.domc_cycle_start = values.domc_cycle_start;
+    if (nFields & FIELD_DOMC_CYCLE_LENGTH) state.domc_cycle_length = values.domc_cycle_length;
+    if (nFields & FIELD_DOMC_COMMIT_START) state.domc_commit_phase_start = values.domc_commit_phase_start;
+    if (nFields & FIELD_DOMC_REVEAL_DEADLINE) state.domc_reveal_deadline = values.domc_reveal_deadline;
+    state.nHeight = (nFields & FIELD_HEIGHT) ? values.nHeight : state.nHeight + 1;
+    state.hashPrevState = (nFields & FIELD_HASH_PREV_STATE) ? values.hashPrevState : hashPrev;
+    state.hashBlock = values.hashBlock;
+}
+
 CKHUStateDB::CKHUStateDB(size_t nCacheSize, bool fMemory, bool fWipe) :
-    CDBWrapper(GetDataDir() / "khu" / "state", nCacheSize, fMemory, fWipe)
+    CKHUDBWrapper(GetDataDir() / "khu" / "state", nCacheSize, fMemory, fWipe)
 {
+    Read(StateKey(DB_KHU_STATE_PRUNED_PREFIX, 0), nPrunedCheckpoint);
 }
 
-bool CKHUStateDB::WriteKHUState(int nHeight, const KhuGlobalState& state)
+bool CKHUStateDB::WriteKHUState(int nHeight, const KhuGlobalState& state, bool fCheckpoint)
 {
-    return Write(std::make_pair(DB_KHU_STATE, std::make_pair(DB_KHU_STATE_PREFIX, nHeight)), state);
+    LOCK(cs);
+
+    KhuGlobalState prevState;
+    const bool fFull = fCheckpoint || nHeight % KHU_STATE_CHECKPOINT_INTERVAL == 0 ||
+                       !ReadKHUState(nHeight - 1, prevState);
+    if (fFull) {
+        Erase(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight));
+        Write(StateKey(DB_KHU_STATE_PREFIX, nHeight), state);
+    } else {
+        Erase(StateKey(DB_KHU_STATE_PREFIX, nHeight));
+        Write(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight), CKHUStateDelta(prevState, state));
+    }
+
+    cachedState = state;
+    nCachedHeight = nHeight;
+
+    if (fPrune) {
+        PruneDeltas(nHeight);
+    }
+    return true;
 }
 
 bool CKHUStateDB::ReadKHUState(int nHeight, KhuGlobalState& state)
 {
-    return Read(std::make_pair(DB_KHU_STATE, std::make_pair(DB_KHU_STATE_PREFIX, nHeight)), state);
+    LOCK(cs);
+
+    // The cache is only trusted while the record exists (the block
+    // transaction that wrote it may have been rolled back since)
+    if (nHeight == nCachedHeight && ExistsKHUState(nHeight)) {
+        state = cachedState;
+        return true;
+    }
+
+    // Walk down to the nearest full record, collecting deltas
+    std::vector<CKHUStateDelta> vDeltas;
+    int nBase = nHeight;
+    while (!Read(StateKey(DB_KHU_STATE_PREFIX, nBase), state)) {
+        if (nBase <= 0 || (int)vDeltas.size() >= KHU_STATE_CHECKPOINT_INTERVAL) {
+            return false;
+        }
+        vDeltas.emplace_back();
+        if (!Read(StateKey(DB_KHU_STATE_DELTA_PREFIX, nBase), vDeltas.back())) {
+            return false;
+        }
+        nBase--;
+    }
+    for (auto it = vDeltas.rbegin(); it != vDeltas.rend(); ++it) {
+        it->Apply(state);
+    }
+    return true;
 }
 
 bool CKHUStateDB::ExistsKHUState(int nHeight)
 {
-    return Exists(std::make_pair(DB_KHU_STATE, std::make_pair(DB_KHU_STATE_PREFIX, nHeight)));
+    return Exists(StateKey(DB_KHU_STATE_PREFIX, nHeight)) ||
+           Exists(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight));
 }
 
 bool CKHUStateDB::EraseKHUState(int nHeight)
 {
-    return Erase(std::make_pair(DB_KHU_STATE, std::make_pair(DB_KHU_STATE_PREFIX, nHeight)));
+    LOCK(cs);
+    if (nHeight == nCachedHeight) {
+        nCachedHeight = -1;
+    }
+    Erase(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight));
+    return Erase(StateKey(DB_KHU_STATE_PREFIX, nHeight));
+}
+
+void CKHUStateDB::PruneDeltas(int nTipHeight)
+{
+    AssertLockHeld(cs);
+
+    // Once the checkpoint below the reorg window (or the ChainLocked heights)
+    // moves, the deltas below it are no longer needed to replay any height
+    // that can still be disconnected
+    const int nKeepFrom = std::max(nTipHeight - nPruneKeepDepth, std::min(nFinalizedHeight.load(), nTipHeight));
+    const int nCheckpoint = nKeepFrom - nKeepFrom % KHU_STATE_CHECKPOINT_INTERVAL;
+    if (nCheckpoint <= nPrunedCheckpoint) {
+        return;
+    }
+
+    // Every interval closed since the last prune: the checkpoint may have moved
+    // by several of them (-khustateprune turned on, finality horizon jump).
+    // Databases written before deltas existed hold full records in there too:
+    // only those of DOMC cycle boundaries are kept, UndoFinalizeDomcCycle reads them.
+    for (int nHeight = nPrunedCheckpoint + 1; nHeight < nCheckpoint; nHeight++) {
+        if (nHeight % KHU_STATE_CHECKPOINT_INTERVAL == 0) {
+            continue;
+        }
+        if (Exists(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight))) {
+            Erase(StateKey(DB_KHU_STATE_DELTA_PREFIX, nHeight));
+            continue;
+        }
+        KhuGlobalState state;
+        if (Read(StateKey(DB_KHU_STATE_PREFIX, nHeight), state) && state.domc_cycle_start != (uint32_t)nHeight) {
+            Erase(StateKey(DB_KHU_STATE_PREFIX, nHeight));
+        }
+    }
+    nPrunedCheckpoint = nCheckpoint;
+    Write(StateKey(DB_KHU_STATE_PRUNED_PREFIX, 0), nPrunedCheckpoint);
+    LogPrint(BCLog::KHU, "%s: pruned KHU state deltas below height %d\n", __func__, nCheckpoint);
 }
 
-KhuGlobalState CKHUStateDB::LoadKHUState_OrGenesis(int nHeight)
+bool CKHUStateDB::IsKHUStatePruned(int nHeight)
 {
-    KhuGlobalState state;
+    LOCK(cs);
+    return nHeight > 0 && nHeight < nPrunedCheckpoint && !ExistsKHUState(nHeight);
+}
 
+bool CKHUStateDB::LoadKHUState_OrGenesis(int nHeight, KhuGlobalState& state)
+{
     if (ReadKHUState(nHeight, state)) {
-        return state;
+        return true;
+    }
+    if (IsKHUStatePruned(nHeight)) {
+        return error("%s: KHU state at height %d was pruned (-khustateprune)", __func__, nHeight);
     }
 
     // Return genesis state if not found
     state.SetNull();
     state.nHeight = nHeight;
-    return state;
+    return true;
 }
 
 // ═══════════════════════════════════════════════════════════════════════════
@@ -76,7 +223,8 @@ bool CKHUStateDB::ExistsKHUUTXO(const COutPoint& outpoint)
 
 bool CKHUStateDB::LoadAllKHUUTXOs(std::vector<std::pair<COutPoint, CKHUUTXO>>& utxos)
 {
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    LOCK(cs);
+    std::unique_ptr<Iterator> pcursor(NewIterator());
 
     // Seek to start of UTXO prefix
     pcursor->Seek(std::make_pair(DB_KHU_UTXO_PREFIX, COutPoint()));
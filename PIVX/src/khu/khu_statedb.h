@@ -5,24 +5,129 @@
 #ifndef PIVX_KHU_STATEDB_H
 #define PIVX_KHU_STATEDB_H
 
-#include "dbwrapper.h"
+#include "consensus/consensus.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/khu_state.h"
 #include "khu/khu_coins.h"
 #include "primitives/transaction.h"
 
+#include <atomic>
 #include <stdint.h>
 #include <vector>
 
+/** A full KhuGlobalState is stored every this many blocks (one KHU day), deltas in between */
+static const int KHU_STATE_CHECKPOINT_INTERVAL = 1440;
+static const bool DEFAULT_KHU_STATE_PRUNE = false;
+
+/**
+ * CKHUStateDelta - Change of KhuGlobalState against the previous height
+ *
+ * Only the fields that differ are serialized (nFields bitmask). nHeight and
+ * hashPrevState are implied (prev.nHeight + 1, prev.GetHash()) unless flagged.
+ */
+class CKHUStateDelta
+{
+public:
+    enum Field : uint32_t {
+        FIELD_C                     = (1 << 0),
+        FIELD_U                     = (1 << 1),
+        FIELD_Z                     = (1 << 2),
+        FIELD_CR                    = (1 << 3),
+        FIELD_UR                    = (1 << 4),
+        FIELD_T                     = (1 << 5),
+        FIELD_R_ANNUAL              = (1 << 6),
+        FIELD_R_NEXT                = (1 << 7),
+        FIELD_R_MAX_DYNAMIC         = (1 << 8),
+        FIELD_LAST_YIELD_HEIGHT     = (1 << 9),
+        FIELD_LAST_YIELD_AMOUNT     = (1 << 10),
+        FIELD_DOMC_CYCLE_START      = (1 << 11),
+        FIELD_DOMC_CYCLE_LENGTH     = (1 << 12),
+        FIELD_DOMC_COMMIT_START     = (1 << 13),
+        FIELD_DOMC_REVEAL_DEADLINE  = (1 << 14),
+        FIELD_HEIGHT                = (1 << 15),
+        FIELD_HASH_PREV_STATE       = (1 << 16),
+    };
+
+    uint32_t nFields{0};
+    KhuGlobalState values;  // only the nFields members and hashBlock are meaningful
+
+    CKHUStateDelta() {}
+    CKHUStateDelta(const KhuGlobalState& prev, const KhuGlobalState& next);
+
+    /** Turn prev (state at height - 1) into the state at height */
+    void Apply(KhuGlobalState& state) const;
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ::Serialize(s, VARINT(nFields));
+        if (nFields & FIELD_C) ::Serialize(s, values.C);
+        if (nFields & FIELD_U) ::Serialize(s, values.U);
+        if (nFields & FIELD_Z) ::Serialize(s, values.Z);
+        if (nFields & FIELD_CR) ::Serialize(s, values.Cr);
+        if (nFields & FIELD_UR) ::Serialize(s, values.Ur);
+        if (nFields & FIELD_T) ::Serialize(s, values.T);
+        if (nFields & FIELD_R_ANNUAL) ::Serialize(s, values.R_annual);
+        if (nFields & FIELD_R_NEXT) ::Serialize(s, values.R_next);
+        if (nFields & FIELD_R_MAX_DYNAMIC) ::Serialize(s, values.R_MAX_dynamic);
+        if (nFields & FIELD_LAST_YIELD_HEIGHT) ::Serialize(s, values.last_yield_update_height);
+        if (nFields & FIELD_LAST_YIELD_AMOUNT) ::Serialize(s, values.last_yield_amount);
+        if (nFields & FIELD_DOMC_CYCLE_START) ::Serialize(s, values.domc_cycle_start);
+        if (nFields & FIELD_DOMC_CYCLE_LENGTH) ::Serialize(s, values.domc_cycle_length);
+        if (nFields & FIELD_DOMC_COMMIT_START) ::Serialize(s, values.domc_commit_phase_start);
+        if (nFields & FIELD_DOMC_REVEAL_DEADLINE) ::Serialize(s, values.domc_reveal_deadline);
+        if (nFields & FIELD_HEIGHT) ::Serialize(s, values.nHeight);
+        if (nFields & FIELD_HASH_PREV_STATE) ::Serialize(s, values.hashPrevState);
+        ::Serialize(s, values.hashBlock);
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        ::Unserialize(s, VARINT(nFields));
+        if (nFields & FIELD_C) ::Unserialize(s, values.C);
+        if (nFields & FIELD_U) ::Unserialize(s, values.U);
+        if (nFields & FIELD_Z) ::Unserialize(s, values.Z);
+        if (nFields & FIELD_CR) ::Unserialize(s, values.Cr);
+        if (nFields & FIELD_UR) ::Unserialize(s, values.Ur);
+        if (nFields & FIELD_T) ::Unserialize(s, values.T);
+        if (nFields & FIELD_R_ANNUAL) ::Unserialize(s, values.R_annual);
+        if (nFields & FIELD_R_NEXT) ::Unserialize(s, values.R_next);
+        if (nFields & FIELD_R_MAX_DYNAMIC) ::Unserialize(s, values.R_MAX_dynamic);
+        if (nFields & FIELD_LAST_YIELD_HEIGHT) ::Unserialize(s, values.last_yield_update_height);
+        if (nFields & FIELD_LAST_YIELD_AMOUNT) ::Unserialize(s, values.last_yield_amount);
+        if (nFields & FIELD_DOMC_CYCLE_START) ::Unserialize(s, values.domc_cycle_start);
+        if (nFields & FIELD_DOMC_CYCLE_LENGTH) ::Unserialize(s, values.domc_cycle_length);
+        if (nFields & FIELD_DOMC_COMMIT_START) ::Unserialize(s, values.domc_commit_phase_start);
+        if (nFields & FIELD_DOMC_REVEAL_DEADLINE) ::Unserialize(s, values.domc_reveal_deadline);
+        if (nFields & FIELD_HEIGHT) ::Unserialize(s, values.nHeight);
+        if (nFields & FIELD_HASH_PREV_STATE) ::Unserialize(s, values.hashPrevState);
+        ::Unserialize(s, values.hashBlock);
+    }
+};
+
 /**
  * CKHUStateDB - LevelDB persistence layer for KHU global state
  *
  * Database keys:
- * - 'K' + 'S' + height -> KhuGlobalState
+ * - 'K' + 'S' + height -> KhuGlobalState (checkpoint, full record)
+ * - 'K' + 'D' + height -> CKHUStateDelta (against height - 1)
+ * - 'K' + 'P' + 0 -> int (last checkpoint whose interval was pruned)
+ *
+ * A full record is written every KHU_STATE_CHECKPOINT_INTERVAL blocks (or on
+ * request), a delta otherwise. Any height is read back by replaying the
+ * deltas from the nearest full record below it; the last written state is
+ * kept in memory so the next block does not replay anything.
+ * Databases written before deltas existed hold a full record at every height
+ * and are read as is.
  *
- * The database stores KHU state snapshots at each block height.
- * This allows for efficient state retrieval and reorg handling.
+ * With -khustateprune, deltas older than -maxreorg blocks,
+ * or below the ChainLock finality horizon, are erased once a newer
+ * checkpoint covers them, along with the per-height full records of older
+ * databases: old heights remain readable at checkpoints and DOMC cycle
+ * boundaries only, the others are reported as pruned (IsKHUStatePruned).
  */
-class CKHUStateDB : public CDBWrapper
+class CKHUStateDB : public CKHUDBWrapper
 {
 public:
     explicit CKHUStateDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
@@ -31,19 +136,49 @@ private:
     CKHUStateDB(const CKHUStateDB&);
     void operator=(const CKHUStateDB&);
 
+    //! Last state written (or read at the highest height), guarded by cs
+    KhuGlobalState cachedState;
+    int nCachedHeight{-1};
+
+    bool fPrune{DEFAULT_KHU_STATE_PRUNE};
+    //! -khustateprune keeps the per-block deltas of this many blocks (-maxreorg)
+    int nPruneKeepDepth{DEFAULT_MAX_REORG_DEPTH};
+    //! Highest height that can no longer be disconnected (ChainLocked)
+    std::atomic<int> nFinalizedHeight{-1};
+    //! Last checkpoint whose interval was pruned (persisted), guarded by cs
+    int nPrunedCheckpoint{0};
+
+    void PruneDeltas(int nTipHeight);
+
 public:
+    /** Enable -khustateprune */
+    void SetPruneMode(bool fPruneIn) { fPrune = fPruneIn; }
+
+    /** Reorg window the deltas must cover, set from -maxreorg at init */
+    void SetPruneKeepDepth(int nDepth) { nPruneKeepDepth = nDepth; }
+
+    /** Finality horizon: heights up to nHeight are never disconnected, their deltas can go */
+    void SetFinalizedHeight(int nHeight) { nFinalizedHeight = nHeight; }
+
     /**
      * WriteKHUState - Persist KHU state for a given height
      *
+     * Stored as a delta against nHeight - 1, or as a full record at
+     * checkpoint heights, when fCheckpoint is set, or when nHeight - 1 is
+     * unknown.
+     *
      * @param nHeight Block height
      * @param state KHU state to write
+     * @param fCheckpoint Force a full record (e.g. DOMC cycle boundaries)
      * @return true on success, false on failure
      */
-    bool WriteKHUState(int nHeight, const KhuGlobalState& state);
+    bool WriteKHUState(int nHeight, const KhuGlobalState& state, bool fCheckpoint = false);
 
     /**
      * ReadKHUState - Read KHU state at a given height
      *
+     * Replays deltas from the nearest full record if needed.
+     *
      * @param nHeight Block height
      * @param state Output parameter for state
      * @return true if state exists, false otherwise
@@ -66,16 +201,26 @@ public:
      */
     bool EraseKHUState(int nHeight);
 
+    /**
+     * IsKHUStatePruned - Check if the state at height was erased by -khustateprune
+     *
+     * @param nHeight Block height
+     * @return true if the state existed but can no longer be read
+     */
+    bool IsKHUStatePruned(int nHeight);
+
     /**
      * LoadKHUState_OrGenesis - Load state or return genesis state
      *
-     * If state doesn't exist at height, returns genesis state (all zeros).
-     * This is used during activation of KHU upgrade.
+     * If state was never written at height, returns genesis state (all zeros).
+     * This is used during activation of KHU upgrade. A pruned height is an
+     * error, not a genesis state.
      *
      * @param nHeight Block height
-     * @return KHU state (existing or genesis)
+     * @param state Output parameter for state (existing or genesis)
+     * @return false if the state at height was pruned
      */
-    KhuGlobalState LoadKHUState_OrGenesis(int nHeight);
+    bool LoadKHUState_OrGenesis(int nHeight, KhuGlobalState& state);
 
     // ═══════════════════════════════════════════════════════════════════════
     // KHU UTXO Persistence (Phase 2)
@@ -117,9 +262,9 @@ public:
     bool ExistsKHUUTXO(const COutPoint& outpoint);
 
     /**
-     * LoadAllKHUUTXOs - Load all UTXOs into memory cache
+     * LoadAllKHUUTXOs - Full scan of the KHU UTXO set
      *
-     * Called at startup to populate the in-memory cache.
+     * Not used for lookups: those go through CKHUCoinsViewDB.
      *
      * @param utxos Output vector for all UTXOs
      * @return true on success
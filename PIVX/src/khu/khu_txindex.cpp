@@ -0,0 +1,159 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "khu/khu_txindex.h"
+
+#include "compat/endian.h"
+#include "khu/khu_utxo.h"
+#include "logging.h"
+#include "primitives/block.h"
+#include "util/system.h"
+
+#include <memory>
+
+// Database key prefixes
+static const char DB_KHU_TXINDEX = 'X';
+static const char DB_KHU_TXINDEX_BLOCK = 'b';
+static const char DB_KHU_TXINDEX_START = 's';
+static const char DB_KHU_TXINDEX_LAST = 't';
+
+// Global KHU transaction index (nullptr without -khutxindex)
+static std::unique_ptr<CKHUTxIndexDB> pkhutxindex;
+
+typedef std::pair<char, std::pair<char, uint32_t>> BlockKey;
+
+static BlockKey MakeBlockKey(int nHeight)
+{
+    return std::make_pair(DB_KHU_TXINDEX, std::make_pair(DB_KHU_TXINDEX_BLOCK, htobe32((uint32_t)nHeight)));
+}
+
+static const std::pair<char, char> START_KEY = std::make_pair(DB_KHU_TXINDEX, DB_KHU_TXINDEX_START);
+static const std::pair<char, char> LAST_KEY = std::make_pair(DB_KHU_TXINDEX, DB_KHU_TXINDEX_LAST);
+
+// KHU typed, or spending a KHU_T outpoint (khusend and other plain transfers)
+static bool IsIndexedKHUTx(const CTransaction& tx, const CCoinsViewCache& view)
+{
+    if (tx.nType >= CTransaction::TxType::KHU_MINT && tx.nType <= CTransaction::TxType::KHU_UNSTAKE) {
+        return true;
+    }
+    if (tx.IsCoinBase()) {
+        return false;
+    }
+    for (const CTxIn& in : tx.vin) {
+        if (HaveKHUCoin(view, in.prevout)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// CKHUTxIndexDB implementation
+// ============================================================================
+
+CKHUTxIndexDB::CKHUTxIndexDB(size_t nCacheSize, bool fMemory, bool fWipe) :
+    CKHUDBWrapper(GetDataDir() / "khu" / "txindex", nCacheSize, fMemory, fWipe)
+{
+}
+
+bool CKHUTxIndexDB::WriteBlock(const CBlock& block, int nHeight, const CCoinsViewCache& view)
+{
+    CKHUTxIndexEntry entry;
+    for (const CTransactionRef& tx : block.vtx) {
+        if (IsIndexedKHUTx(*tx, view)) {
+            entry.vTxids.push_back(tx->GetHash());
+        }
+    }
+
+    LOCK(cs);
+    int nLast;
+    if (!Read(LAST_KEY, nLast) || nLast != nHeight - 1) {
+        // First indexed block, or blocks were connected without -khutxindex
+        LogPrint(BCLog::KHU, "%s: starting KHU tx index range at height %d\n", __func__, nHeight);
+        if (!Write(START_KEY, nHeight)) {
+            return false;
+        }
+    }
+    if (entry.vTxids.empty()) {
+        // Left over by a block disconnected without -khutxindex
+        if (!Erase(MakeBlockKey(nHeight))) {
+            return false;
+        }
+    } else {
+        entry.hashBlock = block.GetHash();
+        if (!Write(MakeBlockKey(nHeight), entry)) {
+            return false;
+        }
+    }
+    return Write(LAST_KEY, nHeight);
+}
+
+bool CKHUTxIndexDB::EraseBlock(int nHeight)
+{
+    LOCK(cs);
+    int nLast;
+    if (Read(LAST_KEY, nLast) && nLast == nHeight) {
+        if (!Write(LAST_KEY, nHeight - 1)) {
+            return false;
+        }
+    }
+    return Erase(MakeBlockKey(nHeight));
+}
+
+bool CKHUTxIndexDB::IsCovered(int nHeight, int nV6Height) const
+{
+    if (nHeight < nV6Height) {
+        return true;
+    }
+    LOCK(cs);
+    int nStart, nLast;
+    return Read(START_KEY, nStart) && Read(LAST_KEY, nLast) && nStart <= nHeight && nHeight <= nLast;
+}
+
+void CKHUTxIndexDB::GetBlocks(int nFirst, int nLast, std::map<int, CKHUTxIndexEntry>& mapBlocks)
+{
+    LOCK(cs);
+    std::unique_ptr<CKHUDBWrapper::Iterator> pcursor(NewIterator());
+    pcursor->Seek(MakeBlockKey(nFirst));
+
+    while (pcursor->Valid()) {
+        BlockKey key;
+        if (!pcursor->GetKey(key) || key.first != DB_KHU_TXINDEX || key.second.first != DB_KHU_TXINDEX_BLOCK) {
+            break;
+        }
+        const int nHeight = (int)be32toh(key.second.second);
+        if (nHeight > nLast) {
+            break;
+        }
+        CKHUTxIndexEntry entry;
+        if (pcursor->GetValue(entry)) {
+            mapBlocks.emplace(nHeight, std::move(entry));
+        }
+        pcursor->Next();
+    }
+}
+
+// ============================================================================
+// Global accessor functions
+// ============================================================================
+
+bool InitKHUTxIndexDB(size_t nCacheSize, bool fReindex, bool fEnabled, bool fMemory)
+{
+    try {
+        pkhutxindex.reset();
+        if (fEnabled) {
+            pkhutxindex = std::make_unique<CKHUTxIndexDB>(nCacheSize, fMemory, fReindex);
+            LogPrint(BCLog::KHU, "KHU: Initialized KHU transaction index\n");
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LogPrintf("ERROR: Failed to initialize KHU transaction index: %s\n", e.what());
+        return false;
+    }
+}
+
+CKHUTxIndexDB* GetKHUTxIndexDB()
+{
+    return pkhutxindex.get();
+}
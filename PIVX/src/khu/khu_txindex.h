@@ -0,0 +1,98 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PIVX_KHU_TXINDEX_H
+#define PIVX_KHU_TXINDEX_H
+
+#include "khu/khu_dbwrapper.h"
+#include "serialize.h"
+#include "uint256.h"
+
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+class CBlock;
+class CCoinsViewCache;
+
+static const bool DEFAULT_KHU_TXINDEX = false;
+
+/**
+ * CKHUTxIndexEntry - Wallet relevant KHU transactions of one block
+ */
+class CKHUTxIndexEntry
+{
+public:
+    uint256 hashBlock;
+    std::vector<uint256> vTxids;
+
+    SERIALIZE_METHODS(CKHUTxIndexEntry, obj) { READWRITE(obj.hashBlock, obj.vTxids); }
+};
+
+/**
+ * CKHUTxIndexDB - Optional block-level index of KHU transactions (-khutxindex)
+ *
+ * Records, per block, the KHU_MINT/REDEEM/STAKE/UNSTAKE transactions and the
+ * transactions spending a KHU_T outpoint: the only ones ScanForKHUCoins acts
+ * on. A rescan then deserializes the listed blocks only.
+ *
+ * DATABASE KEYS:
+ * - 'X' + 'b' + height (big endian) -> CKHUTxIndexEntry (blocks without
+ *   relevant transactions have no entry)
+ * - 'X' + 's' -> int (first height of the current contiguous range)
+ * - 'X' + 't' -> int (last connected height)
+ *
+ * Written by ProcessKHUBlock / DisconnectKHUBlock in the block transaction
+ * of the other KHU databases. Blocks connected while the node ran without
+ * -khutxindex leave a gap; the range restarts after it, so only
+ * [start, last] (and pre-V6 heights, which hold no KHU transaction) are
+ * trusted by IsCovered().
+ */
+class CKHUTxIndexDB : public CKHUDBWrapper
+{
+public:
+    explicit CKHUTxIndexDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+private:
+    CKHUTxIndexDB(const CKHUTxIndexDB&);
+    void operator=(const CKHUTxIndexDB&);
+
+public:
+    /**
+     * WriteBlock - Index the relevant transactions of a connected block
+     *
+     * view/KHU coins must be the ones the block was applied to, so spends of
+     * KHU_T outputs created earlier in the same block are found too.
+     */
+    bool WriteBlock(const CBlock& block, int nHeight, const CCoinsViewCache& view);
+
+    /** EraseBlock - Drop the entry of a disconnected block */
+    bool EraseBlock(int nHeight);
+
+    /** True if the absence of an entry at nHeight means "nothing to scan" */
+    bool IsCovered(int nHeight, int nV6Height) const;
+
+    /** Entries of the heights in [nFirst, nLast] */
+    void GetBlocks(int nFirst, int nLast, std::map<int, CKHUTxIndexEntry>& mapBlocks);
+};
+
+/**
+ * InitKHUTxIndexDB - Open (-khutxindex) or close the KHU transaction index
+ *
+ * @param nCacheSize Cache size in bytes
+ * @param fReindex True if reindexing (wipes the index)
+ * @param fEnabled False closes the index: connected blocks are not indexed
+ * @param fMemory Keep the DB in memory (tests, benchmarks)
+ * @return true on success, false on failure
+ */
+bool InitKHUTxIndexDB(size_t nCacheSize, bool fReindex, bool fEnabled, bool fMemory = false);
+
+/**
+ * GetKHUTxIndexDB - Get global KHU transaction index
+ *
+ * @return Pointer to the index, or nullptr when -khutxindex is off
+ */
+CKHUTxIndexDB* GetKHUTxIndexDB();
+
+#endif // PIVX_KHU_TXINDEX_H
@@ -7,6 +7,7 @@
 #include "coins.h"
 #include "consensus/params.h"
 #include "consensus/validation.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_utxo.h"
 #include "khu/khu_validation.h"
 #include "khu/khu_yield.h"
@@ -128,8 +129,12 @@ bool CheckKHUUnstake(
                         REJECT_INVALID, "bad-unstake-maturity");
     }
 
-    // 9. bonus = noteData.Ur_accumulated >= 0
-    CAmount bonus = noteData.Ur_accumulated;  // ✅ PER-NOTE (NOT Ur_now - Ur_at_stake)
+    // 9. bonus = accumulated per-note yield >= 0 (materialised from the lazy yield index)
+    CAmount bonus = 0;  // ✅ PER-NOTE (NOT Ur_now - Ur_at_stake)
+    if (!khu_yield::GetNoteAccumulatedYield(cm, noteData, nHeight, bonus)) {
+        return state.DoS(100, error("%s: yield overflow", __func__),
+                        REJECT_INVALID, "bad-unstake-bonus-overflow");
+    }
     if (bonus < 0) {
         return state.DoS(100, error("%s: negative bonus", __func__),
                         REJECT_INVALID, "bad-unstake-bonus-negative");
@@ -168,28 +173,36 @@ bool ApplyKHUUnstake(
     const CTransaction& tx,
     CCoinsViewCache& view,
     KhuGlobalState& state,
-    int nHeight)
+    int nHeight,
+    const CKHUTxPrecheck* pprecheck)
 {
     // ⚠️ CRITICAL: cs_khu MUST be held
     AssertLockHeld(cs_khu);
 
-    // 1. Validate transaction has Sapling spend data
-    if (!tx.sapData) {
-        return error("%s: UNSTAKE tx missing Sapling data", __func__);
-    }
+    // 1-3. Sapling structure checks, spend nullifier and payload.
+    // Already done by the ConnectBlock pre-validation pass when available.
+    uint256 saplingNullifier;
+    CUnstakeKHUPayload payload;
+    if (pprecheck && pprecheck->fParsed) {
+        saplingNullifier = pprecheck->unstakeNullifier;
+        payload = pprecheck->unstake;
+    } else {
+        // 1. Validate transaction has Sapling spend data
+        if (!tx.sapData) {
+            return error("%s: UNSTAKE tx missing Sapling data", __func__);
+        }
 
-    if (tx.sapData->vShieldedSpend.empty()) {
-        return error("%s: UNSTAKE tx has no shielded spends", __func__);
-    }
+        if (tx.sapData->vShieldedSpend.empty()) {
+            return error("%s: UNSTAKE tx has no shielded spends", __func__);
+        }
 
-    // 2. Extract nullifier from Sapling spend (for double-spend check)
-    const SpendDescription& saplingSpend = tx.sapData->vShieldedSpend[0];
-    uint256 saplingNullifier = saplingSpend.nullifier;
+        // 2. Extract nullifier from Sapling spend (for double-spend check)
+        saplingNullifier = tx.sapData->vShieldedSpend[0].nullifier;
 
-    // 3. Extract cm from payload (Phase 5/8 fix: avoid nullifier mapping mismatch)
-    CUnstakeKHUPayload payload;
-    if (!GetUnstakeKHUPayload(tx, payload)) {
-        return error("%s: failed to extract UNSTAKE payload", __func__);
+        // 3. Extract cm from payload (Phase 5/8 fix: avoid nullifier mapping mismatch)
+        if (!GetUnstakeKHUPayload(tx, payload)) {
+            return error("%s: failed to extract UNSTAKE payload", __func__);
+        }
     }
     uint256 cm = payload.cm;
 
@@ -211,8 +224,12 @@ bool ApplyKHUUnstake(
     }
 
     // 7. ✅ CRITICAL: Extract P (principal) and Y (yield) from note
+    // Y is materialised from the lazy yield index (bit-exact with per-event crediting)
     CAmount P = noteData.amount;              // Principal staked
-    CAmount Y = noteData.Ur_accumulated;      // Yield accumulated
+    CAmount Y = 0;                            // Yield accumulated
+    if (!khu_yield::GetNoteAccumulatedYield(cm, noteData, nHeight, Y)) {
+        return error("%s: failed to compute yield for cm=%s", __func__, cm.ToString());
+    }
 
     // ═══════════════════════════════════════════════════════════════════════
     // 5 MUTATIONS ATOMIQUES — ORDRE CRITIQUE (préserve invariants C==U+Z, Cr==Ur)
@@ -270,8 +287,13 @@ bool ApplyKHUUnstake(
 
     // 10. BUG #6 FIX: Mark note as spent (keep for undo support)
     // This prevents yield from being calculated for spent notes
+    if (!khu_yield::DeactivateNoteYield(cm, noteData)) {
+        return error("%s: failed to deactivate note yield", __func__);
+    }
+    // Spent notes move to cold storage, pruned once past the reorg window
+    noteData.Ur_accumulated = Y;  // Materialise yield
     noteData.bSpent = true;
-    if (!zkhuDB->WriteNote(cm, noteData)) {
+    if (!zkhuDB->SpendNote(cm, noteData, nHeight)) {
         return error("%s: failed to mark note as spent", __func__);
     }
     LogPrint(BCLog::KHU, "ApplyKHUUnstake: Marked note %s as spent in ZKHU database\n",
@@ -295,9 +317,9 @@ bool ApplyKHUUnstake(
                     __func__, expectedOutput, totalOutput, nKHUOutputs, tx.vout.size());
     }
 
-    // 11b. ✅ CRITICAL: Add only the first 2 KHU_T outputs to mapKHUUTXOs for consensus tracking
+    // 11b. ✅ CRITICAL: Add only the first 2 KHU_T outputs to the KHU coins view for consensus tracking
     // NOTE: Standard AddCoins() only adds to CCoinsViewCache (PIV view).
-    // For KHU_T coins, we MUST also add to mapKHUUTXOs so that REDEEM can find them.
+    // For KHU_T coins, we MUST also add to the KHU coins view so that REDEEM can find them.
     // This is symmetric with ApplyKHUMint which also calls AddKHUCoin().
     // With privacy split, we have 2 KHU outputs (outputs beyond 2 are PIV change)
     for (size_t i = 0; i < nKHUOutputs; ++i) {
@@ -365,10 +387,19 @@ bool UndoKHUUnstake(
         return error("%s: note data not found for cm=%s", __func__, cm.ToString());
     }
 
-    // 6. Extract P (principal) and Y (yield) from note
+    // 6. Extract P (principal) and Y (yield materialised by Apply) from note
     CAmount P = noteData.amount;
     CAmount Y = noteData.Ur_accumulated;
 
+    // Part of Y coming from the lazy yield index (not stored before Apply)
+    ZKHUNoteData unspentNote = noteData;
+    unspentNote.Ur_accumulated = 0;
+    unspentNote.bSpent = false;
+    CAmount lazyYield = 0;
+    if (!khu_yield::GetNoteAccumulatedYield(cm, unspentNote, nHeight, lazyYield) || lazyYield > Y) {
+        return error("%s: inconsistent lazy yield for cm=%s (Y=%d)", __func__, cm.ToString(), Y);
+    }
+
     // ═══════════════════════════════════════════════════════════════════════
     // REVERSE 5 MUTATIONS — SYMÉTRIE CRITIQUE
     //
@@ -403,10 +434,14 @@ bool UndoKHUUnstake(
     state.Ur += Y;          // (5) Reverse: Yield restauré aux droits
 
     // 7. BUG #6 FIX: Unmark note as spent (restore for yield calculation)
+    noteData.Ur_accumulated = Y - lazyYield;
     noteData.bSpent = false;
-    if (!zkhuDB->WriteNote(cm, noteData)) {
+    if (!zkhuDB->UnspendNote(cm, noteData, nHeight)) {
         return error("%s: failed to unmark note as spent", __func__);
     }
+    if (!khu_yield::ReactivateNoteYield(cm, noteData)) {
+        return error("%s: failed to reactivate note yield", __func__);
+    }
     LogPrint(BCLog::KHU, "%s: Restored note %s (unspent) in ZKHU database\n",
              __func__, cm.GetHex().substr(0, 16).c_str());
 
@@ -418,7 +453,7 @@ bool UndoKHUUnstake(
         return error("%s: failed to unspend Sapling nullifier", __func__);
     }
 
-    // 9b. ✅ CRITICAL: Remove only first 2 KHU_T coins from mapKHUUTXOs
+    // 9b. ✅ CRITICAL: Remove only first 2 KHU_T coins from the KHU coins view
     // This is symmetric with the AddKHUCoin() in ApplyKHUUnstake.
     // With privacy split, we have 2 KHU outputs (outputs beyond 2 are PIV change)
     size_t nKHUOutputs = std::min(tx.vout.size(), (size_t)2);  // Privacy split = 2 KHU outputs
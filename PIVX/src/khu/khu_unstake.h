@@ -10,6 +10,7 @@
 
 class CCoinsViewCache;
 class CValidationState;
+struct CKHUTxPrecheck;
 namespace Consensus { struct Params; }
 
 /**
@@ -112,13 +113,15 @@ bool CheckKHUUnstake(
  * @param[in,out] view    Coins view (mutated: creates KHU_T UTXO)
  * @param[in,out] state   KHU global state (mutated: C+, U+, Cr-, Ur-)
  * @param[in]     nHeight Block height
+ * @param[in]     pprecheck Optional ConnectBlock pre-validation result (payload, nullifier)
  * @return true if application successful
  */
 bool ApplyKHUUnstake(
     const CTransaction& tx,
     CCoinsViewCache& view,
     KhuGlobalState& state,
-    int nHeight);
+    int nHeight,
+    const CKHUTxPrecheck* pprecheck = nullptr);
 
 /**
  * UndoKHUUnstake - Undo UNSTAKE during reorg (Consensus Critical)
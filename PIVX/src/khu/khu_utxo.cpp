@@ -10,77 +10,99 @@
 #include "util/system.h"
 #include "utilmoneystr.h"
 
-#include <unordered_map>
-
 // External function to get DB (defined in khu_validation.cpp)
 extern CKHUStateDB* GetKHUStateDB();
 
 // Phase 2: KHU UTXO tracking with LevelDB persistence
-// In-memory cache for performance, backed by LevelDB for persistence
+// Layered like pcoinsTip: state DB <- tip cache <- per-block scopes.
+// Scopes belong to the thread that opened them (the one connecting the
+// block): other threads (RPC, wallet) keep reading the tip and never see
+// coins of a block that has not been flushed yet.
 static RecursiveMutex cs_khu_utxos;
-static std::unordered_map<COutPoint, CKHUUTXO, SaltedOutpointHasher> mapKHUUTXOs GUARDED_BY(cs_khu_utxos);
-static bool fKHUUTXOsLoaded = false;
+static CKHUCoinsView khuCoinsViewDummy;
+static std::unique_ptr<CKHUCoinsViewDB> pkhucoinsdbview GUARDED_BY(cs_khu_utxos);
+static std::unique_ptr<CKHUCoinsViewCache> pkhucoinsTip GUARDED_BY(cs_khu_utxos);
+static thread_local CKHUCoinsViewCache* pkhucoinsScope = nullptr;
+static int nKHUCoinsScopes GUARDED_BY(cs_khu_utxos) = 0;
+
+void InitKHUCoinsTip(CKHUStateDB* db)
+{
+    LOCK(cs_khu_utxos);
+    assert(nKHUCoinsScopes == 0);
+    pkhucoinsTip.reset();
+    pkhucoinsdbview.reset();
+    if (db) {
+        pkhucoinsdbview = std::make_unique<CKHUCoinsViewDB>(*db);
+        pkhucoinsTip = std::make_unique<CKHUCoinsViewCache>(pkhucoinsdbview.get());
+    } else {
+        pkhucoinsTip = std::make_unique<CKHUCoinsViewCache>(&khuCoinsViewDummy);
+    }
+}
 
-// Initialize UTXO cache from database (called at startup)
-static void LoadKHUUTXOsFromDB()
+// Innermost scope opened by this thread, or the tip
+static CKHUCoinsViewCache& ActiveKHUCoinsView() EXCLUSIVE_LOCKS_REQUIRED(cs_khu_utxos)
 {
     AssertLockHeld(cs_khu_utxos);
+    if (pkhucoinsScope) {
+        return *pkhucoinsScope;
+    }
+    if (!pkhucoinsTip) {
+        InitKHUCoinsTip(GetKHUStateDB());
+    }
+    return *pkhucoinsTip;
+}
 
-    if (fKHUUTXOsLoaded) return;
+bool FlushKHUCoinsTip()
+{
+    LOCK(cs_khu_utxos);
+    if (!pkhucoinsTip) return true;
+    return pkhucoinsTip->Flush();
+}
 
-    CKHUStateDB* db = GetKHUStateDB();
-    if (!db) {
-        LogPrintf("%s: WARNING - KHU DB not available yet\n", __func__);
-        return;
-    }
+size_t GetKHUCoinsTipMemoryUsage()
+{
+    LOCK(cs_khu_utxos);
+    return pkhucoinsTip ? pkhucoinsTip->DynamicMemoryUsage() : 0;
+}
 
-    std::vector<std::pair<COutPoint, CKHUUTXO>> utxos;
-    if (db->LoadAllKHUUTXOs(utxos)) {
-        for (const auto& pair : utxos) {
-            mapKHUUTXOs[pair.first] = pair.second;
-        }
-        LogPrint(BCLog::KHU, "%s: Loaded %zu KHU UTXOs from database\n", __func__, utxos.size());
-        fKHUUTXOsLoaded = true;
-    }
+CKHUCoinsViewScope::CKHUCoinsViewScope()
+{
+    LOCK(cs_khu_utxos);
+    pprev = &ActiveKHUCoinsView();
+    pview = std::make_unique<CKHUCoinsViewCache>(pprev);
+    pkhucoinsScope = pview.get();
+    nKHUCoinsScopes++;
 }
 
-bool AddKHUCoin(CCoinsViewCache& view, const COutPoint& outpoint, const CKHUUTXO& coin)
+CKHUCoinsViewScope::~CKHUCoinsViewScope()
+{
+    LOCK(cs_khu_utxos);
+    assert(pkhucoinsScope == pview.get());
+    pkhucoinsScope = pprev == pkhucoinsTip.get() ? nullptr : pprev;
+    nKHUCoinsScopes--;
+}
+
+bool CKHUCoinsViewScope::Flush()
 {
     LOCK(cs_khu_utxos);
+    return pview->Flush();
+}
 
-    // Ensure cache is loaded
-    LoadKHUUTXOsFromDB();
+bool AddKHUCoin(CCoinsViewCache& view, const COutPoint& outpoint, const CKHUUTXO& coin)
+{
+    LOCK(cs_khu_utxos);
+    CKHUCoinsViewCache& khuView = ActiveKHUCoinsView();
 
     LogPrint(BCLog::KHU, "%s: adding %s KHU at %s:%d (height %d)\n",
              __func__, FormatMoney(coin.amount), outpoint.hash.ToString().substr(0,16).c_str(),
              outpoint.n, coin.nHeight);
 
     // Vérifier que le coin n'existe pas déjà
-    auto it = mapKHUUTXOs.find(outpoint);
-    if (it != mapKHUUTXOs.end()) {
-        bool isSpent = it->second.IsSpent();
-        LogPrint(BCLog::KHU, "%s: outpoint=%s already exists (spent=%d)\n",
-                 __func__, outpoint.ToString(), isSpent);
-        if (!isSpent) {
-            return error("%s: coin already exists and not spent at %s", __func__, outpoint.ToString());
-        }
+    if (khuView.HaveCoin(outpoint)) {
+        return error("%s: coin already exists and not spent at %s", __func__, outpoint.ToString());
     }
 
-    // Ajouter le coin à la cache
-    mapKHUUTXOs[outpoint] = coin;
-
-    // Persister dans LevelDB
-    CKHUStateDB* db = GetKHUStateDB();
-    if (db) {
-        if (!db->WriteKHUUTXO(outpoint, coin)) {
-            LogPrintf("ERROR: %s: Failed to persist UTXO to database\n", __func__);
-            // Continue anyway - in-memory cache is updated
-        } else {
-            LogPrint(BCLog::KHU, "%s: Persisted UTXO to LevelDB at %s\n", __func__, outpoint.ToString());
-        }
-    } else {
-        LogPrintf("WARNING: %s: KHU StateDB not available for UTXO persistence\n", __func__);
-    }
+    khuView.AddCoin(outpoint, coin, false);
 
     LogPrint(BCLog::KHU, "%s: added %s KHU at %s\n",
              __func__, FormatMoney(coin.amount), outpoint.ToString());
@@ -91,40 +113,19 @@ bool AddKHUCoin(CCoinsViewCache& view, const COutPoint& outpoint, const CKHUUTXO
 bool SpendKHUCoin(CCoinsViewCache& view, const COutPoint& outpoint)
 {
     LOCK(cs_khu_utxos);
+    CKHUCoinsViewCache& khuView = ActiveKHUCoinsView();
 
-    // Ensure cache is loaded
-    LoadKHUUTXOsFromDB();
-
-    LogPrint(BCLog::KHU, "%s: looking for %s:%d\n",
-              __func__, outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
-
-    auto it = mapKHUUTXOs.find(outpoint);
-    if (it == mapKHUUTXOs.end()) {
+    CKHUUTXO coin;
+    if (!khuView.GetCoin(outpoint, coin)) {
         LogPrint(BCLog::KHU, "%s: coin not found for %s:%d\n",
                  __func__, outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
         return error("%s: coin not found at %s", __func__, outpoint.ToString());
     }
 
-    if (it->second.IsSpent()) {
-        LogPrint(BCLog::KHU, "SpendKHUCoin: coin already spent for %s:%d\n",
-                 outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
-        return error("SpendKHUCoin: coin already spent at %s", outpoint.ToString());
-    }
-
     LogPrint(BCLog::KHU, "SpendKHUCoin: spending %s:%d value=%s\n",
-             outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n, FormatMoney(it->second.amount));
-
-    // Supprimer de la cache
-    mapKHUUTXOs.erase(it);
+             outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n, FormatMoney(coin.amount));
 
-    // Supprimer de LevelDB
-    CKHUStateDB* db = GetKHUStateDB();
-    if (db) {
-        if (!db->EraseKHUUTXO(outpoint)) {
-            LogPrintf("ERROR: %s: Failed to erase UTXO from database\n", __func__);
-            // Continue anyway - in-memory cache is updated
-        }
-    }
+    khuView.SpendCoin(outpoint);
 
     return true;
 }
@@ -133,27 +134,13 @@ bool GetKHUCoin(const CCoinsViewCache& view, const COutPoint& outpoint, CKHUUTXO
 {
     LOCK(cs_khu_utxos);
 
-    // Ensure cache is loaded
-    LoadKHUUTXOsFromDB();
-
-    LogPrint(BCLog::KHU, "%s: looking for %s:%d\n",
-              __func__, outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
-
-    auto it = mapKHUUTXOs.find(outpoint);
-    if (it == mapKHUUTXOs.end()) {
+    if (!ActiveKHUCoinsView().GetCoin(outpoint, coin)) {
         // Not found is normal for PIV inputs - only log at debug level
         LogPrint(BCLog::KHU, "%s: coin not found for %s:%d\n",
                  __func__, outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
         return false;
     }
 
-    if (it->second.IsSpent()) {
-        LogPrint(BCLog::KHU, "GetKHUCoin: coin spent for %s:%d\n",
-                 outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
-        return false;
-    }
-
-    coin = it->second;
     LogPrint(BCLog::KHU, "GetKHUCoin: found %s:%d value=%s\n",
              outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n, FormatMoney(coin.amount));
     return true;
@@ -162,36 +149,13 @@ bool GetKHUCoin(const CCoinsViewCache& view, const COutPoint& outpoint, CKHUUTXO
 bool HaveKHUCoin(const CCoinsViewCache& view, const COutPoint& outpoint)
 {
     LOCK(cs_khu_utxos);
-
-    // Ensure cache is loaded
-    LoadKHUUTXOsFromDB();
-
-    auto it = mapKHUUTXOs.find(outpoint);
-    if (it == mapKHUUTXOs.end()) {
-        return false;
-    }
-
-    return !it->second.IsSpent();
+    return ActiveKHUCoinsView().HaveCoin(outpoint);
 }
 
 bool GetKHUCoinFromTracking(const COutPoint& outpoint, CKHUUTXO& coin)
 {
     LOCK(cs_khu_utxos);
-
-    // Ensure cache is loaded
-    LoadKHUUTXOsFromDB();
-
-    auto it = mapKHUUTXOs.find(outpoint);
-    if (it == mapKHUUTXOs.end()) {
-        return false;
-    }
-
-    if (it->second.IsSpent()) {
-        return false;
-    }
-
-    coin = it->second;
-    return true;
+    return ActiveKHUCoinsView().GetCoin(outpoint, coin);
 }
 
 // Restore a spent KHU UTXO (used during reorg/undo)
@@ -202,16 +166,7 @@ bool RestoreKHUCoin(const COutPoint& outpoint, const CKHUUTXO& coin)
     LogPrint(BCLog::KHU, "%s: restoring %s KHU at %s:%d\n",
              __func__, FormatMoney(coin.amount), outpoint.hash.ToString().substr(0,16).c_str(), outpoint.n);
 
-    // Ajouter à la cache
-    mapKHUUTXOs[outpoint] = coin;
-
-    // Persister dans LevelDB
-    CKHUStateDB* db = GetKHUStateDB();
-    if (db) {
-        if (!db->WriteKHUUTXO(outpoint, coin)) {
-            LogPrintf("ERROR: %s: Failed to persist restored UTXO to database\n", __func__);
-        }
-    }
+    ActiveKHUCoinsView().AddCoin(outpoint, coin, true);
 
     return true;
 }
@@ -8,7 +8,10 @@
 #include "khu/khu_coins.h"
 #include "primitives/transaction.h"
 
+#include <memory>
+
 class CCoinsViewCache;
+class CKHUStateDB;
 
 /**
  * KHU UTXO Tracking Extensions for CCoinsViewCache
@@ -18,6 +21,11 @@ class CCoinsViewCache;
  * These functions extend CCoinsViewCache to track KHU_T colored coin UTXOs.
  * KHU_T UTXOs are stored separately from regular PIV UTXOs for isolation.
  *
+ * They operate on the active KHU coins view: the innermost live
+ * CKHUCoinsViewScope opened by the calling thread if any, otherwise the KHU
+ * coins tip cache, which sits on top of the KHU state DB and is flushed with
+ * the chainstate.
+ *
  * RÈGLES:
  * - KHU_T = colored coin UTXO (structure similaire à Coin)
  * - Namespace LevelDB 'K' + 'U' (isolation)
@@ -69,7 +77,7 @@ bool GetKHUCoin(const CCoinsViewCache& view, const COutPoint& outpoint, CKHUUTXO
 bool HaveKHUCoin(const CCoinsViewCache& view, const COutPoint& outpoint);
 
 /**
- * GetKHUCoinFromTracking - Retrieve KHU_T UTXO from global tracking map
+ * GetKHUCoinFromTracking - Retrieve KHU_T UTXO from the KHU coins view
  *
  * Used when the CCoinsViewCache may not have the coin (e.g., after
  * standard tx validation spent it, but KHU tracking still has it).
@@ -91,4 +99,52 @@ bool GetKHUCoinFromTracking(const COutPoint& outpoint, CKHUUTXO& coin);
  */
 bool RestoreKHUCoin(const COutPoint& outpoint, const CKHUUTXO& coin);
 
+/**
+ * InitKHUCoinsTip - (Re)create the KHU coins tip cache on top of the state DB
+ *
+ * Called by InitKHUStateDB(). Without a state DB (unit tests) the tip is
+ * backed by an empty view.
+ *
+ * @param db KHU state database (may be nullptr)
+ */
+void InitKHUCoinsTip(CKHUStateDB* db);
+
+/**
+ * FlushKHUCoinsTip - Write the dirty KHU coins of the tip to the state DB
+ *
+ * Called by CommitKHURootTransactions() before the state DB root commit.
+ *
+ * @return true on success
+ */
+bool FlushKHUCoinsTip();
+
+/** Memory used by the KHU coins tip cache (bytes) */
+size_t GetKHUCoinsTipMemoryUsage();
+
+/**
+ * CKHUCoinsViewScope - Per-block child cache of the active KHU coins view
+ *
+ * While alive, AddKHUCoin/SpendKHUCoin/RestoreKHUCoin/... operate on a child
+ * cache. Flush() pushes its changes one level down; if the scope is destroyed
+ * without Flush() (failed block, fJustCheck, TestBlockValidity, VerifyDB) the
+ * changes are dropped. Scopes nest and must be destroyed in reverse order.
+ * A scope is only visible to the thread that opened it; other threads keep
+ * seeing the tip until it is flushed there.
+ */
+class CKHUCoinsViewScope
+{
+private:
+    CKHUCoinsViewCache* pprev;
+    std::unique_ptr<CKHUCoinsViewCache> pview;
+
+public:
+    CKHUCoinsViewScope();
+    ~CKHUCoinsViewScope();
+
+    CKHUCoinsViewScope(const CKHUCoinsViewScope&) = delete;
+    CKHUCoinsViewScope& operator=(const CKHUCoinsViewScope&) = delete;
+
+    bool Flush();
+};
+
 #endif // PIVX_KHU_UTXO_H
@@ -10,15 +10,19 @@
 #include "khu/khu_commitment.h"
 #include "khu/khu_commitmentdb.h"
 #include "khu/khu_dao.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/khu_domc.h"
 #include "khu/khu_domcdb.h"
 #include "khu/khu_domc_tx.h"
 #include "khu/khu_mint.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_redeem.h"
 #include "khu/khu_stake.h"
 #include "khu/khu_state.h"
 #include "khu/khu_statedb.h"
+#include "khu/khu_txindex.h"
 #include "khu/khu_unstake.h"
+#include "khu/khu_utxo.h"
 #include "khu/khu_yield.h"
 #include "khu/zkhu_db.h"
 #include "primitives/block.h"
@@ -27,6 +31,7 @@
 #include "validation.h"
 
 #include <memory>
+#include <vector>
 
 // Global KHU state database
 static std::unique_ptr<CKHUStateDB> pkhustatedb;
@@ -40,13 +45,20 @@ static std::unique_ptr<CZKHUTreeDB> pzkhudb;
 // KHU state lock (protects state transitions)
 static RecursiveMutex cs_khu;
 
-bool InitKHUStateDB(size_t nCacheSize, bool fReindex)
+// KHU state of the chain tip: immutable, replaced with std::atomic_store on tip updates
+static std::shared_ptr<const KhuGlobalState> pkhutipstate;
+
+bool InitKHUStateDB(size_t nCacheSize, bool fReindex, bool fMemory)
 {
     LOCK(cs_khu);
 
     try {
         pkhustatedb.reset();
-        pkhustatedb = std::make_unique<CKHUStateDB>(nCacheSize, false, fReindex);
+        std::atomic_store(&pkhutipstate, std::shared_ptr<const KhuGlobalState>());
+        pkhustatedb = std::make_unique<CKHUStateDB>(nCacheSize, fMemory, fReindex);
+        pkhustatedb->SetPruneMode(gArgs.GetBoolArg("-khustateprune", DEFAULT_KHU_STATE_PRUNE));
+        pkhustatedb->SetPruneKeepDepth(gArgs.GetArg("-maxreorg", DEFAULT_MAX_REORG_DEPTH));
+        InitKHUCoinsTip(pkhustatedb.get());
         return true;
     } catch (const std::exception& e) {
         LogPrintf("ERROR: Failed to initialize KHU state database: %s\n", e.what());
@@ -59,13 +71,13 @@ CKHUStateDB* GetKHUStateDB()
     return pkhustatedb.get();
 }
 
-bool InitKHUCommitmentDB(size_t nCacheSize, bool fReindex)
+bool InitKHUCommitmentDB(size_t nCacheSize, bool fReindex, bool fMemory)
 {
     LOCK(cs_khu);
 
     try {
         pkhucommitmentdb.reset();
-        pkhucommitmentdb = std::make_unique<CKHUCommitmentDB>(nCacheSize, false, fReindex);
+        pkhucommitmentdb = std::make_unique<CKHUCommitmentDB>(nCacheSize, fMemory, fReindex);
         LogPrint(BCLog::KHU, "KHU: Initialized commitment database (Phase 3 Finality)\n");
         return true;
     } catch (const std::exception& e) {
@@ -79,13 +91,18 @@ CKHUCommitmentDB* GetKHUCommitmentDB()
     return pkhucommitmentdb.get();
 }
 
-bool InitZKHUDB(size_t nCacheSize, bool fReindex)
+bool InitZKHUDB(size_t nCacheSize, bool fReindex, bool fMemory)
 {
     LOCK(cs_khu);
 
     try {
         pzkhudb.reset();
-        pzkhudb = std::make_unique<CZKHUTreeDB>(nCacheSize, false, fReindex);
+        pzkhudb = std::make_unique<CZKHUTreeDB>(nCacheSize, fMemory, fReindex);
+        pzkhudb->SetSpentNoteKeepDepth(gArgs.GetArg("-maxreorg", DEFAULT_MAX_REORG_DEPTH));
+        if (!pzkhudb->UpgradeNoteIndex()) {
+            LogPrintf("ERROR: Failed to upgrade ZKHU note index\n");
+            return false;
+        }
         LogPrint(BCLog::KHU, "KHU: Initialized ZKHU database (Phase 4/5 Sapling)\n");
         return true;
     } catch (const std::exception& e) {
@@ -99,8 +116,79 @@ CZKHUTreeDB* GetZKHUDB()
     return pzkhudb.get();
 }
 
+static std::vector<CKHUDBWrapper*> GetKHUDBs()
+{
+    std::vector<CKHUDBWrapper*> vDBs;
+    for (CKHUDBWrapper* db : std::initializer_list<CKHUDBWrapper*>{GetKHUStateDB(), GetKHUCommitmentDB(), GetZKHUDB(), GetKHUDomcDB(), GetKHUTxIndexDB()}) {
+        if (db) vDBs.push_back(db);
+    }
+    return vDBs;
+}
+
+std::unique_ptr<CKHUDBScopedCommitter> BeginKHUTransaction()
+{
+    return std::make_unique<CKHUDBScopedCommitter>(GetKHUDBs());
+}
+
+bool CommitKHURootTransactions()
+{
+    // KHU coins tip first, so its writes go out with the state DB batch
+    if (!FlushKHUCoinsTip()) {
+        return false;
+    }
+    for (CKHUDBWrapper* db : GetKHUDBs()) {
+        if (!db->CommitRootTransaction()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t GetKHUDBMemoryUsage()
+{
+    size_t nUsage = GetKHUCoinsTipMemoryUsage();
+    for (CKHUDBWrapper* db : GetKHUDBs()) {
+        nUsage += db->GetMemoryUsage();
+    }
+    return nUsage;
+}
+
+void PublishKHUTipState(const CBlockIndex* pindexTip)
+{
+    std::shared_ptr<const KhuGlobalState> pstate;
+    CKHUStateDB* db = GetKHUStateDB();
+    if (pindexTip && db) {
+        auto pstateRead = std::make_shared<KhuGlobalState>();
+        if (db->ReadKHUState(pindexTip->nHeight, *pstateRead) && pstateRead->hashBlock == pindexTip->GetBlockHash()) {
+            pstate = std::move(pstateRead);
+        }
+    }
+    std::atomic_store(&pkhutipstate, pstate);
+}
+
+std::shared_ptr<const KhuGlobalState> GetKHUTipState()
+{
+    return std::atomic_load(&pkhutipstate);
+}
+
+std::shared_ptr<const KhuGlobalState> GetKHUTipState(const CBlockIndex* pindexTip)
+{
+    std::shared_ptr<const KhuGlobalState> pstate = GetKHUTipState();
+    if (pstate && pindexTip && pstate->hashBlock == pindexTip->GetBlockHash()) {
+        return pstate;
+    }
+    return nullptr;
+}
+
 bool GetCurrentKHUState(KhuGlobalState& state)
 {
+    std::shared_ptr<const KhuGlobalState> ptipState = GetKHUTipState();
+    if (ptipState) {
+        state = *ptipState;
+        return true;
+    }
+
+    // Nothing published yet (startup) or tip without a KHU state
     LOCK(cs_main);
 
     CBlockIndex* pindex = chainActive.Tip();
@@ -174,14 +262,22 @@ bool ProcessKHUBlock(const CBlock& block,
         return validationState.Error("khu-db-not-initialized");
     }
 
+    // KHU coins of this block, dropped unless the block is persisted
+    CKHUCoinsViewScope khuCoinsView;
+
+    // fJustCheck (TestBlockValidity): every step below is applied against a
+    // scratch overlay - the KHU coins scope above plus the KHU DB transaction
+    // (state, ZKHU notes, DOMC votes) the caller opened and rolls back.
+    assert(!fJustCheck || db->HasBlockTransaction());
+
     // Load previous state (or genesis if first KHU block)
     KhuGlobalState prevState;
     if (nHeight > 0) {
-        if (!db->ReadKHUState(nHeight - 1, prevState)) {
-            // If previous state doesn't exist, use genesis state
-            // This happens at KHU activation height
-            prevState.SetNull();
-            prevState.nHeight = nHeight - 1;
+        // If previous state doesn't exist, use genesis state
+        // This happens at KHU activation height
+        if (!db->LoadKHUState_OrGenesis(nHeight - 1, prevState)) {
+            return validationState.Error(strprintf(
+                "khu-pruned-prev-state: Previous state at height %d was pruned", nHeight - 1));
         } else {
             // ✅ FIX CVE-KHU-2025-002: Vérifier les invariants de l'état chargé
             // CRITICAL: Without this check, a corrupted DB with invalid state (C != U)
@@ -264,18 +360,15 @@ bool ProcessKHUBlock(const CBlock& block,
 
     // STEP 2: DAO Treasury accumulation (Phase 6.3)
     // Budget calculated on INITIAL state (before yield/transactions)
-    // Only apply when !fJustCheck (no DB writes in DAO, but for consistency)
-    if (!fJustCheck && !khu_dao::AccumulateDaoTreasuryIfNeeded(newState, nHeight, consensusParams)) {
+    if (!khu_dao::AccumulateDaoTreasuryIfNeeded(newState, nHeight, consensusParams)) {
         return validationState.Error("dao-treasury-failed");
     }
 
     // STEP 3: Daily Yield distribution (Phase 6.1)
     // Apply daily yield to all mature staked notes (every 1440 blocks)
     // This updates Cr += total_yield, Ur += total_yield (invariant Cr==Ur preserved)
-    // CRITICAL: Only apply when !fJustCheck to avoid double DB writes
-    // ApplyDailyYield writes to ZKHU note DB, so must skip during fJustCheck=true
     // Note: V6_activation already defined above (STEP 1)
-    if (!fJustCheck && khu_yield::ShouldApplyDailyYield(nHeight, V6_activation, newState.last_yield_update_height)) {
+    if (khu_yield::ShouldApplyDailyYield(nHeight, V6_activation, newState.last_yield_update_height)) {
         if (!khu_yield::ApplyDailyYield(newState, nHeight, V6_activation)) {
             return validationState.Error("daily-yield-failed");
         }
@@ -287,80 +380,67 @@ bool ProcessKHUBlock(const CBlock& block,
     // STEP 4: Process KHU transactions
     // Note: Basic transaction validation was done by CheckSpecialTx
     // Here we apply transactions to update newState and view.
-    // DB writes are conditional on !fJustCheck (handled inside Apply* functions or here)
+    // With fJustCheck the writes land in the scratch overlay
+    // Stateless parts (payloads, DOMC votes, nullifiers) are pre-computed for
+    // the whole block on the check queue; this loop only mutates state.
+    std::vector<CKHUTxPrecheck> vPrecheck;
+    PrecheckKHUBlock(block, vPrecheck);
     int nKHUTxCount = 0;
-    for (const auto& tx : block.vtx) {
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransactionRef& tx = block.vtx[i];
+        const CKHUTxPrecheck* pprecheck = &vPrecheck[i];
         if (tx->nType == CTransaction::TxType::KHU_MINT) {
             nKHUTxCount++;
-            // ApplyKHUMint modifies global KHU UTXO map - only call when !fJustCheck
             // Transaction structure validation was already done by CheckSpecialTx
-            if (!fJustCheck) {
-                if (!ApplyKHUMint(*tx, newState, view, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply KHU MINT at height %d", nHeight));
-                }
+            if (!ApplyKHUMint(*tx, newState, view, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply KHU MINT at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_MINT tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
         } else if (tx->nType == CTransaction::TxType::KHU_REDEEM) {
             nKHUTxCount++;
-            // ApplyKHURedeem modifies global KHU UTXO map - only call when !fJustCheck
             // Transaction structure validation was already done by CheckSpecialTx
-            if (!fJustCheck) {
-                if (!ApplyKHURedeem(*tx, newState, view, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply KHU REDEEM at height %d", nHeight));
-                }
+            if (!ApplyKHURedeem(*tx, newState, view, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply KHU REDEEM at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_REDEEM tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
         } else if (tx->nType == CTransaction::TxType::KHU_STAKE) {
             // Phase 4: KHU_T → ZKHU (state unchanged: C, U, Cr, Ur)
-            // ApplyKHUStake writes to ZKHU DB, so only call when !fJustCheck
-            // For fJustCheck=true, we validate structure but skip DB writes
             nKHUTxCount++;
-            if (!fJustCheck) {
-                if (!ApplyKHUStake(*tx, view, newState, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply KHU STAKE at height %d", nHeight));
-                }
+            if (!ApplyKHUStake(*tx, view, newState, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply KHU STAKE at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_STAKE tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
         } else if (tx->nType == CTransaction::TxType::KHU_UNSTAKE) {
             // Phase 4: ZKHU → KHU_T + bonus (double flux: C+, U+, Cr-, Ur-)
             // ApplyKHUUnstake reads from ZKHU DB and modifies state
-            // For fJustCheck=true, skip since it needs prior STAKE data
             nKHUTxCount++;
-            if (!fJustCheck) {
-                if (!ApplyKHUUnstake(*tx, view, newState, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply KHU UNSTAKE at height %d", nHeight));
-                }
+            if (!ApplyKHUUnstake(*tx, view, newState, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply KHU UNSTAKE at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_UNSTAKE tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
         } else if (tx->nType == CTransaction::TxType::KHU_DOMC_COMMIT) {
             // Phase 6.2: DOMC commit vote (Hash(R || salt))
-            // Validation runs in both paths, DB write only when !fJustCheck
             nKHUTxCount++;
-            if (!ValidateDomcCommitTx(*tx, validationState, newState, nHeight, consensusParams)) {
+            if (!ValidateDomcCommitTx(*tx, validationState, newState, nHeight, consensusParams, pprecheck)) {
                 return false; // validationState already set
             }
-            if (!fJustCheck) {
-                if (!ApplyDomcCommitTx(*tx, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply DOMC COMMIT at height %d", nHeight));
-                }
+            if (!ApplyDomcCommitTx(*tx, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply DOMC COMMIT at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_DOMC_COMMIT tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
         } else if (tx->nType == CTransaction::TxType::KHU_DOMC_REVEAL) {
             // Phase 6.2: DOMC reveal vote (R + salt)
-            // Validation runs in both paths, DB write only when !fJustCheck
             nKHUTxCount++;
-            if (!ValidateDomcRevealTx(*tx, validationState, newState, nHeight, consensusParams)) {
+            if (!ValidateDomcRevealTx(*tx, validationState, newState, nHeight, consensusParams, pprecheck)) {
                 return false; // validationState already set
             }
-            if (!fJustCheck) {
-                if (!ApplyDomcRevealTx(*tx, nHeight)) {
-                    return validationState.Error(strprintf("Failed to apply DOMC REVEAL at height %d", nHeight));
-                }
+            if (!ApplyDomcRevealTx(*tx, nHeight, pprecheck)) {
+                return validationState.Error(strprintf("Failed to apply DOMC REVEAL at height %d", nHeight));
             }
             LogPrint(BCLog::KHU, "ProcessKHUBlock: KHU_DOMC_REVEAL tx %s (fJustCheck=%d)\n",
                      tx->GetHash().ToString().substr(0, 16), fJustCheck);
@@ -372,21 +452,19 @@ bool ProcessKHUBlock(const CBlock& block,
     // Post-V6: If this is a budget payment block (superblock), deduct amount from T
     // Budget payments are validated in validation.cpp via IsBlockValueValid/IsBudgetPaymentBlock
     // Here we update the KHU state T to reflect the payment
-    if (!fJustCheck) {
-        CAmount nBudgetAmt = 0;
-        if (g_budgetman.GetExpectedPayeeAmount(nHeight, nBudgetAmt) && nBudgetAmt > 0) {
-            LogPrint(BCLog::KHU, "ProcessKHUBlock: Budget payment detected at height %d, amount=%lld\n",
-                     nHeight, (long long)nBudgetAmt);
+    CAmount nBudgetAmt = 0;
+    if (g_budgetman.GetExpectedPayeeAmount(nHeight, nBudgetAmt) && nBudgetAmt > 0) {
+        LogPrint(BCLog::KHU, "ProcessKHUBlock: Budget payment detected at height %d, amount=%lld\n",
+                 nHeight, (long long)nBudgetAmt);
 
-            if (!khu_dao::DeductBudgetPayment(newState, nBudgetAmt)) {
-                return validationState.Error(strprintf(
-                    "Insufficient DAO Treasury T=%lld for budget payment=%lld at height %d",
-                    (long long)newState.T, (long long)nBudgetAmt, nHeight));
-            }
-
-            LogPrint(BCLog::KHU, "ProcessKHUBlock: Deducted budget %lld from T, T_after=%lld\n",
-                     (long long)nBudgetAmt, (long long)newState.T);
+        if (!khu_dao::DeductBudgetPayment(newState, nBudgetAmt)) {
+            return validationState.Error(strprintf(
+                "Insufficient DAO Treasury T=%lld for budget payment=%lld at height %d",
+                (long long)newState.T, (long long)nBudgetAmt, nHeight));
         }
+
+        LogPrint(BCLog::KHU, "ProcessKHUBlock: Deducted budget %lld from T, T_after=%lld\n",
+                 (long long)nBudgetAmt, (long long)newState.T);
     }
 
     // Verify invariants (CRITICAL)
@@ -401,10 +479,29 @@ bool ProcessKHUBlock(const CBlock& block,
 
     // Persist state to database ONLY when not just checking
     if (!fJustCheck) {
-        if (!db->WriteKHUState(nHeight, newState)) {
+        // Full record at DOMC cycle boundaries: UndoFinalizeDomcCycle reads them a cycle later
+        if (!db->WriteKHUState(nHeight, newState, khu_domc::IsDomcCycleBoundary(nHeight, V6_activation))) {
             LogPrint(BCLog::KHU, "ProcessKHUBlock: FAIL - Write state failed at height %d\n", nHeight);
             return validationState.Error(strprintf("Failed to write KHU state at height %d", nHeight));
         }
+        // Spent notes are only needed to undo UNSTAKE within the reorg window
+        CZKHUTreeDB* zkhudb = GetZKHUDB();
+        if (zkhudb && nHeight > zkhudb->GetSpentNoteKeepDepth()) {
+            const int nPruned = zkhudb->PruneSpentNotes(nHeight - zkhudb->GetSpentNoteKeepDepth());
+            if (nPruned < 0) {
+                return validationState.Error(strprintf("Failed to prune spent ZKHU notes at height %d", nHeight));
+            }
+            if (nPruned > 0) {
+                LogPrint(BCLog::KHU, "ProcessKHUBlock: Pruned %d spent ZKHU notes\n", nPruned);
+            }
+        }
+        CKHUTxIndexDB* txindex = GetKHUTxIndexDB();
+        if (txindex && !txindex->WriteBlock(block, nHeight, view)) {
+            return validationState.Error(strprintf("Failed to write KHU tx index at height %d", nHeight));
+        }
+        if (!khuCoinsView.Flush()) {
+            return validationState.Error(strprintf("Failed to flush KHU coins at height %d", nHeight));
+        }
         LogPrint(BCLog::KHU, "ProcessKHUBlock: SUCCESS - Persisted state at height %d\n", nHeight);
     } else {
         LogPrint(BCLog::KHU, "ProcessKHUBlock: SUCCESS - Validated state at height %d (fJustCheck=true, no persist)\n", nHeight);
@@ -440,6 +537,9 @@ bool DisconnectKHUBlock(const CBlock& block,
         return validationState.Error("khu-db-not-initialized");
     }
 
+    // KHU coins restored/spent by the undo, dropped if the disconnect fails
+    CKHUCoinsViewScope khuCoinsView;
+
     // PHASE 3: Check cryptographic finality via commitments (V6_0+ only)
     // NOTE: DisconnectKHUBlock is only called if NetworkUpgradeActive(V6_0) in validation.cpp
     // but we double-check here for clarity and safety
@@ -525,8 +625,9 @@ bool DisconnectKHUBlock(const CBlock& block,
 
     // PHASE 6: Undo Daily Yield (Phase 6.1)
     // Must be undone AFTER transactions, BEFORE DOMC/DAO (reverse order of Connect)
+    // khuState is the state AT nHeight: a yield event was applied iff last_yield_update_height == nHeight
     uint32_t V6_activation = consensusParams.vUpgrades[Consensus::UPGRADE_V6_0].nActivationHeight;
-    if (khu_yield::ShouldApplyDailyYield(nHeight, V6_activation, khuState.last_yield_update_height)) {
+    if ((uint32_t)nHeight >= V6_activation && khuState.last_yield_update_height == (uint32_t)nHeight) {
         if (!khu_yield::UndoDailyYield(khuState, nHeight, V6_activation)) {
             return validationState.Invalid(false, REJECT_INVALID, "undo-daily-yield-failed",
                 strprintf("Failed to undo daily yield at height %d", nHeight));
@@ -610,6 +711,15 @@ bool DisconnectKHUBlock(const CBlock& block,
         }
     }
 
+    CKHUTxIndexDB* txindex = GetKHUTxIndexDB();
+    if (txindex && !txindex->EraseBlock(nHeight)) {
+        return validationState.Error(strprintf("Failed to erase KHU tx index at height %d", nHeight));
+    }
+
+    if (!khuCoinsView.Flush()) {
+        return validationState.Error(strprintf("Failed to flush KHU coins at height %d", nHeight));
+    }
+
     LogPrint(BCLog::KHU, "KHU: Disconnected block %d (undone %zu transactions)\n", nHeight, block.vtx.size());
 
     return true;
@@ -10,6 +10,7 @@
 class CBlock;
 class CBlockIndex;
 class CCoinsViewCache;
+class CKHUDBScopedCommitter;
 class CValidationState;
 class CKHUStateDB;
 class CKHUCommitmentDB;
@@ -29,6 +30,11 @@ namespace Consensus {
  * - Validates invariants
  * - Persists state to DB (when fJustCheck=false)
  *
+ * With fJustCheck=true (TestBlockValidity, block templates) every step is
+ * still applied - DAO, yield, MINT/REDEEM/STAKE/UNSTAKE, DOMC - but against
+ * a scratch overlay: a KHU coins scope plus the KHU DB transaction the caller
+ * opened with BeginKHUTransaction() and rolls back.
+ *
  * FUTURE PHASES (NOT IMPLEMENTED YET):
  * - Phase 2: MINT/REDEEM operations
  * - Phase 3: Daily YIELD application
@@ -40,7 +46,7 @@ namespace Consensus {
  * @param view Coins view cache
  * @param state Validation state (for errors)
  * @param consensusParams Consensus parameters
- * @param fJustCheck If true, only validate without persisting to DB
+ * @param fJustCheck If true, fully simulate the block without persisting anything
  * @return true if KHU processing succeeded
  */
 bool ProcessKHUBlock(const CBlock& block,
@@ -82,9 +88,10 @@ bool DisconnectKHUBlock(const CBlock& block,
  *
  * @param nCacheSize DB cache size
  * @param fReindex If true, wipe and recreate DB
+ * @param fMemory Keep the DB in memory (tests, benchmarks)
  * @return true on success
  */
-bool InitKHUStateDB(size_t nCacheSize, bool fReindex);
+bool InitKHUStateDB(size_t nCacheSize, bool fReindex, bool fMemory = false);
 
 /**
  * GetKHUStateDB - Get global KHU state database instance
@@ -96,11 +103,38 @@ CKHUStateDB* GetKHUStateDB();
 /**
  * GetCurrentKHUState - Get KHU state at chain tip
  *
+ * Served lock free from the tip snapshot (GetKHUTipState). cs_main is only
+ * taken to read the tip state from the DB when no snapshot is published.
+ *
  * @param state Output parameter for state
  * @return true if state loaded successfully
  */
 bool GetCurrentKHUState(KhuGlobalState& state);
 
+/**
+ * PublishKHUTipState - Publish the KHU state snapshot of a new chain tip
+ *
+ * Called with cs_main held by ConnectTip and DisconnectTip, right after
+ * the tip moves. Reads the state once; a tip without KHU state (pre-V6)
+ * publishes nothing.
+ *
+ * @param pindexTip New chain tip
+ */
+void PublishKHUTipState(const CBlockIndex* pindexTip);
+
+/**
+ * GetKHUTipState - Read-mostly snapshot of the KHU state at the chain tip
+ *
+ * Lock free: no cs_main, cs_khu nor LevelDB access. The snapshot is
+ * immutable and replaced atomically on tip updates; callers holding cs_main
+ * may pass the tip to make sure the snapshot is exactly that block's.
+ *
+ * @param pindexTip If set, the snapshot must be the state of this block
+ * @return Snapshot, or nullptr if none (matching) was published
+ */
+std::shared_ptr<const KhuGlobalState> GetKHUTipState();
+std::shared_ptr<const KhuGlobalState> GetKHUTipState(const CBlockIndex* pindexTip);
+
 /**
  * InitKHUCommitmentDB - Initialize the KHU commitment database
  *
@@ -108,9 +142,10 @@ bool GetCurrentKHUState(KhuGlobalState& state);
  *
  * @param nCacheSize DB cache size
  * @param fReindex If true, wipe and recreate DB
+ * @param fMemory Keep the DB in memory (tests, benchmarks)
  * @return true on success
  */
-bool InitKHUCommitmentDB(size_t nCacheSize, bool fReindex);
+bool InitKHUCommitmentDB(size_t nCacheSize, bool fReindex, bool fMemory = false);
 
 /**
  * GetKHUCommitmentDB - Get global KHU commitment database instance
@@ -129,9 +164,10 @@ CKHUCommitmentDB* GetKHUCommitmentDB();
  *
  * @param nCacheSize DB cache size
  * @param fReindex If true, wipe and recreate DB
+ * @param fMemory Keep the DB in memory (tests, benchmarks)
  * @return true on success
  */
-bool InitZKHUDB(size_t nCacheSize, bool fReindex);
+bool InitZKHUDB(size_t nCacheSize, bool fReindex, bool fMemory = false);
 
 /**
  * GetZKHUDB - Get global ZKHU database instance
@@ -142,4 +178,29 @@ bool InitZKHUDB(size_t nCacheSize, bool fReindex);
  */
 CZKHUTreeDB* GetZKHUDB();
 
+/**
+ * BeginKHUTransaction - Open a block transaction over all KHU databases
+ *
+ * Used next to evoDb->BeginTransaction() around ConnectBlock/DisconnectBlock:
+ * the KHU writes of the block are kept in memory until Commit(), and dropped
+ * if the returned committer is destroyed first.
+ *
+ * @return Scoped committer (rolls back on destruction)
+ */
+std::unique_ptr<CKHUDBScopedCommitter> BeginKHUTransaction();
+
+/**
+ * CommitKHURootTransactions - Write the pending KHU writes of all connected blocks
+ *
+ * Called by FlushStateToDisk with the chainstate: one LevelDB batch per KHU database.
+ *
+ * @return true on success
+ */
+bool CommitKHURootTransactions();
+
+/**
+ * GetKHUDBMemoryUsage - Memory held by KHU writes not flushed yet
+ */
+size_t GetKHUDBMemoryUsage();
+
 #endif // PIVX_KHU_VALIDATION_H
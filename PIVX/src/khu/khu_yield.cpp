@@ -10,6 +10,9 @@
 #include "khu/zkhu_db.h"
 #include "khu/zkhu_note.h"
 #include "logging.h"
+#include "util/system.h"
+
+#include <map>
 
 #include <boost/multiprecision/cpp_int.hpp>
 
@@ -29,152 +32,297 @@ uint32_t GetMaturityBlocks()
 // ============================================================================
 
 /**
- * IterateStakedNotes - Stream all ZKHU notes from LevelDB and apply functor
+ * GetFirstYieldEventAtOrAfter - First yield event height >= nHeight
  *
- * RÈGLE CONSENSUS-CRITICAL:
- * - LevelDB cursors provide deterministic lexicographic order
- * - All nodes will process notes in the same order
- * - No in-memory sorting required
+ * Yield events are on the fixed grid nV6ActivationHeight + k × YIELD_INTERVAL
+ * (see ShouldApplyDailyYield).
+ */
+static uint32_t GetFirstYieldEventAtOrAfter(uint32_t nHeight, uint32_t nV6ActivationHeight)
+{
+    if (nHeight <= nV6ActivationHeight) {
+        return nV6ActivationHeight;
+    }
+    const uint32_t nIntervals = (nHeight - nV6ActivationHeight + YIELD_INTERVAL - 1) / YIELD_INTERVAL;
+    return nV6ActivationHeight + nIntervals * YIELD_INTERVAL;
+}
+
+/**
+ * GetNoteYieldStart - First yield event at which a note is mature
  *
- * BUG #8 FIX: Use CZKHUTreeDB::GetAllNotes() which uses the correct key format.
- * The previous implementation used ad-hoc iteration that didn't match the
- * key serialization used by WriteNote().
+ * IsNoteMature(start, h) <=> h - start >= maturity, so this is the first
+ * grid event at or after nStakeStartHeight + maturity.
+ */
+static uint32_t GetNoteYieldStart(uint32_t nStakeStartHeight, uint32_t nV6ActivationHeight)
+{
+    return GetFirstYieldEventAtOrAfter(nStakeStartHeight + GetMaturityBlocks(), nV6ActivationHeight);
+}
+
+static uint32_t GetV6ActivationHeight()
+{
+    return Params().GetConsensus().vUpgrades[Consensus::UPGRADE_V6_0].nActivationHeight;
+}
+
+/**
+ * RebuildYieldIndex - Recompute the aggregate from the note set for a rate R_annual
+ *
+ * Only called when R_annual changes between two yield events (once per DOMC
+ * cycle), when undoing such an event, and once to migrate notes staked before
+ * the accumulator existed. This is the only O(notes) path of the yield engine.
  *
- * @param func Functor to apply to each note: bool(uint256 noteId, ZKHUNoteData& data)
- * @return true if iteration completed successfully
+ * Notes whose yield start is before nNextEvent are counted in nActiveDailyYield,
+ * later ones go to their maturity bucket. Notes without a yield start snapshot
+ * (legacy) get one at nNextEvent: their Ur_accumulated already holds every
+ * earlier event.
+ *
+ * @param index Index to rebuild (epochs untouched)
+ * @param R_annual Rate used to compute the per-note daily yield
+ * @param nNextEvent Height of the next yield event to be applied
+ * @param nV6ActivationHeight V6_0 activation height
+ * @return true on success, false on overflow or DB error
  */
-template<typename Func>
-static bool IterateStakedNotes(Func func)
+static bool RebuildYieldIndex(ZKHUYieldIndex& index, uint32_t R_annual, uint32_t nNextEvent, uint32_t nV6ActivationHeight)
 {
     CZKHUTreeDB* zkhuDB = GetZKHUDB();
     if (!zkhuDB) {
-        // DB not initialized (e.g., test environment or before ZKHU activation)
-        // This is valid - treat as empty note set, iteration succeeds with zero notes
-        LogPrint(BCLog::KHU, "IterateStakedNotes: ZKHU DB not initialized (empty note set)\n");
         return true;
     }
 
-    LogPrint(BCLog::KHU, "IterateStakedNotes: DB initialized, using GetAllNotes()...\n");
-
-    // BUG #8 FIX: Use the encapsulated GetAllNotes() method which uses the correct
-    // key format matching WriteNote(). This ensures iteration finds all notes.
-    std::vector<std::pair<uint256, ZKHUNoteData>> allNotes = zkhuDB->GetAllNotes();
-
-    LogPrint(BCLog::KHU, "IterateStakedNotes: GetAllNotes returned %zu notes\n", allNotes.size());
+    using int128_t = boost::multiprecision::int128_t;
+    int128_t active128 = 0;
+    std::map<uint32_t, int128_t> mapBuckets;
+    uint32_t nLastBucket = nNextEvent + GetMaturityBlocks() + YIELD_INTERVAL;
+    size_t nNotes = 0;
+
+    // Active index is ordered by stake height: spent notes are never visited
+    bool success = zkhuDB->IterateActiveNotes([&](const uint256& noteId, uint32_t nStakeStartHeight, CAmount amount) {
+        uint32_t nYieldStart = 0;
+        if (!zkhuDB->ReadNoteYieldStart(noteId, nYieldStart)) {
+            nYieldStart = std::max(nNextEvent, GetNoteYieldStart(nStakeStartHeight, nV6ActivationHeight));
+            if (!zkhuDB->WriteNoteYieldStart(noteId, nYieldStart)) {
+                LogPrintf("ERROR: RebuildYieldIndex: Failed to write yield start of note %s\n", noteId.GetHex());
+                return false;
+            }
+        }
 
-    for (const auto& notePair : allNotes) {
-        const uint256& noteId = notePair.first;
-        ZKHUNoteData noteData = notePair.second;  // Copy for functor to modify
+        const CAmount dailyYield = CalculateDailyYieldForNote(amount, R_annual);
+        if (nYieldStart < nNextEvent) {
+            active128 += dailyYield;
+        } else {
+            mapBuckets[nYieldStart] += dailyYield;
+            nLastBucket = std::max(nLastBucket, nYieldStart);
+        }
+        nNotes++;
+        return true;
+    });
 
-        LogPrint(BCLog::KHU, "IterateStakedNotes: processing note %s amount=%lld stakeHeight=%u\n",
-                 noteId.GetHex().substr(0, 16).c_str(), (long long)noteData.amount, noteData.nStakeStartHeight);
+    if (!success) {
+        return false;
+    }
 
-        // Apply functor
-        if (!func(noteId, noteData)) {
+    if (active128 > std::numeric_limits<CAmount>::max()) {
+        LogPrintf("ERROR: RebuildYieldIndex: Overflow on active daily yield\n");
+        return false;
+    }
+    index.nActiveDailyYield = static_cast<CAmount>(active128);
+
+    // Pending buckets all lie within one maturity period of the next event
+    for (uint32_t nEvent = nNextEvent; nEvent <= nLastBucket; nEvent += YIELD_INTERVAL) {
+        const auto it = mapBuckets.find(nEvent);
+        const int128_t bucket = (it != mapBuckets.end()) ? it->second : 0;
+        if (bucket > std::numeric_limits<CAmount>::max()) {
+            LogPrintf("ERROR: RebuildYieldIndex: Overflow on maturity bucket %u\n", nEvent);
+            return false;
+        }
+        if (!zkhuDB->WriteMaturityBucket(nEvent, static_cast<CAmount>(bucket))) {
+            LogPrintf("ERROR: RebuildYieldIndex: Failed to write maturity bucket %u\n", nEvent);
             return false;
         }
     }
 
-    LogPrint(BCLog::KHU, "IterateStakedNotes: iteration complete, processed %zu notes\n", allNotes.size());
+    LogPrint(BCLog::KHU, "RebuildYieldIndex: R_annual=%u nextEvent=%u notes=%zu activeDailyYield=%lld\n",
+             R_annual, nNextEvent, nNotes, (long long)index.nActiveDailyYield);
 
     return true;
 }
 
 /**
- * CalculateAndAccumulateYield - Calculate yield for all mature notes AND update their Ur_accumulated
+ * UpdateNoteContribution - Add or remove the daily yield of one note from the aggregate
  *
- * ALGORITHME CONSENSUS-CRITICAL:
- * 1. Iterate all ZKHU notes via LevelDB cursor (deterministic order)
- * 2. For each mature note: calculate daily yield, update Ur_accumulated, write to DB
- * 3. Accumulate total yield for global state update
- * 4. Protect against overflow using int128_t
+ * The note contributes to nActiveDailyYield once its yield start event has been
+ * applied, to its maturity bucket before that.
+ */
+static bool UpdateNoteContribution(CZKHUTreeDB* zkhuDB, const ZKHUYieldIndex& index,
+                                   uint32_t nYieldStart, CAmount amount, bool fAdd, CAmount& nActiveDailyYield)
+{
+    const CAmount dailyYield = CalculateDailyYieldForNote(amount, index.vEpochs.back().R_annual);
+    const CAmount delta = fAdd ? dailyYield : -dailyYield;
+
+    if (index.nLastEventHeight >= nYieldStart) {
+        nActiveDailyYield += delta;
+        if (nActiveDailyYield < 0) {
+            return error("%s: negative active daily yield", __func__);
+        }
+        return true;
+    }
+
+    const CAmount bucket = zkhuDB->ReadMaturityBucket(nYieldStart) + delta;
+    if (bucket < 0) {
+        return error("%s: negative maturity bucket at %u", __func__, nYieldStart);
+    }
+    return zkhuDB->WriteMaturityBucket(nYieldStart, bucket);
+}
+
+static bool UpdateYieldIndexForNote(const uint256& noteId, const ZKHUNoteData& note, bool fAdd)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    if (!zkhuDB) {
+        return true;
+    }
+
+    uint32_t nYieldStart = 0;
+    if (!zkhuDB->ReadNoteYieldStart(noteId, nYieldStart)) {
+        // Untracked note (legacy), picked up by the next RebuildYieldIndex
+        return true;
+    }
+
+    ZKHUYieldIndex index;
+    if (!zkhuDB->ReadYieldIndex(index) || index.IsNull()) {
+        // No yield event yet: the first ApplyDailyYield builds the aggregate
+        return true;
+    }
+
+    CAmount nActiveDailyYield = index.nActiveDailyYield;
+    if (!UpdateNoteContribution(zkhuDB, index, nYieldStart, note.amount, fAdd, nActiveDailyYield)) {
+        return false;
+    }
+    if (nActiveDailyYield != index.nActiveDailyYield) {
+        index.nActiveDailyYield = nActiveDailyYield;
+        return zkhuDB->WriteYieldIndex(index);
+    }
+    return true;
+}
+
+/**
+ * AdvanceYieldIndex - Apply one yield event to the aggregate accumulator
  *
- * BUG #6 FIX: This function now updates each note's Ur_accumulated in the ZKHU database.
- * Previously, only global Cr/Ur were updated but individual notes' Ur_accumulated
- * remained at 0, causing UNSTAKE to return 0 yield.
+ * O(1) in the number of notes: the total is the running active daily yield
+ * plus the notes maturing at this event (their maturity bucket). Falls back to
+ * RebuildYieldIndex only when R_annual changed since the previous event.
  *
- * @param nHeight Current block height
- * @param R_annual Annual yield rate (basis points)
- * @param totalYield Output: total yield calculated (satoshis)
- * @return true on success, false on overflow or error
+ * @param nHeight Yield event height
+ * @param R_annual Rate of this event (basis points)
+ * @param nLastYieldHeight Previous yield event height from the global state (0 if none)
+ * @param nV6ActivationHeight V6_0 activation height
+ * @param totalYield Output: total yield of the event (satoshis)
+ * @return true on success, false on overflow or DB error
  */
-static bool CalculateAndAccumulateYield(uint32_t nHeight, uint16_t R_annual, CAmount& totalYield)
+static bool AdvanceYieldIndex(uint32_t nHeight, uint32_t R_annual, uint32_t nLastYieldHeight,
+                              uint32_t nV6ActivationHeight, CAmount& totalYield)
 {
     totalYield = 0;
 
     CZKHUTreeDB* zkhuDB = GetZKHUDB();
     if (!zkhuDB) {
         // DB not initialized - no notes to process
-        LogPrint(BCLog::KHU, "CalculateAndAccumulateYield: ZKHU DB not initialized\n");
+        LogPrint(BCLog::KHU, "AdvanceYieldIndex: ZKHU DB not initialized\n");
         return true;
     }
 
-    // Use int128_t for overflow-safe accumulation
-    using int128_t = boost::multiprecision::int128_t;
-    int128_t totalYield128 = 0;
-
-    // Collect notes to update (we can't modify during iteration)
-    std::vector<std::pair<uint256, ZKHUNoteData>> notesToUpdate;
-
-    bool success = IterateStakedNotes([&](const uint256& noteId, const ZKHUNoteData& note) {
-        // BUG #6 FIX: Skip notes that have been spent (UNSTAKE'd)
-        // Notes are kept in DB for undo support, but bSpent flag is set
-        if (note.bSpent) {
-            LogPrint(BCLog::KHU, "CalculateAndAccumulateYield: Skipping spent note %s (bSpent=true)\n",
-                     noteId.GetHex().substr(0, 16).c_str());
-            return true; // Skip spent note, continue iteration
+    ZKHUYieldIndex index;
+    zkhuDB->ReadYieldIndex(index);
+
+    // The index must describe exactly the yield events applied to the state.
+    // Drop events beyond it (interrupted disconnect), start over if history is missing.
+    bool fRebuild = false;
+    if (!index.IsNull() && index.nLastEventHeight != nLastYieldHeight) {
+        LogPrintf("AdvanceYieldIndex: yield index at %u does not match state (last yield %u), rebuilding\n",
+                  index.nLastEventHeight, nLastYieldHeight);
+        while (!index.vEpochs.empty() && index.vEpochs.back().nFirstHeight > nLastYieldHeight) {
+            index.vEpochs.pop_back();
+        }
+        if (!index.vEpochs.empty()) {
+            ZKHUYieldEpoch& epoch = index.vEpochs.back();
+            epoch.nEvents = std::min(epoch.nEvents, (nLastYieldHeight - epoch.nFirstHeight) / YIELD_INTERVAL + 1);
+            index.nLastEventHeight = epoch.nFirstHeight + (epoch.nEvents - 1) * YIELD_INTERVAL;
         }
+        if (index.nLastEventHeight != nLastYieldHeight) {
+            index = ZKHUYieldIndex();
+        }
+        fRebuild = true;
+    }
 
-        // Check note maturity
-        if (!IsNoteMature(note.nStakeStartHeight, nHeight)) {
-            return true; // Skip immature note, continue iteration
+    const bool fNewEpoch = index.IsNull() || index.vEpochs.back().R_annual != R_annual;
+    if (fRebuild || fNewEpoch) {
+        if (!RebuildYieldIndex(index, R_annual, nHeight, nV6ActivationHeight)) {
+            return false;
         }
+    }
+    if (fNewEpoch) {
+        index.vEpochs.emplace_back(nHeight, R_annual);
+    }
 
-        // Calculate daily yield for this note
-        CAmount dailyYield = CalculateDailyYieldForNote(note.amount, R_annual);
+    // Notes reaching maturity at this event join the active set
+    using int128_t = boost::multiprecision::int128_t;
+    int128_t active128 = static_cast<int128_t>(index.nActiveDailyYield) + zkhuDB->ReadMaturityBucket(nHeight);
+    if (active128 > std::numeric_limits<CAmount>::max()) {
+        LogPrintf("ERROR: AdvanceYieldIndex: Overflow detected at height %u\n", nHeight);
+        return false;
+    }
 
-        // Accumulate with overflow protection
-        totalYield128 += dailyYield;
+    index.nActiveDailyYield = static_cast<CAmount>(active128);
+    index.vEpochs.back().nEvents++;
+    index.nLastEventHeight = nHeight;
 
-        // Check for overflow (should never happen with realistic values)
-        if (totalYield128 > std::numeric_limits<CAmount>::max()) {
-            LogPrintf("ERROR: CalculateAndAccumulateYield: Overflow detected at note %s\n",
-                      noteId.GetHex());
-            return false; // Stop iteration
-        }
+    if (!zkhuDB->WriteYieldIndex(index)) {
+        LogPrintf("ERROR: AdvanceYieldIndex: Failed to write yield index at height %u\n", nHeight);
+        return false;
+    }
 
-        // BUG #6 FIX: Store note for Ur_accumulated update
-        ZKHUNoteData updatedNote = note;
-        updatedNote.Ur_accumulated += dailyYield;
-        notesToUpdate.emplace_back(noteId, updatedNote);
+    totalYield = index.nActiveDailyYield;
 
-        LogPrint(BCLog::KHU, "CalculateAndAccumulateYield: Note %s amount=%lld dailyYield=%lld newUr=%lld\n",
-                 noteId.GetHex().substr(0, 16).c_str(), (long long)note.amount,
-                 (long long)dailyYield, (long long)updatedNote.Ur_accumulated);
+    LogPrint(BCLog::KHU, "AdvanceYieldIndex: height=%u R_annual=%u epochs=%zu totalYield=%lld\n",
+             nHeight, R_annual, index.vEpochs.size(), (long long)totalYield);
 
-        return true; // Continue iteration
-    });
+    return true;
+}
 
-    if (!success) {
-        return false;
+/**
+ * RewindYieldIndex - Revert AdvanceYieldIndex for the yield event at nHeight
+ */
+static bool RewindYieldIndex(uint32_t nHeight, uint32_t nV6ActivationHeight)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    if (!zkhuDB) {
+        return true;
     }
 
-    // BUG #6 FIX: Write updated notes back to DB
-    for (const auto& notePair : notesToUpdate) {
-        if (!zkhuDB->WriteNote(notePair.first, notePair.second)) {
-            LogPrintf("ERROR: CalculateAndAccumulateYield: Failed to write note %s\n",
-                      notePair.first.GetHex());
-            return false;
-        }
+    ZKHUYieldIndex index;
+    if (!zkhuDB->ReadYieldIndex(index) || index.IsNull() || index.nLastEventHeight != nHeight) {
+        // Nothing recorded for this event, AdvanceYieldIndex resyncs on the next one
+        LogPrint(BCLog::KHU, "RewindYieldIndex: no yield index entry at height %u\n", nHeight);
+        return true;
     }
 
-    LogPrint(BCLog::KHU, "CalculateAndAccumulateYield: Updated %zu notes with yield\n",
-             notesToUpdate.size());
+    index.nActiveDailyYield -= zkhuDB->ReadMaturityBucket(nHeight);
+    if (index.nActiveDailyYield < 0) {
+        return error("%s: negative active daily yield at height %u", __func__, nHeight);
+    }
 
-    // Safe cast to CAmount (overflow already checked)
-    totalYield = static_cast<CAmount>(totalYield128);
+    index.vEpochs.back().nEvents--;
+    index.nLastEventHeight = (nHeight > nV6ActivationHeight) ? nHeight - YIELD_INTERVAL : 0;
 
-    return true;
+    if (index.vEpochs.back().nEvents == 0) {
+        index.vEpochs.pop_back();
+        if (index.vEpochs.empty()) {
+            return zkhuDB->EraseYieldIndex();
+        }
+        // Event opened a new R_annual epoch: recompute the aggregate at the previous rate
+        if (!RebuildYieldIndex(index, index.vEpochs.back().R_annual, nHeight, nV6ActivationHeight)) {
+            return false;
+        }
+    }
+
+    return zkhuDB->WriteYieldIndex(index);
 }
 
 // ============================================================================
@@ -210,10 +358,9 @@ bool ApplyDailyYield(KhuGlobalState& state, uint32_t nHeight, uint32_t nV6Activa
         return false;
     }
 
-    // BUG #6 FIX: Calculate total yield AND update each note's Ur_accumulated
     CAmount totalYield = 0;
-    if (!CalculateAndAccumulateYield(nHeight, state.R_annual, totalYield)) {
-        LogPrintf("ERROR: ApplyDailyYield: Failed to calculate/accumulate yield at height %u\n", nHeight);
+    if (!AdvanceYieldIndex(nHeight, state.R_annual, state.last_yield_update_height, nV6ActivationHeight, totalYield)) {
+        LogPrintf("ERROR: ApplyDailyYield: Failed to advance yield index at height %u\n", nHeight);
         return false;
     }
 
@@ -248,53 +395,9 @@ bool UndoDailyYield(KhuGlobalState& state, uint32_t nHeight, uint32_t nV6Activat
         return false;
     }
 
-    // ═══════════════════════════════════════════════════════════
-    // BUG #6 FIX: Undo per-note Ur_accumulated updates
-    // ═══════════════════════════════════════════════════════════
-    CZKHUTreeDB* zkhuDB = GetZKHUDB();
-    if (zkhuDB && totalYield > 0) {
-        // Collect notes to update
-        std::vector<std::pair<uint256, ZKHUNoteData>> notesToUpdate;
-
-        IterateStakedNotes([&](const uint256& noteId, const ZKHUNoteData& note) {
-            // BUG #6 FIX: Skip notes that were spent (same as in CalculateAndAccumulateYield)
-            // During reorg, spent notes should not have yield undone (was never added)
-            if (note.bSpent) {
-                return true; // Skip spent note
-            }
-
-            // Only process notes that were mature at this height
-            if (!IsNoteMature(note.nStakeStartHeight, nHeight)) {
-                return true; // Skip immature note
-            }
-
-            // Calculate the yield that was added for this note
-            CAmount dailyYield = CalculateDailyYieldForNote(note.amount, state.R_annual);
-
-            // Prepare updated note with yield subtracted
-            ZKHUNoteData updatedNote = note;
-            if (updatedNote.Ur_accumulated >= dailyYield) {
-                updatedNote.Ur_accumulated -= dailyYield;
-            } else {
-                // Edge case: yield was already claimed via UNSTAKE, skip
-                LogPrint(BCLog::KHU, "UndoDailyYield: Note %s has Ur_accumulated=%lld < dailyYield=%lld, skipping\n",
-                         noteId.GetHex().substr(0, 16).c_str(),
-                         (long long)updatedNote.Ur_accumulated, (long long)dailyYield);
-            }
-            notesToUpdate.emplace_back(noteId, updatedNote);
-
-            return true;
-        });
-
-        // Write updated notes back to DB
-        for (const auto& notePair : notesToUpdate) {
-            if (!zkhuDB->WriteNote(notePair.first, notePair.second)) {
-                LogPrintf("ERROR: UndoDailyYield: Failed to write note %s\n", notePair.first.GetHex());
-                return false;
-            }
-        }
-
-        LogPrint(BCLog::KHU, "UndoDailyYield: Reverted yield on %zu notes\n", notesToUpdate.size());
+    if (!RewindYieldIndex(nHeight, nV6ActivationHeight)) {
+        LogPrintf("ERROR: UndoDailyYield: Failed to rewind yield index at height %u\n", nHeight);
+        return false;
     }
 
     // ═══════════════════════════════════════════════════════════
@@ -331,6 +434,90 @@ bool UndoDailyYield(KhuGlobalState& state, uint32_t nHeight, uint32_t nV6Activat
     return true;
 }
 
+bool GetNoteAccumulatedYield(const uint256& noteId, const ZKHUNoteData& note, uint32_t nHeight, CAmount& nYield)
+{
+    nYield = note.Ur_accumulated;
+
+    // Yield of a spent note was materialised on UNSTAKE
+    if (note.bSpent) {
+        return true;
+    }
+
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    if (!zkhuDB) {
+        return true;
+    }
+
+    uint32_t nYieldStart = 0;
+    ZKHUYieldIndex index;
+    if (!zkhuDB->ReadNoteYieldStart(noteId, nYieldStart) || !zkhuDB->ReadYieldIndex(index)) {
+        return true;
+    }
+
+    using int128_t = boost::multiprecision::int128_t;
+    int128_t yield128 = nYield;
+
+    for (const ZKHUYieldEpoch& epoch : index.vEpochs) {
+        if (epoch.nEvents == 0) continue;
+
+        const uint32_t nLastEvent = epoch.nFirstHeight + (epoch.nEvents - 1) * YIELD_INTERVAL;
+        const uint32_t nFrom = std::max(epoch.nFirstHeight, nYieldStart);
+        const uint32_t nTo = std::min(nLastEvent, nHeight);
+        if (nFrom > nTo) continue;
+
+        // Events of the epoch within [nFrom, nTo]
+        const uint32_t kFrom = (nFrom - epoch.nFirstHeight + YIELD_INTERVAL - 1) / YIELD_INTERVAL;
+        const uint32_t kTo = (nTo - epoch.nFirstHeight) / YIELD_INTERVAL;
+        if (kFrom > kTo) continue;
+
+        yield128 += static_cast<int128_t>(CalculateDailyYieldForNote(note.amount, epoch.R_annual)) * (kTo - kFrom + 1);
+    }
+
+    if (yield128 > std::numeric_limits<CAmount>::max()) {
+        return error("%s: overflow for note %s", __func__, noteId.GetHex());
+    }
+
+    nYield = static_cast<CAmount>(yield128);
+    return true;
+}
+
+bool AddNoteToYieldIndex(const uint256& noteId, const ZKHUNoteData& note)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    if (!zkhuDB) {
+        return true;
+    }
+
+    const uint32_t nYieldStart = GetNoteYieldStart(note.nStakeStartHeight, GetV6ActivationHeight());
+    if (!zkhuDB->WriteNoteYieldStart(noteId, nYieldStart)) {
+        return error("%s: failed to write yield start of note %s", __func__, noteId.GetHex());
+    }
+    return UpdateYieldIndexForNote(noteId, note, true);
+}
+
+bool RemoveNoteFromYieldIndex(const uint256& noteId, const ZKHUNoteData& note)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    if (!zkhuDB) {
+        return true;
+    }
+
+    if (!UpdateYieldIndexForNote(noteId, note, false)) {
+        return false;
+    }
+    return zkhuDB->EraseNoteYieldStart(noteId);
+}
+
+bool DeactivateNoteYield(const uint256& noteId, const ZKHUNoteData& note)
+{
+    return UpdateYieldIndexForNote(noteId, note, false);
+}
+
+bool ReactivateNoteYield(const uint256& noteId, const ZKHUNoteData& note)
+{
+    return UpdateYieldIndexForNote(noteId, note, true);
+}
+
 CAmount CalculateDailyYieldForNote(CAmount amount, uint16_t R_annual)
 {
     // FORMULE CONSENSUS (basis points):
@@ -7,6 +7,7 @@
 
 #include "amount.h"
 #include "khu/khu_state.h"
+#include "khu/zkhu_note.h"
 
 #include <stdint.h>
 
@@ -15,13 +16,19 @@
  *
  * RÈGLES ARCHITECTURALES (consensus-critical):
  * - Aucune note stockée dans KhuGlobalState
- * - Lecture streaming LevelDB via curseur (ordre déterministe)
  * - Yield pour notes stakées + matures (≥ 4320 blocks)
  * - Intervalle 1440 blocks
- * - Formule: daily = (amount × R_annual / 10000) / 365
+ * - Formule: daily = (amount × R_annual / 10000) / 365 (floor, PER-NOTE)
  * - Total yield → Cr += daily_total, Ur += daily_total (invariant Cr==Ur)
- * - Undo par recalcul et soustraction
+ * - Undo par montant stocké (last_yield_amount)
  * - Protection overflow avec int128_t
+ *
+ * ACCUMULATEUR LAZY (ZKHUYieldIndex, DB ZKHU):
+ * - daily_total = Σ daily(note) des notes actives, maintenu incrémentalement
+ *   (STAKE → bucket de maturité, UNSTAKE → retrait, événement → fusion du bucket)
+ * - Epochs R_annual: per-note yield = Σ daily(amount, R_e) × événements de l'epoch
+ * - Ur_accumulated matérialisé uniquement au UNSTAKE
+ * - Coût d'un bloc de yield indépendant du nombre de notes (sauf changement de R%)
  */
 
 namespace khu_yield {
@@ -74,12 +81,11 @@ bool ShouldApplyDailyYield(uint32_t nHeight, uint32_t nV6ActivationHeight, uint3
  * ApplyDailyYield - Apply daily yield to all mature staked notes
  *
  * ALGORITHME CONSENSUS-CRITICAL:
- * 1. Iterate all ZKHU notes via LevelDB cursor (deterministic order)
- * 2. For each note:
- *    - Check maturity: height_current - note.nStakeStartHeight >= MATURITY_BLOCKS
- *    - Calculate daily yield: (amount × R_annual / 10000) / 365
- *    - Accumulate total_yield (with overflow protection)
- * 3. Update global state: Cr += total_yield, Ur += total_yield
+ * 1. Advance the lazy yield index:
+ *    - total_yield = active daily yield + notes maturing at this event
+ *    - Equal to Σ (amount × R_annual / 10000) / 365 over mature unspent notes
+ *    - Recomputed from the note set only when R_annual changed
+ * 2. Update global state: Cr += total_yield, Ur += total_yield
  *    (BOTH must be updated to maintain invariant Cr == Ur)
  *
  * @param state KHU global state (will be modified: Cr += total_yield, Ur += total_yield)
@@ -94,7 +100,8 @@ bool ApplyDailyYield(KhuGlobalState& state, uint32_t nHeight, uint32_t nV6Activa
  *
  * ALGORITHME:
  * 1. Use stored yield amount from state.last_yield_amount
- * 2. Subtract from BOTH: Cr -= total_yield, Ur -= total_yield
+ * 2. Rewind the lazy yield index by one event
+ * 3. Subtract from BOTH: Cr -= total_yield, Ur -= total_yield
  *    (BOTH must be updated to maintain invariant Cr == Ur)
  *
  * @param state KHU global state (will be modified: Cr -= total_yield, Ur -= total_yield)
@@ -138,6 +145,34 @@ CAmount CalculateDailyYieldForNote(CAmount amount, uint16_t R_annual);
  */
 bool IsNoteMature(uint32_t noteHeight, uint32_t currentHeight);
 
+/**
+ * GetNoteAccumulatedYield - Yield owed to a note at a given height
+ *
+ * Ur_accumulated (materialised part) + Σ epochs daily(amount, R_e) × events
+ * of the epoch between the note's first mature event and nHeight. Bit-exact
+ * with crediting daily(amount, R) to the note at every yield event.
+ *
+ * @param noteId Note commitment
+ * @param note Note data (spent notes return Ur_accumulated as is)
+ * @param nHeight Height of the UNSTAKE (events applied up to it are counted)
+ * @param nYield Output: accumulated yield (satoshis)
+ * @return true on success, false on overflow
+ */
+bool GetNoteAccumulatedYield(const uint256& noteId, const ZKHUNoteData& note, uint32_t nHeight, CAmount& nYield);
+
+/**
+ * Lazy yield index maintenance (called with cs_khu held, never on fJustCheck)
+ *
+ * - AddNoteToYieldIndex: STAKE, snapshots the note's first mature yield event
+ * - RemoveNoteFromYieldIndex: undo STAKE
+ * - DeactivateNoteYield: UNSTAKE, the note stops earning
+ * - ReactivateNoteYield: undo UNSTAKE
+ */
+bool AddNoteToYieldIndex(const uint256& noteId, const ZKHUNoteData& note);
+bool RemoveNoteFromYieldIndex(const uint256& noteId, const ZKHUNoteData& note);
+bool DeactivateNoteYield(const uint256& noteId, const ZKHUNoteData& note);
+bool ReactivateNoteYield(const uint256& noteId, const ZKHUNoteData& note);
+
 } // namespace khu_yield
 
 #endif // PIVX_KHU_YIELD_H
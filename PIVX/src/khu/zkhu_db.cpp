@@ -4,19 +4,41 @@
 
 #include "khu/zkhu_db.h"
 
+#include "clientversion.h"
+#include "compat/endian.h"
 #include "util/system.h"
 
 // ZKHU namespace key prefixes
 static constexpr char DB_ZKHU_ANCHOR = 'A';      // 'K' + 'A' + anchor → SaplingMerkleTree
 static constexpr char DB_ZKHU_NULLIFIER = 'N';  // 'K' + 'N' + nullifier → bool
-static constexpr char DB_ZKHU_NOTE = 'T';       // 'K' + 'T' + note_id → ZKHUNoteData
+static constexpr char DB_ZKHU_NOTE = 'T';       // 'K' + 'T' + note_id → ZKHUNoteData (unspent)
+static constexpr char DB_ZKHU_SPENT_NOTE = 'X'; // 'K' + 'X' + note_id → ZKHUNoteData (spent, cold)
+static constexpr char DB_ZKHU_PRUNE = 'P';      // 'K' + 'P' + (BE spend height, note_id) → char
+static constexpr char DB_ZKHU_VERSION = 'V';    // 'K' + 'V' → int (note index version)
 static constexpr char DB_ZKHU_LOOKUP = 'L';     // 'K' + 'L' + nullifier → cm
+static constexpr char DB_ZKHU_YIELD_INDEX = 'Y';     // 'K' + 'Y' → ZKHUYieldIndex
+static constexpr char DB_ZKHU_MATURITY = 'M';        // 'K' + 'M' + height → CAmount
+static constexpr char DB_ZKHU_YIELD_START = 'S';     // 'K' + 'S' + note_id → uint32_t
+static constexpr char DB_ACTIVE_INDEX = 'H';         // 'K' + 'H' + (BE stake height, note_id) → CAmount
 
 // Master namespace for all ZKHU data
 static constexpr char DB_ZKHU_NAMESPACE = 'K';
 
+// 1: active note index + cold storage of spent notes
+static constexpr int ZKHU_NOTE_INDEX_VERSION = 1;
+
+static std::pair<char, std::pair<char, uint256>> NoteKey(char prefix, const uint256& noteId)
+{
+    return std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(prefix, noteId));
+}
+
+static std::pair<char, std::pair<char, std::pair<uint32_t, uint256>>> HeightNoteKey(char prefix, uint32_t nHeight, const uint256& noteId)
+{
+    return std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(prefix, std::make_pair(htobe32(nHeight), noteId)));
+}
+
 CZKHUTreeDB::CZKHUTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) :
-    CDBWrapper(GetDataDir() / "khu" / "zkhu", nCacheSize, fMemory, fWipe)
+    CKHUDBWrapper(GetDataDir() / "khu" / "zkhu", nCacheSize, fMemory, fWipe)
 {
 }
 
@@ -55,17 +77,136 @@ bool CZKHUTreeDB::EraseNullifier(const uint256& nullifier)
 
 bool CZKHUTreeDB::WriteNote(const uint256& noteId, const ZKHUNoteData& data)
 {
-    return Write(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_NOTE, noteId)), data);
+    LOCK(cs);
+    const auto activeKey = HeightNoteKey(DB_ACTIVE_INDEX, data.nStakeStartHeight, noteId);
+    if (data.bSpent) {
+        Write(NoteKey(DB_ZKHU_SPENT_NOTE, noteId), data);
+        Erase(NoteKey(DB_ZKHU_NOTE, noteId));
+        Erase(activeKey);
+    } else {
+        Write(NoteKey(DB_ZKHU_NOTE, noteId), data);
+        Write(activeKey, data.amount);
+        Erase(NoteKey(DB_ZKHU_SPENT_NOTE, noteId));
+    }
+    return true;
 }
 
 bool CZKHUTreeDB::ReadNote(const uint256& noteId, ZKHUNoteData& data) const
 {
-    return Read(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_NOTE, noteId)), data);
+    return Read(NoteKey(DB_ZKHU_NOTE, noteId), data) ||
+           Read(NoteKey(DB_ZKHU_SPENT_NOTE, noteId), data);
 }
 
 bool CZKHUTreeDB::EraseNote(const uint256& noteId)
 {
-    return Erase(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_NOTE, noteId)));
+    LOCK(cs);
+    ZKHUNoteData data;
+    if (!ReadNote(noteId, data)) {
+        return true;
+    }
+    Erase(NoteKey(DB_ZKHU_NOTE, noteId));
+    Erase(NoteKey(DB_ZKHU_SPENT_NOTE, noteId));
+    Erase(HeightNoteKey(DB_ACTIVE_INDEX, data.nStakeStartHeight, noteId));
+    return true;
+}
+
+bool CZKHUTreeDB::SpendNote(const uint256& noteId, const ZKHUNoteData& data, int nSpendHeight)
+{
+    LOCK(cs);
+    ZKHUNoteData spent = data;
+    spent.bSpent = true;
+
+    Write(NoteKey(DB_ZKHU_SPENT_NOTE, noteId), spent);
+    Write(HeightNoteKey(DB_ZKHU_PRUNE, nSpendHeight, noteId), '1');
+    Erase(NoteKey(DB_ZKHU_NOTE, noteId));
+    Erase(HeightNoteKey(DB_ACTIVE_INDEX, spent.nStakeStartHeight, noteId));
+    return true;
+}
+
+bool CZKHUTreeDB::UnspendNote(const uint256& noteId, const ZKHUNoteData& data, int nSpendHeight)
+{
+    LOCK(cs);
+    ZKHUNoteData unspent = data;
+    unspent.bSpent = false;
+
+    Write(NoteKey(DB_ZKHU_NOTE, noteId), unspent);
+    Write(HeightNoteKey(DB_ACTIVE_INDEX, unspent.nStakeStartHeight, noteId), unspent.amount);
+    Erase(NoteKey(DB_ZKHU_SPENT_NOTE, noteId));
+    Erase(HeightNoteKey(DB_ZKHU_PRUNE, nSpendHeight, noteId));
+    return true;
+}
+
+int CZKHUTreeDB::PruneSpentNotes(int nMaxSpendHeight)
+{
+    if (nMaxSpendHeight < 0) {
+        return 0;
+    }
+
+    LOCK(cs);
+
+    // Collect first: erasing invalidates the pending-writes side of the cursor
+    std::vector<std::pair<uint32_t, uint256>> vPrune;
+    {
+        std::unique_ptr<Iterator> pcursor(NewIterator());
+        pcursor->Seek(HeightNoteKey(DB_ZKHU_PRUNE, 0, uint256()));
+
+        while (pcursor->Valid()) {
+            std::pair<char, std::pair<char, std::pair<uint32_t, uint256>>> key;
+            if (!pcursor->GetKey(key) || key.first != DB_ZKHU_NAMESPACE || key.second.first != DB_ZKHU_PRUNE) {
+                break;
+            }
+            if (be32toh(key.second.second.first) > (uint32_t)nMaxSpendHeight) {
+                break;
+            }
+            vPrune.emplace_back(be32toh(key.second.second.first), key.second.second.second);
+            pcursor->Next();
+        }
+    }
+
+    for (const auto& it : vPrune) {
+        const uint256& noteId = it.second;
+        ZKHUNoteData data;
+        if (Read(NoteKey(DB_ZKHU_SPENT_NOTE, noteId), data)) {
+            Erase(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_LOOKUP, data.nullifier)));
+        }
+        Erase(NoteKey(DB_ZKHU_SPENT_NOTE, noteId));
+        Erase(NoteKey(DB_ZKHU_YIELD_START, noteId));
+        Erase(HeightNoteKey(DB_ZKHU_PRUNE, it.first, noteId));
+    }
+    return (int)vPrune.size();
+}
+
+bool CZKHUTreeDB::UpgradeNoteIndex()
+{
+    int nVersion = 0;
+    if (Read(std::make_pair(DB_ZKHU_NAMESPACE, DB_ZKHU_VERSION), nVersion) && nVersion >= ZKHU_NOTE_INDEX_VERSION) {
+        return true;
+    }
+
+    // Pre-index records: every note (spent or not) is under 'T'.
+    // Runs at startup before any block: written directly, not through the KHU transaction.
+    size_t nActive = 0, nSpent = 0;
+    CDBBatch batch(CLIENT_VERSION);
+    for (const auto& it : GetAllNotes()) {
+        const uint256& noteId = it.first;
+        const ZKHUNoteData& data = it.second;
+        if (data.bSpent) {
+            // Spend height unknown: kept in cold storage, never pruned
+            batch.Write(NoteKey(DB_ZKHU_SPENT_NOTE, noteId), data);
+            batch.Erase(NoteKey(DB_ZKHU_NOTE, noteId));
+            nSpent++;
+        } else {
+            batch.Write(HeightNoteKey(DB_ACTIVE_INDEX, data.nStakeStartHeight, noteId), data.amount);
+            nActive++;
+        }
+    }
+    batch.Write(std::make_pair(DB_ZKHU_NAMESPACE, DB_ZKHU_VERSION), ZKHU_NOTE_INDEX_VERSION);
+    if (!CDBWrapper::WriteBatch(batch, true)) {
+        return false;
+    }
+
+    LogPrintf("ZKHU: note index upgraded (%zu active, %zu spent notes)\n", nActive, nSpent);
+    return true;
 }
 
 // ========== Nullifier → Commitment Mapping Operations ==========
@@ -85,14 +226,92 @@ bool CZKHUTreeDB::EraseNullifierMapping(const uint256& nullifier)
     return Erase(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_LOOKUP, nullifier)));
 }
 
+// ========== Lazy Yield Accumulator Operations ==========
+
+bool CZKHUTreeDB::WriteYieldIndex(const ZKHUYieldIndex& index)
+{
+    return Write(std::make_pair(DB_ZKHU_NAMESPACE, DB_ZKHU_YIELD_INDEX), index);
+}
+
+bool CZKHUTreeDB::ReadYieldIndex(ZKHUYieldIndex& index) const
+{
+    return Read(std::make_pair(DB_ZKHU_NAMESPACE, DB_ZKHU_YIELD_INDEX), index);
+}
+
+bool CZKHUTreeDB::EraseYieldIndex()
+{
+    return Erase(std::make_pair(DB_ZKHU_NAMESPACE, DB_ZKHU_YIELD_INDEX));
+}
+
+bool CZKHUTreeDB::WriteMaturityBucket(uint32_t nEventHeight, CAmount nDailyYield)
+{
+    if (nDailyYield == 0) {
+        return EraseMaturityBucket(nEventHeight);
+    }
+    return Write(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_MATURITY, nEventHeight)), nDailyYield);
+}
+
+CAmount CZKHUTreeDB::ReadMaturityBucket(uint32_t nEventHeight) const
+{
+    CAmount nDailyYield = 0;
+    Read(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_MATURITY, nEventHeight)), nDailyYield);
+    return nDailyYield;
+}
+
+bool CZKHUTreeDB::EraseMaturityBucket(uint32_t nEventHeight)
+{
+    return Erase(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_MATURITY, nEventHeight)));
+}
+
+bool CZKHUTreeDB::WriteNoteYieldStart(const uint256& noteId, uint32_t nEventHeight)
+{
+    return Write(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_YIELD_START, noteId)), nEventHeight);
+}
+
+bool CZKHUTreeDB::ReadNoteYieldStart(const uint256& noteId, uint32_t& nEventHeight) const
+{
+    return Read(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_YIELD_START, noteId)), nEventHeight);
+}
+
+bool CZKHUTreeDB::EraseNoteYieldStart(const uint256& noteId)
+{
+    return Erase(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_YIELD_START, noteId)));
+}
+
 // ========== Note Iteration Operations ==========
 
+bool CZKHUTreeDB::IterateActiveNotes(const std::function<bool(const uint256&, uint32_t, CAmount)>& func,
+                                     uint32_t nMaxStakeHeight)
+{
+    LOCK(cs);
+    std::unique_ptr<Iterator> pcursor(NewIterator());
+    pcursor->Seek(HeightNoteKey(DB_ACTIVE_INDEX, 0, uint256()));
+
+    while (pcursor->Valid()) {
+        std::pair<char, std::pair<char, std::pair<uint32_t, uint256>>> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ZKHU_NAMESPACE || key.second.first != DB_ACTIVE_INDEX) {
+            break;
+        }
+        const uint32_t nStakeStartHeight = be32toh(key.second.second.first);
+        if (nStakeStartHeight > nMaxStakeHeight) {
+            break;
+        }
+        CAmount amount = 0;
+        if (!pcursor->GetValue(amount) || !func(key.second.second.second, nStakeStartHeight, amount)) {
+            return false;
+        }
+        pcursor->Next();
+    }
+    return true;
+}
+
 std::vector<std::pair<uint256, ZKHUNoteData>> CZKHUTreeDB::GetAllNotes()
 {
     std::vector<std::pair<uint256, ZKHUNoteData>> result;
 
-    // Create iterator using CDBWrapper's NewIterator
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    // Iterator over the DB merged with the pending block writes
+    LOCK(cs);
+    std::unique_ptr<Iterator> pcursor(NewIterator());
 
     // Seek to start of note namespace: 'K' + 'T' + zero-hash
     pcursor->Seek(std::make_pair(DB_ZKHU_NAMESPACE, std::make_pair(DB_ZKHU_NOTE, uint256())));
@@ -104,7 +323,7 @@ std::vector<std::pair<uint256, ZKHUNoteData>> CZKHUTreeDB::GetAllNotes()
             break;
         }
 
-        // Check if still in ZKHU note namespace ('K' + 'T')
+        // Check if still in live ZKHU note namespace ('K' + 'T')
         if (key.first != DB_ZKHU_NAMESPACE || key.second.first != DB_ZKHU_NOTE) {
             break; // End of notes
         }
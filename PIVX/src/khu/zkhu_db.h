@@ -5,11 +5,15 @@
 #ifndef PIVX_KHU_ZKHU_DB_H
 #define PIVX_KHU_ZKHU_DB_H
 
-#include "dbwrapper.h"
+#include "consensus/consensus.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/zkhu_note.h"
 #include "sapling/incrementalmerkletree.h"
 #include "uint256.h"
 
+#include <functional>
+#include <limits>
+
 /**
  * CZKHUTreeDB - ZKHU Database (namespace 'K')
  *
@@ -22,10 +26,16 @@
  * Key Prefixes:
  * - 'K' + 'A' + anchor → SaplingMerkleTree (ZKHU anchor)
  * - 'K' + 'N' + nullifier → bool (ZKHU nullifier spent flag)
- * - 'K' + 'T' + note_id → ZKHUNoteData (ZKHU note metadata)
+ * - 'K' + 'T' + note_id → ZKHUNoteData (live ZKHU note metadata, unspent)
+ * - 'K' + 'X' + note_id → ZKHUNoteData (cold storage: spent notes kept for undo)
+ * - 'K' + 'H' + (BE stake height, note_id) → CAmount (active notes by maturity bucket)
+ * - 'K' + 'P' + (BE spend height, note_id) → char (spent notes pending pruning)
  * - 'K' + 'L' + nullifier → cm (nullifier→commitment mapping for UNSTAKE)
+ * - 'K' + 'Y' → ZKHUYieldIndex (aggregate yield accumulator)
+ * - 'K' + 'M' + height → CAmount (daily yield of notes maturing at that yield event)
+ * - 'K' + 'S' + note_id → uint32_t (first yield event of the note, snapshot at STAKE)
  */
-class CZKHUTreeDB : public CDBWrapper
+class CZKHUTreeDB : public CKHUDBWrapper
 {
 public:
     explicit CZKHUTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
@@ -34,7 +44,14 @@ private:
     CZKHUTreeDB(const CZKHUTreeDB&);
     void operator=(const CZKHUTreeDB&);
 
+    //! Spent notes are kept in cold storage for undo this many blocks (-maxreorg)
+    int nSpentNoteKeepDepth{DEFAULT_MAX_REORG_DEPTH};
+
 public:
+    /** Reorg window the spent notes must cover, set from -maxreorg at init */
+    void SetSpentNoteKeepDepth(int nDepth) { nSpentNoteKeepDepth = nDepth; }
+    int GetSpentNoteKeepDepth() const { return nSpentNoteKeepDepth; }
+
     /**
      * Anchor operations
      */
@@ -50,11 +67,33 @@ public:
 
     /**
      * Note operations
+     * Unspent notes live under 'T' and in the active index, spent notes under 'X'.
+     * WriteNote routes on data.bSpent, ReadNote looks in both.
      */
     bool WriteNote(const uint256& noteId, const ZKHUNoteData& data);
     bool ReadNote(const uint256& noteId, ZKHUNoteData& data) const;
     bool EraseNote(const uint256& noteId);
 
+    /**
+     * Spend / unspend a note (UNSTAKE and its undo)
+     * Moves the note between live and cold storage and (un)schedules its pruning.
+     */
+    bool SpendNote(const uint256& noteId, const ZKHUNoteData& data, int nSpendHeight);
+    bool UnspendNote(const uint256& noteId, const ZKHUNoteData& data, int nSpendHeight);
+
+    /**
+     * Erase spent notes (and their nullifier mapping / yield snapshot) spent
+     * at or below nMaxSpendHeight. Nullifiers themselves are never pruned.
+     * @return number of pruned notes, -1 on error
+     */
+    int PruneSpentNotes(int nMaxSpendHeight);
+
+    /**
+     * One-time upgrade of a pre-index database: build the active note index
+     * and move spent notes to cold storage.
+     */
+    bool UpgradeNoteIndex();
+
     /**
      * Nullifier → Commitment mapping (for UNSTAKE lookup)
      * Phase 5: Required for ApplyKHUUnstake to find note from nullifier
@@ -64,17 +103,34 @@ public:
     bool EraseNullifierMapping(const uint256& nullifier);
 
     /**
-     * Iterate all ZKHU notes (for yield calculation)
-     * Bug #8 Fix: Uses encapsulated iteration with correct key format
-     * @param func Functor: bool(uint256 noteId, ZKHUNoteData& data) - return false to stop
-     * @return true if iteration completed, false on error
+     * Lazy yield accumulator (Phase 6.1)
+     * Aggregate index, per-event maturity buckets and per-note yield start snapshots
+     */
+    bool WriteYieldIndex(const ZKHUYieldIndex& index);
+    bool ReadYieldIndex(ZKHUYieldIndex& index) const;
+    bool EraseYieldIndex();
+
+    bool WriteMaturityBucket(uint32_t nEventHeight, CAmount nDailyYield);
+    CAmount ReadMaturityBucket(uint32_t nEventHeight) const;
+    bool EraseMaturityBucket(uint32_t nEventHeight);
+
+    bool WriteNoteYieldStart(const uint256& noteId, uint32_t nEventHeight);
+    bool ReadNoteYieldStart(const uint256& noteId, uint32_t& nEventHeight) const;
+    bool EraseNoteYieldStart(const uint256& noteId);
+
+    /**
+     * Iterate the active (unspent) notes in stake height order, without
+     * deserializing note records. Spent notes are never visited.
+     * @param func Functor: bool(uint256 noteId, uint32_t nStakeStartHeight, CAmount amount) - return false to stop
+     * @param nMaxStakeHeight Stop after notes staked at this height
+     * @return true if iteration completed, false if stopped by func
      */
-    template<typename Func>
-    bool IterateNotes(Func func) const;
+    bool IterateActiveNotes(const std::function<bool(const uint256&, uint32_t, CAmount)>& func,
+                            uint32_t nMaxStakeHeight = std::numeric_limits<uint32_t>::max());
 
     /**
-     * Get all ZKHU notes as a vector (convenience function)
-     * Note: Not const because NewIterator() is non-const in CDBWrapper
+     * Get all live (unspent) ZKHU notes as a vector (convenience function)
+     * Note: Not const because NewIterator() is non-const in CKHUDBWrapper
      * @return vector of (noteId, noteData) pairs
      */
     std::vector<std::pair<uint256, ZKHUNoteData>> GetAllNotes();
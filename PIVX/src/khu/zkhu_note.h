@@ -10,6 +10,7 @@
 #include "uint256.h"
 
 #include <stdint.h>
+#include <vector>
 
 /**
  * ZKHUNoteData - Private staking note metadata
@@ -51,4 +52,50 @@ struct ZKHUNoteData
     }
 };
 
+/**
+ * ZKHUYieldEpoch - Run of consecutive daily yield events sharing one R_annual
+ *
+ * Events of an epoch are at nFirstHeight + k × YIELD_INTERVAL, k < nEvents.
+ * A new epoch is opened whenever R_annual differs from the previous event.
+ */
+struct ZKHUYieldEpoch
+{
+    uint32_t nFirstHeight;        // Height of the first yield event of the epoch
+    uint32_t R_annual;            // Rate applied to every event of the epoch (basis points)
+    uint32_t nEvents;             // Number of yield events applied in the epoch
+
+    ZKHUYieldEpoch() : nFirstHeight(0), R_annual(0), nEvents(0) {}
+    ZKHUYieldEpoch(uint32_t heightIn, uint32_t rIn) : nFirstHeight(heightIn), R_annual(rIn), nEvents(0) {}
+
+    SERIALIZE_METHODS(ZKHUYieldEpoch, obj)
+    {
+        READWRITE(obj.nFirstHeight, obj.R_annual, obj.nEvents);
+    }
+};
+
+/**
+ * ZKHUYieldIndex - Aggregate (lazy) yield accumulator
+ *
+ * RÈGLE CONSENSUS:
+ * - nActiveDailyYield = Σ daily(amount, R) of all unspent notes already mature
+ *   at nLastEventHeight, with daily() the per-note floor division
+ * - Per-note yield is Σ epochs daily(amount, R_e) × events_in_window,
+ *   materialised into Ur_accumulated on UNSTAKE only
+ */
+struct ZKHUYieldIndex
+{
+    std::vector<ZKHUYieldEpoch> vEpochs;
+    CAmount  nActiveDailyYield;   // Yield paid by the next event (before new maturities)
+    uint32_t nLastEventHeight;    // Height of the last applied yield event (0 if none)
+
+    ZKHUYieldIndex() : nActiveDailyYield(0), nLastEventHeight(0) {}
+
+    bool IsNull() const { return vEpochs.empty(); }
+
+    SERIALIZE_METHODS(ZKHUYieldIndex, obj)
+    {
+        READWRITE(obj.vEpochs, obj.nActiveDailyYield, obj.nLastEventHeight);
+    }
+};
+
 #endif // PIVX_KHU_ZKHU_NOTE_H
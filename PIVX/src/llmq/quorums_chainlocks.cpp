@@ -9,6 +9,8 @@
 #include "quorums_utils.h"
 
 #include "chain.h"
+#include "compat/endian.h"
+#include "dbwrapper.h"
 #include "net_processing.h"
 #include "scheduler.h"
 #include "spork.h"
@@ -21,6 +23,14 @@ namespace llmq
 
 static const std::string CLSIG_REQUESTID_PREFIX = "clsig";
 
+static const std::string DB_CHAINLOCK_BY_HEIGHT = "cl_h";
+static const std::string DB_BEST_CHAINLOCK_HEIGHT = "cl_b";
+
+static std::pair<std::string, uint32_t> ChainLockHeightKey(int nHeight)
+{
+    return std::make_pair(DB_CHAINLOCK_BY_HEIGHT, (uint32_t)htobe32((uint32_t)nHeight));
+}
+
 std::unique_ptr<CChainLocksHandler> chainLocksHandler{nullptr};
 
 bool CChainLockSig::IsNull() const
@@ -33,8 +43,9 @@ std::string CChainLockSig::ToString() const
     return strprintf("CChainLockSig(nHeight=%d, blockHash=%s)", nHeight, blockHash.ToString());
 }
 
-CChainLocksHandler::CChainLocksHandler(CScheduler* _scheduler) :
-    scheduler(_scheduler)
+CChainLocksHandler::CChainLocksHandler(CScheduler* _scheduler, CDBWrapper& _db) :
+    scheduler(_scheduler),
+    db(_db)
 {
 }
 
@@ -44,6 +55,7 @@ CChainLocksHandler::~CChainLocksHandler()
 
 void CChainLocksHandler::Start()
 {
+    LoadBestChainLock();
     quorumSigningManager->RegisterRecoveredSigsListener(this);
     scheduler->scheduleEvery([&]() {
         EnforceBestChainLock();
@@ -142,6 +154,7 @@ void CChainLocksHandler::ProcessNewChainLock(NodeId from, const llmq::CChainLock
 
         bestChainLockHash = hash;
         bestChainLock = clsig;
+        WriteChainLock(clsig);
 
         CInv inv(MSG_CLSIG, hash);
         g_connman->RelayInv(inv, LLMQS_PROTO_VERSION);
@@ -163,6 +176,7 @@ void CChainLocksHandler::ProcessNewChainLock(NodeId from, const llmq::CChainLock
         const CBlockIndex* pindex = blockIt->second;
         bestChainLockWithKnownBlock = bestChainLock;
         bestChainLockBlockIndex = pindex;
+        UpdateFinalizedHeight(chainActive.Tip());
     }
 
     scheduler->scheduleFromNow([&]() {
@@ -193,6 +207,7 @@ void CChainLocksHandler::AcceptedBlockHeader(const CBlockIndex* pindexNew)
         // block processing logic will handle this when the block arrives
         bestChainLockWithKnownBlock = bestChainLock;
         bestChainLockBlockIndex = pindexNew;
+        UpdateFinalizedHeight(chainActive.Tip());
     }
 }
 
@@ -202,6 +217,7 @@ void CChainLocksHandler::UpdatedBlockTip(const CBlockIndex* pindexNew)
     // never locked and TrySignChainTip is not called twice in parallel. Also avoids recursive calls due to
     // EnforceBestChainLock switching chains.
     LOCK(cs);
+    UpdateFinalizedHeight(pindexNew);
     if (tryLockChainTipScheduled) {
         return;
     }
@@ -458,6 +474,108 @@ bool CChainLocksHandler::InternalHasConflictingChainLock(int nHeight, const uint
     return pAncestor->GetBlockHash() != blockHash;
 }
 
+bool CChainLocksHandler::GetChainLockByHeight(int nHeight, CChainLockSig& ret)
+{
+    return db.Read(ChainLockHeightKey(nHeight), ret);
+}
+
+int CChainLocksHandler::GetFinalizedHeight() const
+{
+    if (!sporkManager.IsSporkActive(SPORK_23_CHAINLOCKS_ENFORCEMENT)) {
+        return -1;
+    }
+    return finalizedHeight;
+}
+
+int CChainLocksHandler::GetFinalizedHeight(const CBlockIndex* pindex)
+{
+    if (!sporkManager.IsSporkActive(SPORK_23_CHAINLOCKS_ENFORCEMENT)) {
+        return -1;
+    }
+
+    LOCK(cs);
+    if (!bestChainLockBlockIndex || !pindex) {
+        return -1;
+    }
+    return LastCommonAncestor(pindex, bestChainLockBlockIndex)->nHeight;
+}
+
+void CChainLocksHandler::UpdateFinalizedHeight(const CBlockIndex* pindexTip)
+{
+    AssertLockHeld(cs);
+
+    // The best ChainLock and its ancestors are final, as far as they are part of the active chain
+    int nHeight = -1;
+    if (bestChainLockBlockIndex && pindexTip) {
+        if (pindexTip->nHeight >= bestChainLockBlockIndex->nHeight) {
+            if (pindexTip->GetAncestor(bestChainLockBlockIndex->nHeight) == bestChainLockBlockIndex) {
+                nHeight = bestChainLockBlockIndex->nHeight;
+            }
+        } else if (bestChainLockBlockIndex->GetAncestor(pindexTip->nHeight) == pindexTip) {
+            nHeight = pindexTip->nHeight;
+        }
+    }
+    finalizedHeight = nHeight;
+}
+
+void CChainLocksHandler::WriteChainLock(const CChainLockSig& clsig)
+{
+    CDBBatch batch(CLIENT_VERSION | ADDRV2_FORMAT);
+    batch.Write(ChainLockHeightKey(clsig.nHeight), clsig);
+    batch.Write(DB_BEST_CHAINLOCK_HEIGHT, clsig.nHeight);
+    db.WriteBatch(batch);
+}
+
+void CChainLocksHandler::LoadBestChainLock()
+{
+    int32_t nHeight;
+    CChainLockSig clsig;
+    if (!db.Read(DB_BEST_CHAINLOCK_HEIGHT, nHeight) || !GetChainLockByHeight(nHeight, clsig)) {
+        return;
+    }
+
+    LOCK2(cs_main, cs);
+    if (!bestChainLock.IsNull() && bestChainLock.nHeight >= clsig.nHeight) {
+        return;
+    }
+    bestChainLockHash = ::SerializeHash(clsig);
+    bestChainLock = clsig;
+
+    auto blockIt = mapBlockIndex.find(clsig.blockHash);
+    if (blockIt != mapBlockIndex.end() && blockIt->second->nHeight == clsig.nHeight) {
+        bestChainLockWithKnownBlock = bestChainLock;
+        bestChainLockBlockIndex = blockIt->second;
+        UpdateFinalizedHeight(chainActive.Tip());
+    }
+    LogPrintf("CChainLocksHandler::%s -- loaded CLSIG (%s), finalized height %d\n", __func__, clsig.ToString(), finalizedHeight);
+}
+
+void CChainLocksHandler::CleanupStoredChainLocks(int nBestHeight)
+{
+    const int nCutoff = nBestHeight - CHAINLOCK_DB_KEEP_DEPTH;
+    if (nCutoff <= 0) {
+        return;
+    }
+
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(ChainLockHeightKey(0));
+
+    CDBBatch batch(CLIENT_VERSION | ADDRV2_FORMAT);
+    while (pcursor->Valid()) {
+        std::pair<std::string, uint32_t> k;
+        if (!pcursor->GetKey(k) || k.first != DB_CHAINLOCK_BY_HEIGHT || (int)be32toh(k.second) >= nCutoff) {
+            break;
+        }
+        batch.Erase(k);
+        pcursor->Next();
+    }
+    pcursor.reset();
+
+    if (batch.SizeEstimate() > 0) {
+        db.WriteBatch(batch);
+    }
+}
+
 void CChainLocksHandler::Cleanup()
 {
     if (!g_tiertwo_sync_state.IsBlockchainSynced()) {
@@ -481,6 +599,10 @@ void CChainLocksHandler::Cleanup()
         }
     }
 
+    if (!bestChainLock.IsNull()) {
+        CleanupStoredChainLocks(bestChainLock.nHeight);
+    }
+
     lastCleanupTime = GetTimeMillis();
 }
 
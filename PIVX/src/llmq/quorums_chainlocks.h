@@ -15,6 +15,7 @@
 #include <atomic>
 
 class CBlockIndex;
+class CDBWrapper;
 class CScheduler;
 
 namespace llmq
@@ -43,9 +44,13 @@ class CChainLocksHandler : public CRecoveredSigsListener
 {
     static const int64_t CLEANUP_INTERVAL = 1000 * 30;
     static const int64_t CLEANUP_SEEN_TIMEOUT = 24 * 60 * 60 * 1000;
+    // stored ChainLocks are kept for this many blocks below the best one
+    static const int CHAINLOCK_DB_KEEP_DEPTH = 30 * 24 * 60;
 
 private:
     CScheduler* scheduler;
+    // accepted ChainLocks by height, so that the best one survives restarts
+    CDBWrapper& db;
     RecursiveMutex cs;
     bool tryLockChainTipScheduled{false};
 
@@ -54,6 +59,8 @@ private:
 
     CChainLockSig bestChainLockWithKnownBlock;
     const CBlockIndex* bestChainLockBlockIndex{nullptr};
+    // height of bestChainLockBlockIndex while it is part of the active chain, -1 otherwise
+    std::atomic<int> finalizedHeight{-1};
 
     int32_t lastSignedHeight{-1};
     uint256 lastSignedRequestId;
@@ -64,7 +71,7 @@ private:
     int64_t lastCleanupTime{0};
 
 public:
-    explicit CChainLocksHandler(CScheduler* _scheduler);
+    CChainLocksHandler(CScheduler* _scheduler, CDBWrapper& _db);
     ~CChainLocksHandler();
     void Start();
     void Stop();
@@ -85,10 +92,29 @@ public:
     bool HasChainLock(int nHeight, const uint256& blockHash);
     bool HasConflictingChainLock(int nHeight, const uint256& blockHash);
 
+    /** ChainLock accepted at nHeight, from the persistent store */
+    bool GetChainLockByHeight(int nHeight, CChainLockSig& ret);
+    /**
+     * Heights of the active chain up to this one are ChainLocked and can't be reorganized
+     * (-1 without ChainLock or while the spork is off). Lock free.
+     */
+    int GetFinalizedHeight() const;
+    /**
+     * Height up to which the chain ending at pindex is ChainLocked: the fork point with the best
+     * ChainLock (-1 without ChainLock or while the spork is off). Unlike GetFinalizedHeight, valid
+     * for blocks of another chain than the active one (reorgs).
+     */
+    int GetFinalizedHeight(const CBlockIndex* pindex);
+
 private:
     // these require locks to be held already
     bool InternalHasChainLock(int nHeight, const uint256& blockHash);
     bool InternalHasConflictingChainLock(int nHeight, const uint256& blockHash);
+    void UpdateFinalizedHeight(const CBlockIndex* pindexTip);
+
+    void WriteChainLock(const CChainLockSig& clsig);
+    void LoadBestChainLock();
+    void CleanupStoredChainLocks(int nBestHeight);
 
     void DoInvalidateBlock(const CBlockIndex* pindex, bool activateBestChain);
 
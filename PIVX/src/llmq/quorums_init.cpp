@@ -30,9 +30,9 @@ void InitLLMQSystem(CEvoDB& evoDb, CScheduler* scheduler, bool unitTests)
     quorumBlockProcessor.reset(new CQuorumBlockProcessor(evoDb));
     quorumDKGSessionManager.reset(new CDKGSessionManager(*llmqDb, *blsWorker));
     quorumManager.reset(new CQuorumManager(evoDb, *blsWorker, *quorumDKGSessionManager));
-    quorumSigSharesManager.reset(new CSigSharesManager());
+    quorumSigSharesManager.reset(new CSigSharesManager(*blsWorker));
     quorumSigningManager.reset(new CSigningManager(*llmqDb, unitTests));
-    chainLocksHandler.reset(new CChainLocksHandler(scheduler));
+    chainLocksHandler.reset(new CChainLocksHandler(scheduler, *llmqDb));
 }
 
 void DestroyLLMQSystem()
@@ -6,7 +6,7 @@
 #include "quorums_signing.h"
 
 #include "activemasternode.h"
-#include "bls/bls_batchverifier.h"
+#include "bls/bls_worker.h"
 #include "cxxtimer.h"
 #include "init.h"
 #include "net.h"
@@ -186,9 +186,11 @@ void CSigSharesNodeState::RemoveSession(const uint256& signHash)
 
 //////////////////////
 
-CSigSharesManager::CSigSharesManager()
+CSigSharesManager::CSigSharesManager(CBLSWorker& _blsWorker) :
+    blsWorker(_blsWorker)
 {
     interruptSigningShare.reset();
+    verifyStats.maxUniqueSessions = MIN_VERIFY_UNIQUE_SESSIONS;
 }
 
 CSigSharesManager::~CSigSharesManager()
@@ -598,6 +600,11 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
             ns.pendingIncomingSigShares.Erase(sigShare.GetKey());
             return !ns.pendingIncomingSigShares.Empty(); }, rnd);
 
+        verifyStats.pendingSigShares = 0;
+        for (const auto& p : nodeStates) {
+            verifyStats.pendingSigShares += p.second.pendingIncomingSigShares.Size();
+        }
+
         if (retSigShares.empty()) {
             return;
         }
@@ -630,17 +637,17 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     std::unordered_map<NodeId, std::vector<CSigShare>> sigSharesByNodes;
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
-    CollectPendingSigSharesToVerify(32, sigSharesByNodes, quorums);
+    const size_t maxUniqueSessions = WITH_LOCK(cs, return verifyStats.maxUniqueSessions; );
+    CollectPendingSigSharesToVerify(maxUniqueSessions, sigSharesByNodes, quorums);
     if (sigSharesByNodes.empty()) {
         return false;
     }
 
     // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
     // which are not craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
+    CSigSharesBatchVerifier batchVerifier(MAX_VERIFY_BATCHES);
 
     cxxtimer::Timer prepareTimer(true);
-    size_t verifyCount = 0;
     for (auto& p : sigSharesByNodes) {
         auto nodeId = p.first;
         auto& v = p.second;
@@ -668,23 +675,33 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
                 assert(false);
             }
 
-            batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
-            verifyCount++;
+            batchVerifier.PushSigShare(nodeId, sigShare, pubKeyShare);
         }
     }
     prepareTimer.stop();
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    batchVerifier.Verify(blsWorker);
     verifyTimer.stop();
 
-    LogPrint(BCLog::LLMQ, "CSigSharesManager::%s -- verified sig shares. count=%d, pt=%d, vt=%d, nodes=%d\n", __func__, verifyCount, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
+    const std::set<NodeId>& badSources = batchVerifier.badSources;
+    const size_t verifyCount = batchVerifier.GetSigShareCount();
+    size_t pendingSigShares;
+    {
+        LOCK(cs);
+        verifyStats.UpdateRound(verifyCount, badSources.size(), verifyTimer.count(),
+                                MIN_VERIFY_UNIQUE_SESSIONS, MAX_VERIFY_UNIQUE_SESSIONS);
+        pendingSigShares = verifyStats.pendingSigShares;
+    }
+
+    LogPrint(BCLog::LLMQ, "CSigSharesManager::%s -- verified sig shares. count=%d, batches=%d, pt=%d, vt=%d, nodes=%d, pending=%d\n", __func__,
+        verifyCount, batchVerifier.GetBatchCount(), prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size(), pendingSigShares);
 
     for (auto& p : sigSharesByNodes) {
         auto nodeId = p.first;
         auto& v = p.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             LogPrintf("CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
                 __func__, nodeId);
             // this will also cause re-requesting of the shares that were sent by this node
@@ -698,6 +715,69 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     return true;
 }
 
+void CSigSharesVerifyStats::UpdateRound(size_t verifyCount, size_t badSourceCount, int64_t verifyTime, size_t minSessions, size_t maxSessions)
+{
+    rounds++;
+    verifiedSigShares += verifyCount;
+    badSources += badSourceCount;
+    lastVerifyTime = verifyTime;
+    totalVerifyTime += verifyTime;
+
+    // Grow the rounds while shares pile up, shrink them back once the backlog is gone. A bad share makes
+    // its batch fall back to per-share verification, so after one we restart from small rounds.
+    if (badSourceCount != 0) {
+        maxUniqueSessions = minSessions;
+    } else if (pendingSigShares > verifyCount) {
+        maxUniqueSessions = std::min(maxUniqueSessions * 2, maxSessions);
+    } else if (pendingSigShares == 0) {
+        maxUniqueSessions = std::max(maxUniqueSessions / 2, minSessions);
+    }
+}
+
+size_t CSigSharesBatchVerifier::PushSigShare(NodeId nodeId, const CSigShare& sigShare, const CBLSPublicKey& pubKeyShare)
+{
+    auto it = sessionBatches.find(sigShare.GetSignHash());
+    if (it == sessionBatches.end()) {
+        size_t batchIdx = sessionBatches.size() % maxBatches;
+        if (batchIdx == batchVerifiers.size()) {
+            batchVerifiers.emplace_back(std::make_unique<BatchVerifier>(false, true));
+        }
+        it = sessionBatches.emplace(sigShare.GetSignHash(), batchIdx).first;
+    }
+    batchVerifiers[it->second]->PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
+    sigShareCount++;
+    return it->second;
+}
+
+void CSigSharesBatchVerifier::Verify(CBLSWorker& blsWorker)
+{
+    if (batchVerifiers.size() > 1) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(batchVerifiers.size());
+        for (auto& batchVerifier : batchVerifiers) {
+            BatchVerifier* pbatchVerifier = batchVerifier.get();
+            futures.emplace_back(blsWorker.AsyncRun([pbatchVerifier]() { pbatchVerifier->Verify(); }));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    } else {
+        for (auto& batchVerifier : batchVerifiers) {
+            batchVerifier->Verify();
+        }
+    }
+
+    for (const auto& batchVerifier : batchVerifiers) {
+        badSources.insert(batchVerifier->badSources.begin(), batchVerifier->badSources.end());
+    }
+}
+
+CSigSharesVerifyStats CSigSharesManager::GetVerifyStats()
+{
+    LOCK(cs);
+    return verifyStats;
+}
+
 // It's ensured that no duplicates are passed to this method
 void CSigSharesManager::ProcessPendingSigSharesFromNode(NodeId nodeId,
     const std::vector<CSigShare>& sigShares,
@@ -6,6 +6,7 @@
 #ifndef PIVX_LLMQ_QUORUMS_SIGNING_SHARES_H
 #define PIVX_LLMQ_QUORUMS_SIGNING_SHARES_H
 
+#include "bls/bls_batchverifier.h"
 #include "chainparams.h"
 #include "consensus/params.h"
 #include "net.h"
@@ -18,7 +19,9 @@
 
 #include "llmq/quorums.h"
 
+#include <memory>
 #include <mutex>
+#include <set>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
@@ -339,6 +342,59 @@ public:
     int attempt{0};
 };
 
+/** Metrics of the sig share verification rounds */
+class CSigSharesVerifyStats
+{
+public:
+    // sig shares left pending after the last collection
+    size_t pendingSigShares{0};
+    // current (adaptive) number of unique sessions collected per round
+    size_t maxUniqueSessions{0};
+    uint64_t rounds{0};
+    uint64_t verifiedSigShares{0};
+    uint64_t badSources{0};
+    // verification latency in ms
+    int64_t lastVerifyTime{0};
+    int64_t totalVerifyTime{0};
+
+    /**
+     * Accounts a verification round and adapts maxUniqueSessions (within [minSessions, maxSessions]) to the
+     * backlog left by the last collection (pendingSigShares)
+     */
+    void UpdateRound(size_t verifyCount, size_t badSourceCount, int64_t verifyTime, size_t minSessions, size_t maxSessions);
+};
+
+/**
+ * Batch verification of the sig shares of a round. All shares of a session sign the same message, so a session
+ * is kept in a single batch (where the shares get aggregated) and the sessions are spread over up to maxBatches
+ * batches, verified in parallel by the BLS worker.
+ */
+class CSigSharesBatchVerifier
+{
+private:
+    typedef CBLSBatchVerifier<NodeId, SigShareKey> BatchVerifier;
+
+    size_t maxBatches;
+    std::vector<std::unique_ptr<BatchVerifier>> batchVerifiers;
+    // signHash -> index of the batch of the session
+    std::unordered_map<uint256, size_t, StaticSaltedHasher> sessionBatches;
+    size_t sigShareCount{0};
+
+public:
+    // nodes which sent at least one invalid sig share, in any batch
+    std::set<NodeId> badSources;
+
+public:
+    explicit CSigSharesBatchVerifier(size_t _maxBatches) : maxBatches(_maxBatches) {}
+
+    // returns the index of the batch the sig share was added to
+    size_t PushSigShare(NodeId nodeId, const CSigShare& sigShare, const CBLSPublicKey& pubKeyShare);
+    void Verify(CBLSWorker& blsWorker);
+
+    size_t GetBatchCount() const { return batchVerifiers.size(); }
+    size_t GetSigShareCount() const { return sigShareCount; }
+};
+
 class CSigSharesManager : public CRecoveredSigsListener
 {
     static const int64_t SESSION_NEW_SHARES_TIMEOUT = 60;
@@ -355,9 +411,17 @@ class CSigSharesManager : public CRecoveredSigsListener
     const int64_t MAX_SEND_FOR_RECOVERY_TIMEOUT = 10000;
     const size_t MAX_MSGS_SIG_SHARES = 32;
 
+    // bounds of the number of unique sessions verified per round, adapted to the backlog
+    const size_t MIN_VERIFY_UNIQUE_SESSIONS = 32;
+    const size_t MAX_VERIFY_UNIQUE_SESSIONS = 512;
+    // the sessions of a round are split in up to this many batches, verified in parallel
+    const size_t MAX_VERIFY_BATCHES = 8;
+
 private:
     RecursiveMutex cs;
 
+    CBLSWorker& blsWorker;
+
     std::thread workThread;
     CThreadInterrupt interruptSigningShare;
 
@@ -379,8 +443,11 @@ private:
     int64_t lastCleanupTime{0};
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
+    // must be protected by cs
+    CSigSharesVerifyStats verifyStats;
+
 public:
-    CSigSharesManager();
+    explicit CSigSharesManager(CBLSWorker& _blsWorker);
     ~CSigSharesManager();
 
     void StartWorkerThread();
@@ -400,6 +467,8 @@ public:
 
     static CDeterministicMNCPtr SelectMemberForRecovery(const CQuorumCPtr& quorum, const uint256& id, int attempt);
 
+    CSigSharesVerifyStats GetVerifyStats();
+
 private:
     // all of these return false when the currently processed message should be aborted (as each message actually contains multiple messages)
     bool ProcessMessageSigSesAnn(CNode* pfrom, const CSigSesAnn& ann, CConnman& connman);
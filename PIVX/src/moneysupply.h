@@ -9,7 +9,9 @@
 #include "sync.h"
 
 /*
- * Class used to cache the sum of utxo's values
+ * Class used to cache the sum of utxo's values.
+ * Set from a full coins database scan at startup, then kept current by
+ * ConnectBlock/DisconnectBlock adding each block's delta.
  */
 class CMoneySupply {
 private:
@@ -28,6 +30,14 @@ public:
         nHeight = _nHeight;
     }
 
+    // Apply the supply change of a block connected (or disconnected) at _nHeight
+    void Add(const CAmount& nDelta, int _nHeight)
+    {
+        LOCK(cs);
+        nSupply += nDelta;
+        nHeight = _nHeight;
+    }
+
     CAmount Get() const { LOCK(cs); return nSupply; }
     int64_t GetCacheHeight() const { LOCK(cs); return nHeight; }
 };
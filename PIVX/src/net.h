@@ -736,6 +736,8 @@ public:
 
     // If true, we will announce/send him plain recovered sigs (usually true for full nodes)
     std::atomic<bool> m_wants_recsigs{false};
+    // If true, new blocks are announced to him with a cmpctblock instead of an inv (BIP152 high bandwidth)
+    std::atomic<bool> m_wants_cmpct_announce{false};
     // True when the first message after the verack is received
     std::atomic<bool> fFirstMessageReceived{false};
     // True only if the first message received after verack is a mnauth
@@ -911,6 +913,12 @@ public:
         }
     }
 
+    bool IsInventoryKnown(const CInv& inv)
+    {
+        LOCK(cs_inventory);
+        return filterInventoryKnown.contains(inv.hash);
+    }
+
     void PushInventory(const CInv& inv)
     {
         LOCK(cs_inventory);
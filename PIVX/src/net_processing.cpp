@@ -7,6 +7,8 @@
 
 #include "net_processing.h"
 
+#include "blockencodings.h"
+#include "blocksignature.h"
 #include "budget/budgetmanager.h"
 #include "chain.h"
 #include "evo/deterministicmns.h"
@@ -21,6 +23,7 @@
 #include "merkleblock.h"
 #include "netbase.h"
 #include "netmessagemaker.h"
+#include "pow.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "spork.h"
@@ -45,6 +48,17 @@ static const uint64_t RANDOMIZER_ID_ADDRESS_RELAY = 0x3cac0035b5866b90ULL; // SH
 /** the maximum percentage of addresses from our addrman to return in response to a getaddr message. */
 static constexpr size_t MAX_PCT_ADDR_TO_SEND = 23;
 
+/** The compact block encoding (BIP152 "sendcmpct" version) we speak. */
+static const uint64_t CMPCTBLOCKS_VERSION = 1;
+/** Number of peers asked to announce new blocks to us with a cmpctblock (BIP152 high bandwidth mode). */
+static const unsigned int MAX_CMPCTBLOCK_ANNOUNCERS = 3;
+/** Maximum depth of blocks we're willing to serve as compact blocks to peers when requested. */
+static const int MAX_CMPCTBLOCK_DEPTH = 5;
+/** Maximum depth of blocks we're willing to respond to GETBLOCKTXN requests for. */
+static const int MAX_BLOCKTXN_DEPTH = 10;
+/** Maximum number of cmpctblock requests remembered per peer */
+static const unsigned int MAX_CMPCTBLOCKS_REQUESTED = 4;
+
 struct IteratorComparator
 {
     template<typename I>
@@ -110,6 +124,7 @@ struct QueuedBlock {
     int64_t nTime;              //! Time of "getdata" request in microseconds.
     int nValidatedQueuedBefore; //! Number of blocks queued with validated headers (globally) at the time this one is requested.
     bool fValidatedHeaders;     //! Whether this block has validated headers at the time of request.
+    std::unique_ptr<PartiallyDownloadedBlock> partialBlock; //! Optional, compact block waiting for its blocktxn.
 };
 std::map<uint256, std::pair<NodeId, std::list<QueuedBlock>::iterator> > mapBlocksInFlight;
 
@@ -236,6 +251,11 @@ struct CNodeState {
 
     CNodeBlocks nodeBlocks;
 
+    //! Whether the peer announced (sendcmpct) the compact block version we speak.
+    bool fSupportsDesiredCmpctVersion{false};
+    //! Blocks requested from this peer with a MSG_CMPCT_BLOCK getdata, oldest first.
+    std::deque<uint256> vCmpctBlocksRequested;
+
     CNodeState(CAddress addrIn, std::string addrNameIn) : address(addrIn), name(addrNameIn) {
         fCurrentlyConnected = false;
         nMisbehavior = 0;
@@ -253,6 +273,9 @@ struct CNodeState {
 /** Map maintaining per-node state. Requires cs_main. */
 std::map<NodeId, CNodeState> mapNodeState;
 
+/** Peers asked to announce blocks with a cmpctblock, least recent first. Requires cs_main. */
+std::list<NodeId> lNodesAnnouncingHeaderAndIDs;
+
 // Requires cs_main.
 CNodeState* State(NodeId pnode)
 {
@@ -319,7 +342,7 @@ void MarkBlockAsReceived(const uint256& hash)
 }
 
 // Requires cs_main.
-void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex* pindex = nullptr)
+void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex* pindex = nullptr, std::unique_ptr<PartiallyDownloadedBlock> partialBlock = nullptr)
 {
     CNodeState* state = State(nodeid);
     assert(state != nullptr);
@@ -327,9 +350,9 @@ void MarkBlockAsInFlight(NodeId nodeid, const uint256& hash, const CBlockIndex*
     // Make sure it's not listed somewhere already.
     MarkBlockAsReceived(hash);
 
-    QueuedBlock newentry = {hash, pindex, GetTimeMicros(), nQueuedValidatedHeaders, pindex != nullptr};
+    QueuedBlock newentry = {hash, pindex, GetTimeMicros(), nQueuedValidatedHeaders, pindex != nullptr, std::move(partialBlock)};
     nQueuedValidatedHeaders += newentry.fValidatedHeaders;
-    std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(), newentry);
+    std::list<QueuedBlock>::iterator it = state->vBlocksInFlight.insert(state->vBlocksInFlight.end(), std::move(newentry));
     state->nBlocksInFlight++;
     mapBlocksInFlight[hash] = std::make_pair(nodeid, it);
 }
@@ -373,6 +396,78 @@ static void UpdateBlockAvailability(NodeId nodeid, const uint256& hash) EXCLUSIV
     }
 }
 
+/**
+ * Checks of a cmpctblock that need neither its mempool transactions nor its
+ * full body: parent, header context, proof of work or the staker signature
+ * over the prefilled coinstake, and ChainLocks.
+ */
+static bool CheckCmpctBlockHeader(const CBlockHeaderAndShortTxIDs& cmpctblock, CBlockIndex* pindexPrev, CValidationState& state) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+
+    const uint256 hashBlock = cmpctblock.header.GetHash();
+    const int nHeight = pindexPrev->nHeight + 1;
+    if (pindexPrev->nStatus & BLOCK_FAILED_MASK)
+        return state.DoS(100, false, REJECT_INVALID, "bad-prevblk");
+
+    if (!ContextualCheckBlockHeader(cmpctblock.header, state, pindexPrev))
+        return false;
+
+    // The coinbase and the coinstake are always prefilled
+    CBlock block;
+    if (!cmpctblock.GetBlockSkeleton(block))
+        return state.DoS(100, false, REJECT_INVALID, "bad-cmpct-prefilled");
+
+    const bool isPoSActive = Params().GetConsensus().NetworkUpgradeActive(nHeight, Consensus::UPGRADE_POS);
+    if (isPoSActive != block.IsProofOfStake())
+        return state.DoS(100, false, REJECT_INVALID, isPoSActive ? "PoW-ended" : "PoS-early");
+    if (block.IsProofOfWork() && !CheckProofOfWork(hashBlock, block.nBits))
+        return state.DoS(50, false, REJECT_INVALID, "high-hash", false, "proof of work failed");
+    if (!CheckBlockSignature(block))
+        return state.DoS(100, false, REJECT_INVALID, "bad-blk-sig", false, "block signature verification failed");
+
+    if (llmq::chainLocksHandler->HasConflictingChainLock(nHeight, hashBlock))
+        return state.DoS(10, false, REJECT_INVALID, "bad-chainlock");
+
+    return true;
+}
+
+/**
+ * Ask a peer that just gave us a new block to announce the next ones with a
+ * cmpctblock (BIP152 high bandwidth mode). At most MAX_CMPCTBLOCK_ANNOUNCERS
+ * peers do so; the least recent one is moved back to inv announcements.
+ */
+static void MaybeSetPeerAsAnnouncingHeaderAndIDs(NodeId nodeid, CConnman* connman) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+
+    CNodeState* nodestate = State(nodeid);
+    if (!nodestate || !nodestate->fSupportsDesiredCmpctVersion) {
+        // Never ask from peers who can't provide compact blocks.
+        return;
+    }
+    for (auto it = lNodesAnnouncingHeaderAndIDs.begin(); it != lNodesAnnouncingHeaderAndIDs.end(); it++) {
+        if (*it == nodeid) {
+            lNodesAnnouncingHeaderAndIDs.erase(it);
+            lNodesAnnouncingHeaderAndIDs.push_back(nodeid);
+            return;
+        }
+    }
+    connman->ForNode(nodeid, [connman](CNode* pfrom) {
+        AssertLockHeld(cs_main);
+        if (lNodesAnnouncingHeaderAndIDs.size() >= MAX_CMPCTBLOCK_ANNOUNCERS) {
+            connman->ForNode(lNodesAnnouncingHeaderAndIDs.front(), [connman](CNode* pnodeStop) {
+                connman->PushMessage(pnodeStop, CNetMsgMaker(pnodeStop->GetSendVersion()).Make(NetMsgType::SENDCMPCT, /* fAnnounceUsingCMPCTBLOCK */ false, CMPCTBLOCKS_VERSION));
+                return true;
+            });
+            lNodesAnnouncingHeaderAndIDs.pop_front();
+        }
+        connman->PushMessage(pfrom, CNetMsgMaker(pfrom->GetSendVersion()).Make(NetMsgType::SENDCMPCT, /* fAnnounceUsingCMPCTBLOCK */ true, CMPCTBLOCKS_VERSION));
+        lNodesAnnouncingHeaderAndIDs.push_back(pfrom->GetId());
+        return true;
+    });
+}
+
 /** Update pindexLastCommonBlock and add not-in-flight missing successors to vBlocks, until it has
  *  at most count entries. */
 static void FindNextBlocksToDownload(NodeId nodeid, unsigned int count, std::vector<const CBlockIndex*>& vBlocks, NodeId& nodeStaller) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
@@ -490,6 +585,7 @@ void PeerLogicValidation::FinalizeNode(NodeId nodeid, bool& fUpdateConnectionTim
         mapBlocksInFlight.erase(entry.hash);
     EraseOrphansFor(nodeid);
     nPreferredDownload -= state->fPreferredDownload;
+    lNodesAnnouncingHeaderAndIDs.remove(nodeid);
 
     mapNodeState.erase(nodeid);
     LogPrint(BCLog::NET, "Cleared nodestate for peer=%d\n", nodeid);
@@ -713,8 +809,39 @@ PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn) :
     recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
 }
 
+// Last connected block, and its compact encoding built (once) when first relayed
+static Mutex cs_most_recent_block;
+static std::shared_ptr<const CBlock> most_recent_block GUARDED_BY(cs_most_recent_block);
+static uint256 most_recent_block_hash GUARDED_BY(cs_most_recent_block);
+static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_block GUARDED_BY(cs_most_recent_block);
+
+static std::shared_ptr<const CBlock> GetMostRecentBlock(const uint256& hash)
+{
+    LOCK(cs_most_recent_block);
+    return most_recent_block_hash == hash ? most_recent_block : nullptr;
+}
+
+static std::shared_ptr<const CBlockHeaderAndShortTxIDs> GetMostRecentCompactBlock(const uint256& hash)
+{
+    LOCK(cs_most_recent_block);
+    if (!most_recent_block || most_recent_block_hash != hash) {
+        return nullptr;
+    }
+    if (!most_recent_compact_block) {
+        most_recent_compact_block = std::make_shared<const CBlockHeaderAndShortTxIDs>(*most_recent_block);
+    }
+    return most_recent_compact_block;
+}
+
 void PeerLogicValidation::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex)
 {
+    {
+        LOCK(cs_most_recent_block);
+        most_recent_block = pblock;
+        most_recent_block_hash = pindex->GetBlockHash();
+        most_recent_compact_block.reset();
+    }
+
     LOCK(g_cs_orphans);
 
     std::vector<uint256> vOrphanErase;
@@ -751,14 +878,22 @@ void PeerLogicValidation::UpdatedBlockTip(const CBlockIndex* pindexNew, const CB
 
     if (!fInitialDownload) {
         const uint256& hashNewTip = pindexNew->GetBlockHash();
+        const CInv inv(MSG_BLOCK, hashNewTip);
+        const std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = GetMostRecentCompactBlock(hashNewTip);
         // Relay inventory, but don't relay old inventory during initial block download.
-        connman->ForEachNode([nNewHeight, hashNewTip](CNode* pnode) {
+        connman->ForEachNode([this, nNewHeight, &inv, &pcmpctblock](CNode* pnode) {
             // Don't sync from MN only connections.
             if (!pnode->CanRelay()) {
                 return;
             }
             if (nNewHeight > (pnode->nStartingHeight != -1 ? pnode->nStartingHeight - 2000 : 0)) {
-                pnode->PushInventory(CInv(MSG_BLOCK, hashNewTip));
+                if (pcmpctblock && pnode->m_wants_cmpct_announce && !pnode->IsInventoryKnown(inv)) {
+                    // High bandwidth peer: skip the inv/getdata round trip
+                    pnode->AddInventoryKnown(inv);
+                    connman->PushMessage(pnode, CNetMsgMaker(pnode->GetSendVersion()).Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+                } else {
+                    pnode->PushInventory(inv);
+                }
             }
         });
     }
@@ -782,10 +917,18 @@ void PeerLogicValidation::BlockChecked(const CBlock& block, const CValidationSta
             // Spam filter
             CheckBlockSpam(it->second, block.GetHash());
         }
+    } else if (state.IsValid() && !IsInitialBlockDownload() && it != mapBlockSource.end() &&
+               chainActive.Tip() && chainActive.Tip()->GetBlockHash() == block.hashPrevBlock) {
+        // First peer to give us a new tip: ask it to announce the next ones with a cmpctblock
+        MaybeSetPeerAsAnnouncingHeaderAndIDs(it->second, connman);
     }
 
     if (it != mapBlockSource.end())
         mapBlockSource.erase(it);
+
+    // Got the block, whatever its source: stop waiting for a peer to send it
+    // (e.g. the transactions of its cmpctblock)
+    MarkBlockAsReceived(hash);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1095,12 +1238,30 @@ void static ProcessGetBlockData(CNode* pfrom, const CInv& inv, CConnman* connman
     }
     // Don't send not-validated blocks
     if (send && (pindex->nStatus & BLOCK_HAVE_DATA)) {
-        // Send block from disk
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex))
-            assert(!"cannot load block from disk");
+        // Send block from disk, unless it is the block just connected
+        std::shared_ptr<const CBlock> pblock = GetMostRecentBlock(inv.hash);
+        if (!pblock) {
+            std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*pblockRead, pindex))
+                assert(!"cannot load block from disk");
+            pblock = pblockRead;
+        }
+        const CBlock& block = *pblock;
         if (inv.type == MSG_BLOCK)
             connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, block));
+        else if (inv.type == MSG_CMPCT_BLOCK) {
+            // Deeper blocks are sent in full: their transactions left the peer's mempool
+            if (pindex->nHeight >= chainActive.Height() - MAX_CMPCTBLOCK_DEPTH) {
+                std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = GetMostRecentCompactBlock(inv.hash);
+                if (pcmpctblock) {
+                    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, *pcmpctblock));
+                } else {
+                    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::CMPCTBLOCK, CBlockHeaderAndShortTxIDs(block)));
+                }
+            } else {
+                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, block));
+            }
+        }
         else // MSG_FILTERED_BLOCK)
         {
             bool send_ = false;
@@ -1208,7 +1369,7 @@ void static ProcessGetData(CNode* pfrom, CConnman* connman, const std::atomic<bo
 
     if (it != pfrom->vRecvGetData.end() && !pfrom->fPauseSend) {
         const CInv &inv = *it;
-        if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
+        if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK || inv.type == MSG_CMPCT_BLOCK) {
             it++;
             ProcessGetBlockData(pfrom, inv, connman, interruptMsgProc);
         }
@@ -1229,6 +1390,27 @@ void static ProcessGetData(CNode* pfrom, CConnman* connman, const std::atomic<bo
 }
 
 bool fRequestedSporksIDB = false;
+/** Hand a block from a peer, received in full or rebuilt from a cmpctblock, to validation */
+static void ProcessBlockFromPeer(CNode* pfrom, const std::shared_ptr<const CBlock>& pblock)
+{
+    const uint256& hashBlock = pblock->GetHash();
+    pfrom->AddInventoryKnown(CInv(MSG_BLOCK, hashBlock));
+    if (!mapBlockIndex.count(hashBlock)) {
+        {
+            LOCK(cs_main);
+            MarkBlockAsReceived(hashBlock);
+            mapBlockSource.emplace(hashBlock, pfrom->GetId());
+        }
+        ProcessNewBlock(pblock, nullptr);
+
+        // Disconnect node if its running an old protocol version,
+        // used during upgrades, when the node is already connected.
+        pfrom->DisconnectOldProtocol(pfrom->nVersion, ActiveProtocol());
+    } else {
+        LogPrint(BCLog::NET, "%s : Already processed block %s, skipping ProcessNewBlock()\n", __func__, hashBlock.GetHex());
+    }
+}
+
 bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vRecv, int64_t nTimeReceived, CConnman* connman, std::atomic<bool>& interruptMsgProc)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
@@ -1450,6 +1632,11 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
             CMNAuth::PushMNAUTH(pfrom, *connman);
         }
 
+        if (pfrom->nVersion >= COMPACT_BLOCKS_VERSION && pfrom->CanRelay()) {
+            // We can receive and serve compact blocks, announced the usual way (inv) for now
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::SENDCMPCT, /* fAnnounceUsingCMPCTBLOCK */ false, CMPCTBLOCKS_VERSION));
+        }
+
         pfrom->fSuccessfullyConnected = true;
         LogPrintf("New outbound peer connected: version: %d, blocks=%d, peer=%d%s\n",
                   pfrom->nVersion.load(), pfrom->nStartingHeight, pfrom->GetId(),
@@ -1595,6 +1782,9 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
         LOCK(cs_main);
 
         std::vector<CInv> vToFetch;
+        // A single new block at the tip is fetched as a compact block: its transactions are likely in our mempool
+        const bool fFetchCompact = State(pfrom->GetId())->fSupportsDesiredCmpctVersion && !IsInitialBlockDownload() &&
+                                   std::count_if(vInv.begin(), vInv.end(), [](const CInv& inv) { return inv.type == MSG_BLOCK; }) == 1;
 
         for (unsigned int nInv = 0; nInv < vInv.size(); nInv++) {
             const CInv& inv = vInv[nInv];
@@ -1617,7 +1807,7 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
                 UpdateBlockAvailability(pfrom->GetId(), inv.hash);
                 if (!fAlreadyHave && !fImporting && !fReindex && !mapBlocksInFlight.count(inv.hash)) {
                     // Add this to the list of blocks to request
-                    vToFetch.push_back(inv);
+                    vToFetch.emplace_back(fFetchCompact ? MSG_CMPCT_BLOCK : MSG_BLOCK, inv.hash);
                     LogPrint(BCLog::NET, "getblocks (%d) %s to peer=%d\n", pindexBestHeader->nHeight, inv.hash.ToString(), pfrom->GetId());
                 }
             } else {
@@ -1658,8 +1848,16 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
 
         }
 
-        if (!vToFetch.empty())
+        if (!vToFetch.empty()) {
+            CNodeState* nodestate = State(pfrom->GetId());
+            for (const CInv& inv : vToFetch) {
+                if (inv.type != MSG_CMPCT_BLOCK) continue;
+                if (nodestate->vCmpctBlocksRequested.size() >= MAX_CMPCTBLOCKS_REQUESTED)
+                    nodestate->vCmpctBlocksRequested.pop_front();
+                nodestate->vCmpctBlocksRequested.push_back(inv.hash);
+            }
             connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETDATA, vToFetch));
+        }
     }
 
 
@@ -2001,24 +2199,182 @@ bool static ProcessMessage(CNode* pfrom, std::string strCommand, CDataStream& vR
                 pfrom->vBlockRequested.emplace_back(hashBlock);
             }
         } else {
-            pfrom->AddInventoryKnown(inv);
-            if (!mapBlockIndex.count(hashBlock)) {
-                {
-                    LOCK(cs_main);
-                    MarkBlockAsReceived(hashBlock);
-                    mapBlockSource.emplace(hashBlock, pfrom->GetId());
+            ProcessBlockFromPeer(pfrom, pblock);
+        }
+    }
+
+    else if (strCommand == NetMsgType::SENDCMPCT) {
+        bool fAnnounceUsingCMPCTBLOCK = false;
+        uint64_t nCMPCTBLOCKVersion = 0;
+        vRecv >> fAnnounceUsingCMPCTBLOCK >> nCMPCTBLOCKVersion;
+        if (nCMPCTBLOCKVersion == CMPCTBLOCKS_VERSION) {
+            LOCK(cs_main);
+            State(pfrom->GetId())->fSupportsDesiredCmpctVersion = true;
+            pfrom->m_wants_cmpct_announce = fAnnounceUsingCMPCTBLOCK;
+        }
+    }
+
+    else if (strCommand == NetMsgType::CMPCTBLOCK && !fImporting && !fReindex) // Ignore blocks received while importing
+    {
+        CBlockHeaderAndShortTxIDs cmpctblock;
+        vRecv >> cmpctblock;
+        const uint256 hashBlock = cmpctblock.header.GetHash();
+        LogPrint(BCLog::NET, "received cmpctblock %s peer=%d\n", hashBlock.ToString(), pfrom->GetId());
+
+        std::shared_ptr<CBlock> pblock;
+        {
+            LOCK(cs_main);
+            CNodeState* nodestate = State(pfrom->GetId());
+            // Only high bandwidth peers announce with a cmpctblock, the others send it on request
+            auto itRequested = std::find(nodestate->vCmpctBlocksRequested.begin(), nodestate->vCmpctBlocksRequested.end(), hashBlock);
+            const bool fRequested = itRequested != nodestate->vCmpctBlocksRequested.end();
+            if (fRequested) {
+                nodestate->vCmpctBlocksRequested.erase(itRequested);
+            } else if (std::find(lNodesAnnouncingHeaderAndIDs.begin(), lNodesAnnouncingHeaderAndIDs.end(), pfrom->GetId()) == lNodesAnnouncingHeaderAndIDs.end()) {
+                LogPrint(BCLog::NET, "Peer %d sent us an unrequested cmpctblock %s\n", pfrom->GetId(), hashBlock.ToString());
+                return true;
+            }
+
+            pfrom->AddInventoryKnown(CInv(MSG_BLOCK, hashBlock));
+            CBlockIndex* pindex = LookupBlockIndex(hashBlock);
+            if (pindex && (pindex->nStatus & BLOCK_HAVE_DATA)) {
+                // Already got it, e.g. from another high bandwidth peer
+                return true;
+            }
+
+            const std::vector<CInv> vGetBlock(1, CInv(MSG_BLOCK, hashBlock));
+            CBlockIndex* pindexPrev = LookupBlockIndex(cmpctblock.header.hashPrevBlock);
+            if (!pindexPrev) {
+                // The full block goes through the usual unknown parent logic
+                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETDATA, vGetBlock));
+                return true;
+            }
+
+            // Check the header before looking up its transactions in the mempool
+            CValidationState state;
+            if (!CheckCmpctBlockHeader(cmpctblock, pindexPrev, state)) {
+                int nDoS = 0;
+                state.IsInvalid(nDoS);
+                if (nDoS > 0) {
+                    Misbehaving(pfrom->GetId(), nDoS, strprintf("invalid compact block header %s: %s", hashBlock.ToString(), FormatStateMessage(state)));
+                } else {
+                    LogPrint(BCLog::NET, "Peer %d sent us a rejected cmpctblock %s: %s\n", pfrom->GetId(), hashBlock.ToString(), FormatStateMessage(state));
                 }
-                ProcessNewBlock(pblock, nullptr);
+                return true;
+            }
+            UpdateBlockAvailability(pfrom->GetId(), hashBlock);
+
+            auto itInFlight = mapBlocksInFlight.find(hashBlock);
+            if (itInFlight != mapBlocksInFlight.end() && itInFlight->second.first == pfrom->GetId() && itInFlight->second.second->partialBlock) {
+                // Already waiting for its transactions
+                return true;
+            }
+
+            auto partialBlock = std::make_unique<PartiallyDownloadedBlock>(&mempool);
+            ReadStatus status = partialBlock->InitData(cmpctblock);
+            if (status == READ_STATUS_INVALID) {
+                Misbehaving(pfrom->GetId(), 100, strprintf("invalid compact block %s", hashBlock.ToString()));
+                return false;
+            } else if (status == READ_STATUS_FAILED) {
+                // Uneven short ID distribution, just request the block
+                MarkBlockAsInFlight(pfrom->GetId(), hashBlock);
+                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETDATA, vGetBlock));
+                return true;
+            }
 
-                // Disconnect node if its running an old protocol version,
-                // used during upgrades, when the node is already connected.
-                pfrom->DisconnectOldProtocol(pfrom->nVersion, ActiveProtocol());
+            BlockTransactionsRequest req;
+            for (size_t i = 0; i < cmpctblock.BlockTxCount(); i++) {
+                if (!partialBlock->IsTxAvailable(i))
+                    req.indexes.push_back(i);
+            }
+            if (req.indexes.empty()) {
+                pblock = std::make_shared<CBlock>();
+                if (partialBlock->FillBlock(*pblock, std::vector<CTransactionRef>()) != READ_STATUS_OK) {
+                    MarkBlockAsInFlight(pfrom->GetId(), hashBlock);
+                    connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETDATA, vGetBlock));
+                    return true;
+                }
             } else {
-                LogPrint(BCLog::NET, "%s : Already processed block %s, skipping ProcessNewBlock()\n", __func__, pblock->GetHash().GetHex());
+                // Wait for the missing transactions. In flight like any requested block: the
+                // download timeout disconnects a peer that never answers, and the block
+                // arriving from another peer drops the partial one.
+                req.blockhash = hashBlock;
+                MarkBlockAsInFlight(pfrom->GetId(), hashBlock, nullptr, std::move(partialBlock));
+                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETBLOCKTXN, req));
+                return true;
+            }
+        } // release cs_main
+
+        ProcessBlockFromPeer(pfrom, pblock);
+    }
+
+    else if (strCommand == NetMsgType::GETBLOCKTXN) {
+        BlockTransactionsRequest req;
+        vRecv >> req;
+
+        std::shared_ptr<const CBlock> pblock = GetMostRecentBlock(req.blockhash);
+        {
+            LOCK(cs_main);
+            CBlockIndex* pindex = LookupBlockIndex(req.blockhash);
+            if (!pindex || !(pindex->nStatus & BLOCK_HAVE_DATA)) {
+                LogPrint(BCLog::NET, "Peer %d sent us a getblocktxn for a block we don't have\n", pfrom->GetId());
+                return true;
+            }
+            if (pindex->nHeight < chainActive.Height() - MAX_BLOCKTXN_DEPTH) {
+                // Not a reconstruction of a recent block: answer with the full block, as for a getdata
+                LogPrint(BCLog::NET, "Peer %d sent us a getblocktxn for a block > %i deep\n", pfrom->GetId(), MAX_BLOCKTXN_DEPTH);
+                pfrom->vRecvGetData.emplace_back(MSG_BLOCK, req.blockhash);
+                return true;
+            }
+            if (!pblock) {
+                std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
+                if (!ReadBlockFromDisk(*pblockRead, pindex))
+                    assert(!"cannot load block from disk");
+                pblock = pblockRead;
+            }
+
+            BlockTransactions resp(req);
+            for (size_t i = 0; i < req.indexes.size(); i++) {
+                if (req.indexes[i] >= pblock->vtx.size()) {
+                    Misbehaving(pfrom->GetId(), 100, strprintf("getblocktxn with out-of-bounds tx index %d", req.indexes[i]));
+                    return false;
+                }
+                resp.txn[i] = pblock->vtx[req.indexes[i]];
             }
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCKTXN, resp));
         }
     }
 
+    else if (strCommand == NetMsgType::BLOCKTXN && !fImporting && !fReindex) // Ignore blocks received while importing
+    {
+        BlockTransactions resp;
+        vRecv >> resp;
+
+        std::shared_ptr<CBlock> pblock = std::make_shared<CBlock>();
+        {
+            LOCK(cs_main);
+            auto itInFlight = mapBlocksInFlight.find(resp.blockhash);
+            if (itInFlight == mapBlocksInFlight.end() || itInFlight->second.first != pfrom->GetId() || !itInFlight->second.second->partialBlock) {
+                LogPrint(BCLog::NET, "Peer %d sent us block transactions for block we weren't expecting\n", pfrom->GetId());
+                return true;
+            }
+            ReadStatus status = itInFlight->second.second->partialBlock->FillBlock(*pblock, resp.txn);
+            MarkBlockAsReceived(resp.blockhash);
+            if (status == READ_STATUS_INVALID) {
+                Misbehaving(pfrom->GetId(), 100, strprintf("invalid blocktxn for block %s", resp.blockhash.ToString()));
+                return false;
+            } else if (status == READ_STATUS_FAILED) {
+                // Might have collided, fall back to getdata now
+                const std::vector<CInv> vGetBlock(1, CInv(MSG_BLOCK, resp.blockhash));
+                MarkBlockAsInFlight(pfrom->GetId(), resp.blockhash);
+                connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::GETDATA, vGetBlock));
+                return true;
+            }
+        } // release cs_main
+
+        ProcessBlockFromPeer(pfrom, pblock);
+    }
+
     // This asymmetric behavior for inbound and outbound connections was introduced
     // to prevent a fingerprinting attack: an attacker can send specific fake addresses
     // to users' AddrMan and later request them by sending getaddr messages.
@@ -39,6 +39,10 @@ const char* FILTERLOAD = "filterload";
 const char* FILTERADD = "filteradd";
 const char* FILTERCLEAR = "filterclear";
 const char* SENDHEADERS = "sendheaders";
+const char* SENDCMPCT = "sendcmpct";
+const char* CMPCTBLOCK = "cmpctblock";
+const char* GETBLOCKTXN = "getblocktxn";
+const char* BLOCKTXN = "blocktxn";
 const char* SPORK = "spork";
 const char* GETSPORKS = "getsporks";
 const char* MNBROADCAST = "mnb";
@@ -97,6 +101,10 @@ const static std::string allNetMessageTypes[] = {
     NetMsgType::FILTERADD,
     NetMsgType::FILTERCLEAR,
     NetMsgType::SENDHEADERS,
+    NetMsgType::SENDCMPCT,
+    NetMsgType::CMPCTBLOCK,
+    NetMsgType::GETBLOCKTXN,
+    NetMsgType::BLOCKTXN,
     "filtered block",  // Should never occur
     "ix",              // deprecated
     "txlvote",         // deprecated
@@ -206,7 +214,7 @@ bool operator<(const CInv& a, const CInv& b)
 }
 
 bool CInv::IsMasterNodeType() const{
-     return type > 2;
+     return type > 2 && type != MSG_CMPCT_BLOCK;
 }
 
 std::string CInv::GetCommand() const
@@ -236,6 +244,7 @@ std::string CInv::GetCommand() const
         case MSG_QUORUM_PREMATURE_COMMITMENT: return cmd.append(NetMsgType::QPCOMMITMENT);
         case MSG_QUORUM_RECOVERED_SIG: return cmd.append(NetMsgType::QSIGREC);
         case MSG_CLSIG: return cmd.append(NetMsgType::CLSIG);
+        case MSG_CMPCT_BLOCK: return cmd.append(NetMsgType::CMPCTBLOCK);
         default:
             throw std::out_of_range(strprintf("%s: type=%d unknown type", __func__, type));
     }
@@ -219,6 +219,32 @@ extern const char* FILTERCLEAR;
  * @see https://bitcoin.org/en/developer-reference#sendheaders
  */
 extern const char* SENDHEADERS;
+/**
+ * Contains a 1-byte bool and 8-byte LE version number.
+ * Indicates that a node is willing to provide blocks via "cmpctblock" messages.
+ * May indicate that a node prefers to receive new block announcements via a
+ * "cmpctblock" message rather than an "inv", depending on message contents.
+ * @since protocol version COMPACT_BLOCKS_VERSION as described by BIP152.
+ */
+extern const char* SENDCMPCT;
+/**
+ * Contains a CBlockHeaderAndShortTxIDs object - providing a header, the
+ * block signature and a list of "short txids".
+ * @since protocol version COMPACT_BLOCKS_VERSION as described by BIP152.
+ */
+extern const char* CMPCTBLOCK;
+/**
+ * Contains a BlockTransactionsRequest
+ * Peer should respond with "blocktxn" message.
+ * @since protocol version COMPACT_BLOCKS_VERSION as described by BIP152.
+ */
+extern const char* GETBLOCKTXN;
+/**
+ * Contains a BlockTransactions.
+ * Sent in response to a "getblocktxn" message.
+ * @since protocol version COMPACT_BLOCKS_VERSION as described by BIP152.
+ */
+extern const char* BLOCKTXN;
 /**
  * The spork message is used to send spork values to connected
  * peers
@@ -462,7 +488,9 @@ enum GetDataMsg {
     MSG_QUORUM_PREMATURE_COMMITMENT,
     MSG_QUORUM_RECOVERED_SIG,
     MSG_CLSIG,
-    MSG_TYPE_MAX = MSG_CLSIG,
+    // Only used in getdata, never in invs (BIP152)
+    MSG_CMPCT_BLOCK,
+    MSG_TYPE_MAX = MSG_CMPCT_BLOCK,
 };
 
 /** inv message data */
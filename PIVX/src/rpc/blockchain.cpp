@@ -5,6 +5,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or https://www.opensource.org/licenses/mit-license.php.
 
+#include "blockstatsindex.h"
 #include "budget/budgetmanager.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -14,6 +15,7 @@
 #include "hash.h"
 #include "kernel.h"
 #include "key_io.h"
+#include "khu/khu_validation.h"
 #include "llmq/quorums_chainlocks.h"
 #include "masternodeman.h"
 #include "policy/feerate.h"
@@ -256,6 +258,7 @@ UniValue getbestchainlock(const JSONRPCRequest& request)
             "  \"blockhash\" : \"hash\",      (string) The block hash hex encoded\n"
             "  \"height\" : n,              (numeric) The block height or index\n"
             "  \"known_block\" : true|false (boolean) True if the block is known by our node\n"
+            "  \"finalized_height\" : n,    (numeric) The active chain is ChainLocked up to this height, -1 if not\n"
             "}\n"
             "\nExamples:\n" +
             HelpExampleCli("getbestchainlock", "") + HelpExampleRpc("getbestchainlock", ""));
@@ -266,11 +269,44 @@ UniValue getbestchainlock(const JSONRPCRequest& request)
     }
     result.pushKV("blockhash", clsig.blockHash.GetHex());
     result.pushKV("height", clsig.nHeight);
+    result.pushKV("finalized_height", llmq::chainLocksHandler->GetFinalizedHeight());
     LOCK(cs_main);
     result.pushKV("known_block", mapBlockIndex.count(clsig.blockHash) > 0);
     return result;
 }
 
+UniValue getchainlock(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getchainlock height\n"
+            "\nReturns the chainlock received for the given height. Throws an error if there is none.\n"
+            "\nArguments:\n"
+            "1. height         (numeric, required) The block height\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"blockhash\" : \"hash\",      (string) The block hash hex encoded\n"
+            "  \"height\" : n,              (numeric) The block height or index\n"
+            "  \"signature\" : \"hex\",       (string) The recovered quorum signature\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getchainlock", "1000") + HelpExampleRpc("getchainlock", "1000"));
+
+    const int nHeight = request.params[0].get_int();
+    if (nHeight < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+    }
+    llmq::CChainLockSig clsig;
+    if (!llmq::chainLocksHandler->GetChainLockByHeight(nHeight, clsig)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, strprintf("No chainlock found at height %d", nHeight));
+    }
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("blockhash", clsig.blockHash.GetHex());
+    result.pushKV("height", clsig.nHeight);
+    result.pushKV("signature", clsig.sig.ToString());
+    return result;
+}
+
 void RPCNotifyBlockChange(bool fInitialDownload, const CBlockIndex* pindex)
 {
     if(pindex) {
@@ -703,15 +739,15 @@ UniValue getsupplyinfo(const JSONRPCRequest& request)
     if (request.fHelp || request.params.size() > 1)
         throw std::runtime_error(
             "getsupplyinfo ( force_update )\n"
-            "\nIf force_update=false (default if no argument is given): return the last cached money supply"
-            "\n(sum of spendable transaction outputs) and the height of the chain when it was last updated"
-            "\n(it is updated periodically, whenever the chainstate is flushed)."
+            "\nReturn the money supply (sum of spendable transaction outputs), kept current as blocks are"
+            "\nconnected and disconnected, together with the shield pool value and, after the V6 upgrade,"
+            "\nthe KHU supply at the chain tip."
             "\n"
-            "\nIf force_update=true: Flush the chainstate to disk and return the money supply updated to"
-            "\nthe current chain height.\n"
+            "\nIf force_update=true: Flush the chainstate to disk and recompute the transparent supply with a"
+            "\nfull scan of the coins database (slow, meant to audit the cached value).\n"
 
             "\nArguments:\n"
-            "1. force_update       (boolean, optional, default=false) flush chainstate to disk and update cache\n"
+            "1. force_update       (boolean, optional, default=false) flush chainstate to disk and rescan the coins\n"
 
             "\nResult:\n"
             "{\n"
@@ -719,6 +755,15 @@ UniValue getsupplyinfo(const JSONRPCRequest& request)
             "  \"transparentsupply\" : n   (numeric) The sum of all spendable transaction outputs at height updateheight\n"
             "  \"shieldsupply\": n         (numeric) Chain tip shield pool value\n"
             "  \"totalsupply\": n          (numeric) The sum of transparentsupply and shieldsupply\n"
+            "  \"khusupply\": {            (json object, only after the V6 upgrade) KHU state at the chain tip\n"
+            "     \"height\": n,           (numeric) Height of the KHU state\n"
+            "     \"C\": n,                (numeric) PIV collateral backing KHU\n"
+            "     \"U\": n,                (numeric) Transparent KHU supply\n"
+            "     \"Z\": n,                (numeric) Staked (shielded) KHU supply\n"
+            "     \"Cr\": n,               (numeric) Reward collateral pool\n"
+            "     \"Ur\": n,               (numeric) Accumulated unstake rights\n"
+            "     \"T\": n                 (numeric) DAO treasury pool (PIV)\n"
+            "  }\n"
             "}\n"
 
             "\nExamples:\n" +
@@ -728,8 +773,10 @@ UniValue getsupplyinfo(const JSONRPCRequest& request)
     const bool fForceUpdate = request.params.size() > 0 ? request.params[0].get_bool() : false;
 
     if (fForceUpdate) {
-        // Flush state to disk (which updates the cached supply)
+        LOCK(cs_main);
+        // The cursor only sees the coins database
         FlushStateToDisk();
+        MoneySupply.Update(pcoinsTip->GetTotalAmount(), chainActive.Height());
     }
 
     UniValue ret(UniValue::VOBJ);
@@ -741,6 +788,20 @@ UniValue getsupplyinfo(const JSONRPCRequest& request)
     const CAmount totalSupply = tSupply + (shieldedPoolValue ? *shieldedPoolValue : 0);
     ret.pushKV("totalsupply", ValueFromAmount(totalSupply));
 
+    // KHU state is stored per height: its supply is the state of the tip
+    KhuGlobalState khuState;
+    if (GetCurrentKHUState(khuState)) {
+        UniValue khu(UniValue::VOBJ);
+        khu.pushKV("height", (int64_t)khuState.nHeight);
+        khu.pushKV("C", ValueFromAmount(khuState.C));
+        khu.pushKV("U", ValueFromAmount(khuState.U));
+        khu.pushKV("Z", ValueFromAmount(khuState.Z));
+        khu.pushKV("Cr", ValueFromAmount(khuState.Cr));
+        khu.pushKV("Ur", ValueFromAmount(khuState.Ur));
+        khu.pushKV("T", ValueFromAmount(khuState.T));
+        ret.pushKV("khusupply", khu);
+    }
+
     return ret;
 }
 
@@ -1365,6 +1426,8 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
                 "getblockindexstats height range\n"
                 "\nReturns aggregated BlockIndex data for blocks "
                 "\n[height, height+1, height+2, ..., height+range-1]\n"
+                "\nServed from the block statistics index when enabled (-blockstatsindex) and synced,"
+                "\notherwise computed reading the blocks from disk.\n"
 
                 "\nArguments:\n"
                 "1. height             (numeric, required) block height where the search starts.\n"
@@ -1379,6 +1442,12 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
                 "  \"txbytes\": xxxxx                (numeric) Sum of the size of all txes over block range\n"
                 "  \"ttlfee\": xxxxx                 (numeric) Sum of the fee amount of all txes over block range\n"
                 "  \"feeperkb\": xxxxx               (numeric) Average fee per kb (excluding zc txes)\n"
+                "  \"shield_txcount\": xxxxx         (numeric, index only) Shield tx count\n"
+                "  \"khu_txcount\": xxxxx            (numeric, index only) KHU mint/redeem/stake/unstake tx count\n"
+                "  \"khu_delta\": {                  (json object, index only) Change of the KHU state over the range,\n"
+                "                                     missing when the KHU state at a bound is not known\n"
+                "     \"C\": xxxxx, \"U\": xxxxx, \"Z\": xxxxx\n"
+                "  }\n"
                 "}\n"
 
                 "\nExamples:\n" +
@@ -1392,6 +1461,26 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
     ret.pushKV("Starting block", heightStart);
     ret.pushKV("Ending block", heightEnd);
 
+    CBlockStatsEntry stats;
+    if (g_blockstatsindex && g_blockstatsindex->LookupRange(heightStart, heightEnd, stats)) {
+        CFeeRate nFeeRate = CFeeRate(stats.nFees, stats.nTxBytes);
+        ret.pushKV("txcount", stats.nTxCount);
+        ret.pushKV("txcount_all", stats.nTxCountAll);
+        ret.pushKV("txbytes", stats.nTxBytes);
+        ret.pushKV("ttlfee", FormatMoney(stats.nFees));
+        ret.pushKV("feeperkb", FormatMoney(nFeeRate.GetFeePerK()));
+        ret.pushKV("shield_txcount", stats.nShieldedTxCount);
+        ret.pushKV("khu_txcount", stats.nKHUTxCount);
+        if (stats.fKHUState) {
+            UniValue khu(UniValue::VOBJ);
+            khu.pushKV("C", ValueFromAmount(stats.nKHUC));
+            khu.pushKV("U", ValueFromAmount(stats.nKHUU));
+            khu.pushKV("Z", ValueFromAmount(stats.nKHUZ));
+            ret.pushKV("khu_delta", khu);
+        }
+        return ret;
+    }
+
     CAmount nFees = 0;
     int64_t nBytes = 0;
     int64_t nTxCount = 0;
@@ -1407,8 +1496,6 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
             throw JSONRPCError(RPC_DATABASE_ERROR, "failed to read block from disk");
         }
 
-        CAmount nValueIn = 0;
-        CAmount nValueOut = 0;
         const int ntx = block.vtx.size();
         const int firstTxIndex = block.IsProofOfStake() ? 2 : 1;
         nTxCount_all += ntx;
@@ -1426,6 +1513,7 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
             nBytes += GetSerializeSize(tx, CLIENT_VERSION);
 
             // Transparent inputs
+            CAmount nValueIn = 0;
             for (unsigned int j = 0; j < tx.vin.size(); j++) {
                 COutPoint prevout = tx.vin[j].prevout;
                 CTransactionRef txPrev;
@@ -1437,11 +1525,8 @@ UniValue getblockindexstats(const JSONRPCRequest& request) {
             // Shield inputs
             nValueIn += tx.GetShieldedValueIn();
 
-            // Transparent/Shield outputs
-            nValueOut += tx.GetValueOut();
-
-            // update fee
-            nFees += nValueIn - nValueOut;
+            // update fee (Transparent/Shield outputs)
+            nFees += nValueIn - tx.GetValueOut();
         }
         pindex = pindex->pprev;
     }
@@ -1720,6 +1805,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbose|verbosity"} },
     { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      true,  {} },
     { "blockchain",         "getbestchainlock",       &getbestchainlock,       true,  {} },
+    { "blockchain",         "getchainlock",           &getchainlock,           true,  {"height"} },
     { "blockchain",         "getblockcount",          &getblockcount,          true,  {} },
     { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         false, {"blockhash","verbose"} },
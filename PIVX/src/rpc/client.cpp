@@ -59,7 +59,9 @@ static const CRPCConvertParam vRPCConvertParams[] = {
     { "getblockindexstats", 0, "height" },
     { "getblockindexstats", 1, "range" },
     { "getblocktemplate", 0, "template_request" },
+    { "getchainlock", 0, "height" },
     { "getfeeinfo", 0, "blocks" },
+    { "getkhustate", 0, "height" },
     { "getshieldbalance", 1, "minconf" },
     { "getshieldbalance", 2, "include_watchonly" },
     { "getminedcommitment", 0, "llmq_type" },
@@ -16,6 +16,7 @@
 #include "khu/khu_domc_tx.h"
 #include "khu/khu_domcdb.h"
 #include "khu/khu_state.h"
+#include "khu/khu_statedb.h"
 #include "masternodeman.h"
 #include "primitives/transaction.h"
 #include "rpc/server.h"
@@ -28,9 +29,9 @@
 #include <univalue.h>
 
 /**
- * getkhustate - Get current KHU global state
+ * getkhustate - Get current (or historical) KHU global state
  *
- * Returns the KHU state at the current chain tip, including:
+ * Returns the KHU state at the current chain tip (or at the given height), including:
  * - C/U (collateral/supply)
  * - Cr/Ur (reward pool)
  * - R% governance parameters
@@ -38,7 +39,7 @@
  * - Invariant validation status
  *
  * Usage:
- *   getkhustate
+ *   getkhustate ( height )
  *
  * Returns:
  * {
@@ -58,10 +59,13 @@
  */
 static UniValue getkhustate(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0) {
+    if (request.fHelp || request.params.size() > 1) {
         throw std::runtime_error(
-            "getkhustate\n"
-            "\nReturns the current KHU global state.\n"
+            "getkhustate ( height )\n"
+            "\nReturns the current KHU global state, or the state at the given height.\n"
+            "\nArguments:\n"
+            "1. height    (numeric, optional) Block height (default: chain tip). With -khustateprune,\n"
+            "             only recent heights and checkpoints are available.\n"
             "\nResult:\n"
             "{\n"
             "  \"height\": n,           (numeric) Block height\n"
@@ -84,14 +88,31 @@ static UniValue getkhustate(const JSONRPCRequest& request)
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getkhustate", "")
+            + HelpExampleCli("getkhustate", "1000000")
             + HelpExampleRpc("getkhustate", "")
         );
     }
 
-    LOCK(cs_main);
-
     KhuGlobalState state;
-    if (!GetCurrentKHUState(state)) {
+    if (!request.params.empty()) {
+        LOCK(cs_main);
+        const int nHeight = request.params[0].get_int();
+        if (nHeight < 0 || nHeight > chainActive.Height()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
+        }
+        CKHUStateDB* db = GetKHUStateDB();
+        if (!db) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "KHU state database not initialized");
+        }
+        if (!db->ReadKHUState(nHeight, state)) {
+            if (db->IsKHUStatePruned(nHeight)) {
+                throw JSONRPCError(RPC_MISC_ERROR, strprintf("KHU state at height %d was pruned (-khustateprune), "
+                                   "only every %dth block is kept", nHeight, KHU_STATE_CHECKPOINT_INTERVAL));
+            }
+            throw JSONRPCError(RPC_INVALID_PARAMETER,
+                              strprintf("No KHU state available at height %d", nHeight));
+        }
+    } else if (!GetCurrentKHUState(state)) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to load KHU state");
     }
 
@@ -584,7 +605,7 @@ static UniValue khudaoinfo(const JSONRPCRequest& request)
 static const CRPCCommand commands[] = {
     //  category    name                      actor (function)            okSafe  argNames
     //  ----------- ------------------------  ------------------------    ------  ----------
-    { "khu",        "getkhustate",            &getkhustate,               true,   {} },
+    { "khu",        "getkhustate",            &getkhustate,               true,   {"height"} },
     { "khu",        "getkhustatecommitment",  &getkhustatecommitment,     true,   {"height"} },
     { "khu",        "domccommit",             &domccommit,                false,  {"R_proposal", "mn_outpoint"} },
     { "khu",        "domcreveal",             &domcreveal,                false,  {"R_proposal", "salt", "mn_outpoint"} },
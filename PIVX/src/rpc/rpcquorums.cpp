@@ -344,6 +344,44 @@ UniValue quorumdkgstatus(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue quorumsigsharesstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0) {
+        throw std::runtime_error(
+            "quorumsigsharesstats\n"
+            "Returns metrics of the verification of the received LLMQ signature shares.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"pending\": n,              (numeric) Sig shares waiting for verification\n"
+            "  \"max_sessions\": n,         (numeric) Current number of unique sessions verified per round\n"
+            "  \"rounds\": n,               (numeric) Verification rounds since startup\n"
+            "  \"verified\": n,             (numeric) Sig shares verified since startup\n"
+            "  \"bad_sources\": n,          (numeric) Peers which sent invalid sig shares\n"
+            "  \"last_verify_time\": n,     (numeric) Verification time of the last round, in ms\n"
+            "  \"avg_verify_time\": n,      (numeric) Average verification time of a round, in ms\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleRpc("quorumsigsharesstats", "")
+            + HelpExampleCli("quorumsigsharesstats", "")
+        );
+    }
+
+    if (!llmq::quorumSigSharesManager) {
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "LLMQ system not initialized");
+    }
+
+    const llmq::CSigSharesVerifyStats stats = llmq::quorumSigSharesManager->GetVerifyStats();
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("pending", (uint64_t)stats.pendingSigShares);
+    ret.pushKV("max_sessions", (uint64_t)stats.maxUniqueSessions);
+    ret.pushKV("rounds", stats.rounds);
+    ret.pushKV("verified", stats.verifiedSigShares);
+    ret.pushKV("bad_sources", stats.badSources);
+    ret.pushKV("last_verify_time", stats.lastVerifyTime);
+    ret.pushKV("avg_verify_time", stats.rounds ? stats.totalVerifyTime / (int64_t)stats.rounds : 0);
+    return ret;
+}
+
 UniValue quorumselectquorum(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 2) {
@@ -422,6 +460,7 @@ static const CRPCCommand commands[] =
     { "evo",         "quorumselectquorum",     &quorumselectquorum,  true,  {"llmq_type", "id"}  },
     { "evo",         "quorumdkgsimerror",      &quorumdkgsimerror,   true,  {"error_type", "rate"}  },
     { "evo",         "quorumdkgstatus",        &quorumdkgstatus,     true,  {"detail_level"}  },
+    { "evo",         "quorumsigsharesstats",   &quorumsigsharesstats,true,  {}  },
     { "evo",         "listquorums",            &listquorums,         true,  {"count"}  },
     { "evo",         "getquoruminfo",          &getquoruminfo,       true,  {"llmqType", "quorumHash", "includeSkShare"}  },
 
@@ -10,11 +10,85 @@
 #include "consensus/validation.h" // for CValidationState
 #include "util/system.h" // for error()
 #include "consensus/upgrades.h" // for CurrentEpochBranchId()
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "random.h"
+#include "script/sigcache.h" // for SignatureCacheHasher, MAX_MAX_SIG_CACHE_SIZE
 
 #include <librustzcash.h>
 
+#include <boost/thread/shared_mutex.hpp>
+
 namespace SaplingValidation {
 
+namespace {
+/**
+ * Valid Sapling bundle cache, to avoid verifying the zk-SNARK proofs of a
+ * shielded transaction twice (once when accepted into the memory pool, and
+ * again when its block is checked). Same design as CSignatureCache.
+ */
+class CProofCache
+{
+private:
+    //! Entries are SHA256(nonce || txid || Sapling signature hash):
+    uint256 nonce;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_proofcache;
+
+public:
+    CProofCache()
+    {
+        GetRandBytes(nonce.begin(), 32);
+    }
+
+    void ComputeEntry(uint256& entry, const uint256& txid, const uint256& dataToBeSigned)
+    {
+        CSHA256().Write(nonce.begin(), 32).Write(txid.begin(), 32).Write(dataToBeSigned.begin(), 32).Finalize(entry.begin());
+    }
+
+    bool Get(const uint256& entry, const bool erase)
+    {
+        boost::shared_lock<boost::shared_mutex> lock(cs_proofcache);
+        return setValid.contains(entry, erase);
+    }
+
+    void Set(uint256& entry)
+    {
+        boost::unique_lock<boost::shared_mutex> lock(cs_proofcache);
+        setValid.insert(entry);
+    }
+
+    uint32_t setup_bytes(size_t n)
+    {
+        return setValid.setup_bytes(n);
+    }
+};
+
+static CProofCache proofCache;
+}
+
+void InitProofCache()
+{
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, gArgs.GetArg("-maxsaplingproofcachesize", DEFAULT_MAX_SAPLING_PROOF_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    size_t nElems = proofCache.setup_bytes(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for Sapling proof cache, able to store %zu elements\n",
+            (nElems*sizeof(uint256)) >>20, nMaxCacheSize>>20, nElems);
+}
+
+// Signature hash the spend authorization and binding signatures commit to
+static bool GetSaplingSigHash(const CTransaction& tx, uint256& dataToBeSigned)
+{
+    // Empty output script.
+    CScript scriptCode;
+    try {
+        dataToBeSigned = SignatureHash(scriptCode, tx, NOT_AN_INPUT, SIGHASH_ALL, 0, SIGVERSION_SAPLING);
+    } catch (const std::logic_error& ex) {
+        return false;
+    }
+    return true;
+}
+
 // Verifies that Shielded txs are properly formed and performs content-independent checks
 bool CheckTransaction(const CTransaction& tx, CValidationState& state, CAmount& nValueOut)
 {
@@ -116,7 +190,8 @@ bool ContextualCheckTransaction(
         const CChainParams& chainparams,
         const int nHeight,
         const bool isMined,
-        bool isInitBlockDownload)
+        bool isInitBlockDownload,
+        std::vector<CProofCheck>* pvChecks)
 {
     const int DOS_LEVEL_BLOCK = 100;
     // DoS level set to 10 to be more forgiving.
@@ -166,70 +241,131 @@ bool ContextualCheckTransaction(
                 REJECT_INVALID, "bad-txns-exchange-addr-has-sapling");
         }
 
-        // Empty output script.
-        CScript scriptCode;
-        try {
-            dataToBeSigned = SignatureHash(scriptCode, tx, NOT_AN_INPUT, SIGHASH_ALL, 0, SIGVERSION_SAPLING);
-        } catch (const std::logic_error& ex) {
+        if (!GetSaplingSigHash(tx, dataToBeSigned)) {
             // A logic error should never occur because we pass NOT_AN_INPUT and
             // SIGHASH_ALL to SignatureHash().
             return state.DoS(100, error("%s: error computing signature hash", __func__ ),
                              REJECT_INVALID, "error-computing-signature-hash");
         }
 
-        // Sapling verification process
-        auto ctx = librustzcash_sapling_verification_ctx_init();
-
-        for (const SpendDescription &spend : tx.sapData->vShieldedSpend) {
-            if (!librustzcash_sapling_check_spend(
-                    ctx,
-                    spend.cv.begin(),
-                    spend.anchor.begin(),
-                    spend.nullifier.begin(),
-                    spend.rk.begin(),
-                    spend.zkproof.begin(),
-                    spend.spendAuthSig.begin(),
-                    dataToBeSigned.begin())) {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                return state.DoS(
-                        dosLevelPotentiallyRelaxing,
-                        error("%s: Sapling spend description invalid", __func__ ),
-                        REJECT_INVALID, "bad-txns-sapling-spend-description-invalid");
-            }
+        if (pvChecks) {
+            pvChecks->emplace_back(tx, dataToBeSigned, dosLevelPotentiallyRelaxing, !isMined);
+            return true;
         }
-
-        for (const OutputDescription &output : tx.sapData->vShieldedOutput) {
-            if (!librustzcash_sapling_check_output(
-                    ctx,
-                    output.cv.begin(),
-                    output.cmu.begin(),
-                    output.ephemeralKey.begin(),
-                    output.zkproof.begin())) {
-                librustzcash_sapling_verification_ctx_free(ctx);
-                // This should be a non-contextual check, but we check it here
-                // as we need to pass over the outputs anyway in order to then
-                // call librustzcash_sapling_final_check().
-                return state.DoS(100, error("%s: Sapling output description invalid", __func__ ),
-                                 REJECT_INVALID, "bad-txns-sapling-output-description-invalid");
-            }
+        const ProofError err = VerifyProofs(tx, dataToBeSigned, !isMined);
+        if (err != ProofError::NONE) {
+            return InvalidProofs(err, state, dosLevelPotentiallyRelaxing);
         }
+    }
+    return true;
+}
 
-        if (!librustzcash_sapling_final_check(
+bool HasCachedProofs(const CTransaction& tx)
+{
+    uint256 dataToBeSigned, entry;
+    if (!tx.IsShieldedTx() || !GetSaplingSigHash(tx, dataToBeSigned)) {
+        return false;
+    }
+    proofCache.ComputeEntry(entry, tx.GetHash(), dataToBeSigned);
+    return proofCache.Get(entry, false);
+}
+
+void EraseCachedProofs(const CTransaction& tx)
+{
+    uint256 dataToBeSigned, entry;
+    if (!tx.IsShieldedTx() || !GetSaplingSigHash(tx, dataToBeSigned)) {
+        return;
+    }
+    proofCache.ComputeEntry(entry, tx.GetHash(), dataToBeSigned);
+    proofCache.Get(entry, true);
+}
+
+ProofError VerifyProofs(const CTransaction& tx, const uint256& dataToBeSigned, bool fCacheStore)
+{
+    uint256 entry;
+    proofCache.ComputeEntry(entry, tx.GetHash(), dataToBeSigned);
+    // Lookup only: blocks that are just checked (templates) must not consume the mempool entries
+    if (proofCache.Get(entry, false)) {
+        return ProofError::NONE;
+    }
+
+    // Sapling verification process
+    auto ctx = librustzcash_sapling_verification_ctx_init();
+
+    for (const SpendDescription &spend : tx.sapData->vShieldedSpend) {
+        if (!librustzcash_sapling_check_spend(
                 ctx,
-                tx.sapData->valueBalance,
-                tx.sapData->bindingSig.begin(),
+                spend.cv.begin(),
+                spend.anchor.begin(),
+                spend.nullifier.begin(),
+                spend.rk.begin(),
+                spend.zkproof.begin(),
+                spend.spendAuthSig.begin(),
                 dataToBeSigned.begin())) {
             librustzcash_sapling_verification_ctx_free(ctx);
-            return state.DoS(
-                    dosLevelPotentiallyRelaxing,
-                    error("%s: Sapling binding signature invalid", __func__ ),
-                    REJECT_INVALID, "bad-txns-sapling-binding-signature-invalid");
+            return ProofError::SPEND_DESCRIPTION;
         }
+    }
 
+    for (const OutputDescription &output : tx.sapData->vShieldedOutput) {
+        if (!librustzcash_sapling_check_output(
+                ctx,
+                output.cv.begin(),
+                output.cmu.begin(),
+                output.ephemeralKey.begin(),
+                output.zkproof.begin())) {
+            librustzcash_sapling_verification_ctx_free(ctx);
+            return ProofError::OUTPUT_DESCRIPTION;
+        }
+    }
+
+    if (!librustzcash_sapling_final_check(
+            ctx,
+            tx.sapData->valueBalance,
+            tx.sapData->bindingSig.begin(),
+            dataToBeSigned.begin())) {
         librustzcash_sapling_verification_ctx_free(ctx);
+        return ProofError::BINDING_SIG;
     }
-    return true;
+
+    librustzcash_sapling_verification_ctx_free(ctx);
+    if (fCacheStore) {
+        proofCache.Set(entry);
+    }
+    return ProofError::NONE;
 }
 
+bool InvalidProofs(ProofError err, CValidationState& state, int dosLevelPotentiallyRelaxing)
+{
+    switch (err) {
+    case ProofError::SPEND_DESCRIPTION:
+        return state.DoS(
+                dosLevelPotentiallyRelaxing,
+                error("%s: Sapling spend description invalid", __func__ ),
+                REJECT_INVALID, "bad-txns-sapling-spend-description-invalid");
+    case ProofError::OUTPUT_DESCRIPTION:
+        // This should be a non-contextual check, but we check it here
+        // as we need to pass over the outputs anyway in order to then
+        // call librustzcash_sapling_final_check().
+        return state.DoS(100, error("%s: Sapling output description invalid", __func__ ),
+                         REJECT_INVALID, "bad-txns-sapling-output-description-invalid");
+    case ProofError::BINDING_SIG:
+        return state.DoS(
+                dosLevelPotentiallyRelaxing,
+                error("%s: Sapling binding signature invalid", __func__ ),
+                REJECT_INVALID, "bad-txns-sapling-binding-signature-invalid");
+    case ProofError::NONE:
+        break;
+    }
+    assert(false);
+    return false;
+}
+
+bool CProofCheck::operator()()
+{
+    const ProofError err = VerifyProofs(*ptx, dataToBeSigned, fCacheStore);
+    if (perr) *perr = err;
+    return err == ProofError::NONE;
+}
 
 } // End SaplingValidation namespace
@@ -7,12 +7,80 @@
 #define PIVX_SAPLING_SAPLING_VALIDATION_H
 
 #include "chainparams.h"
+#include "uint256.h"
+
+#include <vector>
 
 class CTransaction;
 class CValidationState;
 
+// Default size of the Sapling proof cache, in MiB (over 250000 entries)
+static const unsigned int DEFAULT_MAX_SAPLING_PROOF_CACHE_SIZE = 8;
+
 namespace SaplingValidation {
 
+/** To be called once in AppInitMain/BasicTestingSetup to initialize the proof cache */
+void InitProofCache();
+
+/** First failing step of a Sapling proof verification */
+enum class ProofError {
+    NONE,
+    SPEND_DESCRIPTION,
+    OUTPUT_DESCRIPTION,
+    BINDING_SIG,
+};
+
+/**
+ * Verify every spend/output proof and the binding signature of tx in one verification context.
+ * Successful verifications are remembered when fCacheStore (mempool) and only looked up
+ * otherwise (blocks, block templates): entries are dropped by EraseCachedProofs once
+ * their block is connected.
+ */
+ProofError VerifyProofs(const CTransaction& tx, const uint256& dataToBeSigned, bool fCacheStore);
+
+/** Whether a successful verification of the proofs of tx is cached */
+bool HasCachedProofs(const CTransaction& tx);
+
+/** Drop the cached verification of tx, connected in a block (ConnectBlock) */
+void EraseCachedProofs(const CTransaction& tx);
+
+/** Set the reject reason of a failed VerifyProofs into state. Always returns false. */
+bool InvalidProofs(ProofError err, CValidationState& state, int dosLevelPotentiallyRelaxing);
+
+/**
+ * Deferred VerifyProofs of one transaction, run on a CCheckQueue worker.
+ * The outcome is written to *perr, owned by the caller, so that the exact
+ * reject reason can be reported once the queue is done.
+ */
+class CProofCheck
+{
+private:
+    const CTransaction* ptx;
+    uint256 dataToBeSigned;
+    int dosLevelPotentiallyRelaxing;
+    bool fCacheStore;
+    ProofError* perr;
+
+public:
+    CProofCheck() : ptx(nullptr), dosLevelPotentiallyRelaxing(0), fCacheStore(false), perr(nullptr) {}
+    CProofCheck(const CTransaction& txIn, const uint256& dataToBeSignedIn, int dosLevelIn, bool fCacheStoreIn) :
+        ptx(&txIn), dataToBeSigned(dataToBeSignedIn), dosLevelPotentiallyRelaxing(dosLevelIn), fCacheStore(fCacheStoreIn), perr(nullptr) {}
+
+    bool operator()();
+
+    void SetErrorOutput(ProofError* perrIn) { perr = perrIn; }
+    int GetDoSLevel() const { return dosLevelPotentiallyRelaxing; }
+
+    void swap(CProofCheck& check)
+    {
+        std::swap(ptx, check.ptx);
+        std::swap(dataToBeSigned, check.dataToBeSigned);
+        std::swap(dosLevelPotentiallyRelaxing, check.dosLevelPotentiallyRelaxing);
+        std::swap(fCacheStore, check.fCacheStore);
+        std::swap(perr, check.perr);
+    }
+};
+
 /** Context-independent validity checks */
 // Note: for v3+, if the tx has no shielded data, this method returns true.
 // Note2: This function only performs shielded data related checks, it does NOT checks regular inputs and outputs.
@@ -21,9 +89,10 @@ bool CheckTransactionWithoutProofVerification(const CTransaction& tx, CValidatio
 
 /** Check a transaction contextually against a set of consensus rules */
 // Note: if v5 upgrade wasn't enforced, this method returns true without performing any check.
+// Note2: if pvChecks is not null, the proof verification is appended to it instead of being run.
 bool ContextualCheckTransaction(const CTransaction &tx, CValidationState &state,
                                 const CChainParams &chainparams, int nHeight, bool isMined,
-                                bool sInitBlockDownload);
+                                bool sInitBlockDownload, std::vector<CProofCheck>* pvChecks = nullptr);
 
 }; // End SaplingValidation namespace
 
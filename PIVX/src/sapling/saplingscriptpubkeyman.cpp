@@ -8,16 +8,87 @@
 #include "chain.h" // for CBlockIndex
 #include "primitives/transaction.h"
 #include "consensus/params.h"
+#include "ctpl_stl.h"
 #include "primitives/block.h"
 #include "sapling/incrementalmerkletree.h"
 #include "uint256.h"
-#include "validation.h" // for ReadBlockFromDisk()
+#include "util/threadnames.h"
+#include "validation.h" // for ReadBlockFromDisk(), nScriptCheckThreads
 #include "wallet/wallet.h"
 #include <algorithm>
+#include <future>
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+// Below this many trial decryptions (outputs x keys) a batch is not split over the pool
+static const size_t MIN_PARALLEL_TRIAL_DECRYPTIONS = 64;
+
+// Trial decryption workers, sized from -par like the script check threads
+static ctpl::thread_pool& GetTrialDecryptionPool()
+{
+    static std::unique_ptr<ctpl::thread_pool> pool = [] {
+        auto p = std::make_unique<ctpl::thread_pool>(std::max(nScriptCheckThreads - 1, 1));
+        RenameThreadPool(*p, "pivx-zdecrypt");
+        return p;
+    }();
+    return *pool;
+}
+
+static void TrialDecryptRange(const std::vector<const OutputDescription*>& vOutputs,
+                              const std::vector<libzcash::SaplingIncomingViewingKey>& vIvks,
+                              std::vector<Optional<SaplingTrialDecryption>>& vResults,
+                              size_t nBegin, size_t nEnd)
+{
+    for (size_t i = nBegin; i < nEnd; i++) {
+        const OutputDescription& output = *vOutputs[i];
+        for (const auto& ivk : vIvks) {
+            auto result = libzcash::SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cmu);
+            if (result) {
+                vResults[i] = SaplingTrialDecryption{ivk, *result};
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * Protocol Spec: 4.19 Block Chain Scanning (Sapling)
+ * For each output, the first key in vIvks that decrypts it (if any). The
+ * outputs are split in contiguous chunks, one per worker plus the caller.
+ */
+static std::vector<Optional<SaplingTrialDecryption>> TrialDecryptOutputs(
+        const std::vector<const OutputDescription*>& vOutputs,
+        const std::vector<libzcash::SaplingIncomingViewingKey>& vIvks)
+{
+    std::vector<Optional<SaplingTrialDecryption>> vResults(vOutputs.size());
+    if (vOutputs.empty() || vIvks.empty()) {
+        return vResults;
+    }
+
+    const size_t nWorkers = nScriptCheckThreads > 1 ? nScriptCheckThreads - 1 : 0;
+    if (nWorkers == 0 || vOutputs.size() < 2 || vOutputs.size() * vIvks.size() < MIN_PARALLEL_TRIAL_DECRYPTIONS) {
+        TrialDecryptRange(vOutputs, vIvks, vResults, 0, vOutputs.size());
+        return vResults;
+    }
+
+    const size_t nChunks = std::min(vOutputs.size(), nWorkers + 1);
+    const size_t nChunkSize = (vOutputs.size() + nChunks - 1) / nChunks;
+    std::vector<std::future<void>> vFutures;
+    for (size_t nBegin = nChunkSize; nBegin < vOutputs.size(); nBegin += nChunkSize) {
+        const size_t nEnd = std::min(nBegin + nChunkSize, vOutputs.size());
+        vFutures.emplace_back(GetTrialDecryptionPool().push([&vOutputs, &vIvks, &vResults, nBegin, nEnd](int) {
+            TrialDecryptRange(vOutputs, vIvks, vResults, nBegin, nEnd);
+        }));
+    }
+    TrialDecryptRange(vOutputs, vIvks, vResults, 0, nChunkSize);
+    for (auto& f : vFutures) {
+        f.get();
+    }
+    return vResults;
+}
+
 void SaplingScriptPubKeyMan::AddToSaplingSpends(const uint256& nullifier, const uint256& wtxid)
 {
     AssertLockHeld(wallet->cs_wallet);
@@ -541,47 +612,58 @@ std::pair<mapSaplingNoteData_t, SaplingIncomingViewingKeyMap> SaplingScriptPubKe
     mapSaplingNoteData_t noteData;
     SaplingIncomingViewingKeyMap viewingKeysToAdd;
 
-    // Protocol Spec: 4.19 Block Chain Scanning (Sapling)
-    for (uint32_t i = 0; i < tx.sapData->vShieldedOutput.size(); ++i) {
-        const OutputDescription output = tx.sapData->vShieldedOutput[i];
-        for (auto it = wallet->mapSaplingFullViewingKeys.begin(); it != wallet->mapSaplingFullViewingKeys.end(); ++it) {
-            libzcash::SaplingIncomingViewingKey ivk = it->first;
-            auto result = libzcash::SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cmu);
-            if (!result) {
-                continue;
-            }
-
-            // Check if we already have it.
-            Optional<libzcash::SaplingPaymentAddress> address = ivk.address(result.get().d);
-            if (address && wallet->mapSaplingIncomingViewingKeys.count(address.get()) == 0) {
-                viewingKeysToAdd[address.get()] = ivk;
-            }
-            // We don't cache the nullifier here as computing it requires knowledge of the note position
-            // in the commitment tree, which can only be determined when the transaction has been mined.
-            SaplingOutPoint op {hash, i};
-            SaplingNoteData nd;
-            nd.ivk = ivk;
-            nd.amount = result->value();
-            nd.address = address;
-            const auto& memo = result->memo();
-            // don't save empty memo (starting with 0xF6)
-            if (memo[0] < 0xF6) {
-                nd.memo = memo;
+    // Use the block batch if it was decrypted with the current keys
+    std::vector<Optional<SaplingTrialDecryption>> vDecrypted(tx.sapData->vShieldedOutput.size());
+    if (setBatchDecryptedTxes.count(hash) && nBatchDecryptionKeys == wallet->mapSaplingFullViewingKeys.size()) {
+        for (uint32_t i = 0; i < vDecrypted.size(); ++i) {
+            auto it = mapBatchDecryptions.find(SaplingOutPoint(hash, i));
+            if (it != mapBatchDecryptions.end()) {
+                vDecrypted[i] = it->second;
             }
+        }
+    } else {
+        std::vector<const OutputDescription*> vOutputs;
+        for (const OutputDescription& output : tx.sapData->vShieldedOutput) {
+            vOutputs.emplace_back(&output);
+        }
+        vDecrypted = TrialDecryptOutputs(vOutputs, GetTrialDecryptionKeys());
+    }
 
-            // Tag KHU_STAKE notes for the standard Sapling witness pipeline
-            // This allows IncrementNoteWitnesses to maintain witnesses for ZKHU stake notes
-            if (tx.nType == CTransaction::TxType::KHU_STAKE) {
-                nd.khu_stake_meta.is_khu_stake = true;
-                nd.khu_stake_meta.stake_height = 0;  // Will be set when tx is confirmed
-                nd.khu_stake_meta.is_mature = false;
-                LogPrint(BCLog::KHU, "FindMySaplingNotes: detected KHU_STAKE note, txid=%s, op.n=%d\n",
-                         hash.ToString().substr(0, 16), i);
-            }
+    for (uint32_t i = 0; i < vDecrypted.size(); ++i) {
+        if (!vDecrypted[i]) {
+            continue;
+        }
+        const libzcash::SaplingIncomingViewingKey& ivk = vDecrypted[i]->ivk;
+        const libzcash::SaplingNotePlaintext& result = vDecrypted[i]->plaintext;
+        // Check if we already have it.
+        Optional<libzcash::SaplingPaymentAddress> address = ivk.address(result.d);
+        if (address && wallet->mapSaplingIncomingViewingKeys.count(address.get()) == 0) {
+            viewingKeysToAdd[address.get()] = ivk;
+        }
+        // We don't cache the nullifier here as computing it requires knowledge of the note position
+        // in the commitment tree, which can only be determined when the transaction has been mined.
+        SaplingOutPoint op {hash, i};
+        SaplingNoteData nd;
+        nd.ivk = ivk;
+        nd.amount = result.value();
+        nd.address = address;
+        const auto& memo = result.memo();
+        // don't save empty memo (starting with 0xF6)
+        if (memo[0] < 0xF6) {
+            nd.memo = memo;
+        }
 
-            noteData.insert(std::make_pair(op, nd));
-            break;
+        // Tag KHU_STAKE notes for the standard Sapling witness pipeline
+        // This allows IncrementNoteWitnesses to maintain witnesses for ZKHU stake notes
+        if (tx.nType == CTransaction::TxType::KHU_STAKE) {
+            nd.khu_stake_meta.is_khu_stake = true;
+            nd.khu_stake_meta.stake_height = 0;  // Will be set when tx is confirmed
+            nd.khu_stake_meta.is_mature = false;
+            LogPrint(BCLog::KHU, "FindMySaplingNotes: detected KHU_STAKE note, txid=%s, op.n=%d\n",
+                     hash.ToString().substr(0, 16), i);
         }
+
+        noteData.insert(std::make_pair(op, nd));
     }
 
     return std::make_pair(noteData, viewingKeysToAdd);
@@ -593,23 +675,72 @@ std::vector<libzcash::SaplingPaymentAddress> SaplingScriptPubKeyMan::FindMySapli
     std::vector<libzcash::SaplingPaymentAddress> ret;
     if (!tx.sapData) return ret;
 
-    // Protocol Spec: 4.19 Block Chain Scanning (Sapling)
+    std::vector<const OutputDescription*> vOutputs;
     for (const OutputDescription& output : tx.sapData->vShieldedOutput) {
-        for (auto it = wallet->mapSaplingFullViewingKeys.begin(); it != wallet->mapSaplingFullViewingKeys.end(); ++it) {
-            libzcash::SaplingIncomingViewingKey ivk = it->first;
-            auto result = libzcash::SaplingNotePlaintext::decrypt(output.encCiphertext, ivk, output.ephemeralKey, output.cmu);
-            if (!result) {
-                continue;
-            }
-            Optional<libzcash::SaplingPaymentAddress> address = ivk.address(result.get().d);
-            if (address && wallet->mapSaplingIncomingViewingKeys.count(address.get()) != 0) {
-                ret.emplace_back(address.get());
-            }
+        vOutputs.emplace_back(&output);
+    }
+    for (const auto& decrypted : TrialDecryptOutputs(vOutputs, GetTrialDecryptionKeys())) {
+        if (!decrypted) {
+            continue;
+        }
+        Optional<libzcash::SaplingPaymentAddress> address = decrypted->ivk.address(decrypted->plaintext.d);
+        if (address && wallet->mapSaplingIncomingViewingKeys.count(address.get()) != 0) {
+            ret.emplace_back(address.get());
         }
     }
     return ret;
 }
 
+std::vector<libzcash::SaplingIncomingViewingKey> SaplingScriptPubKeyMan::GetTrialDecryptionKeys() const
+{
+    AssertLockHeld(wallet->cs_KeyStore);
+    std::vector<libzcash::SaplingIncomingViewingKey> vIvks;
+    vIvks.reserve(wallet->mapSaplingFullViewingKeys.size());
+    for (const auto& it : wallet->mapSaplingFullViewingKeys) {
+        vIvks.emplace_back(it.first);
+    }
+    return vIvks;
+}
+
+void SaplingScriptPubKeyMan::BatchDecryptBlock(const CBlock& block)
+{
+    std::vector<uint256> vTxids;
+    std::vector<SaplingOutPoint> vOutPoints;
+    std::vector<const OutputDescription*> vOutputs;
+    for (const auto& tx : block.vtx) {
+        if (!tx->IsShieldedTx()) continue;
+        const uint256& hash = tx->GetHash();
+        vTxids.emplace_back(hash);
+        for (uint32_t i = 0; i < tx->sapData->vShieldedOutput.size(); ++i) {
+            vOutPoints.emplace_back(hash, i);
+            vOutputs.emplace_back(&tx->sapData->vShieldedOutput[i]);
+        }
+    }
+
+    // Only the key list is read under the lock, the decryption runs without it
+    std::vector<libzcash::SaplingIncomingViewingKey> vIvks = WITH_LOCK(wallet->cs_KeyStore, return GetTrialDecryptionKeys(); );
+    std::vector<Optional<SaplingTrialDecryption>> vDecrypted = TrialDecryptOutputs(vOutputs, vIvks);
+
+    LOCK(wallet->cs_KeyStore);
+    mapBatchDecryptions.clear();
+    setBatchDecryptedTxes.clear();
+    setBatchDecryptedTxes.insert(vTxids.begin(), vTxids.end());
+    nBatchDecryptionKeys = vIvks.size();
+    for (size_t i = 0; i < vDecrypted.size(); i++) {
+        if (vDecrypted[i]) {
+            mapBatchDecryptions.emplace(vOutPoints[i], std::move(*vDecrypted[i]));
+        }
+    }
+}
+
+void SaplingScriptPubKeyMan::ClearBatchDecryptions()
+{
+    LOCK(wallet->cs_KeyStore);
+    mapBatchDecryptions.clear();
+    setBatchDecryptedTxes.clear();
+    nBatchDecryptionKeys = 0;
+}
+
 void SaplingScriptPubKeyMan::GetNotes(const std::vector<SaplingOutPoint>& saplingOutpoints,
                                       std::vector<SaplingNoteEntry>& saplingEntriesRet) const
 {
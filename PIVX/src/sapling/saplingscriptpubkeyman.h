@@ -14,6 +14,7 @@
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include <map>
+#include <set>
 
 //! Size of witness cache
 //  Should be large enough that we can expect not to reorg beyond our cache
@@ -23,6 +24,13 @@ static const unsigned int WITNESS_CACHE_SIZE = DEFAULT_MAX_REORG_DEPTH + 1;
 class CBlock;
 class CBlockIndex;
 
+/** Wallet key that decrypted a Sapling output, and the note plaintext */
+struct SaplingTrialDecryption
+{
+    libzcash::SaplingIncomingViewingKey ivk;
+    libzcash::SaplingNotePlaintext plaintext;
+};
+
 /** Sapling note, its location in a transaction, and number of confirmations. */
 struct SaplingNoteEntry
 {
@@ -316,6 +324,12 @@ public:
     //! Find all of the addresses in the given tx that have been sent to a SaplingPaymentAddress in this wallet.
     std::vector<libzcash::SaplingPaymentAddress> FindMySaplingAddresses(const CTransaction& tx) const;
 
+    //! Trial-decrypt all the Sapling outputs of a block at once, outside of the wallet locks and
+    //! across the decryption thread pool. FindMySaplingNotes uses the results for the block txes
+    //! until ClearBatchDecryptions().
+    void BatchDecryptBlock(const CBlock& block);
+    void ClearBatchDecryptions();
+
     //! Find notes for the outpoints
     void GetNotes(const std::vector<SaplingOutPoint>& saplingOutpoints,
                   std::vector<SaplingNoteEntry>& saplingEntriesRet) const;
@@ -460,6 +474,15 @@ private:
     Optional<uint256> commonOVK;
     uint256 getCommonOVKFromSeed() const;
 
+    /* Trial decryptions of the block being connected or rescanned (guarded by cs_KeyStore) */
+    std::map<SaplingOutPoint, SaplingTrialDecryption> mapBatchDecryptions;
+    std::set<uint256> setBatchDecryptedTxes;
+    /* Number of viewing keys the batch was decrypted with (keys are never removed) */
+    size_t nBatchDecryptionKeys{0};
+
+    /* Incoming viewing keys of the wallet, in trial decryption order */
+    std::vector<libzcash::SaplingIncomingViewingKey> GetTrialDecryptionKeys() const;
+
 
     /**
      * Used to keep track of spent Notes, and
@@ -0,0 +1,204 @@
+// Copyright (c) 2011-2020 The Bitcoin Core developers
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "blockencodings.h"
+#include "consensus/merkle.h"
+#include "random.h"
+#include "streams.h"
+#include "txmempool.h"
+#include "version.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blockencodings_tests, BasicTestingSetup)
+
+static CMutableTransaction MakeTx(const uint256& prevHash, CAmount nValue)
+{
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(prevHash, 0));
+    tx.vin[0].scriptSig = CScript() << OP_11;
+    tx.vout.emplace_back(nValue, CScript() << OP_11 << OP_EQUAL);
+    return tx;
+}
+
+// Coinbase, (coinstake,) then two transactions, the second spending the first
+static CBlock BuildBlock(bool fProofOfStake)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.emplace_back();
+    coinbase.vin[0].scriptSig = CScript() << OP_11 << InsecureRand32();
+    coinbase.vout.emplace_back(fProofOfStake ? 0 : 42, CScript() << OP_TRUE);
+    if (fProofOfStake) coinbase.vout[0].SetEmpty();
+    block.vtx.emplace_back(MakeTransactionRef(coinbase));
+
+    if (fProofOfStake) {
+        CMutableTransaction coinstake;
+        coinstake.vin.emplace_back(COutPoint(InsecureRand256(), 1));
+        coinstake.vout.emplace_back();
+        coinstake.vout[0].SetEmpty();
+        coinstake.vout.emplace_back(42, CScript() << OP_TRUE);
+        block.vtx.emplace_back(MakeTransactionRef(coinstake));
+        block.vchBlockSig = {0x30, 0x44, 0x02};
+    }
+
+    const CMutableTransaction tx1 = MakeTx(InsecureRand256(), 1000);
+    block.vtx.emplace_back(MakeTransactionRef(tx1));
+    block.vtx.emplace_back(MakeTransactionRef(MakeTx(tx1.GetHash(), 900)));
+
+    block.nVersion = 4;
+    block.hashPrevBlock = InsecureRand256();
+    block.nBits = 0x207fffff;
+    block.nTime = 1600000000;
+    bool mutated;
+    block.hashMerkleRoot = BlockMerkleRoot(block, &mutated);
+    assert(!mutated);
+    return block;
+}
+
+static CBlockHeaderAndShortTxIDs RoundTrip(const CBlockHeaderAndShortTxIDs& cmpctblock)
+{
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << cmpctblock;
+    CBlockHeaderAndShortTxIDs cmpctblockRead;
+    stream >> cmpctblockRead;
+    return cmpctblockRead;
+}
+
+BOOST_AUTO_TEST_CASE(reconstruct_from_mempool)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildBlock(false);
+
+    pool.addUnchecked(block.vtx[2]->GetHash(), entry.FromTx(*block.vtx[2]));
+    pool.addUnchecked(block.vtx[1]->GetHash(), entry.FromTx(*block.vtx[1]));
+
+    const CBlockHeaderAndShortTxIDs cmpctblock = RoundTrip(CBlockHeaderAndShortTxIDs(block));
+    BOOST_CHECK_EQUAL(cmpctblock.BlockTxCount(), block.vtx.size());
+
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_REQUIRE(partialBlock.InitData(cmpctblock) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK(partialBlock.IsTxAvailable(i));
+    }
+
+    CBlock blockRebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(blockRebuilt, {}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(blockRebuilt.GetHash().ToString(), block.GetHash().ToString());
+    BOOST_CHECK_EQUAL(blockRebuilt.vtx.size(), block.vtx.size());
+}
+
+BOOST_AUTO_TEST_CASE(reconstruct_with_missing_txs)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildBlock(false);
+
+    // Only the last transaction is in our mempool
+    pool.addUnchecked(block.vtx[2]->GetHash(), entry.FromTx(*block.vtx[2]));
+
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_REQUIRE(partialBlock.InitData(RoundTrip(CBlockHeaderAndShortTxIDs(block))) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(!partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(partialBlock.IsTxAvailable(2));
+
+    // getblocktxn / blocktxn round trip
+    BlockTransactionsRequest req;
+    req.blockhash = block.GetHash();
+    req.indexes = {1};
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    stream << req;
+    BlockTransactionsRequest reqRead;
+    stream >> reqRead;
+    BOOST_CHECK(reqRead.blockhash == req.blockhash);
+    BOOST_CHECK(reqRead.indexes == req.indexes);
+
+    // A wrong transaction yields a merkle mismatch: fall back to the full block
+    {
+        PartiallyDownloadedBlock partialBlockCopy = partialBlock;
+        CBlock blockRebuilt;
+        BOOST_CHECK(partialBlockCopy.FillBlock(blockRebuilt, {block.vtx[2]}) == READ_STATUS_FAILED);
+    }
+    // Too many transactions is an invalid answer
+    {
+        PartiallyDownloadedBlock partialBlockCopy = partialBlock;
+        CBlock blockRebuilt;
+        BOOST_CHECK(partialBlockCopy.FillBlock(blockRebuilt, {block.vtx[1], block.vtx[2]}) == READ_STATUS_INVALID);
+    }
+
+    CBlock blockRebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(blockRebuilt, {block.vtx[1]}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(blockRebuilt.GetHash().ToString(), block.GetHash().ToString());
+}
+
+// Compact block whose short IDs can be tampered with
+struct TestHeaderAndShortIDs : public CBlockHeaderAndShortTxIDs
+{
+    explicit TestHeaderAndShortIDs(const CBlock& block) : CBlockHeaderAndShortTxIDs(block) {}
+
+    void CollideShortIDs(size_t i, size_t j) { shorttxids[j] = shorttxids[i]; }
+};
+
+BOOST_AUTO_TEST_CASE(reconstruct_with_short_id_collision)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildBlock(false);
+
+    pool.addUnchecked(block.vtx[2]->GetHash(), entry.FromTx(*block.vtx[2]));
+    pool.addUnchecked(block.vtx[1]->GetHash(), entry.FromTx(*block.vtx[1]));
+
+    // Both transactions share a short ID: neither is taken from the mempool
+    TestHeaderAndShortIDs cmpctblock(block);
+    cmpctblock.CollideShortIDs(0, 1);
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_REQUIRE(partialBlock.InitData(RoundTrip(cmpctblock)) == READ_STATUS_OK);
+    BOOST_CHECK(partialBlock.IsTxAvailable(0));
+    BOOST_CHECK(!partialBlock.IsTxAvailable(1));
+    BOOST_CHECK(!partialBlock.IsTxAvailable(2));
+
+    CBlock blockRebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(blockRebuilt, {block.vtx[1], block.vtx[2]}) == READ_STATUS_OK);
+    BOOST_CHECK_EQUAL(blockRebuilt.GetHash().ToString(), block.GetHash().ToString());
+}
+
+BOOST_AUTO_TEST_CASE(proof_of_stake_block)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+    const CBlock block = BuildBlock(true);
+    BOOST_REQUIRE(block.IsProofOfStake());
+
+    pool.addUnchecked(block.vtx[2]->GetHash(), entry.FromTx(*block.vtx[2]));
+    pool.addUnchecked(block.vtx[3]->GetHash(), entry.FromTx(*block.vtx[3]));
+
+    // Coinbase and coinstake are prefilled, the block signature travels with the header
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_REQUIRE(partialBlock.InitData(RoundTrip(CBlockHeaderAndShortTxIDs(block))) == READ_STATUS_OK);
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        BOOST_CHECK(partialBlock.IsTxAvailable(i));
+    }
+
+    CBlock blockRebuilt;
+    BOOST_CHECK(partialBlock.FillBlock(blockRebuilt, {}) == READ_STATUS_OK);
+    BOOST_CHECK(blockRebuilt.IsProofOfStake());
+    BOOST_CHECK(blockRebuilt.vchBlockSig == block.vchBlockSig);
+    BOOST_CHECK_EQUAL(blockRebuilt.GetHash().ToString(), block.GetHash().ToString());
+}
+
+BOOST_AUTO_TEST_CASE(invalid_compact_block)
+{
+    CTxMemPool pool(CFeeRate(0));
+
+    // Empty compact block
+    PartiallyDownloadedBlock partialBlock(&pool);
+    BOOST_CHECK(partialBlock.InitData(CBlockHeaderAndShortTxIDs()) == READ_STATUS_INVALID);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -384,6 +384,16 @@ BOOST_FIXTURE_TEST_CASE(dip3_protx, TestChain400Setup)
         nHeight++;
     }
 
+    // the lists cache is bounded by the estimated memory usage of the lists
+    {
+        const CDeterministicMNList& tipList = deterministicMNManager->GetListAtChainTip();
+        const CDeterministicMNList& oldList = deterministicMNManager->GetListForBlock(chainActive[nHeight - 3]);
+        BOOST_CHECK_EQUAL(oldList.GetAllMNsCount(), 3);
+        BOOST_CHECK(oldList.GetMemoryUsage() < tipList.GetMemoryUsage());
+        // a historical list is memoized once rebuilt
+        BOOST_CHECK(deterministicMNManager->GetListForBlock(chainActive[nHeight - 3]).GetBlockHash() == oldList.GetBlockHash());
+    }
+
     // enable SPORK_21
     const CSporkMessage& spork = CSporkMessage(SPORK_21_LEGACY_MNS_MAX_HEIGHT, nHeight, GetTime());
     sporkManager.AddOrUpdateSporkMessage(spork);
@@ -1052,6 +1062,26 @@ BOOST_FIXTURE_TEST_CASE(dkg_pose_and_qfc_invalid_paths, TestChain400Setup)
 
     // get quorum mns
     auto members = deterministicMNManager->GetAllQuorumMembers(Consensus::LLMQ_TEST, quorumIndex);
+    {
+        // same members as the full sort of the scores, then served from the cache
+        const uint256& modifier = ::SerializeHash(std::make_pair(static_cast<uint8_t>(Consensus::LLMQ_TEST), quorumHash));
+        auto scores = deterministicMNManager->GetListForBlock(quorumIndex).CalculateScores(modifier);
+        std::sort(scores.begin(), scores.end(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+            return b.first < a.first;
+        });
+        BOOST_REQUIRE_EQUAL(members.size(), std::min((size_t)params.size, scores.size()));
+        for (size_t i = 0; i < members.size(); i++) {
+            BOOST_CHECK(members[i]->proTxHash == scores[i].second->proTxHash);
+        }
+        BOOST_CHECK(deterministicMNManager->GetAllQuorumMembers(Consensus::LLMQ_TEST, quorumIndex) == members);
+        // persisted when the quorum block was connected
+        std::vector<uint256> proTxHashes;
+        BOOST_CHECK(evoDb->Read(std::make_pair(std::string("dmn_Q"), std::make_pair(static_cast<uint8_t>(Consensus::LLMQ_TEST), quorumHash)), proTxHashes));
+        BOOST_REQUIRE_EQUAL(proTxHashes.size(), members.size());
+        for (size_t i = 0; i < members.size(); i++) {
+            BOOST_CHECK(proTxHashes[i] == members[i]->proTxHash);
+        }
+    }
     std::vector<CBLSPublicKey> pkeys;
     std::vector<CBLSSecretKey> skeys;
     for (size_t i = 0; i < members.size()-1; i++) {             // all, except the last one...
@@ -0,0 +1,134 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//
+// Unit tests for TestBlockValidity on KHU blocks
+//
+// TestBlockValidity applies the KHU transactions of a block template in
+// full, inside a KHU DB transaction it rolls back: the KHU databases must
+// come out of it unchanged.
+//
+
+#include "test/test_pivx.h"
+
+#include "khu/khu_commitmentdb.h"
+#include "khu/khu_domcdb.h"
+#include "khu/khu_mint.h"
+#include "khu/khu_state.h"
+#include "khu/khu_statedb.h"
+#include "khu/khu_validation.h"
+#include "khu/zkhu_db.h"
+#include "script/sign.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+// Regtest V6 activation
+static const int KHU_V6_HEIGHT = 200;
+
+struct KHUBlockValiditySetup : public TestChainSetup
+{
+    KHUBlockValiditySetup() : TestChainSetup(KHU_V6_HEIGHT - 1)
+    {
+        if (!InitKHUStateDB(1 << 20, true, true) || !InitKHUCommitmentDB(1 << 20, true, true) ||
+            !InitZKHUDB(1 << 20, true, true) || !InitKHUDomcDB(1 << 20, true, true)) {
+            throw std::runtime_error("Failed to initialize KHU DBs for TestBlockValidity tests");
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(khu_blockvalidity_tests, KHUBlockValiditySetup)
+
+// Value of a LevelDB record, as raw bytes
+struct RawDBValue
+{
+    std::string data;
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        data.assign(s.begin(), s.end());
+        s.ignore(s.size());
+    }
+};
+
+// Every record written to disk by a KHU database
+static std::map<std::string, std::string> DumpKHUDB(CDBWrapper& db)
+{
+    std::map<std::string, std::string> mapRecords;
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+        const CDataStream ssKey = pcursor->GetKey();
+        RawDBValue value;
+        BOOST_CHECK(pcursor->GetValue(value));
+        mapRecords.emplace(std::string(ssKey.begin(), ssKey.end()), value.data);
+    }
+    return mapRecords;
+}
+
+// Flushes the connected blocks, then dumps the state (with KHU UTXOs), ZKHU, DOMC and commitment databases
+static std::vector<std::map<std::string, std::string>> FlushAndDumpKHUDBs()
+{
+    LOCK(cs_main);
+    BOOST_CHECK(CommitKHURootTransactions());
+    BOOST_CHECK_EQUAL(GetKHUDBMemoryUsage(), 0U);
+    return {DumpKHUDB(*GetKHUStateDB()), DumpKHUDB(*GetZKHUDB()), DumpKHUDB(*GetKHUDomcDB()), DumpKHUDB(*GetKHUCommitmentDB())};
+}
+
+static CMutableTransaction CreateMintTx(const CTransaction& txFrom, const CKey& key, CAmount amount)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = CTransaction::TxType::KHU_MINT;
+    const CScript scriptKey = GetScriptForRawPubKey(key.GetPubKey());
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << CMintKHUPayload(amount, scriptKey);
+    mtx.extraPayload = std::vector<uint8_t>(ds.begin(), ds.end());
+    mtx.vin.emplace_back(txFrom.GetHash(), 0);
+    mtx.vout.emplace_back(amount, CScript() << OP_RETURN << std::vector<unsigned char>(32, 0x01));
+    mtx.vout.emplace_back(amount, scriptKey);
+    mtx.vout.emplace_back(txFrom.vout[0].nValue - 2 * amount - COIN / 100, scriptKey);
+
+    CBasicKeyStore keystore;
+    keystore.AddKeyPubKey(key, key.GetPubKey());
+    BOOST_REQUIRE(SignSignature(keystore, txFrom, mtx, 0, SIGHASH_ALL));
+    return mtx;
+}
+
+BOOST_AUTO_TEST_CASE(testblockvalidity_leaves_khu_dbs_unchanged)
+{
+    const CScript scriptPubKey = GetScriptForRawPubKey(coinbaseKey.GetPubKey());
+    const CAmount nMint = 10 * COIN;
+
+    // First KHU block, then a block with a MINT
+    CreateAndProcessBlock({}, scriptPubKey);
+    KhuGlobalState prevState, state;
+    BOOST_REQUIRE(GetKHUStateDB()->ReadKHUState(KHU_V6_HEIGHT, prevState));
+    CreateAndProcessBlock({CreateMintTx(coinbaseTxns[0], coinbaseKey, nMint)}, scriptPubKey);
+    BOOST_REQUIRE(GetKHUStateDB()->ReadKHUState(KHU_V6_HEIGHT + 1, state));
+    BOOST_CHECK_EQUAL(state.C, prevState.C + nMint);
+    prevState = state;
+
+    const auto vDBsBefore = FlushAndDumpKHUDBs();
+
+    // Template with another MINT, fully simulated by TestBlockValidity
+    const CBlock block = CreateBlock({CreateMintTx(coinbaseTxns[1], coinbaseKey, nMint)}, scriptPubKey, true, false);
+    {
+        LOCK(cs_main);
+        CValidationState valState;
+        BOOST_CHECK(TestBlockValidity(valState, block, chainActive.Tip(), false, true, false));
+        BOOST_CHECK(valState.IsValid());
+        BOOST_CHECK_EQUAL(GetKHUDBMemoryUsage(), 0U);
+    }
+    BOOST_CHECK(!GetKHUStateDB()->ExistsKHUState(KHU_V6_HEIGHT + 2));
+    BOOST_CHECK(FlushAndDumpKHUDBs() == vDBsBefore);
+
+    // The simulated block was the real thing
+    ProcessNewBlock(std::make_shared<const CBlock>(block), nullptr);
+    BOOST_REQUIRE(GetKHUStateDB()->ReadKHUState(KHU_V6_HEIGHT + 2, state));
+    BOOST_CHECK_EQUAL(state.C, prevState.C + nMint);
+    BOOST_CHECK(FlushAndDumpKHUDBs() != vDBsBefore);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,159 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//
+// Unit tests for the layered KHU coins views (CKHUCoinsViewCache)
+//
+// KHU_T UTXOs go through the same DIRTY/FRESH cache layering as pcoinsTip:
+// per-block scopes on top of a tip cache on top of the KHU state DB.
+//
+
+#include "test/test_pivx.h"
+
+#include "coins.h"
+#include "khu/khu_coins.h"
+#include "khu/khu_dbwrapper.h"
+#include "khu/khu_statedb.h"
+#include "khu/khu_utxo.h"
+#include "random.h"
+
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(khu_coins_tests, BasicTestingSetup)
+
+static CKHUUTXO MakeCoin(CAmount amount, uint32_t nHeight)
+{
+    return CKHUUTXO(amount, CScript() << OP_TRUE, nHeight);
+}
+
+BOOST_AUTO_TEST_CASE(khu_coins_cache_fresh_and_dirty)
+{
+    CKHUCoinsView base;
+    CKHUCoinsViewCache parent(&base);
+    const COutPoint out1(InsecureRand256(), 0);
+    const COutPoint out2(InsecureRand256(), 1);
+
+    parent.AddCoin(out1, MakeCoin(5 * COIN, 1), false);
+    BOOST_CHECK(parent.HaveCoin(out1));
+    BOOST_CHECK(parent.DynamicMemoryUsage() > 0);
+
+    {
+        CKHUCoinsViewCache child(&parent);
+        // Created and spent in the same child: never reaches the parent
+        child.AddCoin(out2, MakeCoin(COIN, 2), false);
+        child.SpendCoin(out2);
+        BOOST_CHECK_EQUAL(child.GetCacheSize(), 0U);
+
+        // Spending a parent coin is only visible to the child until Flush()
+        CKHUUTXO moved;
+        child.SpendCoin(out1, &moved);
+        BOOST_CHECK_EQUAL(moved.amount, 5 * COIN);
+        BOOST_CHECK(!child.HaveCoin(out1));
+        BOOST_CHECK(parent.HaveCoin(out1));
+        BOOST_CHECK(child.Flush());
+    }
+
+    // Spent FRESH entry is dropped from the parent as well
+    BOOST_CHECK(!parent.HaveCoin(out1));
+    BOOST_CHECK(!parent.HaveCoin(out2));
+    BOOST_CHECK_EQUAL(parent.GetCacheSize(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(khu_coins_cache_flush_to_db)
+{
+    CKHUStateDB db(1 << 20, true);
+    CKHUCoinsViewDB dbView(db);
+    const COutPoint out1(InsecureRand256(), 0);
+    const COutPoint out2(InsecureRand256(), 0);
+    BOOST_CHECK(db.WriteKHUUTXO(out1, MakeCoin(3 * COIN, 1)));
+
+    CKHUCoinsViewCache tip(&dbView);
+    CKHUUTXO coin;
+    BOOST_CHECK(tip.GetCoin(out1, coin));
+    BOOST_CHECK_EQUAL(coin.amount, 3 * COIN);
+    BOOST_CHECK(tip.HaveCoinInCache(out1));
+
+    // Clean entries can be evicted
+    tip.Uncache(out1);
+    BOOST_CHECK(!tip.HaveCoinInCache(out1));
+
+    tip.SpendCoin(out1);
+    tip.AddCoin(out2, MakeCoin(2 * COIN, 2), false);
+    // Nothing written before the flush
+    BOOST_CHECK(db.ExistsKHUUTXO(out1));
+    BOOST_CHECK(!db.ExistsKHUUTXO(out2));
+
+    BOOST_CHECK(tip.Flush());
+    BOOST_CHECK_EQUAL(tip.GetCacheSize(), 0U);
+    BOOST_CHECK(!db.ExistsKHUUTXO(out1));
+    BOOST_CHECK(db.ReadKHUUTXO(out2, coin));
+    BOOST_CHECK_EQUAL(coin.amount, 2 * COIN);
+}
+
+BOOST_AUTO_TEST_CASE(khu_coins_view_scope_discard)
+{
+    InitKHUCoinsTip(nullptr);
+    CCoinsView coinsDummy;
+    CCoinsViewCache dummyView(&coinsDummy);
+    const COutPoint out1(InsecureRand256(), 0);
+    const COutPoint out2(InsecureRand256(), 0);
+    BOOST_CHECK(AddKHUCoin(dummyView, out1, MakeCoin(COIN, 1)));
+
+    {
+        // Failed block: the scope is dropped without Flush()
+        CKHUCoinsViewScope scope;
+        BOOST_CHECK(SpendKHUCoin(dummyView, out1));
+        BOOST_CHECK(AddKHUCoin(dummyView, out2, MakeCoin(COIN, 2)));
+        BOOST_CHECK(!HaveKHUCoin(dummyView, out1));
+    }
+    BOOST_CHECK(HaveKHUCoin(dummyView, out1));
+    BOOST_CHECK(!HaveKHUCoin(dummyView, out2));
+
+    {
+        // Nested scopes: the inner one flushes into the outer one only
+        CKHUCoinsViewScope outer;
+        {
+            CKHUCoinsViewScope inner;
+            BOOST_CHECK(SpendKHUCoin(dummyView, out1));
+            BOOST_CHECK(inner.Flush());
+        }
+        BOOST_CHECK(!HaveKHUCoin(dummyView, out1));
+        BOOST_CHECK(outer.Flush());
+    }
+    BOOST_CHECK(!HaveKHUCoin(dummyView, out1));
+    // Spending twice fails
+    BOOST_CHECK(!SpendKHUCoin(dummyView, out1));
+    BOOST_CHECK(RestoreKHUCoin(out1, MakeCoin(COIN, 1)));
+    BOOST_CHECK(HaveKHUCoin(dummyView, out1));
+    BOOST_CHECK(GetKHUCoinsTipMemoryUsage() > 0);
+}
+
+BOOST_AUTO_TEST_CASE(khu_coins_scope_hidden_from_other_threads)
+{
+    InitKHUCoinsTip(nullptr);
+    CCoinsView coinsDummy;
+    CCoinsViewCache dummyView(&coinsDummy);
+    const COutPoint out1(InsecureRand256(), 0);
+    const COutPoint out2(InsecureRand256(), 0);
+    BOOST_CHECK(AddKHUCoin(dummyView, out1, MakeCoin(COIN, 1)));
+
+    CKHUCoinsViewScope scope;
+    BOOST_CHECK(SpendKHUCoin(dummyView, out1));
+    BOOST_CHECK(AddKHUCoin(dummyView, out2, MakeCoin(COIN, 2)));
+    // Another thread (e.g. RPC) only sees the tip while the block is connected
+    std::thread([&] {
+        CKHUUTXO coin;
+        BOOST_CHECK(GetKHUCoinFromTracking(out1, coin));
+        BOOST_CHECK(!HaveKHUCoin(dummyView, out2));
+    }).join();
+    BOOST_CHECK(scope.Flush());
+    std::thread([&] {
+        BOOST_CHECK(!HaveKHUCoin(dummyView, out1));
+        BOOST_CHECK(HaveKHUCoin(dummyView, out2));
+    }).join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
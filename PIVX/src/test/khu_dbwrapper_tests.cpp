@@ -0,0 +1,169 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//
+// Unit tests for the block-atomic KHU database layer (CKHUDBWrapper)
+//
+// KHU writes of a block stay in memory until the block transaction is
+// committed, and reach LevelDB in one batch when the root transaction is
+// flushed with the chainstate.
+//
+
+#include "test/test_pivx.h"
+
+#include "khu/khu_dbwrapper.h"
+#include "khu/khu_state.h"
+#include "khu/khu_statedb.h"
+#include "random.h"
+
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(khu_dbwrapper_tests, BasicTestingSetup)
+
+static KhuGlobalState MakeState(int nHeight)
+{
+    KhuGlobalState state;
+    state.SetNull();
+    state.nHeight = nHeight;
+    state.C = state.U = nHeight * COIN;
+    return state;
+}
+
+BOOST_AUTO_TEST_CASE(khu_db_block_transaction_rollback)
+{
+    CKHUStateDB db(1 << 20, true);
+    KhuGlobalState state;
+
+    {
+        CKHUDBScopedCommitter tx({&db});
+        BOOST_CHECK(db.WriteKHUState(10, MakeState(10)));
+        // Pending writes are visible to the block being processed
+        BOOST_CHECK(db.ReadKHUState(10, state));
+        BOOST_CHECK_EQUAL(state.C, 10 * COIN);
+        // Failed block: the committer goes out of scope without Commit()
+    }
+    BOOST_CHECK(!db.ExistsKHUState(10));
+    BOOST_CHECK_EQUAL(db.GetMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(khu_db_root_transaction_flush)
+{
+    CKHUStateDB db(1 << 20, true);
+    const CDBWrapper& rawDB = db;
+    const auto key10 = std::make_pair('K', std::make_pair('S', 10));
+    KhuGlobalState state;
+
+    for (int nHeight = 10; nHeight <= 12; nHeight++) {
+        CKHUDBScopedCommitter tx({&db});
+        BOOST_CHECK(db.WriteKHUState(nHeight, MakeState(nHeight)));
+        tx.Commit();
+    }
+
+    // Committed blocks are readable, but nothing reached LevelDB yet
+    BOOST_CHECK(db.ReadKHUState(11, state));
+    BOOST_CHECK(!rawDB.Read(key10, state));
+    BOOST_CHECK(db.GetMemoryUsage() > 0);
+
+    // Disconnect of the tip within the same flush window
+    {
+        CKHUDBScopedCommitter tx({&db});
+        BOOST_CHECK(db.EraseKHUState(12));
+        tx.Commit();
+    }
+
+    BOOST_CHECK(db.CommitRootTransaction());
+    BOOST_CHECK_EQUAL(db.GetMemoryUsage(), 0U);
+    BOOST_CHECK(rawDB.Read(key10, state));
+    BOOST_CHECK_EQUAL(state.nHeight, 10U);
+    BOOST_CHECK(db.ExistsKHUState(11));
+    BOOST_CHECK(!db.ExistsKHUState(12));
+}
+
+BOOST_AUTO_TEST_CASE(khu_db_non_block_writes_survive_rollback)
+{
+    CKHUStateDB db(1 << 20, true);
+    KhuGlobalState state;
+
+    {
+        CKHUDBScopedCommitter tx({&db});
+        BOOST_CHECK(db.WriteKHUState(10, MakeState(10)));
+        // Another thread (e.g. RPC) writes while the block is processed
+        std::thread([&db] { BOOST_CHECK(db.WriteKHUState(20, MakeState(20), true)); }).join();
+        // Failed block
+    }
+    BOOST_CHECK(!db.ExistsKHUState(10));
+    BOOST_CHECK(db.ReadKHUState(20, state));
+    BOOST_CHECK_EQUAL(state.C, 20 * COIN);
+
+    // Written outside any block transaction (startup)
+    BOOST_CHECK(db.WriteKHUState(30, MakeState(30), true));
+    {
+        CKHUDBScopedCommitter tx({&db});
+        tx.Rollback();
+    }
+    BOOST_CHECK(db.ExistsKHUState(30));
+    BOOST_CHECK(db.CommitRootTransaction());
+    BOOST_CHECK(db.ExistsKHUState(20));
+    BOOST_CHECK(db.ExistsKHUState(30));
+}
+
+BOOST_AUTO_TEST_CASE(khu_db_pending_writes_hidden_from_other_threads)
+{
+    CKHUStateDB db(1 << 20, true);
+    BOOST_CHECK(db.WriteKHUState(10, MakeState(10), true));
+
+    CKHUDBScopedCommitter tx({&db});
+    BOOST_CHECK(db.HasBlockTransaction());
+    BOOST_CHECK(db.WriteKHUState(11, MakeState(11)));
+    BOOST_CHECK(db.EraseKHUState(10));
+    BOOST_CHECK(db.ExistsKHUState(11));
+    BOOST_CHECK(!db.ExistsKHUState(10));
+
+    // e.g. RPC: only connected blocks are visible
+    std::thread([&db] {
+        BOOST_CHECK(!db.HasBlockTransaction());
+        BOOST_CHECK(db.ExistsKHUState(10));
+        BOOST_CHECK(!db.ExistsKHUState(11));
+    }).join();
+
+    tx.Commit();
+    BOOST_CHECK(!db.HasBlockTransaction());
+    std::thread([&db] {
+        BOOST_CHECK(!db.ExistsKHUState(10));
+        BOOST_CHECK(db.ExistsKHUState(11));
+    }).join();
+}
+
+BOOST_AUTO_TEST_CASE(khu_db_iterator_merges_pending_writes)
+{
+    CKHUStateDB db(1 << 20, true);
+    std::vector<COutPoint> vOutpoints;
+    for (int i = 0; i < 6; i++) {
+        vOutpoints.emplace_back(InsecureRand256(), i);
+    }
+
+    // Three UTXOs on disk
+    for (int i = 0; i < 3; i++) {
+        BOOST_CHECK(db.WriteKHUUTXO(vOutpoints[i], CKHUUTXO(COIN, CScript(), 1)));
+    }
+    BOOST_CHECK(db.CommitRootTransaction());
+
+    // Pending block: one spent, three created
+    CKHUDBScopedCommitter tx({&db});
+    BOOST_CHECK(db.EraseKHUUTXO(vOutpoints[1]));
+    for (int i = 3; i < 6; i++) {
+        BOOST_CHECK(db.WriteKHUUTXO(vOutpoints[i], CKHUUTXO(2 * COIN, CScript(), 2)));
+    }
+
+    std::vector<std::pair<COutPoint, CKHUUTXO>> utxos;
+    BOOST_CHECK(db.LoadAllKHUUTXOs(utxos));
+    BOOST_CHECK_EQUAL(utxos.size(), 5U);
+    for (const auto& it : utxos) {
+        BOOST_CHECK(it.first != vOutpoints[1]);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,7 +4,11 @@
 
 #include "khu/khu_state.h"
 #include "khu/khu_statedb.h"
+#include "khu/khu_validation.h"
 #include "amount.h"
+#include "arith_uint256.h"
+#include "chain.h"
+#include "random.h"
 #include "test/test_pivx.h"
 
 #include <boost/test/unit_test.hpp>
@@ -217,7 +221,8 @@ BOOST_AUTO_TEST_CASE(test_db_load_or_genesis)
     CKHUStateDB db(1 << 20, true, true);
 
     // Request state at height 999 (doesn't exist)
-    KhuGlobalState state = db.LoadKHUState_OrGenesis(999);
+    KhuGlobalState state;
+    BOOST_CHECK(db.LoadKHUState_OrGenesis(999, state));
 
     // Should return genesis state with nHeight = 999
     BOOST_CHECK_EQUAL(state.nHeight, 999);
@@ -253,6 +258,158 @@ BOOST_AUTO_TEST_CASE(test_db_erase)
     BOOST_CHECK(!db.ExistsKHUState(123));
 }
 
+// Chain of states where the amounts only move every few blocks, with a DOMC
+// cycle starting at 2000. Up to nLegacyTip, a full record at every height (as
+// written before deltas existed).
+static std::vector<KhuGlobalState> WriteStateChain(CKHUStateDB& db, int nTip, int nLegacyTip = 0)
+{
+    std::vector<KhuGlobalState> vStates(nTip + 1);
+    for (int nHeight = 1; nHeight <= nTip; nHeight++) {
+        KhuGlobalState& state = vStates[nHeight];
+        state = vStates[nHeight - 1];
+        state.nHeight = nHeight;
+        state.hashBlock = ArithToUint256(arith_uint256(nHeight));
+        state.hashPrevState = vStates[nHeight - 1].GetHash();
+        if (nHeight % 7 == 0) {
+            state.C += COIN;
+            state.U += COIN;
+        }
+        if (nHeight % 100 == 0) {
+            state.R_annual = nHeight;
+        }
+        if (nHeight == 2000) {
+            state.domc_cycle_start = nHeight;
+        }
+        BOOST_CHECK(db.WriteKHUState(nHeight, state, nHeight == 2000 || nHeight <= nLegacyTip));
+    }
+    return vStates;
+}
+
+/**
+ * Test 8b: Checkpoints and deltas
+ *
+ * Full records at checkpoints (and on request), deltas in between,
+ * any height readable by replay.
+ */
+BOOST_AUTO_TEST_CASE(test_db_state_deltas)
+{
+    CKHUStateDB db(1 << 20, true, true);
+    const CDBWrapper& rawDB = db;
+    const int nTip = 3 * KHU_STATE_CHECKPOINT_INTERVAL + 10;
+    std::vector<KhuGlobalState> vStates = WriteStateChain(db, nTip);
+
+    BOOST_CHECK(db.CommitRootTransaction());
+    KhuGlobalState full;
+    BOOST_CHECK(rawDB.Read(std::make_pair('K', std::make_pair('S', KHU_STATE_CHECKPOINT_INTERVAL)), full));
+    BOOST_CHECK(rawDB.Read(std::make_pair('K', std::make_pair('S', 2000)), full));
+    BOOST_CHECK(!rawDB.Read(std::make_pair('K', std::make_pair('S', 2001)), full));
+
+    for (int nHeight : {1, 7, KHU_STATE_CHECKPOINT_INTERVAL - 1, KHU_STATE_CHECKPOINT_INTERVAL, 1999, 2000, 2001, nTip - 1, nTip}) {
+        KhuGlobalState loaded;
+        BOOST_CHECK(db.ReadKHUState(nHeight, loaded));
+        BOOST_CHECK(loaded.GetHash() == vStates[nHeight].GetHash());
+    }
+
+    // Disconnect the tip: the previous height is replayed again
+    BOOST_CHECK(db.EraseKHUState(nTip));
+    BOOST_CHECK(!db.ExistsKHUState(nTip));
+    KhuGlobalState loaded;
+    BOOST_CHECK(!db.ReadKHUState(nTip, loaded));
+    BOOST_CHECK(db.ReadKHUState(nTip - 1, loaded));
+    BOOST_CHECK(loaded.GetHash() == vStates[nTip - 1].GetHash());
+}
+
+/**
+ * Test 8c: -khustateprune
+ *
+ * Only the reorg window and the checkpoints stay readable.
+ */
+BOOST_AUTO_TEST_CASE(test_db_state_prune)
+{
+    CKHUStateDB db(1 << 20, true, true);
+    db.SetPruneMode(true);
+    const int nKeepDepth = 200;
+    db.SetPruneKeepDepth(nKeepDepth);
+    const int nTip = 2 * KHU_STATE_CHECKPOINT_INTERVAL + nKeepDepth;
+    std::vector<KhuGlobalState> vStates = WriteStateChain(db, nTip);
+
+    KhuGlobalState loaded;
+    BOOST_CHECK(!db.ReadKHUState(1000, loaded));
+    BOOST_CHECK(!db.ReadKHUState(KHU_STATE_CHECKPOINT_INTERVAL + 1, loaded));
+    // Pruned heights are reported as such, never as a genesis state
+    BOOST_CHECK(db.IsKHUStatePruned(1000));
+    BOOST_CHECK(!db.LoadKHUState_OrGenesis(1000, loaded));
+    BOOST_CHECK(!db.IsKHUStatePruned(KHU_STATE_CHECKPOINT_INTERVAL));
+    BOOST_CHECK(!db.IsKHUStatePruned(nTip + 1));
+    for (int nHeight : {KHU_STATE_CHECKPOINT_INTERVAL, 2000, 2 * KHU_STATE_CHECKPOINT_INTERVAL,
+                        nTip - nKeepDepth + 1, nTip}) {
+        BOOST_CHECK(db.ReadKHUState(nHeight, loaded));
+        BOOST_CHECK(loaded.GetHash() == vStates[nHeight].GetHash());
+    }
+}
+
+/**
+ * Test 8d: -khustateprune below the ChainLock finality horizon
+ *
+ * ChainLocked heights can't be disconnected: their deltas go before the reorg window allows it.
+ */
+BOOST_AUTO_TEST_CASE(test_db_state_prune_finalized)
+{
+    CKHUStateDB db(1 << 20, true, true);
+    db.SetPruneMode(true);
+    const int nTip = 2 * KHU_STATE_CHECKPOINT_INTERVAL + 10;
+    db.SetFinalizedHeight(nTip - 5);
+    std::vector<KhuGlobalState> vStates = WriteStateChain(db, nTip);
+
+    KhuGlobalState loaded;
+    BOOST_CHECK(!db.ReadKHUState(KHU_STATE_CHECKPOINT_INTERVAL + 1, loaded));
+    BOOST_CHECK(!db.ReadKHUState(2 * KHU_STATE_CHECKPOINT_INTERVAL - 1, loaded));
+    for (int nHeight : {KHU_STATE_CHECKPOINT_INTERVAL, 2000, 2 * KHU_STATE_CHECKPOINT_INTERVAL,
+                        2 * KHU_STATE_CHECKPOINT_INTERVAL + 1, nTip}) {
+        BOOST_CHECK(db.ReadKHUState(nHeight, loaded));
+        BOOST_CHECK(loaded.GetHash() == vStates[nHeight].GetHash());
+    }
+}
+
+/**
+ * Test 8e: -khustateprune turned on with several intervals to prune
+ *
+ * Every interval below the new checkpoint is pruned at once, including the
+ * full records an older database wrote at every height.
+ */
+BOOST_AUTO_TEST_CASE(test_db_state_prune_jump)
+{
+    CKHUStateDB db(1 << 20, true, true);
+    const CDBWrapper& rawDB = db;
+    const int nKeepDepth = 200;
+    db.SetPruneKeepDepth(nKeepDepth);
+    const int nTip = 4 * KHU_STATE_CHECKPOINT_INTERVAL + nKeepDepth;
+    std::vector<KhuGlobalState> vStates = WriteStateChain(db, nTip, KHU_STATE_CHECKPOINT_INTERVAL + 100);
+
+    // Reconnect the tip with pruning on: the checkpoint jumps from 0 to 4 intervals
+    db.SetPruneMode(true);
+    BOOST_CHECK(db.EraseKHUState(nTip));
+    BOOST_CHECK(db.WriteKHUState(nTip, vStates[nTip]));
+    BOOST_CHECK(db.CommitRootTransaction());
+
+    const int nCheckpoint = 4 * KHU_STATE_CHECKPOINT_INTERVAL;
+    for (int nHeight = 1; nHeight <= nTip; nHeight++) {
+        const bool fKept = nHeight >= nCheckpoint || nHeight % KHU_STATE_CHECKPOINT_INTERVAL == 0 || nHeight == 2000;
+        BOOST_CHECK_EQUAL(db.ExistsKHUState(nHeight), fKept);
+        BOOST_CHECK_EQUAL(db.IsKHUStatePruned(nHeight), !fKept);
+    }
+    KhuGlobalState full;
+    BOOST_CHECK(!rawDB.Read(std::make_pair('K', std::make_pair('S', 100)), full));
+    BOOST_CHECK(!rawDB.Read(std::make_pair('K', std::make_pair('S', KHU_STATE_CHECKPOINT_INTERVAL + 1)), full));
+
+    KhuGlobalState loaded;
+    for (int nHeight : {KHU_STATE_CHECKPOINT_INTERVAL, 2000, 3 * KHU_STATE_CHECKPOINT_INTERVAL,
+                        nCheckpoint, nCheckpoint + 1, nTip}) {
+        BOOST_CHECK(db.ReadKHUState(nHeight, loaded));
+        BOOST_CHECK(loaded.GetHash() == vStates[nHeight].GetHash());
+    }
+}
+
 /**
  * Test 9: Reorg depth validation (consensus rule)
  *
@@ -285,4 +442,57 @@ BOOST_AUTO_TEST_CASE(test_reorg_depth_constant)
     // Actual reorg rejection is tested in integration tests
 }
 
+/**
+ * Test 10: Tip state snapshot
+ *
+ * Verify that the published tip state is an immutable copy, only handed
+ * out for the block it belongs to.
+ */
+BOOST_AUTO_TEST_CASE(test_tip_state_snapshot)
+{
+    BOOST_REQUIRE(InitKHUStateDB(1 << 20, true, true));
+    BOOST_CHECK(!GetKHUTipState());
+
+    KhuGlobalState state;
+    state.nHeight = 200;
+    state.C = 10 * COIN;
+    state.U = 10 * COIN;
+    state.hashBlock = InsecureRand256();
+    BOOST_REQUIRE(GetKHUStateDB()->WriteKHUState(200, state));
+
+    uint256 hashTip = state.hashBlock;
+    CBlockIndex indexTip;
+    indexTip.nHeight = 200;
+    indexTip.phashBlock = &hashTip;
+    PublishKHUTipState(&indexTip);
+
+    std::shared_ptr<const KhuGlobalState> ptipState = GetKHUTipState();
+    BOOST_REQUIRE(ptipState);
+    BOOST_CHECK(ptipState->GetHash() == state.GetHash());
+    BOOST_CHECK(GetKHUTipState(&indexTip) == ptipState);
+
+    // Later writes only show up with the next publish
+    state.C = 20 * COIN;
+    state.U = 20 * COIN;
+    BOOST_REQUIRE(GetKHUStateDB()->WriteKHUState(200, state));
+    BOOST_CHECK_EQUAL(GetKHUTipState()->C, 10 * COIN);
+    PublishKHUTipState(&indexTip);
+    BOOST_CHECK_EQUAL(GetKHUTipState()->C, 20 * COIN);
+    BOOST_CHECK_EQUAL(ptipState->C, 10 * COIN);
+
+    // Served from the snapshot, chainActive is not looked at
+    KhuGlobalState currentState;
+    BOOST_CHECK(GetCurrentKHUState(currentState));
+    BOOST_CHECK_EQUAL(currentState.C, 20 * COIN);
+
+    // A competing block at the same height does not get the snapshot
+    uint256 hashOther = InsecureRand256();
+    CBlockIndex indexOther;
+    indexOther.nHeight = 200;
+    indexOther.phashBlock = &hashOther;
+    BOOST_CHECK(!GetKHUTipState(&indexOther));
+    PublishKHUTipState(&indexOther);
+    BOOST_CHECK(!GetKHUTipState());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -572,4 +572,45 @@ BOOST_AUTO_TEST_CASE(test_mint_overflow_rejected)
     // This unit test verifies the overflow detection logic that the fix implements.
 }
 
+/**
+ * Test 9: Commitment signature binding
+ *
+ * The quorum signs GetKHUCommitmentSignHash: a signature of one commitment
+ * must not verify for another height, state or quorum.
+ */
+BOOST_AUTO_TEST_CASE(test_commitment_sign_hash)
+{
+    CBLSSecretKey skQuorum;
+    skQuorum.MakeNewKey();
+    const CBLSPublicKey pkQuorum = skQuorum.GetPublicKey();
+    uint256 quorumHash1, quorumHash2;
+    quorumHash1.SetHex("0000000000000000000000000000000000000000000000000000000000000001");
+    quorumHash2.SetHex("0000000000000000000000000000000000000000000000000000000000000002");
+
+    KhuGlobalState state;
+    state.C = state.U = 1000 * COIN;
+    state.nHeight = 1000;
+    KhuStateCommitment commitment = CreateKHUStateCommitment(state, quorumHash1);
+    commitment.sig = skQuorum.Sign(GetKHUCommitmentSignHash(commitment));
+    BOOST_CHECK(commitment.sig.VerifyInsecure(pkQuorum, GetKHUCommitmentSignHash(commitment)));
+
+    KhuStateCommitment other = commitment;
+    other.nHeight = 1001;
+    BOOST_CHECK(!other.sig.VerifyInsecure(pkQuorum, GetKHUCommitmentSignHash(other)));
+
+    other = commitment;
+    state.U += 1;
+    other.hashState = ComputeKHUStateHash(state);
+    BOOST_CHECK(!other.sig.VerifyInsecure(pkQuorum, GetKHUCommitmentSignHash(other)));
+
+    other = commitment;
+    other.quorumHash = quorumHash2;
+    BOOST_CHECK(!other.sig.VerifyInsecure(pkQuorum, GetKHUCommitmentSignHash(other)));
+
+    // No quorum manager in unit tests: the quorum key is unknown, full verification fails
+    state.U -= 1;
+    commitment.signers.assign(10, true);
+    BOOST_CHECK(!VerifyKHUStateCommitment(commitment, state));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
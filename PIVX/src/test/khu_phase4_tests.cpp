@@ -24,6 +24,7 @@
 #include "consensus/upgrades.h"
 #include "consensus/validation.h"
 #include "khu/khu_coins.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_stake.h"
 #include "khu/khu_unstake.h"
 #include "khu/khu_state.h"
@@ -31,6 +32,7 @@
 #include "khu/khu_utxo.h"
 #include "khu/khu_validation.h"
 #include "khu/zkhu_db.h"
+#include "primitives/block.h"
 #include "primitives/transaction.h"
 #include "sapling/sapling_transaction.h"
 #include "script/standard.h"
@@ -147,7 +149,7 @@ static void SetupKHUState(KhuGlobalState& state, int height,
 }
 
 // Helper: Add KHU_T UTXO to coins view AND KHU tracking system
-// NOTE: Must use AddKHUCoin() so GetKHUCoin() can find the coin in mapKHUUTXOs
+// NOTE: Must use AddKHUCoin() so GetKHUCoin() can find the coin in the KHU coins view
 static void AddKHUCoinToView(CCoinsViewCache& view, const COutPoint& outpoint, CAmount amount, uint32_t nHeight = 1)
 {
     CScript scriptPubKey = GetScriptForDestination(CKeyID(uint160()));
@@ -613,4 +615,84 @@ BOOST_AUTO_TEST_CASE(test_invariants_after_unstake)
     BOOST_CHECK_EQUAL(state.Z, 0);  // All ZKHU unstaked
 }
 
+// ============================================================================
+// TEST 8: STAKE/UNSTAKE CONNECTBLOCK PRE-VALIDATION
+// ============================================================================
+// The Sapling structure and value checks run on the KHU check queue workers.
+// Results must match the inline pass, and Apply must reject exactly as before
+// for transactions the pre-validation did not accept.
+// ============================================================================
+
+BOOST_AUTO_TEST_CASE(test_stake_unstake_block_precheck)
+{
+    LOCK(cs_khu);
+
+    KhuGlobalState state;
+    SetupKHUState(state, 1000, 100, 100, 50, 50);
+
+    CCoinsViewCache view(pcoinsTip.get());
+    CScript dest = GetScriptForDestination(CKeyID(uint160()));
+
+    const CAmount amount = 10 * COIN;
+    const COutPoint khuInput(GetRandHash(), 0);
+    AddKHUCoinToView(view, khuInput, amount);
+
+    // Below MIN_STAKE_AMOUNT
+    CMutableTransaction smallStake(*CreateStakeTx(MIN_STAKE_AMOUNT - 1, COutPoint(GetRandHash(), 0)));
+    // No transparent input
+    CMutableTransaction noInputStake(*CreateStakeTx(amount, khuInput));
+    noInputStake.vin.clear();
+    // No shielded spend
+    CMutableTransaction noSpendUnstake(*CreateUnstakeTx(amount, dest, GetRandHash(), 1000, GetRandHash()));
+    noSpendUnstake.sapData->vShieldedSpend.clear();
+
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(CMutableTransaction()));
+    block.vtx.emplace_back(CreateStakeTx(amount, khuInput));
+    block.vtx.emplace_back(MakeTransactionRef(smallStake));
+    block.vtx.emplace_back(MakeTransactionRef(noInputStake));
+    block.vtx.emplace_back(CreateUnstakeTx(amount, dest, GetRandHash(), 1000, GetRandHash()));
+    block.vtx.emplace_back(MakeTransactionRef(noSpendUnstake));
+
+    // More than one KHU tx and script check threads running: queued path
+    BOOST_REQUIRE(nScriptCheckThreads > 1);
+    std::vector<CKHUTxPrecheck> vPrecheck;
+    PrecheckKHUBlock(block, vPrecheck);
+    BOOST_REQUIRE_EQUAL(vPrecheck.size(), block.vtx.size());
+
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        CKHUTxPrecheck inlineCheck;
+        PrecheckKHUTransaction(*block.vtx[i], inlineCheck);
+        BOOST_CHECK_EQUAL(vPrecheck[i].fParsed, inlineCheck.fParsed);
+        BOOST_CHECK_EQUAL(vPrecheck[i].stakeAmount, inlineCheck.stakeAmount);
+        BOOST_CHECK(vPrecheck[i].stakeNullifier == inlineCheck.stakeNullifier);
+        BOOST_CHECK(vPrecheck[i].unstakeNullifier == inlineCheck.unstakeNullifier);
+        BOOST_CHECK(vPrecheck[i].unstake.cm == inlineCheck.unstake.cm);
+    }
+
+    BOOST_CHECK(!vPrecheck[0].fParsed);
+    BOOST_CHECK(vPrecheck[1].fParsed);
+    BOOST_CHECK_EQUAL(vPrecheck[1].stakeAmount, amount);
+    BOOST_CHECK(vPrecheck[1].stakeNullifier == GetZKHUStakeNullifier(block.vtx[1]->sapData->vShieldedOutput[0].cmu));
+    BOOST_CHECK(!vPrecheck[2].fParsed);
+    BOOST_CHECK(!vPrecheck[3].fParsed);
+    BOOST_CHECK(vPrecheck[4].fParsed);
+    BOOST_CHECK(vPrecheck[4].unstakeNullifier == block.vtx[4]->sapData->vShieldedSpend[0].nullifier);
+    BOOST_CHECK(!vPrecheck[5].fParsed);
+
+    // Apply from the pre-validation result
+    const KhuGlobalState stateBefore = state;
+    BOOST_CHECK(ApplyKHUStake(*block.vtx[1], view, state, 1000, &vPrecheck[1]));
+    BOOST_CHECK_EQUAL(state.U, stateBefore.U - amount);
+    ZKHUNoteData noteData;
+    BOOST_CHECK(GetZKHUDB()->ReadNote(block.vtx[1]->sapData->vShieldedOutput[0].cmu, noteData));
+    BOOST_CHECK_EQUAL(noteData.amount, amount);
+    BOOST_CHECK(noteData.nullifier == vPrecheck[1].stakeNullifier);
+
+    // Rejected transactions still fail in the serial step
+    BOOST_CHECK(!ApplyKHUStake(*block.vtx[2], view, state, 1000, &vPrecheck[2]));
+    BOOST_CHECK(!ApplyKHUStake(*block.vtx[3], view, state, 1000, &vPrecheck[3]));
+    BOOST_CHECK(!ApplyKHUUnstake(*block.vtx[5], view, state, 1000, &vPrecheck[5]));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -14,6 +14,8 @@
  * - Median calculation (0 votes, 1 vote, multiple votes, clamping)
  * - Cycle finalization (commit → reveal → median → R_annual update)
  * - Reorg support (undo operations)
+ * - ConnectBlock pre-validation pass (decoded votes)
+ * - Cycle-major vote keys and incremental R histogram
  */
 
 #include "test_pivx.h"
@@ -23,6 +25,7 @@
 #include "khu/khu_domc.h"
 #include "khu/khu_domcdb.h"
 #include "khu/khu_domc_tx.h"
+#include "khu/khu_precheck.h"
 #include "khu/khu_state.h"
 #include "primitives/transaction.h"
 #include "script/script.h"
@@ -895,4 +898,135 @@ BOOST_AUTO_TEST_CASE(domc_reorg_support)
     }
 }
 
+// ============================================================================
+// Test 8: ConnectBlock pre-validation
+// ============================================================================
+
+BOOST_AUTO_TEST_CASE(domc_block_precheck)
+{
+    const COutPoint mn = CreateTestMN(50);
+    const uint16_t R = 2500;
+    const uint256 salt = InsecureRand256();
+
+    DomcCommit commit;
+    commit.mnOutpoint = mn;
+    commit.nCycleId = 7;
+    commit.nCommitHeight = 1234;
+    commit.hashCommit = InsecureRand256();
+
+    DomcReveal reveal;
+    reveal.nRProposal = R;
+    reveal.salt = salt;
+    reveal.mnOutpoint = mn;
+    reveal.nCycleId = 7;
+    reveal.nRevealHeight = 2345;
+
+    // Malformed reveal: no OP_RETURN payload
+    CMutableTransaction badReveal;
+    badReveal.nVersion = CTransaction::TxVersion::SAPLING;
+    badReveal.nType = CTransaction::TxType::KHU_DOMC_REVEAL;
+    badReveal.vout.emplace_back(0, CScript() << OP_TRUE);
+
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(CMutableTransaction()));
+    block.vtx.emplace_back(MakeTransactionRef(CreateCommitTx(commit)));
+    block.vtx.emplace_back(MakeTransactionRef(CreateRevealTx(reveal)));
+    block.vtx.emplace_back(MakeTransactionRef(badReveal));
+
+    std::vector<CKHUTxPrecheck> vPrecheck;
+    PrecheckKHUBlock(block, vPrecheck);
+    BOOST_REQUIRE_EQUAL(vPrecheck.size(), block.vtx.size());
+
+    BOOST_CHECK(!vPrecheck[0].fParsed);
+    BOOST_CHECK(vPrecheck[1].fParsed);
+    BOOST_CHECK(vPrecheck[1].domcCommit.mnOutpoint == mn);
+    BOOST_CHECK(vPrecheck[1].domcCommit.hashCommit == commit.hashCommit);
+    BOOST_CHECK(vPrecheck[2].fParsed);
+    BOOST_CHECK_EQUAL(vPrecheck[2].domcReveal.nRProposal, R);
+    BOOST_CHECK(vPrecheck[2].hashReveal == reveal.GetCommitHash());
+    // Parse failures are left to the serial step, which rejects as before
+    BOOST_CHECK(!vPrecheck[3].fParsed);
+
+    CValidationState state;
+    KhuGlobalState khuState;
+    khuState.SetNull();
+    Consensus::Params consensusParams;
+    BOOST_CHECK(!ValidateDomcRevealTx(*block.vtx[3], state, khuState, 2345, consensusParams, &vPrecheck[3]));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-domc-reveal-format");
+}
+
+// ============================================================================
+// Test 9: Cycle-major vote storage and R histogram
+// ============================================================================
+
+BOOST_AUTO_TEST_CASE(domc_reveal_histogram)
+{
+    BOOST_REQUIRE(InitKHUDomcDB(1 << 20, true));
+    CKHUDomcDB* domcDB = GetKHUDomcDB();
+    BOOST_REQUIRE(domcDB != nullptr);
+
+    const uint32_t CYCLE_ID = 2000000;
+    const uint32_t OTHER_CYCLE_ID = CYCLE_ID + 1;
+    const std::vector<uint16_t> votes = {1200, 3000, 1200, 2600, 1800};
+
+    for (size_t i = 0; i < votes.size(); i++) {
+        DomcReveal reveal;
+        reveal.nRProposal = votes[i];
+        reveal.salt = InsecureRand256();
+        reveal.mnOutpoint = CreateTestMN(400 + i);
+        reveal.nCycleId = CYCLE_ID;
+        BOOST_CHECK(domcDB->WriteReveal(reveal));
+        BOOST_CHECK(domcDB->AddMasternodeToCycleIndex(CYCLE_ID, reveal.mnOutpoint));
+        // Indexing twice is a no-op
+        BOOST_CHECK(domcDB->AddMasternodeToCycleIndex(CYCLE_ID, reveal.mnOutpoint));
+    }
+    // Neighbouring cycle must not leak into the range scans
+    DomcReveal other;
+    other.nRProposal = 100;
+    other.mnOutpoint = CreateTestMN(400);
+    other.nCycleId = OTHER_CYCLE_ID;
+    BOOST_CHECK(domcDB->WriteReveal(other));
+    BOOST_CHECK(domcDB->AddMasternodeToCycleIndex(OTHER_CYCLE_ID, other.mnOutpoint));
+
+    std::vector<COutPoint> mns;
+    BOOST_CHECK(domcDB->GetMasternodesForCycle(CYCLE_ID, mns));
+    BOOST_CHECK_EQUAL(mns.size(), votes.size());
+    std::vector<DomcReveal> reveals;
+    BOOST_CHECK(domcDB->GetRevealsForCycle(CYCLE_ID, reveals));
+    BOOST_CHECK_EQUAL(reveals.size(), votes.size());
+
+    // Sorted: [1200, 1200, 1800, 2600, 3000] → proposals[2] = 1800
+    CDomcRHistogram histogram;
+    BOOST_CHECK(domcDB->GetRHistogram(CYCLE_ID, histogram));
+    BOOST_CHECK_EQUAL(histogram.nTotal, votes.size());
+    BOOST_CHECK_EQUAL(histogram.mapBuckets.size(), 4U);
+    BOOST_CHECK_EQUAL(histogram.GetMedian(), 1800);
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(CYCLE_ID, 1500, R_MAX), 1800);
+
+    // Replacing a reveal moves its vote to the new bucket
+    DomcReveal replaced;
+    BOOST_CHECK(domcDB->ReadReveal(CreateTestMN(404), CYCLE_ID, replaced));
+    replaced.nRProposal = 2900;
+    BOOST_CHECK(domcDB->WriteReveal(replaced));
+    // Sorted: [1200, 1200, 2600, 2900, 3000]
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(CYCLE_ID, 1500, R_MAX), 2600);
+
+    // Undoing a reveal removes its vote
+    BOOST_CHECK(domcDB->EraseReveal(CreateTestMN(401), CYCLE_ID));
+    // Sorted: [1200, 1200, 2600, 2900]
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(CYCLE_ID, 1500, R_MAX), 2600);
+    BOOST_CHECK(domcDB->EraseReveal(CreateTestMN(402), CYCLE_ID));
+    BOOST_CHECK(domcDB->EraseReveal(CreateTestMN(403), CYCLE_ID));
+    // Sorted: [1200, 2900]
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(CYCLE_ID, 1500, R_MAX), 2900);
+
+    // Cycle cleanup leaves the other cycle alone
+    BOOST_CHECK(domcDB->EraseCycleData(CYCLE_ID));
+    BOOST_CHECK(!domcDB->GetRHistogram(CYCLE_ID, histogram));
+    BOOST_CHECK(!domcDB->GetRevealsForCycle(CYCLE_ID, reveals));
+    BOOST_CHECK(!domcDB->GetMasternodesForCycle(CYCLE_ID, mns));
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(CYCLE_ID, 1500, R_MAX), 1500);
+    BOOST_CHECK_EQUAL(CalculateDomcMedian(OTHER_CYCLE_ID, 1500, R_MAX), 100);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
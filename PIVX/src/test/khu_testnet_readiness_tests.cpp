@@ -379,7 +379,7 @@ BOOST_AUTO_TEST_CASE(reorg_mint_redeem_undo_sequence)
     BOOST_CHECK(state.CheckInvariants());
 
     // Note: UndoKHUMint would fail here because UndoKHURedeem doesn't
-    // restore the UTXO to mapKHUUTXOs (Phase 2 limitation).
+    // restore the UTXO to the KHU coins view (Phase 2 limitation).
     // In production, undo data properly tracks spent UTXOs.
 }
 
@@ -0,0 +1,137 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//
+// Unit tests for the optional KHU transaction index (-khutxindex)
+//
+// Tests verify which transactions of a block get indexed, that the covered
+// range follows connects/disconnects and restarts after a gap.
+//
+
+#include "test/test_pivx.h"
+
+#include "coins.h"
+#include "khu/khu_coins.h"
+#include "khu/khu_txindex.h"
+#include "khu/khu_utxo.h"
+#include "khu/khu_validation.h"
+#include "primitives/block.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+
+static const int V6_HEIGHT = 1000;
+
+struct KHUTxIndexSetup : public BasicTestingSetup
+{
+    KHUTxIndexSetup() : BasicTestingSetup()
+    {
+        if (!InitKHUStateDB(1 << 20, true, true) || !InitKHUTxIndexDB(1 << 20, true, true, true)) {
+            throw std::runtime_error("Failed to initialize KHU DBs for tx index tests");
+        }
+    }
+
+    ~KHUTxIndexSetup()
+    {
+        InitKHUTxIndexDB(0, false, false);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(khu_txindex_tests, KHUTxIndexSetup)
+
+static CTransactionRef MakeTx(int16_t nType, const COutPoint& prevout)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = nType;
+    mtx.vin.emplace_back(prevout);
+    mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    return MakeTransactionRef(mtx);
+}
+
+static CBlock MakeBlock(const std::vector<CTransactionRef>& vtx)
+{
+    CBlock block;
+    CMutableTransaction coinbase;
+    coinbase.vin.emplace_back();
+    coinbase.vout.emplace_back(0, CScript() << OP_TRUE);
+    block.vtx.emplace_back(MakeTransactionRef(coinbase));
+    block.vtx.insert(block.vtx.end(), vtx.begin(), vtx.end());
+    block.nNonce = InsecureRand32();
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(index_relevant_txs)
+{
+    CKHUTxIndexDB* txindex = GetKHUTxIndexDB();
+    BOOST_REQUIRE(txindex);
+    CCoinsView coinsDummy;
+    CCoinsViewCache view(&coinsDummy);
+
+    const COutPoint khuOutpoint(InsecureRand256(), 1);
+    CKHUUTXO utxo(COIN, CScript() << OP_TRUE, V6_HEIGHT);
+    utxo.fIsKHU = true;
+    BOOST_REQUIRE(AddKHUCoin(view, khuOutpoint, utxo));
+
+    const CTransactionRef mint = MakeTx(CTransaction::TxType::KHU_MINT, COutPoint(InsecureRand256(), 0));
+    const CTransactionRef khuSend = MakeTx(CTransaction::TxType::NORMAL, khuOutpoint);
+    const CTransactionRef unrelated = MakeTx(CTransaction::TxType::NORMAL, COutPoint(InsecureRand256(), 0));
+    const CBlock block = MakeBlock({mint, unrelated, khuSend});
+
+    BOOST_CHECK(txindex->WriteBlock(block, V6_HEIGHT, view));
+    BOOST_CHECK(txindex->WriteBlock(MakeBlock({unrelated}), V6_HEIGHT + 1, view));
+
+    std::map<int, CKHUTxIndexEntry> mapBlocks;
+    txindex->GetBlocks(V6_HEIGHT - 10, V6_HEIGHT + 10, mapBlocks);
+    BOOST_REQUIRE_EQUAL(mapBlocks.size(), 1);
+    const CKHUTxIndexEntry& entry = mapBlocks.at(V6_HEIGHT);
+    BOOST_CHECK(entry.hashBlock == block.GetHash());
+    BOOST_REQUIRE_EQUAL(entry.vTxids.size(), 2);
+    BOOST_CHECK(entry.vTxids[0] == mint->GetHash());
+    BOOST_CHECK(entry.vTxids[1] == khuSend->GetHash());
+
+    // Pre-V6 heights never hold KHU transactions
+    BOOST_CHECK(txindex->IsCovered(V6_HEIGHT - 1, V6_HEIGHT));
+    BOOST_CHECK(txindex->IsCovered(V6_HEIGHT, V6_HEIGHT));
+    BOOST_CHECK(txindex->IsCovered(V6_HEIGHT + 1, V6_HEIGHT));
+    BOOST_CHECK(!txindex->IsCovered(V6_HEIGHT + 2, V6_HEIGHT));
+}
+
+BOOST_AUTO_TEST_CASE(index_range)
+{
+    CKHUTxIndexDB* txindex = GetKHUTxIndexDB();
+    BOOST_REQUIRE(txindex);
+    CCoinsView coinsDummy;
+    CCoinsViewCache view(&coinsDummy);
+    const CTransactionRef mint = MakeTx(CTransaction::TxType::KHU_MINT, COutPoint(InsecureRand256(), 0));
+
+    // Indexing starts after activation: earlier V6 blocks are not covered
+    const int nFirst = V6_HEIGHT + 100;
+    for (int h = nFirst; h < nFirst + 10; h++) {
+        BOOST_CHECK(txindex->WriteBlock(MakeBlock({mint}), h, view));
+    }
+    BOOST_CHECK(!txindex->IsCovered(nFirst - 1, V6_HEIGHT));
+    BOOST_CHECK(txindex->IsCovered(nFirst, V6_HEIGHT));
+    BOOST_CHECK(txindex->IsCovered(nFirst + 9, V6_HEIGHT));
+
+    // Reorg of the tip
+    BOOST_CHECK(txindex->EraseBlock(nFirst + 9));
+    BOOST_CHECK(!txindex->IsCovered(nFirst + 9, V6_HEIGHT));
+    std::map<int, CKHUTxIndexEntry> mapBlocks;
+    txindex->GetBlocks(nFirst, nFirst + 20, mapBlocks);
+    BOOST_CHECK_EQUAL(mapBlocks.size(), 9);
+    BOOST_CHECK(txindex->WriteBlock(MakeBlock({}), nFirst + 9, view));
+    BOOST_CHECK(txindex->IsCovered(nFirst, V6_HEIGHT));
+    mapBlocks.clear();
+    txindex->GetBlocks(nFirst, nFirst + 20, mapBlocks);
+    BOOST_CHECK_EQUAL(mapBlocks.size(), 9);
+
+    // Blocks connected without -khutxindex: the range restarts after the gap
+    BOOST_CHECK(txindex->WriteBlock(MakeBlock({mint}), nFirst + 20, view));
+    BOOST_CHECK(!txindex->IsCovered(nFirst + 5, V6_HEIGHT));
+    BOOST_CHECK(!txindex->IsCovered(nFirst + 15, V6_HEIGHT));
+    BOOST_CHECK(txindex->IsCovered(nFirst + 20, V6_HEIGHT));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,237 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+//
+// Unit tests for KHU Phase 6.1: lazy (aggregate) yield accumulator
+//
+// Tests verify that the O(1) yield index stays bit-exact with crediting
+// (amount × R_annual / 10000) / 365 to every mature unspent note at each
+// yield event, across R_annual epochs, UNSTAKE and reorg (undo).
+//
+
+#include "test/test_pivx.h"
+
+#include "chainparams.h"
+#include "consensus/params.h"
+#include "khu/khu_state.h"
+#include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
+#include "khu/zkhu_db.h"
+#include "khu/zkhu_note.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+
+static const uint32_t V6_HEIGHT = 1000;
+
+struct KHUYieldIndexSetup : public BasicTestingSetup
+{
+    KHUYieldIndexSetup() : BasicTestingSetup()
+    {
+        UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V6_0, V6_HEIGHT);
+        if (!InitZKHUDB(1 << 20, true)) {
+            throw std::runtime_error("Failed to initialize ZKHU DB for yield index tests");
+        }
+    }
+
+    ~KHUYieldIndexSetup()
+    {
+        UpdateNetworkUpgradeParameters(Consensus::UPGRADE_V6_0, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
+    }
+};
+
+struct ReferenceNote
+{
+    ZKHUNoteData data;
+    CAmount credited{0};   // Yield credited event by event (reference engine)
+};
+
+BOOST_FIXTURE_TEST_SUITE(khu_yield_index_tests, KHUYieldIndexSetup)
+
+static void StakeNote(std::map<uint256, ReferenceNote>& notes, CAmount amount, uint32_t nHeight)
+{
+    const uint256 cm = InsecureRand256();
+    ReferenceNote& ref = notes[cm];
+    ref.data = ZKHUNoteData(amount, nHeight, 0, InsecureRand256(), cm);
+    BOOST_REQUIRE(GetZKHUDB()->WriteNote(cm, ref.data));
+    BOOST_REQUIRE(khu_yield::AddNoteToYieldIndex(cm, ref.data));
+}
+
+static void UnstakeNote(std::map<uint256, ReferenceNote>& notes, const uint256& cm, uint32_t nHeight)
+{
+    ReferenceNote& ref = notes.at(cm);
+    CAmount nYield = 0;
+    BOOST_REQUIRE(khu_yield::GetNoteAccumulatedYield(cm, ref.data, nHeight, nYield));
+    BOOST_CHECK_EQUAL(nYield, ref.credited);
+
+    // Same sequence as ApplyKHUUnstake
+    BOOST_REQUIRE(khu_yield::DeactivateNoteYield(cm, ref.data));
+    ref.data.Ur_accumulated = nYield;
+    ref.data.bSpent = true;
+    BOOST_REQUIRE(GetZKHUDB()->SpendNote(cm, ref.data, nHeight));
+}
+
+// Reference engine: per-note scan and floor division at every event
+static CAmount CreditEvent(std::map<uint256, ReferenceNote>& notes, uint32_t nHeight, uint32_t R_annual)
+{
+    CAmount total = 0;
+    for (auto& it : notes) {
+        ReferenceNote& ref = it.second;
+        if (ref.data.bSpent || !khu_yield::IsNoteMature(ref.data.nStakeStartHeight, nHeight)) continue;
+        const CAmount daily = khu_yield::CalculateDailyYieldForNote(ref.data.amount, R_annual);
+        ref.credited += daily;
+        total += daily;
+    }
+    return total;
+}
+
+static void CheckAllNotes(const std::map<uint256, ReferenceNote>& notes, uint32_t nHeight)
+{
+    for (const auto& it : notes) {
+        CAmount nYield = 0;
+        BOOST_CHECK(khu_yield::GetNoteAccumulatedYield(it.first, it.second.data, nHeight, nYield));
+        BOOST_CHECK_EQUAL(nYield, it.second.credited);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(yield_index_bit_exact_with_per_note_scan)
+{
+    const uint32_t interval = khu_yield::YIELD_INTERVAL;
+    std::map<uint256, ReferenceNote> notes;
+    KhuGlobalState state;
+    state.SetNull();
+
+    // Notes staked before activation are picked up by the first event
+    StakeNote(notes, 100 * COIN + 7, V6_HEIGHT - 10);
+    StakeNote(notes, 3 * COIN + 1, V6_HEIGHT - 1);
+
+    const int nEvents = 16;
+    for (int i = 0; i < nEvents; i++) {
+        const uint32_t nHeight = V6_HEIGHT + i * interval;
+        state.R_annual = (i < 6) ? 4000 : (i < 11 ? 3333 : 1234);
+
+        // Yield first, then block transactions (ProcessKHUBlock order)
+        BOOST_REQUIRE(khu_yield::ApplyDailyYield(state, nHeight, V6_HEIGHT));
+        BOOST_CHECK_EQUAL(state.last_yield_amount, CreditEvent(notes, nHeight, state.R_annual));
+        BOOST_CHECK(state.CheckInvariants());
+
+        // Odd amounts make the per-note floor division differ from the aggregate one
+        for (int j = 0; j < 5; j++) {
+            StakeNote(notes, (1 + InsecureRandRange(5000)) * COIN + InsecureRandRange(COIN), nHeight + j * 97);
+        }
+
+        // Unstake one mature note, sometimes in the block of the yield event
+        for (const auto& it : notes) {
+            if (!it.second.data.bSpent && khu_yield::IsNoteMature(it.second.data.nStakeStartHeight, nHeight)) {
+                UnstakeNote(notes, it.first, (i % 2) ? nHeight : nHeight + 500);
+                break;
+            }
+        }
+        CheckAllNotes(notes, nHeight + interval - 1);
+    }
+
+    // Reorg the last events (crossing back into the previous R_annual epoch)
+    std::vector<std::pair<uint32_t, CAmount>> vUndone;
+    for (int i = nEvents; i < nEvents + 7; i++) {
+        const uint32_t nHeight = V6_HEIGHT + i * interval;
+        state.R_annual = (i < nEvents + 3) ? 1234 : 2500;
+        BOOST_REQUIRE(khu_yield::ApplyDailyYield(state, nHeight, V6_HEIGHT));
+        vUndone.emplace_back(nHeight, state.last_yield_amount);
+    }
+    for (auto it = vUndone.rbegin(); it != vUndone.rend(); ++it) {
+        state.last_yield_amount = it->second;
+        BOOST_REQUIRE(khu_yield::UndoDailyYield(state, it->first, V6_HEIGHT));
+    }
+    BOOST_CHECK_EQUAL(state.last_yield_update_height, V6_HEIGHT + (nEvents - 1) * interval);
+    CheckAllNotes(notes, V6_HEIGHT + (nEvents + 10) * interval);
+
+    // Reconnect with a different rate history: same result as the reference engine
+    for (int i = nEvents; i < nEvents + 4; i++) {
+        const uint32_t nHeight = V6_HEIGHT + i * interval;
+        state.R_annual = 5000;
+        BOOST_REQUIRE(khu_yield::ApplyDailyYield(state, nHeight, V6_HEIGHT));
+        BOOST_CHECK_EQUAL(state.last_yield_amount, CreditEvent(notes, nHeight, state.R_annual));
+    }
+    CheckAllNotes(notes, V6_HEIGHT + (nEvents + 4) * interval);
+}
+
+BOOST_AUTO_TEST_CASE(yield_index_stake_undo)
+{
+    std::map<uint256, ReferenceNote> notes;
+    KhuGlobalState state;
+    state.SetNull();
+    state.R_annual = 4000;
+
+    BOOST_REQUIRE(khu_yield::ApplyDailyYield(state, V6_HEIGHT, V6_HEIGHT));
+    StakeNote(notes, 1000 * COIN, V6_HEIGHT + 1);
+    const uint256 cm = notes.begin()->first;
+
+    // Undo STAKE before maturity: the note no longer contributes to its bucket
+    BOOST_REQUIRE(khu_yield::RemoveNoteFromYieldIndex(cm, notes.at(cm).data));
+    BOOST_REQUIRE(GetZKHUDB()->EraseNote(cm));
+    notes.clear();
+
+    for (uint32_t nHeight = V6_HEIGHT + khu_yield::YIELD_INTERVAL;
+         nHeight <= V6_HEIGHT + 6 * khu_yield::YIELD_INTERVAL; nHeight += khu_yield::YIELD_INTERVAL) {
+        BOOST_REQUIRE(khu_yield::ApplyDailyYield(state, nHeight, V6_HEIGHT));
+        BOOST_CHECK_EQUAL(state.last_yield_amount, 0);
+    }
+}
+
+static bool IsActive(const uint256& cm)
+{
+    bool fFound = false;
+    BOOST_CHECK(GetZKHUDB()->IterateActiveNotes([&](const uint256& noteId, uint32_t, CAmount) {
+        fFound |= (noteId == cm);
+        return true;
+    }));
+    return fFound;
+}
+
+BOOST_AUTO_TEST_CASE(active_index_spend_and_prune)
+{
+    CZKHUTreeDB* zkhuDB = GetZKHUDB();
+    const uint256 cm = InsecureRand256();
+    const uint256 nullifier = InsecureRand256();
+    ZKHUNoteData data(42 * COIN, 5000, 0, nullifier, cm);
+    BOOST_REQUIRE(zkhuDB->WriteNote(cm, data));
+    BOOST_REQUIRE(zkhuDB->WriteNullifierMapping(nullifier, cm));
+    BOOST_CHECK(IsActive(cm));
+
+    // Active index is ordered by stake height
+    uint32_t nLastHeight = 0;
+    BOOST_CHECK(zkhuDB->IterateActiveNotes([&](const uint256&, uint32_t nStakeStartHeight, CAmount) {
+        BOOST_CHECK(nStakeStartHeight >= nLastHeight);
+        nLastHeight = nStakeStartHeight;
+        return true;
+    }));
+
+    // Spent: leaves the active index, still readable for undo
+    // Above any spend height of the other cases (shared DB)
+    const int nSpendHeight = 1000000;
+    BOOST_CHECK(zkhuDB->PruneSpentNotes(nSpendHeight - 1) >= 0);
+    BOOST_REQUIRE(zkhuDB->SpendNote(cm, data, nSpendHeight));
+    BOOST_CHECK(!IsActive(cm));
+    ZKHUNoteData read;
+    BOOST_CHECK(zkhuDB->ReadNote(cm, read));
+    BOOST_CHECK(read.bSpent);
+
+    // Undo within the reorg window
+    BOOST_REQUIRE(zkhuDB->UnspendNote(cm, read, nSpendHeight));
+    BOOST_CHECK(IsActive(cm));
+    BOOST_CHECK(zkhuDB->ReadNote(cm, read));
+    BOOST_CHECK(!read.bSpent);
+    BOOST_CHECK_EQUAL(zkhuDB->PruneSpentNotes(nSpendHeight), 0);
+
+    // Prune only once the spend height is past the window
+    BOOST_REQUIRE(zkhuDB->SpendNote(cm, read, nSpendHeight));
+    BOOST_CHECK_EQUAL(zkhuDB->PruneSpentNotes(nSpendHeight - 1), 0);
+    BOOST_CHECK(zkhuDB->ReadNote(cm, read));
+    BOOST_CHECK_EQUAL(zkhuDB->PruneSpentNotes(nSpendHeight), 1);
+    BOOST_CHECK(!zkhuDB->ReadNote(cm, read));
+    uint256 cmLookup;
+    BOOST_CHECK(!zkhuDB->ReadNullifierMapping(nullifier, cmLookup));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -174,6 +174,47 @@ BOOST_AUTO_TEST_CASE(FindMySaplingNotes)
     BOOST_CHECK_EQUAL(2, noteMap.size());
 }
 
+BOOST_AUTO_TEST_CASE(FindMySaplingNotesBatchDecrypted)
+{
+    auto consensusParams = Params().GetConsensus();
+
+    CWallet& wallet = m_wallet;
+    LOCK(wallet.cs_wallet);
+    wallet.SetupSPKM(false);
+    auto sspkm = wallet.GetSaplingScriptPubKeyMan();
+
+    auto sk = GetTestMasterSaplingSpendingKey();
+    auto expsk = sk.expsk;
+    auto extfvk = sk.ToXFVK();
+    auto pa = sk.DefaultAddress();
+
+    auto testNote = GetTestSaplingNote(pa, 50000000);
+    auto builder = TransactionBuilder(consensusParams);
+    builder.AddSaplingSpend(expsk, testNote.note, testNote.tree.root(), testNote.tree.witness());
+    builder.AddSaplingOutput(extfvk.fvk.ovk, pa, 25000000, {});
+    builder.SetFee(10000000);
+    auto tx = MakeTransactionRef(builder.Build().GetTxOrThrow());
+
+    CBlock block;
+    block.vtx.emplace_back(tx);
+
+    // Batch decrypted without the key: stale once the key is added
+    sspkm->BatchDecryptBlock(block);
+    BOOST_CHECK_EQUAL(0, sspkm->FindMySaplingNotes(*tx).first.size());
+    BOOST_CHECK(wallet.AddSaplingZKey(sk));
+    BOOST_CHECK_EQUAL(2, sspkm->FindMySaplingNotes(*tx).first.size());
+
+    // Batch decrypted with the key: same notes as the per-tx path
+    sspkm->BatchDecryptBlock(block);
+    auto noteMap = sspkm->FindMySaplingNotes(*tx).first;
+    BOOST_CHECK_EQUAL(2, noteMap.size());
+    for (const auto& it : noteMap) {
+        BOOST_CHECK(it.second.address && *it.second.address == pa);
+    }
+    sspkm->ClearBatchDecryptions();
+    BOOST_CHECK_EQUAL(2, sspkm->FindMySaplingNotes(*tx).first.size());
+}
+
 // Generate note A and spend to create note B, from which we spend to create two conflicting transactions
 BOOST_AUTO_TEST_CASE(GetConflictedSaplingNotes)
 {
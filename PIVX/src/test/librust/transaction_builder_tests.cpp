@@ -101,6 +101,48 @@ BOOST_AUTO_TEST_CASE(SaplingToSapling)
     BOOST_CHECK_EQUAL(state.GetRejectReason(), "");
 }
 
+BOOST_AUTO_TEST_CASE(SaplingDeferredProofCheck)
+{
+    auto consensusParams = Params().GetConsensus();
+
+    auto sk = libzcash::SaplingSpendingKey::random();
+    auto expsk = sk.expanded_spending_key();
+    auto fvk = sk.full_viewing_key();
+    auto pa = sk.default_address();
+
+    auto testNote = GetTestSaplingNote(pa, 40000000);
+    auto builder = TransactionBuilder(consensusParams);
+    builder.AddSaplingSpend(expsk, testNote.note, testNote.tree.root(), testNote.tree.witness());
+    builder.SetFee(10000000);
+    builder.AddSaplingOutput(fvk.ovk, pa, 29900000, {});
+    auto tx = builder.Build().GetTxOrThrow();
+
+    // Proofs are only collected, then verified by the check object
+    std::vector<SaplingValidation::CProofCheck> vChecks;
+    CValidationState state;
+    BOOST_CHECK(SaplingValidation::ContextualCheckTransaction(tx, state, Params(), 3, true, false, &vChecks));
+    BOOST_CHECK_EQUAL(vChecks.size(), 1);
+    SaplingValidation::ProofError err = SaplingValidation::ProofError::SPEND_DESCRIPTION;
+    vChecks[0].SetErrorOutput(&err);
+    BOOST_CHECK(vChecks[0]());
+    BOOST_CHECK(err == SaplingValidation::ProofError::NONE);
+
+    // Broken binding signature: deferred check fails with the inline reject reason
+    CMutableTransaction mtx(tx);
+    mtx.sapData->bindingSig[0] ^= 1;
+    const CTransaction badTx(mtx);
+    vChecks.clear();
+    BOOST_CHECK(SaplingValidation::ContextualCheckTransaction(badTx, state, Params(), 3, true, false, &vChecks));
+    BOOST_CHECK_EQUAL(vChecks.size(), 1);
+    vChecks[0].SetErrorOutput(&err);
+    BOOST_CHECK(!vChecks[0]());
+    BOOST_CHECK(err == SaplingValidation::ProofError::BINDING_SIG);
+    BOOST_CHECK(!SaplingValidation::InvalidProofs(err, state, 100));
+    CValidationState inlineState;
+    BOOST_CHECK(!SaplingValidation::ContextualCheckTransaction(badTx, inlineState, Params(), 3, true, false));
+    BOOST_CHECK_EQUAL(state.GetRejectReason(), inlineState.GetRejectReason());
+}
+
 BOOST_AUTO_TEST_CASE(ThrowsOnTransparentInputWithoutKeyStore)
 {
     auto builder = TransactionBuilder(Params().GetConsensus());
@@ -4,7 +4,10 @@
 
 #include "test/test_pivx.h"
 
+#include "khu/khu_domc.h"
+#include "khu/khu_unstake.h"
 #include "policy/feerate.h"
+#include "streams.h"
 #include "txmempool.h"
 #include "util/system.h"
 
@@ -579,4 +582,76 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(0);
 }
 
+static CMutableTransaction MakeKHUUnstakeTx(const uint256& cm)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = CTransaction::TxType::KHU_UNSTAKE;
+    mtx.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    mtx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << CUnstakeKHUPayload(cm);
+    mtx.extraPayload = std::vector<uint8_t>(ds.begin(), ds.end());
+    return mtx;
+}
+
+static CMutableTransaction MakeKHUDomcCommitTx(const COutPoint& mnOutpoint, uint32_t nCycleId)
+{
+    khu_domc::DomcCommit commit;
+    commit.hashCommit = InsecureRand256();
+    commit.mnOutpoint = mnOutpoint;
+    commit.nCycleId = nCycleId;
+    CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+    ds << commit;
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = CTransaction::TxType::KHU_DOMC_COMMIT;
+    mtx.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+    mtx.vout.emplace_back(0, CScript() << OP_RETURN << std::vector<unsigned char>(ds.begin(), ds.end()));
+    return mtx;
+}
+
+BOOST_AUTO_TEST_CASE(MempoolKHUConflictTest)
+{
+    CTxMemPool pool(CFeeRate(0));
+    TestMemPoolEntryHelper entry;
+
+    // Two UNSTAKEs of the same note
+    const uint256 cm = InsecureRand256();
+    CMutableTransaction unstake1 = MakeKHUUnstakeTx(cm);
+    CMutableTransaction unstake2 = MakeKHUUnstakeTx(cm);
+    BOOST_CHECK(!pool.existsKHUConflict(unstake1));
+    pool.addUnchecked(unstake1.GetHash(), entry.FromTx(unstake1));
+    BOOST_CHECK(pool.existsKHUConflict(unstake2));
+    BOOST_CHECK(!pool.existsKHUConflict(MakeKHUUnstakeTx(InsecureRand256())));
+
+    // Two commits of the same masternode for the same cycle
+    const COutPoint mnOutpoint(InsecureRand256(), 1);
+    CMutableTransaction commit1 = MakeKHUDomcCommitTx(mnOutpoint, 1000);
+    CMutableTransaction commit2 = MakeKHUDomcCommitTx(mnOutpoint, 1000);
+    pool.addUnchecked(commit1.GetHash(), entry.FromTx(commit1));
+    BOOST_CHECK(pool.existsKHUConflict(commit2));
+    BOOST_CHECK(!pool.existsKHUConflict(MakeKHUDomcCommitTx(mnOutpoint, 2000)));
+    BOOST_CHECK(!pool.existsKHUConflict(MakeKHUDomcCommitTx(COutPoint(InsecureRand256(), 1), 1000)));
+
+    // Unreadable payloads are conflicts
+    CMutableTransaction badUnstake = unstake2;
+    badUnstake.extraPayload = std::vector<uint8_t>(1, 0);
+    BOOST_CHECK(pool.existsKHUConflict(badUnstake));
+
+    // The conflicting txes get mined: the mempool ones are evicted
+    std::vector<CTransactionRef> vtx;
+    vtx.emplace_back(MakeTransactionRef(unstake2));
+    vtx.emplace_back(MakeTransactionRef(commit2));
+    pool.removeForBlock(vtx, 1);
+    BOOST_CHECK_EQUAL(pool.size(), 0);
+    BOOST_CHECK(!pool.existsKHUConflict(unstake1));
+    BOOST_CHECK(!pool.existsKHUConflict(commit1));
+
+    // Removal frees the keys
+    pool.addUnchecked(unstake1.GetHash(), entry.FromTx(unstake1));
+    pool.removeRecursive(unstake1);
+    BOOST_CHECK(!pool.existsKHUConflict(unstake2));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,119 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "bls/bls_worker.h"
+#include "llmq/quorums_signing.h"
+#include "llmq/quorums_signing_shares.h"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+BOOST_FIXTURE_TEST_SUITE(quorums_signing_shares_tests, BasicTestingSetup)
+
+static CSigShare MakeSigShare(const uint256& id, uint16_t quorumMember, const CBLSSecretKey& sk)
+{
+    CSigShare sigShare;
+    sigShare.llmqType = Consensus::LLMQ_TEST;
+    sigShare.quorumHash = uint256S("01");
+    sigShare.quorumMember = quorumMember;
+    sigShare.id = id;
+    sigShare.msgHash = uint256S("02");
+    sigShare.UpdateKey();
+    sigShare.sigShare.Set(sk.Sign(sigShare.GetSignHash()));
+    return sigShare;
+}
+
+BOOST_AUTO_TEST_CASE(sig_shares_batch_verifier)
+{
+    CBLSWorker worker;
+    worker.Start();
+
+    const size_t nMembers = 3;
+    const size_t nSessions = 10;
+    std::vector<CBLSSecretKey> skShares(nMembers);
+    for (auto& sk : skShares) {
+        sk.MakeNewKey();
+    }
+    CBLSSecretKey skOther;
+    skOther.MakeNewKey();
+
+    // Node i relays the share of member i for every session, node 2 sends a bad share in session 7
+    const NodeId badNode = 2;
+    const size_t badSession = 7;
+    for (size_t maxBatches : {1, 4, 16}) {
+        CSigSharesBatchVerifier batchVerifier(maxBatches);
+        for (size_t j = 0; j < nSessions; j++) {
+            const uint256 id = ArithToUint256(arith_uint256(j + 1));
+            for (size_t i = 0; i < nMembers; i++) {
+                const bool fBad = (NodeId)i == badNode && j == badSession;
+                const CSigShare sigShare = MakeSigShare(id, (uint16_t)i, fBad ? skOther : skShares[i]);
+                // a session stays in one batch, sessions go round-robin over the batches
+                BOOST_CHECK_EQUAL(batchVerifier.PushSigShare((NodeId)i, sigShare, skShares[i].GetPublicKey()), j % maxBatches);
+            }
+        }
+        BOOST_CHECK_EQUAL(batchVerifier.GetBatchCount(), std::min(maxBatches, nSessions));
+        BOOST_CHECK_EQUAL(batchVerifier.GetSigShareCount(), nMembers * nSessions);
+
+        // Only the sender of the bad share is blamed, whichever batch it landed in
+        batchVerifier.Verify(worker);
+        BOOST_CHECK(batchVerifier.badSources == std::set<NodeId>{badNode});
+    }
+
+    // All valid: nobody is blamed
+    CSigSharesBatchVerifier batchVerifier(4);
+    for (size_t j = 0; j < nSessions; j++) {
+        const uint256 id = ArithToUint256(arith_uint256(j + 1));
+        for (size_t i = 0; i < nMembers; i++) {
+            batchVerifier.PushSigShare((NodeId)i, MakeSigShare(id, (uint16_t)i, skShares[i]), skShares[i].GetPublicKey());
+        }
+    }
+    batchVerifier.Verify(worker);
+    BOOST_CHECK(batchVerifier.badSources.empty());
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(sig_shares_verify_stats)
+{
+    const size_t nMin = 32;
+    const size_t nMax = 512;
+    CSigSharesVerifyStats stats;
+    stats.maxUniqueSessions = nMin;
+
+    // Backlog growing: the rounds double, up to the max
+    stats.pendingSigShares = 1000;
+    for (size_t nExpected : {64, 128, 256, 512, 512}) {
+        stats.UpdateRound(stats.maxUniqueSessions, 0, 10, nMin, nMax);
+        BOOST_CHECK_EQUAL(stats.maxUniqueSessions, nExpected);
+    }
+
+    // Backlog drained by the round: unchanged
+    stats.pendingSigShares = 100;
+    stats.UpdateRound(512, 0, 10, nMin, nMax);
+    BOOST_CHECK_EQUAL(stats.maxUniqueSessions, nMax);
+
+    // No backlog: the rounds halve, down to the min
+    stats.pendingSigShares = 0;
+    for (size_t nExpected : {256, 128, 64, 32, 32}) {
+        stats.UpdateRound(10, 0, 10, nMin, nMax);
+        BOOST_CHECK_EQUAL(stats.maxUniqueSessions, nExpected);
+    }
+
+    // A bad source resets the rounds to the min, even with a backlog
+    stats.pendingSigShares = 1000;
+    stats.UpdateRound(32, 0, 10, nMin, nMax);
+    BOOST_CHECK_EQUAL(stats.maxUniqueSessions, 64U);
+    stats.UpdateRound(64, 1, 10, nMin, nMax);
+    BOOST_CHECK_EQUAL(stats.maxUniqueSessions, nMin);
+
+    BOOST_CHECK_EQUAL(stats.rounds, 13U);
+    BOOST_CHECK_EQUAL(stats.badSources, 1U);
+    BOOST_CHECK_EQUAL(stats.lastVerifyTime, 10);
+    BOOST_CHECK_EQUAL(stats.totalVerifyTime, 130);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
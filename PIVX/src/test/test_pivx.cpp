@@ -20,6 +20,7 @@
 #include "rpc/server.h"
 #include "rpc/register.h"
 #include "pow.h"
+#include "sapling/sapling_validation.h"
 #include "script/sigcache.h"
 #include "sporkdb.h"
 #include "streams.h"
@@ -71,6 +72,7 @@ BasicTestingSetup::BasicTestingSetup(const std::string& chainName)
     BLSInit();
     SetupEnvironment();
     InitSignatureCache();
+    SaplingValidation::InitProofCache();
     fCheckBlockIndex = true;
     SelectParams(chainName);
     SeedInsecureRand();
@@ -133,8 +135,9 @@ TestingSetup::TestingSetup(const std::string& chainName) : BasicTestingSetup(cha
             BOOST_CHECK(ok);
         }
         nScriptCheckThreads = 3;
-        for (int i=0; i < nScriptCheckThreads-1; i++)
+        for (int i=0; i < nScriptCheckThreads-1; i++) {
             threadGroup.create_thread(&ThreadScriptCheck);
+        }
         peerLogic.reset(new PeerLogicValidation(connman));
 }
 
@@ -0,0 +1,145 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "pow.h"
+#include "random.h"
+#include "txdb.h"
+#include "validation.h"
+
+#include <boost/test/unit_test.hpp>
+
+struct TxDBTestingSetup : public BasicTestingSetup
+{
+    TxDBTestingSetup() : BasicTestingSetup(CBaseChainParams::REGTEST) {}
+};
+
+BOOST_FIXTURE_TEST_SUITE(txdb_tests, TxDBTestingSetup)
+
+// Owns the CBlockIndex entries of a block map
+struct CBlockIndexMap
+{
+    BlockMap map;
+
+    ~CBlockIndexMap()
+    {
+        for (auto& p : map) {
+            delete p.second;
+        }
+    }
+
+    CBlockIndex* Insert(const uint256& hash)
+    {
+        if (hash.IsNull()) {
+            return nullptr;
+        }
+        auto mi = map.find(hash);
+        if (mi != map.end()) {
+            return mi->second;
+        }
+        CBlockIndex* pindexNew = new CBlockIndex();
+        mi = map.emplace(hash, pindexNew).first;
+        pindexNew->phashBlock = &mi->first;
+        return pindexNew;
+    }
+
+    // Same as LoadBlockIndexDB: a block's chain work is its parent's plus its own proof
+    void ComputeChainWork()
+    {
+        std::vector<CBlockIndex*> vSortedByHeight;
+        for (auto& p : map) {
+            vSortedByHeight.push_back(p.second);
+        }
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(), [](const CBlockIndex* a, const CBlockIndex* b) {
+            return a->nHeight < b->nHeight;
+        });
+        for (CBlockIndex* pindex : vSortedByHeight) {
+            pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        }
+    }
+};
+
+// Block tree of nBlocks headers above the regtest PoS activation (no PoW
+// check), with a one block fork every 50 blocks
+static void CreateBlockTree(CBlockIndexMap& blockTree, int nBlocks)
+{
+    const int nBaseHeight = 1000;
+    CBlockIndex* pindexTip = nullptr;
+    for (int i = 0; i < nBlocks; i++) {
+        std::vector<CBlockIndex*> vParents{pindexTip};
+        if (i % 50 == 49) {
+            vParents.push_back(pindexTip->pprev);
+        }
+        for (CBlockIndex* pindexPrev : vParents) {
+            CBlockIndex index;
+            index.pprev = pindexPrev;
+            index.nHeight = pindexPrev ? pindexPrev->nHeight + 1 : nBaseHeight;
+            index.nVersion = 10;
+            index.hashMerkleRoot = InsecureRand256();
+            index.nTime = 1600000000 + index.nHeight * 60 + (pindexPrev == pindexTip ? 0 : 1);
+            index.nBits = 0x1e0ffff0 + InsecureRandRange(16);
+            index.nNonce = InsecureRand32();
+            index.nTx = 1 + InsecureRandRange(100);
+            index.nStatus = BLOCK_VALID_TREE;
+            if (pindexPrev == pindexTip) {
+                index.nStatus |= BLOCK_HAVE_DATA;
+                index.nFile = i / 1000;
+                index.nDataPos = 8 + i * 1000;
+            }
+            CBlockIndex* pindexNew = blockTree.Insert(CDiskBlockIndex(&index).GetBlockHash());
+            const uint256* phashBlock = pindexNew->phashBlock;
+            *pindexNew = index;
+            pindexNew->phashBlock = phashBlock;
+            if (pindexPrev == pindexTip) {
+                pindexTip = pindexNew;
+            }
+        }
+    }
+    blockTree.ComputeChainWork();
+}
+
+static void CheckSameBlockTree(const CBlockIndexMap& blockTree, const CBlockIndexMap& loaded)
+{
+    BOOST_CHECK_EQUAL(loaded.map.size(), blockTree.map.size());
+    for (const auto& p : blockTree.map) {
+        const CBlockIndex* pindex = p.second;
+        auto it = loaded.map.find(p.first);
+        BOOST_REQUIRE(it != loaded.map.end());
+        const CBlockIndex* pindexLoaded = it->second;
+        BOOST_CHECK_EQUAL(pindexLoaded->nHeight, pindex->nHeight);
+        BOOST_CHECK(pindexLoaded->pprev == nullptr ? pindex->pprev == nullptr :
+                    pindex->pprev && pindexLoaded->pprev->GetBlockHash() == pindex->pprev->GetBlockHash());
+        BOOST_CHECK(pindexLoaded->nChainWork == pindex->nChainWork);
+        BOOST_CHECK_EQUAL(pindexLoaded->nStatus, pindex->nStatus);
+        BOOST_CHECK_EQUAL(pindexLoaded->nTx, pindex->nTx);
+        BOOST_CHECK_EQUAL(pindexLoaded->nFile, pindex->nFile);
+        BOOST_CHECK_EQUAL(pindexLoaded->nDataPos, pindex->nDataPos);
+        BOOST_CHECK_EQUAL(pindexLoaded->nTime, pindex->nTime);
+        BOOST_CHECK_EQUAL(pindexLoaded->nBits, pindex->nBits);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(load_block_index_sharded)
+{
+    CBlockIndexMap blockTree;
+    CreateBlockTree(blockTree, 2000);
+
+    CBlockTreeDB db(1 << 20, true);
+    std::vector<const CBlockIndex*> vBlocks;
+    for (const auto& p : blockTree.map) {
+        vBlocks.push_back(p.second);
+    }
+    BOOST_REQUIRE(db.WriteBatchSync({}, 0, vBlocks));
+
+    // One cursor over the whole key range, then shards of the first hash byte
+    for (int nThreads : {1, 3, MAX_BLOCK_INDEX_LOAD_THREADS}) {
+        CBlockIndexMap loaded;
+        BOOST_REQUIRE(db.LoadBlockIndexGuts([&loaded](const uint256& hash) { return loaded.Insert(hash); }, nThreads));
+        loaded.ComputeChainWork();
+        CheckSameBlockTree(blockTree, loaded);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,44 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_pivx.h"
+
+#include "random.h"
+#include "saltedhasher.h"
+#include "unordered_lru_cache.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(unordered_lru_cache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(unordered_mem_lru_cache_bytes)
+{
+    // bounded by the memory usage of the entries, not by their count
+    unordered_mem_lru_cache<uint256, int, StaticSaltedHasher> cache(100);
+    const uint256 h1 = GetRandHash(), h2 = GetRandHash(), h3 = GetRandHash();
+    cache.insert(h1, 1, 40);
+    cache.insert(h2, 2, 40);
+    BOOST_CHECK_EQUAL(cache.bytes(), 80);
+
+    // h1 is now the most recently used: h2 is evicted to fit h3
+    BOOST_CHECK_EQUAL(*cache.get(h1), 1);
+    cache.insert(h3, 3, 40);
+    BOOST_CHECK_EQUAL(cache.size(), 2);
+    BOOST_CHECK(cache.get(h2) == nullptr);
+    BOOST_CHECK(cache.exists(h1) && cache.exists(h3));
+    BOOST_CHECK_EQUAL(cache.bytes(), 80);
+
+    // replacing an entry updates its size, an entry above the bound is still kept alone
+    cache.insert(h1, 4, 10);
+    BOOST_CHECK_EQUAL(cache.bytes(), 50);
+    BOOST_CHECK_EQUAL(*cache.get(h1), 4);
+    cache.insert(h2, 5, 200);
+    BOOST_CHECK_EQUAL(cache.size(), 1);
+    BOOST_CHECK_EQUAL(cache.bytes(), 200);
+    cache.erase(h2);
+    BOOST_CHECK_EQUAL(cache.size(), 0);
+    BOOST_CHECK_EQUAL(cache.bytes(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
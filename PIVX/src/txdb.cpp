@@ -9,11 +9,16 @@
 #include "clientversion.h"
 #include "pow.h"
 #include "random.h"
+#include "shutdown.h"
 #include "uint256.h"
 #include "util/system.h"
+#include "util/threadnames.h"
 #include "util/vector.h"
+#include "utiltime.h"
 
+#include <atomic>
 #include <stdint.h>
+#include <thread>
 
 #include <boost/thread.hpp>
 
@@ -285,59 +290,111 @@ bool CBlockTreeDB::ReadInt(const std::string& name, int& nValue)
     return Read(std::make_pair('I', name), nValue);
 }
 
-bool CBlockTreeDB::LoadBlockIndexGuts(std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
+// Load the block index entries whose hash starts with a byte in [nFirstByte, nEndByte)
+static bool LoadBlockIndexShard(CBlockTreeDB& db, int nFirstByte, int nEndByte, Mutex& cs_insert,
+                                const std::function<CBlockIndex*(const uint256&)>& insertBlockIndex,
+                                std::atomic<bool>& fFailed, std::atomic<size_t>& nLoaded)
 {
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
 
-    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, UINT256_ZERO));
+    uint256 hashStart;
+    *hashStart.begin() = (unsigned char)nFirstByte;
+    pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, hashStart));
 
-    // Load mapBlockIndex
+    const Consensus::Params& consensus = Params().GetConsensus();
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
+        if (fFailed || ShutdownRequested()) {
+            return false;
+        }
         std::pair<char, uint256> key;
-        if (pcursor->GetKey(key) && key.first == DB_BLOCK_INDEX) {
-            CDiskBlockIndex diskindex;
-            if (pcursor->GetValue(diskindex)) {
-                // Construct block index object
-                CBlockIndex* pindexNew = insertBlockIndex(diskindex.GetBlockHash());
-                pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
-                pindexNew->nHeight = diskindex.nHeight;
-                pindexNew->nFile = diskindex.nFile;
-                pindexNew->nDataPos = diskindex.nDataPos;
-                pindexNew->nUndoPos = diskindex.nUndoPos;
-                pindexNew->nVersion = diskindex.nVersion;
-                pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-                pindexNew->nTime = diskindex.nTime;
-                pindexNew->nBits = diskindex.nBits;
-                pindexNew->nNonce = diskindex.nNonce;
-                pindexNew->nStatus = diskindex.nStatus;
-                pindexNew->nTx = diskindex.nTx;
-
-                // sapling
-                pindexNew->nSaplingValue  = diskindex.nSaplingValue;
-                pindexNew->hashFinalSaplingRoot = diskindex.hashFinalSaplingRoot;
-
-                //zerocoin
-                pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
-
-                //Proof Of Stake
-                pindexNew->nFlags = diskindex.nFlags;
-                pindexNew->vStakeModifier = diskindex.vStakeModifier;
-
-                if (!Params().GetConsensus().NetworkUpgradeActive(pindexNew->nHeight, Consensus::UPGRADE_POS)) {
-                    if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits))
-                        return error("%s : CheckProofOfWork failed: %s", __func__, pindexNew->ToString());
-                }
-
-                pcursor->Next();
-            } else {
-                return error("%s : failed to read value", __func__);
-            }
-        } else {
+        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX || *key.second.begin() >= nEndByte) {
             break;
         }
+        CDiskBlockIndex diskindex;
+        if (!pcursor->GetValue(diskindex)) {
+            return error("%s : failed to read value", __func__);
+        }
+        // Hashing the header is the bulk of the work, done outside of the lock
+        const uint256 hashBlock = diskindex.GetBlockHash();
+        if (!consensus.NetworkUpgradeActive(diskindex.nHeight, Consensus::UPGRADE_POS)) {
+            if (!CheckProofOfWork(hashBlock, diskindex.nBits))
+                return error("%s : CheckProofOfWork failed: %s", __func__, diskindex.ToString());
+        }
+
+        // Construct block index object
+        CBlockIndex* pindexNew;
+        {
+            LOCK(cs_insert);
+            pindexNew = insertBlockIndex(hashBlock);
+            pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+        }
+        pindexNew->nHeight = diskindex.nHeight;
+        pindexNew->nFile = diskindex.nFile;
+        pindexNew->nDataPos = diskindex.nDataPos;
+        pindexNew->nUndoPos = diskindex.nUndoPos;
+        pindexNew->nVersion = diskindex.nVersion;
+        pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+        pindexNew->nTime = diskindex.nTime;
+        pindexNew->nBits = diskindex.nBits;
+        pindexNew->nNonce = diskindex.nNonce;
+        pindexNew->nStatus = diskindex.nStatus;
+        pindexNew->nTx = diskindex.nTx;
+
+        // sapling
+        pindexNew->nSaplingValue  = diskindex.nSaplingValue;
+        pindexNew->hashFinalSaplingRoot = diskindex.hashFinalSaplingRoot;
+
+        //zerocoin
+        pindexNew->nAccumulatorCheckpoint = diskindex.nAccumulatorCheckpoint;
+
+        //Proof Of Stake
+        pindexNew->nFlags = diskindex.nFlags;
+        pindexNew->vStakeModifier = diskindex.vStakeModifier;
+
+        nLoaded++;
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::LoadBlockIndexGuts(std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nThreads)
+{
+    const int64_t nStart = GetTimeMillis();
+
+    // The keys are ordered by block hash: split them in ranges of the first hash byte,
+    // each one read and deserialized by its own cursor and thread.
+    if (nThreads <= 0) {
+        nThreads = std::min(GetNumCores(), MAX_BLOCK_INDEX_LOAD_THREADS);
+    }
+    nThreads = std::max(1, std::min(nThreads, 256));
+    Mutex cs_insert;
+    std::atomic<bool> fFailed{false};
+    std::atomic<size_t> nLoaded{0};
+    std::vector<std::thread> vThreads;
+    for (int i = 0; i < nThreads; i++) {
+        const int nFirstByte = 256 * i / nThreads;
+        const int nEndByte = 256 * (i + 1) / nThreads;
+        vThreads.emplace_back([&, nFirstByte, nEndByte] {
+            util::ThreadRename(strprintf("pivx-loadblk.%d", nFirstByte));
+            try {
+                if (!LoadBlockIndexShard(*this, nFirstByte, nEndByte, cs_insert, insertBlockIndex, fFailed, nLoaded)) {
+                    fFailed = true;
+                }
+            } catch (const std::exception& e) {
+                LogPrintf("%s: %s\n", __func__, e.what());
+                fFailed = true;
+            }
+        });
+    }
+    for (std::thread& t : vThreads) {
+        t.join();
+    }
+    boost::this_thread::interruption_point();
+    if (fFailed) {
+        return false;
     }
 
+    LogPrint(BCLog::BENCHMARK, "%s: loaded %u block index entries with %d threads in %dms\n", __func__, nLoaded.load(), nThreads, GetTimeMillis() - nStart);
     return true;
 }
 
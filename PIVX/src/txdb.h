@@ -39,6 +39,8 @@ static const int64_t nMaxBlockDBCache = 2;
 static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! Max threads reading the block index at startup
+static const int MAX_BLOCK_INDEX_LOAD_THREADS = 8;
 
 struct CDiskTxPos : public FlatFilePos
 {
@@ -144,7 +146,11 @@ public:
     bool ReadFlag(const std::string& name, bool& fValue);
     bool WriteInt(const std::string& name, int nValue);
     bool ReadInt(const std::string& name, int& nValue);
-    bool LoadBlockIndexGuts(std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+    /**
+     * Load all block index entries, with nThreads cursors in parallel (0: one per core, up to
+     * MAX_BLOCK_INDEX_LOAD_THREADS). insertBlockIndex is called from these threads, one call at a time.
+     */
+    bool LoadBlockIndexGuts(std::function<CBlockIndex*(const uint256&)> insertBlockIndex, int nThreads = 0);
 };
 
 /** Zerocoin database (zerocoin/) */
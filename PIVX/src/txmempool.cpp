@@ -11,6 +11,8 @@
 #include "evo/deterministicmns.h"
 #include "evo/specialtx_validation.h"
 #include "evo/providertx.h"
+#include "khu/khu_domc_tx.h"
+#include "khu/khu_unstake.h"
 #include "policy/fees.h"
 #include "reverse_iterate.h"
 #include "streams.h"
@@ -360,6 +362,24 @@ void CTxMemPool::AddTransactionsUpdated(unsigned int n)
     nTransactionsUpdated += n;
 }
 
+// (masternode, cycle) a DOMC commit or reveal votes for
+static bool GetKHUDomcVoteKey(const CTransaction& tx, std::pair<COutPoint, uint32_t>& key)
+{
+    if (tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT) {
+        khu_domc::DomcCommit commit;
+        if (!ExtractDomcCommitFromTx(tx, commit)) return false;
+        key = std::make_pair(commit.mnOutpoint, commit.nCycleId);
+        return true;
+    }
+    if (tx.nType == CTransaction::TxType::KHU_DOMC_REVEAL) {
+        khu_domc::DomcReveal reveal;
+        if (!ExtractDomcRevealFromTx(tx, reveal)) return false;
+        key = std::make_pair(reveal.mnOutpoint, reveal.nCycleId);
+        return true;
+    }
+    return false;
+}
+
 void CTxMemPool::addUncheckedSpecialTx(const CTransaction& tx)
 {
     if (!tx.IsSpecialTx()) return;
@@ -473,6 +493,7 @@ bool CTxMemPool::addUnchecked(const uint256& hash, const CTxMemPoolEntry &entry,
     minerPolicyEstimator->processTransaction(entry, validFeeEstimate);
 
     addUncheckedSpecialTx(tx);
+    addUncheckedKHUTx(tx);
 
     return true;
 }
@@ -537,6 +558,43 @@ void CTxMemPool::removeUncheckedSpecialTx(const CTransaction& tx)
     }
 }
 
+void CTxMemPool::addUncheckedKHUTx(const CTransaction& tx)
+{
+    // As for special txes, ATMP already checked the payloads
+    const uint256& txid = tx.GetHash();
+    if (tx.nType == CTransaction::TxType::KHU_UNSTAKE) {
+        CUnstakeKHUPayload pl;
+        if (GetUnstakeKHUPayload(tx, pl)) {
+            mapKHUUnstakeNotes.emplace(pl.cm, txid);
+        }
+        return;
+    }
+    std::pair<COutPoint, uint32_t> voteKey;
+    if (GetKHUDomcVoteKey(tx, voteKey)) {
+        auto& mapVotes = tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT ? mapKHUDomcCommits : mapKHUDomcReveals;
+        mapVotes.emplace(voteKey, txid);
+    }
+}
+
+void CTxMemPool::removeUncheckedKHUTx(const CTransaction& tx)
+{
+    const uint256& txid = tx.GetHash();
+    if (tx.nType == CTransaction::TxType::KHU_UNSTAKE) {
+        CUnstakeKHUPayload pl;
+        if (GetUnstakeKHUPayload(tx, pl)) {
+            auto it = mapKHUUnstakeNotes.find(pl.cm);
+            if (it != mapKHUUnstakeNotes.end() && it->second == txid) mapKHUUnstakeNotes.erase(it);
+        }
+        return;
+    }
+    std::pair<COutPoint, uint32_t> voteKey;
+    if (GetKHUDomcVoteKey(tx, voteKey)) {
+        auto& mapVotes = tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT ? mapKHUDomcCommits : mapKHUDomcReveals;
+        auto it = mapVotes.find(voteKey);
+        if (it != mapVotes.end() && it->second == txid) mapVotes.erase(it);
+    }
+}
+
 void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
 {
     if (reason != MemPoolRemovalReason::BLOCK) {
@@ -559,6 +617,7 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     }
 
     removeUncheckedSpecialTx(tx);
+    removeUncheckedKHUTx(tx);
 
     totalTxSize -= it->GetTxSize();
     cachedInnerUsage -= it->DynamicMemoryUsage();
@@ -838,6 +897,32 @@ void CTxMemPool::removeProTxConflicts(const CTransaction &tx)
     }
 }
 
+void CTxMemPool::removeKHUConflicts(const CTransaction &tx)
+{
+    auto removeConflict = [&](const uint256& conflictHash) {
+        if (conflictHash != tx.GetHash() && mapTx.count(conflictHash)) {
+            removeRecursive(mapTx.find(conflictHash)->GetTx(), MemPoolRemovalReason::CONFLICT);
+        }
+    };
+
+    if (tx.nType == CTransaction::TxType::KHU_UNSTAKE) {
+        CUnstakeKHUPayload pl;
+        if (!GetUnstakeKHUPayload(tx, pl)) {
+            LogPrint(BCLog::MEMPOOL, "%s: ERROR: Invalid transaction payload, tx: %s\n", __func__, tx.ToString());
+            return;
+        }
+        auto it = mapKHUUnstakeNotes.find(pl.cm);
+        if (it != mapKHUUnstakeNotes.end()) removeConflict(it->second);
+        return;
+    }
+    std::pair<COutPoint, uint32_t> voteKey;
+    if (GetKHUDomcVoteKey(tx, voteKey)) {
+        const auto& mapVotes = tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT ? mapKHUDomcCommits : mapKHUDomcReveals;
+        auto it = mapVotes.find(voteKey);
+        if (it != mapVotes.end()) removeConflict(it->second);
+    }
+}
+
 /**
  * Called when a block is connected. Removes from mempool and updates the miner fee estimator.
  */
@@ -862,6 +947,7 @@ void CTxMemPool::removeForBlock(const std::vector<CTransactionRef>& vtx, unsigne
         }
         removeConflicts(*tx);
         removeProTxConflicts(*tx);
+        removeKHUConflicts(*tx);
         ClearPrioritisation(tx->GetHash());
     }
     lastRollingFeeUpdate = GetTime();
@@ -876,6 +962,9 @@ void CTxMemPool::_clear()
     mapNextTx.clear();
     mapProTxAddresses.clear();
     mapProTxPubKeyIDs.clear();
+    mapKHUUnstakeNotes.clear();
+    mapKHUDomcCommits.clear();
+    mapKHUDomcReveals.clear();
     totalTxSize = 0;
     cachedInnerUsage = 0;
     lastRollingFeeUpdate = GetTime();
@@ -1038,6 +1127,15 @@ void CTxMemPool::checkNullifiers() const
         const CTransactionRef& tx = findTx->GetSharedTx();
         assert(*tx == *it.second);
     }
+    for (const auto& it : mapKHUUnstakeNotes) {
+        assert(mapTx.count(it.second));
+    }
+    for (const auto& it : mapKHUDomcCommits) {
+        assert(mapTx.count(it.second));
+    }
+    for (const auto& it : mapKHUDomcReveals) {
+        assert(mapTx.count(it.second));
+    }
 }
 
 bool CTxMemPool::CompareDepthAndScore(const uint256& hasha, const uint256& hashb)
@@ -1197,6 +1295,30 @@ bool CTxMemPool::existsProviderTxConflict(const CTransaction &tx) const
     return false;
 }
 
+bool CTxMemPool::existsKHUConflict(const CTransaction &tx) const
+{
+    LOCK(cs);
+
+    if (tx.nType == CTransaction::TxType::KHU_UNSTAKE) {
+        CUnstakeKHUPayload pl;
+        if (!GetUnstakeKHUPayload(tx, pl)) {
+            LogPrint(BCLog::MEMPOOL, "%s: ERROR: Invalid transaction payload, tx: %s\n", __func__, tx.ToString());
+            return true; // i.e. can't decode payload == conflict
+        }
+        return mapKHUUnstakeNotes.count(pl.cm);
+    }
+    if (tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT || tx.nType == CTransaction::TxType::KHU_DOMC_REVEAL) {
+        std::pair<COutPoint, uint32_t> voteKey;
+        if (!GetKHUDomcVoteKey(tx, voteKey)) {
+            LogPrint(BCLog::MEMPOOL, "%s: ERROR: Invalid transaction payload, tx: %s\n", __func__, tx.ToString());
+            return true;
+        }
+        const auto& mapVotes = tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT ? mapKHUDomcCommits : mapKHUDomcReveals;
+        return mapVotes.count(voteKey);
+    }
+    return false;
+}
+
 CFeeRate CTxMemPool::estimateFee(int nBlocks) const
 {
     LOCK(cs);
@@ -1334,7 +1456,10 @@ size_t CTxMemPool::DynamicMemoryUsage() const
             memusage::DynamicUsage(mapDeltas) +
             memusage::DynamicUsage(mapLinks) +
             cachedInnerUsage +
-            memusage::DynamicUsage(mapSaplingNullifiers);
+            memusage::DynamicUsage(mapSaplingNullifiers) +
+            memusage::DynamicUsage(mapKHUUnstakeNotes) +
+            memusage::DynamicUsage(mapKHUDomcCommits) +
+            memusage::DynamicUsage(mapKHUDomcReveals);
 }
 
 void CTxMemPool::RemoveStaged(setEntries &stage, bool updateDescendants, MemPoolRemovalReason reason)
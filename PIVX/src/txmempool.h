@@ -500,6 +500,11 @@ private:
     std::map<uint256, uint256> mapProTxBlsPubKeyHashes;
     std::map<COutPoint, uint256> mapProTxCollaterals;
 
+    // KHU txes: note commitment spent by an UNSTAKE, (masternode, cycle) of a DOMC vote -> transaction
+    std::map<uint256, uint256> mapKHUUnstakeNotes;
+    std::map<std::pair<COutPoint, uint32_t>, uint256> mapKHUDomcCommits;
+    std::map<std::pair<COutPoint, uint32_t>, uint256> mapKHUDomcReveals;
+
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
@@ -655,6 +660,8 @@ public:
     std::vector<TxMempoolInfo> infoAll() const;
 
     bool existsProviderTxConflict(const CTransaction &tx) const;
+    /** Whether another mempool tx already unstakes the same note or casts the same DOMC vote */
+    bool existsKHUConflict(const CTransaction &tx) const;
     void removeProTxReferences(const uint256& proTxHash, MemPoolRemovalReason reason);
 
     /** Estimate fee rate needed to get into the next nBlocks
@@ -719,6 +726,11 @@ private:
     void removeProTxSpentCollateralConflicts(const CTransaction &tx);
     void removeProTxConflicts(const CTransaction &tx);
 
+    /** KHU txes **/
+    void addUncheckedKHUTx(const CTransaction& tx);
+    void removeUncheckedKHUTx(const CTransaction& tx);
+    void removeKHUConflicts(const CTransaction &tx);
+
 };
 
 /**
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <list>
 #include <unordered_map>
 #include <vector>
 
@@ -112,4 +113,93 @@ private:
     }
 };
 
+/**
+ * LRU cache bounded by the memory usage of its values (as reported by the
+ * caller on insertion) instead of their count. The least recently used entries
+ * are evicted as soon as the total goes above maxBytes, the last inserted entry
+ * is always kept.
+ */
+template<typename Key, typename Value, typename Hasher>
+class unordered_mem_lru_cache
+{
+private:
+    // Most recently used first
+    typedef std::list<std::pair<Key, Value>> ListType;
+    typedef std::unordered_map<Key, std::pair<typename ListType::iterator, size_t>, Hasher> MapType;
+
+    ListType entries;
+    MapType cacheMap;
+    size_t maxBytes;
+    size_t usedBytes{0};
+
+public:
+    explicit unordered_mem_lru_cache(size_t _maxBytes) : maxBytes(_maxBytes)
+    {
+        assert(_maxBytes != 0);
+    }
+
+    size_t max_bytes() const { return maxBytes; }
+    size_t bytes() const { return usedBytes; }
+    size_t size() const { return cacheMap.size(); }
+
+    void insert(const Key& key, const Value& v, size_t nBytes)
+    {
+        auto it = cacheMap.find(key);
+        if (it != cacheMap.end()) {
+            usedBytes -= it->second.second;
+            entries.erase(it->second.first);
+            cacheMap.erase(it);
+        }
+        entries.emplace_front(key, v);
+        cacheMap.emplace(key, std::make_pair(entries.begin(), nBytes));
+        usedBytes += nBytes;
+        truncate_if_needed();
+    }
+
+    // Pointer to the cached value (valid until the next insert/erase), nullptr if missing
+    const Value* get(const Key& key)
+    {
+        auto it = cacheMap.find(key);
+        if (it == cacheMap.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second.first);
+        return &it->second.first->second;
+    }
+
+    bool exists(const Key& key) const
+    {
+        return cacheMap.count(key) != 0;
+    }
+
+    void erase(const Key& key)
+    {
+        auto it = cacheMap.find(key);
+        if (it != cacheMap.end()) {
+            usedBytes -= it->second.second;
+            entries.erase(it->second.first);
+            cacheMap.erase(it);
+        }
+    }
+
+    void clear()
+    {
+        entries.clear();
+        cacheMap.clear();
+        usedBytes = 0;
+    }
+
+private:
+    void truncate_if_needed()
+    {
+        while (usedBytes > maxBytes && entries.size() > 1) {
+            auto it = cacheMap.find(entries.back().first);
+            assert(it != cacheMap.end());
+            usedBytes -= it->second.second;
+            cacheMap.erase(it);
+            entries.pop_back();
+        }
+    }
+};
+
 #endif // PIVX_UNORDERED_LRU_CACHE_H
@@ -29,10 +29,13 @@
 #include "interfaces/handler.h"
 #include "invalid.h"
 #include "kernel.h"
+#include "khu/khu_dbwrapper.h"
 #include "khu/khu_state.h"
 #include "khu/khu_statedb.h"
+#include "khu/khu_utxo.h"
 #include "khu/khu_validation.h"
 #include "khu/khu_domc_tx.h"
+#include "khu/khu_precheck.h"
 #include "legacy/validation_zerocoin_legacy.h"
 #include "llmq/quorums_chainlocks.h"
 #include "masternode-payments.h"
@@ -40,6 +43,7 @@
 #include "policy/policy.h"
 #include "pow.h"
 #include "reverse_iterate.h"
+#include "sapling/sapling_validation.h"
 #include "script/sigcache.h"
 #include "shutdown.h"
 #include "spork.h"
@@ -61,6 +65,7 @@
 #include <boost/thread.hpp>
 #include <atomic>
 #include <queue>
+#include <thread>
 
 
 #if defined(NDEBUG)
@@ -453,6 +458,11 @@ static bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState &state,
         }
     }
 
+    // Check KHU note commitments and DOMC votes
+    if (pool.existsKHUConflict(tx)) {
+        return state.Invalid(false, REJECT_CONFLICT, "khu-txn-mempool-conflict");
+    }
+
     {
         CCoinsView dummy;
         CCoinsViewCache view(&dummy);
@@ -501,18 +511,24 @@ static bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState &state,
         // Phase 6.2: Validate DOMC transactions (commit/reveal votes)
         if (tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT ||
             tx.nType == CTransaction::TxType::KHU_DOMC_REVEAL) {
-            // Load current KHU state to validate DOMC transaction
-            CKHUStateDB* khudb = GetKHUStateDB();
-            if (!khudb) {
-                return state.DoS(100, false, REJECT_INVALID, "khu-db-not-initialized",
-                                false, "KHU state database not initialized");
-            }
+            // Load current KHU state to validate DOMC transaction: the tip
+            // snapshot, unless it was not published for this tip yet
+            std::shared_ptr<const KhuGlobalState> pkhuState = GetKHUTipState(chainActive.Tip());
+            if (!pkhuState) {
+                CKHUStateDB* khudb = GetKHUStateDB();
+                if (!khudb) {
+                    return state.DoS(100, false, REJECT_INVALID, "khu-db-not-initialized",
+                                    false, "KHU state database not initialized");
+                }
 
-            KhuGlobalState khuState;
-            if (!khudb->ReadKHUState(chainHeight, khuState)) {
-                return state.DoS(100, false, REJECT_INVALID, "khu-state-not-found",
-                                false, strprintf("KHU state not found at height %d", chainHeight));
+                auto pkhuStateRead = std::make_shared<KhuGlobalState>();
+                if (!khudb->ReadKHUState(chainHeight, *pkhuStateRead)) {
+                    return state.DoS(100, false, REJECT_INVALID, "khu-state-not-found",
+                                    false, strprintf("KHU state not found at height %d", chainHeight));
+                }
+                pkhuState = std::move(pkhuStateRead);
             }
+            const KhuGlobalState& khuState = *pkhuState;
 
             // Validate DOMC commit transaction
             if (tx.nType == CTransaction::TxType::KHU_DOMC_COMMIT) {
@@ -1094,6 +1110,24 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache &inputs, int nHeight, b
     UpdateCoins(tx, inputs, txundo, nHeight, fSkipInvalid);
 }
 
+/** Change of the sum of the utxo values caused by UpdateCoins(tx), given the coins it spent */
+static CAmount GetTxSupplyDelta(const CTransaction& tx, const CTxUndo& txundo, bool fSkipInvalid)
+{
+    CAmount nDelta = 0;
+    const uint256& txid = tx.GetHash();
+    for (size_t i = 0; i < tx.vout.size(); i++) {
+        // Same outputs AddCoins/AddCoin leave out of the utxo set
+        const CTxOut& out = tx.vout[i];
+        if (out.scriptPubKey.IsUnspendable() || out.IsZerocoinMint()) continue;
+        if (fSkipInvalid && invalid_out::ContainsOutPoint(COutPoint(txid, i))) continue;
+        nDelta += out.nValue;
+    }
+    for (const Coin& coin : txundo.vprevout) {
+        nDelta -= coin.out.nValue;
+    }
+    return nDelta;
+}
+
 bool CScriptCheck::operator()()
 {
     const CScript& scriptSig = ptxTo->vin[nIn].scriptSig;
@@ -1160,7 +1194,7 @@ bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoins
 }
 }// namespace Consensus
 
-bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& precomTxData, std::vector<CScriptCheck> *pvChecks)
+bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& precomTxData, std::vector<CBlockCheck> *pvChecks)
 {
     if (!tx.IsCoinBase() && !tx.HasZerocoinSpendInputs()) {
 
@@ -1192,8 +1226,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
                 // Verify signature
                 CScriptCheck check(coin.out, tx, i, flags, cacheStore, &precomTxData);
                 if (pvChecks) {
-                    pvChecks->emplace_back();
-                    check.swap(pvChecks->back());
+                    pvChecks->emplace_back(check);
                 } else if (!check()) {
                     if (flags & STANDARD_NOT_MANDATORY_VERIFY_FLAGS) {
                         // Check whether the failure was caused by a
@@ -1270,6 +1303,8 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, FlatFilePos& pos, const uint25
     return true;
 }
 
+} // anon namespace
+
 bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& hashBlock)
 {
     // Open history file to read
@@ -1295,8 +1330,6 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint2
     return true;
 }
 
-} // anon namespace
-
 enum DisconnectResult
 {
     DISCONNECT_OK,      // All good.
@@ -1355,6 +1388,7 @@ DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoin
     }
 
     bool fClean = true;
+    CAmount nSupplyDelta = 0;
 
     CBlockUndo blockUndo;
     FlatFilePos pos = pindex->GetUndoPos();
@@ -1398,6 +1432,9 @@ DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoin
                 if (tx.vout[o] != coin.out) {
                     fClean = false; // transaction output mismatch
                 }
+                if (!coin.IsSpent()) {
+                    nSupplyDelta -= coin.out.nValue;
+                }
             }
         }
 
@@ -1417,6 +1454,7 @@ DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoin
         }
         for (unsigned int j = tx.vin.size(); j-- > 0;) {
             const COutPoint& out = tx.vin[j].prevout;
+            nSupplyDelta += txundo.vprevout[j].out.nValue;
             int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
             if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
             fClean = fClean && res != DISCONNECT_UNCLEAN;
@@ -1469,6 +1507,10 @@ DisconnectResult DisconnectBlock(CBlock& block, const CBlockIndex* pindex, CCoin
         }
     }
 
+    if (!fJustCheck) {
+        MoneySupply.Add(nSupplyDelta, pindex->nHeight - 1);
+    }
+
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
@@ -1489,7 +1531,7 @@ void static FlushBlockFile(bool fFinalize = false)
 
 bool FindUndoPos(CValidationState& state, int nFile, FlatFilePos& pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+static CCheckQueue<CBlockCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck()
 {
@@ -1497,6 +1539,73 @@ void ThreadScriptCheck()
     scriptcheckqueue.Thread();
 }
 
+bool CBlockCheck::operator()()
+{
+    switch (kind) {
+    case Kind::SCRIPT:
+        return scriptCheck();
+    case Kind::SAPLING_PROOF:
+        return proofCheck();
+    case Kind::KHU_TX:
+        // Always true: a failed parse is reported by the serial apply step
+        PrecheckKHUTransaction(*ptx, *pkhuPrecheck);
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool RunBlockChecks(std::vector<CBlockCheck>& vChecks)
+{
+    if (!nScriptCheckThreads) {
+        for (CBlockCheck& check : vChecks) {
+            if (!check()) {
+                return false;
+            }
+        }
+        return true;
+    }
+    CCheckQueueControl<CBlockCheck> control(&scriptcheckqueue);
+    control.Add(vChecks);
+    return control.Wait();
+}
+
+/** Run the deferred Sapling proof checks of a block, in parallel when script check threads are running */
+static bool CheckSaplingProofs(std::vector<SaplingValidation::CProofCheck>& vChecks, CValidationState& state)
+{
+    if (vChecks.empty()) {
+        return true;
+    }
+
+    // The queue only reports pass/fail: keep the outcome of each check to set the exact reject reason
+    std::vector<SaplingValidation::ProofError> vErrors(vChecks.size(), SaplingValidation::ProofError::NONE);
+    std::vector<int> vDoSLevels(vChecks.size());
+    for (size_t i = 0; i < vChecks.size(); i++) {
+        vChecks[i].SetErrorOutput(&vErrors[i]);
+        vDoSLevels[i] = vChecks[i].GetDoSLevel();
+    }
+
+    // AcceptBlock and TestBlockValidity run ContextualCheckBlock outside of
+    // ConnectBlock: the script check queue is free
+    std::vector<CBlockCheck> vBlockChecks;
+    vBlockChecks.reserve(vChecks.size());
+    for (SaplingValidation::CProofCheck& check : vChecks) {
+        vBlockChecks.emplace_back(check);
+    }
+    if (RunBlockChecks(vBlockChecks)) {
+        return true;
+    }
+
+    // First failure in block order (workers stop picking up checks after one fails)
+    for (size_t i = 0; i < vErrors.size(); i++) {
+        if (vErrors[i] != SaplingValidation::ProofError::NONE) {
+            return SaplingValidation::InvalidProofs(vErrors[i], state, vDoSLevels[i]);
+        }
+    }
+    return state.DoS(100, error("%s: Sapling proof verification failed", __func__),
+                     REJECT_INVALID, "bad-txns-sapling-proof-invalid");
+}
+
 static int64_t nTimeVerify = 0;
 static int64_t nTimeProcessSpecial = 0;
 static int64_t nTimeConnect = 0;
@@ -1542,22 +1651,18 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (isV6UpgradeEnforced && pindex->pprev) {
         // Check if the block we're building on (12 blocks back) has a ChainLock
         const int FINALITY_DEPTH = 12;
-        CBlockIndex* pindexCheck = pindex->pprev;
-        int depth = 0;
-
-        // Walk back to find block at FINALITY_DEPTH
-        while (pindexCheck && depth < FINALITY_DEPTH) {
-            pindexCheck = pindexCheck->pprev;
-            depth++;
-        }
+        // Final part of the chain being extended, not of the active one (reorgs)
+        const int nFinalizedHeight = llmq::chainLocksHandler->GetFinalizedHeight(pindex->pprev);
+        const CBlockIndex* pindexCheck = pindex->pprev->nHeight >= FINALITY_DEPTH ?
+                                         pindex->pprev->GetAncestor(pindex->pprev->nHeight - FINALITY_DEPTH) : nullptr;
 
         // If we have 12+ blocks of history after V6, enforce ChainLock on ancestors
-        if (pindexCheck && depth == FINALITY_DEPTH &&
-            consensus.NetworkUpgradeActive(pindexCheck->nHeight, Consensus::UPGRADE_V6_0)) {
+        if (pindexCheck && consensus.NetworkUpgradeActive(pindexCheck->nHeight, Consensus::UPGRADE_V6_0)) {
 
             // Check if the block at FINALITY_DEPTH has a ChainLock
             // Only enforce if ChainLocks spork is active OR if we're past V6 + 12
-            if (sporkManager.IsSporkActive(SPORK_23_CHAINLOCKS_ENFORCEMENT)) {
+            // (pindexCheck is an ancestor of the best ChainLock up to nFinalizedHeight)
+            if (sporkManager.IsSporkActive(SPORK_23_CHAINLOCKS_ENFORCEMENT) && pindexCheck->nHeight > nFinalizedHeight) {
                 if (!llmq::chainLocksHandler->HasChainLock(pindexCheck->nHeight, pindexCheck->GetBlockHash())) {
                     // Don't reject during initial sync - only warn
                     if (g_tiertwo_sync_state.IsSynced()) {
@@ -1570,6 +1675,13 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                 }
             }
         }
+
+        // Finalized heights can't be disconnected anymore: let the KHU state DB prune below them
+        if (!fJustCheck) {
+            if (CKHUStateDB* khudb = GetKHUStateDB()) {
+                khudb->SetFinalizedHeight(nFinalizedHeight);
+            }
+        }
     }
 
     // Coinbase output should be empty if proof-of-stake block (before v6 enforcement)
@@ -1627,7 +1739,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         exchangeAddrActivated = consensus.NetworkUpgradeActive(pindex->pprev->nHeight, Consensus::UPGRADE_V5_6);
     }
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CBlockCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
 
     int64_t nTimeStart = GetTimeMicros();
     CAmount nFees = 0;
@@ -1641,6 +1753,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
     CAmount nValueOut = 0;
     CAmount nValueIn = 0;
+    CAmount nSupplyDelta = 0;
     unsigned int nMaxBlockSigOps = MAX_BLOCK_SIGOPS_CURRENT;
 
     // Sapling
@@ -1698,7 +1811,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
                 nFees += txValueIn - txValueOut;
             nValueIn += txValueIn;
 
-            std::vector<CScriptCheck> vChecks;
+            std::vector<CBlockCheck> vChecks;
             unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_DERSIG;
             if (fCLTVIsActivated)
                 flags |= SCRIPT_VERIFY_CHECKLOCKTIMEVERIFY;
@@ -1717,7 +1830,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
             blockundo.vtxundo.emplace_back();
         }
         const bool fSkipInvalid = SkipInvalidUTXOS(pindex->nHeight);
-        UpdateCoins(tx, view, i == 0 ? undoDummy : blockundo.vtxundo.back(), pindex->nHeight, fSkipInvalid);
+        CTxUndo& txundo = i == 0 ? undoDummy : blockundo.vtxundo.back();
+        UpdateCoins(tx, view, txundo, pindex->nHeight, fSkipInvalid);
+        nSupplyDelta += GetTxSupplyDelta(tx, txundo, fSkipInvalid);
 
         // Sapling update tree
         if (tx.IsShieldedTx() && !tx.sapData->vShieldedOutput.empty()) {
@@ -1794,7 +1909,7 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     LogPrint(BCLog::BENCHMARK, "    - Process special tx: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeProcessSpecial * 0.000001);
 
     // KHU: Process KHU state transitions (Phase 1+ - runs for both fJustCheck and !fJustCheck)
-    // When fJustCheck=true: validates without persisting to DB
+    // When fJustCheck=true: applies the block to a scratch KHU overlay, nothing persisted
     // When fJustCheck=false: validates and persists to DB
     if (consensus.NetworkUpgradeActive(pindex->nHeight, Consensus::UPGRADE_V6_0)) {
         LogPrint(BCLog::KHU, "ConnectBlock: Calling ProcessKHUBlock height=%d fJustCheck=%d\n",
@@ -1810,6 +1925,13 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     if (fJustCheck)
         return true;
 
+    // The proofs of the connected transactions won't be verified again
+    for (const auto& tx : block.vtx) {
+        if (tx->IsShieldedTx()) {
+            SaplingValidation::EraseCachedProofs(*tx);
+        }
+    }
+
     // Write undo information to disk
     if (pindex->GetUndoPos().IsNull() || !pindex->IsValid(BLOCK_VALID_SCRIPTS)) {
         if (pindex->GetUndoPos().IsNull()) {
@@ -1859,6 +1981,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         ZPIVModule::CleanCoinSpendsCache();
     }
 
+    // Keep the cached money supply current, no utxo set scan needed
+    MoneySupply.Add(nSupplyDelta, pindex->nHeight);
+
     // 100 blocks after the last invalid out, clean the map contents
     if (pindex->nHeight == consensus.height_last_invalid_UTXO + 100) {
         invalid_out::setInvalidOutPoints.clear();
@@ -1874,7 +1999,6 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
  * Update the on-disk chain state.
  * The caches and indexes are flushed if either they're too large, forceWrite is set, or
  * fast is not set and it's been a while since the last write.
- * Full flush also updates the money supply from disk (except during shutdown)
  */
 bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
 {
@@ -1906,13 +2030,15 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
         bool fCacheCritical = mode == FLUSH_STATE_IF_NEEDED && (unsigned) cacheSize > nCoinCacheUsage;
         // The evoDB cache is too large, time to write
         bool fEvoDbCacheCritical = mode == FLUSH_STATE_IF_NEEDED && evoDb != nullptr && evoDb->GetMemoryUsage() >= (64 << 20);
+        // The KHU DBs pending writes are too large, time to write
+        bool fKHUDbCacheCritical = mode == FLUSH_STATE_IF_NEEDED && GetKHUDBMemoryUsage() >= (64 << 20);
         // It's been a while since we wrote the block index to disk.
         // Do this frequently, so we don't need to redownload after a crash.
         bool fPeriodicWrite = mode == FLUSH_STATE_PERIODIC && nNow > nLastWrite + (int64_t)DATABASE_WRITE_INTERVAL * 1000000;
         // It's been very long since we flushed the cache. Do this infrequently, to optimize cache usage.
         bool fPeriodicFlush = mode == FLUSH_STATE_PERIODIC && nNow > nLastFlush + (int64_t)DATABASE_FLUSH_INTERVAL * 1000000;
         // Combine all conditions that result in a full cache flush.
-        bool fDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || fCacheLarge || fCacheCritical || fEvoDbCacheCritical || fPeriodicFlush;
+        bool fDoFullFlush = (mode == FLUSH_STATE_ALWAYS) || fCacheLarge || fCacheCritical || fEvoDbCacheCritical || fKHUDbCacheCritical || fPeriodicFlush;
         // Write blocks and block index to disk.
         if (fDoFullFlush || fPeriodicWrite) {
             // Depend on nMinDiskSpace to ensure we can write block index
@@ -1961,11 +2087,10 @@ bool static FlushStateToDisk(CValidationState& state, FlushStateMode mode)
             if (!evoDb->CommitRootTransaction()) {
                 return AbortNode(state, "Failed to commit EvoDB");
             }
-            nLastFlush = nNow;
-            // Update money supply on memory, reading data from disk
-            if (!ShutdownRequested() && !IsInitialBlockDownload()) {
-                MoneySupply.Update(pcoinsTip->GetTotalAmount(), chainActive.Height());
+            if (!CommitKHURootTransactions()) {
+                return AbortNode(state, "Failed to commit KHU databases");
             }
+            nLastFlush = nNow;
         }
         if ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000) {
             // Update best block in wallet (so we can detect restored wallets).
@@ -2059,6 +2184,8 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
     int64_t nStart = GetTimeMicros();
     {
         auto dbTx = evoDb->BeginTransaction();
+        auto khuDbTx = BeginKHUTransaction();
+        CKHUCoinsViewScope khuCoinsView;
 
         CCoinsViewCache view(pcoinsTip.get());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
@@ -2066,7 +2193,10 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
             return error("DisconnectTip() : DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
+        flushed = khuCoinsView.Flush();
+        assert(flushed);
         dbTx->Commit();
+        khuDbTx->Commit();
     }
     LogPrint(BCLog::BENCHMARK, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     const uint256& saplingAnchorAfterDisconnect = pcoinsTip->GetBestAnchor();
@@ -2100,6 +2230,8 @@ bool static DisconnectTip(CValidationState& state, const CChainParams& chainpara
 
     // Update MN manager cache
     deterministicMNManager->SetTipIndex(pindexDelete->pprev);
+    // Lock free KHU state for mempool and RPC readers
+    PublishKHUTipState(pindexDelete->pprev);
     // replace the cached hash of pindexDelete with the hash of the block
     // at depth CACHED_BLOCK_HASHES if it exists, or empty hash otherwise.
     if ((unsigned) pindexDelete->nHeight >= CACHED_BLOCK_HASHES) {
@@ -2189,6 +2321,8 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
     LogPrint(BCLog::BENCHMARK, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * 0.001, nTimeReadFromDisk * 0.000001);
     {
         auto dbTx = evoDb->BeginTransaction();
+        auto khuDbTx = BeginKHUTransaction();
+        CKHUCoinsViewScope khuCoinsView;
 
         CCoinsViewCache view(pcoinsTip.get());
         bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, false);
@@ -2203,7 +2337,10 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
         LogPrint(BCLog::BENCHMARK, "  - Connect total: %.2fms [%.2fs]\n", (nTime3 - nTime2) * 0.001, nTimeConnectTotal * 0.000001);
         bool flushed = view.Flush();
         assert(flushed);
+        flushed = khuCoinsView.Flush();
+        assert(flushed);
         dbTx->Commit();
+        khuDbTx->Commit();
     }
     int64_t nTime4 = GetTimeMicros();
     nTimeFlush += nTime4 - nTime3;
@@ -2224,6 +2361,8 @@ bool static ConnectTip(CValidationState& state, CBlockIndex* pindexNew, const st
     disconnectpool.removeForBlock(blockConnecting.vtx);
     // Update chainActive & related variables.
     UpdateTip(pindexNew);
+    // Lock free KHU state for mempool and RPC readers
+    PublishKHUTipState(pindexNew);
     // Update TierTwo managers
     mnodeman.SetBestHeight(pindexNew->nHeight);
     g_budgetman.SetBestHeight(pindexNew->nHeight);
@@ -3094,11 +3233,14 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIn
     const int nHeight = pindexPrev == nullptr ? 0 : pindexPrev->nHeight + 1;
     const CChainParams& chainparams = Params();
 
+    // Sapling proofs of all the transactions, verified together once the cheap checks passed
+    std::vector<SaplingValidation::CProofCheck> vSaplingChecks;
+
     // Check that all transactions are finalized
     for (const auto& tx : block.vtx) {
 
         // Check transaction contextually against consensus rules at block height
-        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true /* isMined */, IsInitialBlockDownload())) {
+        if (!ContextualCheckTransaction(tx, state, chainparams, nHeight, true /* isMined */, IsInitialBlockDownload(), &vSaplingChecks)) {
             return false;
         }
 
@@ -3107,6 +3249,10 @@ bool ContextualCheckBlock(const CBlock& block, CValidationState& state, CBlockIn
         }
     }
 
+    if (!CheckSaplingProofs(vSaplingChecks, state)) {
+        return false;
+    }
+
     // Enforce block.nVersion=2 rule that the coinbase starts with serialized block height
     if (pindexPrev) { // pindexPrev is only null on the first block which is a version 1 block.
         CScript expect = CScript() << nHeight;
@@ -3600,6 +3746,8 @@ bool TestBlockValidity(CValidationState& state, const CBlock& block, CBlockIndex
 
     // begin tx and let it rollback
     auto dbTx = evoDb->BeginTransaction();
+    auto khuDbTx = BeginKHUTransaction();
+    CKHUCoinsViewScope khuCoinsView;
 
     // NOTE: CheckBlockHeader is called by CheckBlock
     if (!ContextualCheckBlockHeader(block, state, pindexPrev))
@@ -3640,10 +3788,8 @@ fs::path GetBlockPosFilename(const FlatFilePos &pos)
     return BlockFileSeq().FileName(pos);
 }
 
-CBlockIndex* InsertBlockIndex(const uint256& hash)
+static CBlockIndex* InsertBlockIndexUnlocked(const uint256& hash)
 {
-    AssertLockHeld(cs_main);
-
     if (hash.IsNull())
         return nullptr;
 
@@ -3661,33 +3807,74 @@ CBlockIndex* InsertBlockIndex(const uint256& hash)
     return pindexNew;
 }
 
+CBlockIndex* InsertBlockIndex(const uint256& hash)
+{
+    AssertLockHeld(cs_main);
+    return InsertBlockIndexUnlocked(hash);
+}
+
 bool static LoadBlockIndexDB(std::string& strError) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     AssertLockHeld(cs_main);
 
-    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndex))
+    int64_t nStart = GetTimeMillis();
+    // The loading threads insert one at a time, while this thread holds cs_main for them
+    if (!pblocktree->LoadBlockIndexGuts(InsertBlockIndexUnlocked))
         return false;
+    int64_t nNow = GetTimeMillis();
+    LogPrint(BCLog::BENCHMARK, "%s: block index entries loaded in %dms\n", __func__, nNow - nStart);
+    nStart = nNow;
 
     boost::this_thread::interruption_point();
 
-    // Calculate nChainWork
-    std::vector<std::pair<int, CBlockIndex*> > vSortedByHeight;
-    vSortedByHeight.reserve(mapBlockIndex.size());
+    // Sort by height, one bucket per height
+    int nMaxHeight = 0;
     for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
         CBlockIndex* pindex = item.second;
-        vSortedByHeight.emplace_back(pindex->nHeight, pindex);
+        nMaxHeight = std::max(nMaxHeight, pindex->nHeight);
         // build mapPrevBlockIndex
         if (pindex->pprev) {
             mapPrevBlockIndex.emplace(pindex->pprev->GetBlockHash(), pindex);
         }
     }
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end());
-    for (const std::pair<int, CBlockIndex*>& item : vSortedByHeight) {
+    std::vector<size_t> vBucketEnd(nMaxHeight + 2, 0);
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+        vBucketEnd[item.second->nHeight + 1]++;
+    }
+    for (size_t i = 1; i < vBucketEnd.size(); i++) {
+        vBucketEnd[i] += vBucketEnd[i - 1];
+    }
+    std::vector<CBlockIndex*> vSortedByHeight(mapBlockIndex.size());
+    for (const std::pair<const uint256, CBlockIndex*>& item : mapBlockIndex) {
+        vSortedByHeight[vBucketEnd[item.second->nHeight]++] = item.second;
+    }
+
+    // The proof of each block does not depend on its ancestors: computed by height ranges in parallel
+    std::vector<arith_uint256> vBlockProof(vSortedByHeight.size());
+    {
+        const size_t nThreads = std::max(1, std::min(GetNumCores(), MAX_BLOCK_INDEX_LOAD_THREADS));
+        const size_t nChunk = vSortedByHeight.size() / nThreads + 1;
+        std::vector<std::thread> vThreads;
+        for (size_t nBegin = 0; nBegin < vSortedByHeight.size(); nBegin += nChunk) {
+            const size_t nEnd = std::min(nBegin + nChunk, vSortedByHeight.size());
+            vThreads.emplace_back([&vSortedByHeight, &vBlockProof, nBegin, nEnd] {
+                for (size_t i = nBegin; i < nEnd; i++) {
+                    vBlockProof[i] = GetBlockProof(*vSortedByHeight[i]);
+                }
+            });
+        }
+        for (std::thread& t : vThreads) {
+            t.join();
+        }
+    }
+
+    // Calculate nChainWork
+    for (size_t i = 0; i < vSortedByHeight.size(); i++) {
         // Stop if shutdown was requested
         if (ShutdownRequested()) return false;
 
-        CBlockIndex* pindex = item.second;
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + GetBlockProof(*pindex);
+        CBlockIndex* pindex = vSortedByHeight[i];
+        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) + vBlockProof[i];
         pindex->nTimeMax = (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime) : pindex->nTime);
         if (pindex->nStatus & BLOCK_HAVE_DATA) {
             if (pindex->pprev) {
@@ -3720,6 +3907,10 @@ bool static LoadBlockIndexDB(std::string& strError) EXCLUSIVE_LOCKS_REQUIRED(cs_
             pindexBestHeader = pindex;
     }
 
+    nNow = GetTimeMillis();
+    LogPrint(BCLog::BENCHMARK, "%s: chain work of %u blocks computed in %dms\n", __func__, vSortedByHeight.size(), nNow - nStart);
+    nStart = nNow;
+
     // Load block file info
     pblocktree->ReadLastBlockFile(nLastBlockFile);
     vinfoBlockFile.resize(nLastBlockFile + 1);
@@ -3753,6 +3944,8 @@ bool static LoadBlockIndexDB(std::string& strError) EXCLUSIVE_LOCKS_REQUIRED(cs_
         }
     }
 
+    LogPrint(BCLog::BENCHMARK, "%s: block files checked in %dms\n", __func__, GetTimeMillis() - nStart);
+
     //Check if the shutdown procedure was followed on last client exit
     bool fLastShutdownWasPrepared = true;
     pblocktree->ReadFlag("shutdown", fLastShutdownWasPrepared);
@@ -3827,6 +4020,8 @@ bool CVerifyDB::VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth
 
     // begin tx and let it rollback
     auto dbTx = evoDb->BeginTransaction();
+    auto khuDbTx = BeginKHUTransaction();
+    CKHUCoinsViewScope khuCoinsView;
 
     // Verify blocks in the best chain
     if (nCheckDepth <= 0)
@@ -3894,17 +4089,26 @@ bool CVerifyDB::VerifyDB(CCoinsView* coinsview, int nCheckLevel, int nCheckDepth
 
     // check level 4: try reconnecting blocks
     if (nCheckLevel >= 4) {
+        // The blocks were disconnected with fJustCheck (supply untouched): ConnectBlock adds
+        // their supply once more, restore the cached value once they are reconnected.
+        const CAmount nSupply = MoneySupply.Get();
+        const int nSupplyHeight = MoneySupply.GetCacheHeight();
         CBlockIndex* pindex = pindexState;
         while (pindex != chainActive.Tip()) {
             boost::this_thread::interruption_point();
             uiInterface.ShowProgress(_("Verifying blocks..."), std::max(1, std::min(99, 100 - (int)(((double)(chainHeight - pindex->nHeight)) / (double)nCheckDepth * 50))));
             pindex = chainActive.Next(pindex);
             CBlock block;
-            if (!ReadBlockFromDisk(block, pindex))
+            if (!ReadBlockFromDisk(block, pindex)) {
+                MoneySupply.Update(nSupply, nSupplyHeight);
                 return error("%s: *** ReadBlockFromDisk failed at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
-            if (!ConnectBlock(block, state, pindex, coins, false))
+            }
+            if (!ConnectBlock(block, state, pindex, coins, false)) {
+                MoneySupply.Update(nSupply, nSupplyHeight);
                 return error("%s: *** found unconnectable block at %d, hash=%s", __func__, pindex->nHeight, pindex->GetBlockHash().ToString());
+            }
         }
+        MoneySupply.Update(nSupply, nSupplyHeight);
     }
     LogPrintf("[DONE].\n");
     LogPrintf("No coin database inconsistencies in last %i blocks (%i transactions)\n", chainHeight - pindexState->nHeight, nGoodTransactions);
@@ -4019,6 +4223,7 @@ void UnloadBlockIndex()
     LOCK(cs_main);
     setBlockIndexCandidates.clear();
     chainActive.SetTip(nullptr);
+    PublishKHUTipState(nullptr);
     pindexBestInvalid = nullptr;
     pindexBestHeader = nullptr;
     mempool.clear();
@@ -22,6 +22,7 @@
 #include "fs.h"
 #include "moneysupply.h"
 #include "policy/feerate.h"
+#include "sapling/sapling_validation.h"
 #include "script/script_error.h"
 #include "sync.h"
 #include "txmempool.h"
@@ -40,6 +41,7 @@
 class AccumulatorCache;
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CBudgetManager;
 class CCoinsViewDB;
 class CZerocoinDB;
@@ -48,6 +50,7 @@ class CBloomFilter;
 class CInv;
 class CConnman;
 class CNode;
+class CBlockCheck;
 class CScriptCheck;
 
 struct PrecomputedTransactionData;
@@ -250,7 +253,7 @@ CAmount GetShieldedTxMinFee(const CTransaction& tx);
  * This does not modify the UTXO set. If pvChecks is not nullptr, script checks are pushed onto it
  * instead of being performed inline.
  */
-bool CheckInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& view, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& precomTxData, std::vector<CScriptCheck>* pvChecks = nullptr);
+bool CheckInputs(const CTransaction& tx, CValidationState& state, const CCoinsViewCache& view, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& precomTxData, std::vector<CBlockCheck>* pvChecks = nullptr);
 
 /** Apply the effects of this transaction on the UTXO set represented by view */
 void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight, bool fSkipInvalid = false);
@@ -307,11 +310,64 @@ public:
     ScriptError GetScriptError() const { return error; }
 };
 
+struct CKHUTxPrecheck;
+
+/**
+ * Closure run by the script check workers (-par): a script check, a Sapling
+ * proof check, or the stateless pre-validation of a KHU transaction. The
+ * steps of block validation share one worker pool, each being the master of
+ * the queue in turn (under cs_main).
+ */
+class CBlockCheck
+{
+public:
+    enum class Kind : uint8_t {
+        NONE,
+        SCRIPT,
+        SAPLING_PROOF,
+        KHU_TX,
+    };
+
+private:
+    Kind kind;
+    CScriptCheck scriptCheck;
+    SaplingValidation::CProofCheck proofCheck;
+    const CTransaction* ptx;
+    CKHUTxPrecheck* pkhuPrecheck;
+
+public:
+    CBlockCheck() : kind(Kind::NONE), ptx(nullptr), pkhuPrecheck(nullptr) {}
+    explicit CBlockCheck(CScriptCheck& check) : kind(Kind::SCRIPT), ptx(nullptr), pkhuPrecheck(nullptr) { scriptCheck.swap(check); }
+    explicit CBlockCheck(SaplingValidation::CProofCheck& check) : kind(Kind::SAPLING_PROOF), ptx(nullptr), pkhuPrecheck(nullptr) { proofCheck.swap(check); }
+    CBlockCheck(const CTransaction& txIn, CKHUTxPrecheck& precheckOut) : kind(Kind::KHU_TX), ptx(&txIn), pkhuPrecheck(&precheckOut) {}
+
+    bool operator()();
+
+    void swap(CBlockCheck& check)
+    {
+        std::swap(kind, check.kind);
+        scriptCheck.swap(check.scriptCheck);
+        proofCheck.swap(check.proofCheck);
+        std::swap(ptx, check.ptx);
+        std::swap(pkhuPrecheck, check.pkhuPrecheck);
+    }
+};
+
+/**
+ * Run checks on the script check workers, the calling thread joining them
+ * (inline without -par). The caller holds cs_main and has no other checks
+ * pending on the queue.
+ *
+ * @return true if all checks passed
+ */
+bool RunBlockChecks(std::vector<CBlockCheck>& vChecks);
+
 
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, FlatFilePos& pos);
 bool ReadBlockFromDisk(CBlock& block, const FlatFilePos& pos);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex);
+bool UndoReadFromDisk(CBlockUndo& blockundo, const FlatFilePos& pos, const uint256& hashBlock);
 
 
 /** Functions for validating blocks and updating the block tree */
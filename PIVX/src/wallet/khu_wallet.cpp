@@ -8,6 +8,7 @@
 #include "chainparams.h"
 #include "khu/khu_coins.h"
 #include "khu/khu_state.h"
+#include "khu/khu_txindex.h"
 #include "khu/khu_validation.h"
 #include "logging.h"
 #include "primitives/transaction.h"
@@ -18,6 +19,11 @@
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 
+#include <algorithm>
+#include <map>
+#include <set>
+#include <vector>
+
 // ============================================================================
 // Balance Functions
 // ============================================================================
@@ -388,66 +394,128 @@ void ProcessKHUTransactionForWallet(CWallet* pwallet, const CTransactionRef& tx,
     // Its inputs are already handled in STEP 1 above
 }
 
-bool ScanForKHUCoins(CWallet* pwallet, int nStartHeight)
+// Blocks listed per cs_main section of ScanForKHUCoins
+static const int KHU_RESCAN_CHUNK_SIZE = 1000;
+
+// Block ScanForKHUCoins has to read, with the txids to process if filtered
+struct KHURescanBlock
 {
-    LOCK2(cs_main, pwallet->cs_wallet);
+    const CBlockIndex* pindex;
+    bool fFiltered;
+    std::set<uint256> setTxids;
+};
 
+bool ScanForKHUCoins(CWallet* pwallet, int nStartHeight)
+{
     LogPrint(BCLog::KHU, "ScanForKHUCoins: Starting scan from height %d\n", nStartHeight);
 
-    // Clear existing KHU coins before full rescan
-    if (nStartHeight == 0) {
-        pwallet->khuData.Clear();
-        // Also clear from database
-        WalletBatch batch(pwallet->GetDBHandle());
-        // Note: Full clear would need cursor iteration; for now, coins are
-        // individually erased via RemoveKHUCoinFromWallet when spent
-    }
+    {
+        LOCK2(cs_main, pwallet->cs_wallet);
+        if (!chainActive[nStartHeight]) {
+            LogPrintf("ERROR: ScanForKHUCoins: Invalid start height %d\n", nStartHeight);
+            return false;
+        }
 
-    const CBlockIndex* pindex = chainActive[nStartHeight];
-    if (!pindex) {
-        LogPrintf("ERROR: ScanForKHUCoins: Invalid start height %d\n", nStartHeight);
-        return false;
+        // Clear existing KHU coins before full rescan
+        if (nStartHeight == 0) {
+            pwallet->khuData.Clear();
+            // Note: Full clear would need cursor iteration; for now, coins are
+            // individually erased via RemoveKHUCoinFromWallet when spent
+        }
     }
 
+    // No KHU transaction (hence no KHU coin to spend) before V6
+    const int nV6Height = Params().GetConsensus().vUpgrades[Consensus::UPGRADE_V6_0].nActivationHeight;
+    CKHUTxIndexDB* txindex = GetKHUTxIndexDB();
+
     int nScanned = 0;
+    int nRead = 0;
     int nKHUTxProcessed = 0;
-
-    while (pindex) {
-        CBlock block;
-        if (!ReadBlockFromDisk(block, pindex)) {
-            LogPrintf("ERROR: ScanForKHUCoins: Failed to read block at height %d\n", pindex->nHeight);
-            return false;
+    int nHeight = nStartHeight;
+
+    while (true) {
+        // List the blocks of the chunk under cs_main; read and apply them without it
+        std::vector<KHURescanBlock> vBlocks;
+        int nLast;
+        {
+            LOCK(cs_main);
+            const int nTipHeight = chainActive.Height();
+            if (nHeight > nTipHeight) break;
+            nLast = std::min(nHeight + KHU_RESCAN_CHUNK_SIZE - 1, nTipHeight);
+
+            std::map<int, CKHUTxIndexEntry> mapIndexed;
+            if (txindex) {
+                txindex->GetBlocks(nHeight, nLast, mapIndexed);
+            }
+            for (int h = std::max(nHeight, nV6Height); h <= nLast; h++) {
+                const CBlockIndex* pindex = chainActive[h];
+                if (!txindex || !txindex->IsCovered(h, nV6Height)) {
+                    vBlocks.push_back({pindex, false, {}});
+                    continue;
+                }
+                auto it = mapIndexed.find(h);
+                if (it == mapIndexed.end()) {
+                    continue;
+                }
+                if (it->second.hashBlock != pindex->GetBlockHash()) {
+                    // Indexed while the chain was moving, read it all
+                    vBlocks.push_back({pindex, false, {}});
+                    continue;
+                }
+                vBlocks.push_back({pindex, true, std::set<uint256>(it->second.vTxids.begin(), it->second.vTxids.end())});
+            }
         }
 
-        for (const auto& tx : block.vtx) {
-            // Process ALL transactions to detect:
-            // 1. KHU-specific transactions (MINT, REDEEM, STAKE, UNSTAKE)
-            // 2. Regular transactions that spend our tracked KHU UTXOs (via khusend)
-            bool isKHUTx = (tx->nType >= CTransaction::TxType::KHU_MINT &&
-                           tx->nType <= CTransaction::TxType::KHU_UNSTAKE);
-
-            // For non-KHU transactions, only process if we have KHU coins
-            // that might be spent (optimization)
-            if (isKHUTx || !pwallet->khuData.mapKHUCoins.empty()) {
-                ProcessKHUTransactionForWallet(pwallet, tx, pindex->nHeight);
-                if (isKHUTx) nKHUTxProcessed++;
+        int nNextHeight = nLast + 1;
+        for (const KHURescanBlock& rescanBlock : vBlocks) {
+            const CBlockIndex* pindex = rescanBlock.pindex;
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pindex)) {
+                LogPrintf("ERROR: ScanForKHUCoins: Failed to read block at height %d\n", pindex->nHeight);
+                return false;
             }
-        }
+            nRead++;
 
-        nScanned++;
-        if (nScanned % 10000 == 0) {
-            LogPrint(BCLog::KHU, "ScanForKHUCoins: Scanned %d blocks (height %d), %d KHU coins tracked\n",
-                     nScanned, pindex->nHeight, pwallet->khuData.mapKHUCoins.size());
+            LOCK2(cs_main, pwallet->cs_wallet);
+            if (!chainActive.Contains(pindex)) {
+                // Reorganized meanwhile, list the chunk again from the fork
+                nNextHeight = pindex->nHeight;
+                break;
+            }
+            for (const auto& tx : block.vtx) {
+                if (rescanBlock.fFiltered && !rescanBlock.setTxids.count(tx->GetHash())) {
+                    continue;
+                }
+                // Process ALL transactions to detect:
+                // 1. KHU-specific transactions (MINT, REDEEM, STAKE, UNSTAKE)
+                // 2. Regular transactions that spend our tracked KHU UTXOs (via khusend)
+                bool isKHUTx = (tx->nType >= CTransaction::TxType::KHU_MINT &&
+                               tx->nType <= CTransaction::TxType::KHU_UNSTAKE);
+
+                // For non-KHU transactions, only process if we have KHU coins
+                // that might be spent (optimization)
+                if (isKHUTx || !pwallet->khuData.mapKHUCoins.empty()) {
+                    ProcessKHUTransactionForWallet(pwallet, tx, pindex->nHeight);
+                    if (isKHUTx) nKHUTxProcessed++;
+                }
+            }
         }
 
-        pindex = chainActive.Next(pindex);
+        nScanned += nNextHeight - nHeight;
+        if (nNextHeight > nHeight) {
+            LogPrint(BCLog::KHU, "ScanForKHUCoins: Scanned %d blocks (height %d), read %d, %d KHU coins tracked\n",
+                     nScanned, nNextHeight - 1, nRead, WITH_LOCK(pwallet->cs_wallet, return pwallet->khuData.mapKHUCoins.size()));
+        }
+        nHeight = nNextHeight;
     }
 
+    LOCK(pwallet->cs_wallet);
+
     // Update final balances
     pwallet->khuData.UpdateBalance();
 
-    LogPrint(BCLog::KHU, "ScanForKHUCoins: Complete. Scanned %d blocks, %d KHU tx, found %d coins, balance=%d\n",
-             nScanned, nKHUTxProcessed, pwallet->khuData.mapKHUCoins.size(), pwallet->khuData.nKHUBalance);
+    LogPrint(BCLog::KHU, "ScanForKHUCoins: Complete. Scanned %d blocks (read %d), %d KHU tx, found %d coins, balance=%d\n",
+             nScanned, nRead, nKHUTxProcessed, pwallet->khuData.mapKHUCoins.size(), pwallet->khuData.nKHUBalance);
 
     return true;
 }
@@ -669,3 +737,147 @@ void ProcessKHUUnstakeForWallet(CWallet* pwallet, const CTransactionRef& tx)
         MarkZKHUNoteSpent(pwallet, spend.nullifier);
     }
 }
+
+// ============================================================================
+// ZKHU Witness Cache
+// ============================================================================
+
+void IncrementZKHUNoteWitnesses(CWallet* pwallet, const CBlockIndex* pindex,
+                                const CBlock* pblock, SaplingMerkleTree saplingTree)
+{
+    LOCK(pwallet->cs_wallet);
+
+    KHUWalletData& khuData = pwallet->khuData;
+    if (khuData.mapZKHUNotes.empty()) return;
+
+    const int nHeight = pindex->nHeight;
+
+    // 1) Copy the previous witness of every unspent note that is exactly one block behind.
+    //    Notes witnessed at nHeight already (crash between witness flush and block index
+    //    flush) are left untouched, stale caches are dropped and rebuilt on demand.
+    std::vector<ZKHUWitnessData*> vActive;
+    for (auto it = khuData.mapZKHUWitnesses.begin(); it != khuData.mapZKHUWitnesses.end();) {
+        ZKHUWitnessData& wd = it->second;
+        auto noteIt = khuData.mapZKHUNotes.find(it->first);
+        if (noteIt == khuData.mapZKHUNotes.end() || wd.witnesses.empty() ||
+            (wd.witnessHeight != nHeight - 1 && wd.witnessHeight != nHeight)) {
+            khuData.MarkZKHUWitnessErased(it->first);
+            it = khuData.mapZKHUWitnesses.erase(it);
+            continue;
+        }
+        if (wd.witnessHeight == nHeight - 1 && !noteIt->second.fSpent) {
+            wd.witnesses.push_front(wd.witnesses.front());
+            if (wd.witnesses.size() > WITNESS_CACHE_SIZE) {
+                wd.witnesses.pop_back();
+            }
+            vActive.emplace_back(&wd);
+            khuData.MarkZKHUWitnessDirty(it->first);
+        }
+        ++it;
+    }
+
+    // 2) Append the block note commitments in order, witnessing our new notes on arrival
+    for (const auto& tx : pblock->vtx) {
+        if (!tx->IsShieldedTx() || !tx->sapData) continue;
+
+        for (const OutputDescription& output : tx->sapData->vShieldedOutput) {
+            const uint256& cmu = output.cmu;
+            for (ZKHUWitnessData* wd : vActive) {
+                wd->witnesses.front().append(cmu);
+            }
+            saplingTree.append(cmu);
+
+            if (tx->nType != CTransaction::TxType::KHU_STAKE) continue;
+            if (!khuData.mapZKHUNotes.count(cmu) || khuData.mapZKHUWitnesses.count(cmu)) continue;
+
+            ZKHUWitnessData& wd = khuData.mapZKHUWitnesses[cmu];
+            khuData.MarkZKHUWitnessDirty(cmu);
+            wd.witnesses.push_front(saplingTree.witness());
+            vActive.emplace_back(&wd);
+
+            LogPrint(BCLog::KHU, "%s: witnessing ZKHU note cm=%s at height %d\n",
+                     __func__, cmu.GetHex().substr(0, 16), nHeight);
+        }
+    }
+
+    // 3) Set last processed height
+    for (ZKHUWitnessData* wd : vActive) {
+        wd->witnessHeight = nHeight;
+    }
+}
+
+void DecrementZKHUNoteWitnesses(CWallet* pwallet, int nHeight)
+{
+    LOCK(pwallet->cs_wallet);
+
+    KHUWalletData& khuData = pwallet->khuData;
+    for (auto it = khuData.mapZKHUWitnesses.begin(); it != khuData.mapZKHUWitnesses.end();) {
+        ZKHUWitnessData& wd = it->second;
+        if (wd.witnessHeight == nHeight) {
+            if (!wd.witnesses.empty()) {
+                wd.witnesses.pop_front();
+            }
+            wd.witnessHeight = nHeight - 1;
+            khuData.MarkZKHUWitnessDirty(it->first);
+        }
+        // Note arrived in the disconnected block, or cache exhausted by a deep reorg
+        if (wd.witnesses.empty()) {
+            khuData.MarkZKHUWitnessErased(it->first);
+            it = khuData.mapZKHUWitnesses.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
+bool GetZKHUNoteWitness(const CWallet* pwallet, const uint256& cm, int nTipHeight,
+                        SaplingWitness& witnessOut, uint256& anchorOut)
+{
+    LOCK(pwallet->cs_wallet);
+
+    auto it = pwallet->khuData.mapZKHUWitnesses.find(cm);
+    if (it == pwallet->khuData.mapZKHUWitnesses.end()) {
+        return false;
+    }
+    const ZKHUWitnessData& wd = it->second;
+    if (wd.witnesses.empty() || wd.witnessHeight != nTipHeight) {
+        LogPrint(BCLog::KHU, "%s: stale witness for cm=%s (witnessHeight=%d, tip=%d)\n",
+                 __func__, cm.GetHex().substr(0, 16), wd.witnessHeight, nTipHeight);
+        return false;
+    }
+
+    witnessOut = wd.witnesses.front();
+    anchorOut = witnessOut.root();
+    return true;
+}
+
+void SetZKHUNoteWitness(CWallet* pwallet, const uint256& cm, int nHeight, const SaplingWitness& witness)
+{
+    LOCK(pwallet->cs_wallet);
+
+    ZKHUWitnessData& wd = pwallet->khuData.mapZKHUWitnesses[cm];
+    pwallet->khuData.MarkZKHUWitnessDirty(cm);
+    wd.witnesses.clear();
+    wd.witnesses.push_front(witness);
+    wd.witnessHeight = nHeight;
+}
+
+bool WriteZKHUWitnessesToDB(CWallet* pwallet, WalletBatch& batch)
+{
+    LOCK(pwallet->cs_wallet);
+
+    const KHUWalletData& khuData = pwallet->khuData;
+    for (const uint256& cm : khuData.setZKHUWitnessesDirty) {
+        auto it = khuData.mapZKHUWitnesses.find(cm);
+        assert(it != khuData.mapZKHUWitnesses.end());
+        if (!batch.WriteZKHUWitness(cm, it->second)) {
+            return false;
+        }
+    }
+    for (const uint256& cm : khuData.setZKHUWitnessesErased) {
+        if (!batch.EraseZKHUWitness(cm)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -10,15 +10,21 @@
 #include "khu/khu_unstake.h" // For GetZKHUMaturityBlocks()
 #include "khu/zkhu_memo.h"
 #include "primitives/transaction.h"
+#include "sapling/incrementalmerkletree.h"
 #include "serialize.h"
 #include "uint256.h"
 #include "utiltime.h"
 
+#include <list>
 #include <map>
+#include <set>
 #include <vector>
 
+class CBlock;
+class CBlockIndex;
 class CWallet;
 class COutput;
+class WalletBatch;
 class CCoinsViewCache;
 
 /**
@@ -130,6 +136,28 @@ struct ZKHUNoteEntry {
     }
 };
 
+/**
+ * ZKHUWitnessData - Incremental witness cache for one ZKHU note
+ *
+ * Mirrors SaplingNoteData::witnesses/witnessHeight: the front witness is valid
+ * at witnessHeight, older entries allow rolling back up to WITNESS_CACHE_SIZE
+ * blocks. Advanced on every connected block so that UNSTAKE is a lookup,
+ * not a chain rescan. Persisted via wallet.dat (prefix "zkhuwitness").
+ */
+struct ZKHUWitnessData {
+    //! Witness cache, most recent first
+    std::list<SaplingWitness> witnesses;
+
+    //! Block height corresponding to witnesses.front() (-1 if never witnessed)
+    int witnessHeight{-1};
+
+    ZKHUWitnessData() = default;
+
+    SERIALIZE_METHODS(ZKHUWitnessData, obj) {
+        READWRITE(obj.witnesses, obj.witnessHeight);
+    }
+};
+
 /**
  * KHU Wallet Data Container
  *
@@ -147,6 +175,15 @@ public:
     //! Map of ZKHU nullifiers to note commitments (for spend detection)
     std::map<uint256, uint256> mapZKHUNullifiers;
 
+    //! Incremental witness cache for ZKHU notes: note_commitment -> witnesses
+    std::map<uint256, ZKHUWitnessData> mapZKHUWitnesses;
+
+    //! Witness caches changed since the last SetBestChain() flush (to write to wallet.dat)
+    std::set<uint256> setZKHUWitnessesDirty;
+
+    //! Witness caches dropped from memory since the last flush (to erase from wallet.dat)
+    std::set<uint256> setZKHUWitnessesErased;
+
     //! Cached KHU transparent balance
     CAmount nKHUBalance{0};
 
@@ -160,10 +197,25 @@ public:
         mapKHUCoins.clear();
         mapZKHUNotes.clear();
         mapZKHUNullifiers.clear();
+        mapZKHUWitnesses.clear();
+        setZKHUWitnessesDirty.clear();
+        setZKHUWitnessesErased.clear();
         nKHUBalance = 0;
         nKHUStaked = 0;
     }
 
+    //! Record a witness cache change for the next flush
+    void MarkZKHUWitnessDirty(const uint256& cm) {
+        setZKHUWitnessesErased.erase(cm);
+        setZKHUWitnessesDirty.insert(cm);
+    }
+
+    //! Record a witness cache removal for the next flush
+    void MarkZKHUWitnessErased(const uint256& cm) {
+        setZKHUWitnessesDirty.erase(cm);
+        setZKHUWitnessesErased.insert(cm);
+    }
+
     //! Recalculate cached balances from maps
     void UpdateBalance() {
         nKHUBalance = 0;
@@ -275,4 +327,29 @@ void ProcessKHUStakeForWallet(CWallet* pwallet, const CTransactionRef& tx, int n
 //! Process a KHU_UNSTAKE transaction to mark notes spent
 void ProcessKHUUnstakeForWallet(CWallet* pwallet, const CTransactionRef& tx);
 
+/**
+ * ZKHU Witness Cache Functions
+ *
+ * Same model as SaplingScriptPubKeyMan::IncrementNoteWitnesses/DecrementNoteWitnesses,
+ * restricted to the wallet's unspent ZKHU notes.
+ */
+
+//! Advance ZKHU note witnesses with the commitments of a connected block.
+//! saplingTree is the Sapling tree state BEFORE pblock.
+void IncrementZKHUNoteWitnesses(CWallet* pwallet, const CBlockIndex* pindex,
+                                const CBlock* pblock, SaplingMerkleTree saplingTree);
+
+//! Roll back ZKHU note witnesses for a disconnected block at nHeight
+void DecrementZKHUNoteWitnesses(CWallet* pwallet, int nHeight);
+
+//! Get the cached witness of a ZKHU note, valid at nTipHeight (false on cache miss)
+bool GetZKHUNoteWitness(const CWallet* pwallet, const uint256& cm, int nTipHeight,
+                        SaplingWitness& witnessOut, uint256& anchorOut);
+
+//! Seed the witness cache of a ZKHU note with a witness valid at nHeight
+void SetZKHUNoteWitness(CWallet* pwallet, const uint256& cm, int nHeight, const SaplingWitness& witness);
+
+//! Write the changed ZKHU witness caches and erase the dropped ones in an open wallet batch (called from SetBestChain)
+bool WriteZKHUWitnessesToDB(CWallet* pwallet, WalletBatch& batch);
+
 #endif // PIVX_WALLET_KHU_WALLET_H
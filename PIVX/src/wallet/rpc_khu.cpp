@@ -21,6 +21,7 @@
 #include "khu/khu_state.h"
 #include "khu/khu_unstake.h"
 #include "khu/khu_validation.h"
+#include "khu/khu_yield.h"
 #include "khu/zkhu_db.h"
 #include "khu/zkhu_memo.h"
 #include "streams.h"
@@ -43,11 +44,13 @@
 #include <univalue.h>
 
 /**
- * ComputeWitnessForZKHUNote - Compute witness by scanning blockchain (fallback)
+ * ComputeWitnessForZKHUNote - Rebuild a witness from the note's block (cache miss fallback)
  *
- * When the wallet's witness cache is incomplete (e.g., after fast block generation
- * or wallet restart), this function rebuilds the witness from scratch by scanning
- * the blockchain and building the Sapling merkle tree.
+ * Used only when the wallet's ZKHU witness cache has no entry valid at the tip
+ * (e.g. wallet created before the cache existed, or a reorg deeper than
+ * WITNESS_CACHE_SIZE). Starts from the Sapling tree committed by the block
+ * preceding the note (hashFinalSaplingRoot), so only blocks from targetHeight to
+ * the tip are read, never the whole chain.
  *
  * @param targetCm Note commitment to find
  * @param targetHeight Block height where the note was created
@@ -63,51 +66,58 @@ static bool ComputeWitnessForZKHUNote(
 {
     LOCK(cs_main);
 
-    // Build Sapling merkle tree from genesis up to current tip
-    SaplingMerkleTree saplingTree;
-    bool foundNote = false;
-    int notePosition = -1;
+    const Consensus::Params& consensus = Params().GetConsensus();
+    if (targetHeight <= 0 || targetHeight > chainActive.Height()) {
+        LogPrintf("ComputeWitnessForZKHUNote: Invalid note height %d\n", targetHeight);
+        return false;
+    }
+    const int nSaplingHeight = consensus.vUpgrades[Consensus::UPGRADE_V5_0].nActivationHeight;
+    const int nStartHeight = std::max(targetHeight, std::max(nSaplingHeight, 1));
 
-    // Scan blocks from beginning to find our note and build the tree
-    for (int height = 1; height <= chainActive.Height(); height++) {
-        CBlockIndex* pindex = chainActive[height];
-        if (!pindex) continue;
+    // Sapling tree state right before the note's block
+    SaplingMerkleTree saplingTree;
+    const CBlockIndex* pindexStart = chainActive[nStartHeight];
+    if (pindexStart->pprev && consensus.NetworkUpgradeActive(pindexStart->pprev->nHeight, Consensus::UPGRADE_V5_0)) {
+        if (!pcoinsTip->GetSaplingAnchorAt(pindexStart->pprev->hashFinalSaplingRoot, saplingTree)) {
+            LogPrintf("ComputeWitnessForZKHUNote: Missing Sapling anchor at height %d\n",
+                      pindexStart->pprev->nHeight);
+            return false;
+        }
+    }
 
+    bool foundNote = false;
+    for (const CBlockIndex* pindex = pindexStart; pindex; pindex = chainActive.Next(pindex)) {
         CBlock block;
         if (!ReadBlockFromDisk(block, pindex)) {
-            LogPrintf("ComputeWitnessForZKHUNote: Failed to read block at height %d\n", height);
+            LogPrintf("ComputeWitnessForZKHUNote: Failed to read block at height %d\n", pindex->nHeight);
             return false;
         }
 
-        // Process each transaction's Sapling outputs
         for (const auto& tx : block.vtx) {
             if (!tx->IsShieldedTx() || !tx->sapData) continue;
 
-            for (size_t i = 0; i < tx->sapData->vShieldedOutput.size(); i++) {
-                const uint256& cmu = tx->sapData->vShieldedOutput[i].cmu;
-
-                if (cmu == targetCm && !foundNote) {
-                    // This is our note - capture witness at this point
-                    saplingTree.append(cmu);
+            for (const OutputDescription& output : tx->sapData->vShieldedOutput) {
+                const uint256& cmu = output.cmu;
+                saplingTree.append(cmu);
+                if (foundNote) {
+                    witnessOut.append(cmu);
+                } else if (cmu == targetCm) {
                     witnessOut = saplingTree.witness();
                     foundNote = true;
-                    notePosition = saplingTree.size() - 1;
                     LogPrint(BCLog::KHU, "ComputeWitnessForZKHUNote: Found note at height %d, position %d\n",
-                             height, notePosition);
-                } else if (foundNote) {
-                    // Note already found - append to update witness
-                    saplingTree.append(cmu);
-                    witnessOut.append(cmu);
-                } else {
-                    // Haven't found our note yet - just build tree
-                    saplingTree.append(cmu);
+                             pindex->nHeight, saplingTree.size() - 1);
                 }
             }
         }
+
+        // The note must be in its confirmation block, stop early otherwise
+        if (!foundNote && pindex->nHeight == targetHeight) {
+            break;
+        }
     }
 
     if (!foundNote) {
-        LogPrintf("ComputeWitnessForZKHUNote: Note commitment not found in blockchain\n");
+        LogPrintf("ComputeWitnessForZKHUNote: Note commitment not found at height %d\n", targetHeight);
         return false;
     }
 
@@ -1080,19 +1090,18 @@ static UniValue khurescan(const JSONRPCRequest& request)
         }
     }
 
-    LOCK2(cs_main, pwallet->cs_wallet);
-
-    int nCurrentHeight = chainActive.Height();
+    int nCurrentHeight = WITH_LOCK(cs_main, return chainActive.Height());
     if (nStartHeight > nCurrentHeight) {
         throw JSONRPCError(RPC_INVALID_PARAMETER,
             strprintf("Start height %d is greater than current height %d", nStartHeight, nCurrentHeight));
     }
 
-    // Perform scan
+    // Perform scan (takes cs_main per chunk of blocks, not across the whole chain)
     if (!ScanForKHUCoins(pwallet, nStartHeight)) {
         throw JSONRPCError(RPC_WALLET_ERROR, "Failed to scan for KHU coins");
     }
 
+    LOCK(pwallet->cs_wallet);
     UniValue result(UniValue::VOBJ);
     result.pushKV("scanned_blocks", nCurrentHeight - nStartHeight + 1);
     result.pushKV("khu_coins_found", (int)pwallet->khuData.mapKHUCoins.size());
@@ -1594,7 +1603,9 @@ static UniValue khuunstake(const JSONRPCRequest& request)
     if (zkhuDB) {
         ZKHUNoteData consensusNote;
         if (zkhuDB->ReadNote(targetCm, consensusNote)) {
-            yieldBonus = consensusNote.Ur_accumulated;
+            if (!khu_yield::GetNoteAccumulatedYield(targetCm, consensusNote, nCurrentHeight, yieldBonus)) {
+                throw JSONRPCError(RPC_INTERNAL_ERROR, "Failed to compute accumulated yield for note");
+            }
             LogPrint(BCLog::KHU, "khuunstake: Using consensus yield=%s for cm=%s\n",
                      FormatMoney(yieldBonus), targetCm.GetHex().substr(0, 16).c_str());
         } else {
@@ -1611,56 +1622,32 @@ static UniValue khuunstake(const JSONRPCRequest& request)
     // PIV change output (if any)
     CAmount nPIVChange = nPIVInputValue - nFee;
 
-    // Get witness and anchor for the note
-    std::vector<SaplingOutPoint> ops = {saplingOp};
-    std::vector<Optional<SaplingWitness>> witnesses;
+    // Get witness and anchor for the note:
+    // 1) ZKHU witness cache, advanced on every connected block (O(1) lookup)
+    // 2) Standard Sapling pipeline (mapSaplingNoteData witnesses)
+    // 3) Rebuild from the note's block, then seed the ZKHU cache
+    SaplingWitness witness;
     uint256 anchor;
-    saplingMan->GetSaplingNoteWitnesses(ops, witnesses, anchor);
+    if (GetZKHUNoteWitness(pwallet, targetCm, nCurrentHeight, witness, anchor)) {
+        LogPrint(BCLog::KHU, "khuunstake: WITNESS_SOURCE=ZKHU_CACHE\n");
+    } else {
+        std::vector<SaplingOutPoint> ops = {saplingOp};
+        std::vector<Optional<SaplingWitness>> witnesses;
+        saplingMan->GetSaplingNoteWitnesses(ops, witnesses, anchor);
 
-    // Diagnostic: Check if STAKE tx is in wallet and has Sapling note data
-    {
-        auto wtxIt = pwallet->mapWallet.find(saplingOp.hash);
-        if (wtxIt == pwallet->mapWallet.end()) {
-            LogPrintf("khuunstake: DIAGNOSTIC - STAKE tx NOT in mapWallet! txid=%s\n",
-                      saplingOp.hash.GetHex().substr(0, 16));
+        if (!witnesses.empty() && witnesses[0]) {
+            LogPrint(BCLog::KHU, "khuunstake: WITNESS_SOURCE=STANDARD_PIPELINE\n");
+            witness = witnesses[0].get();
         } else {
-            const CWalletTx& wtx = wtxIt->second;
-            LogPrintf("khuunstake: DIAGNOSTIC - STAKE tx in mapWallet, txid=%s, "
-                      "mapSaplingNoteData.size=%zu, IsShieldedTx=%d\n",
-                      saplingOp.hash.GetHex().substr(0, 16),
-                      wtx.mapSaplingNoteData.size(),
-                      wtx.tx->IsShieldedTx() ? 1 : 0);
-
-            auto ndIt = wtx.mapSaplingNoteData.find(saplingOp);
-            if (ndIt == wtx.mapSaplingNoteData.end()) {
-                LogPrintf("khuunstake: DIAGNOSTIC - SaplingOutPoint NOT in mapSaplingNoteData\n");
-            } else {
-                LogPrintf("khuunstake: DIAGNOSTIC - SaplingOutPoint in mapSaplingNoteData, "
-                          "witnesses.size=%zu, witnessHeight=%d\n",
-                          ndIt->second.witnesses.size(),
-                          ndIt->second.witnessHeight);
+            LogPrintf("khuunstake: WITNESS_SOURCE=FALLBACK (wallet cache miss), rebuilding from height %d\n",
+                      targetNote->nConfirmedHeight);
+            if (!ComputeWitnessForZKHUNote(targetCm, targetNote->nConfirmedHeight, witness, anchor)) {
+                throw JSONRPCError(RPC_WALLET_ERROR,
+                    "Failed to compute witness for ZKHU note. The note may not exist in the blockchain. "
+                    "Try running 'khurescannotes' or restarting the wallet.");
             }
         }
-    }
-
-    SaplingWitness witness;
-    bool usedFallback = false;
-    if (witnesses.empty() || !witnesses[0]) {
-        // Fallback: compute witness by scanning blockchain
-        // TODO: Realign ZKHU on standard Sapling note/witness pipeline
-        //       (FindMySaplingNotes + IncrementNoteWitnesses)
-        //       This fallback is temporary for testing.
-        LogPrintf("khuunstake: WITNESS_SOURCE=FALLBACK (wallet cache miss), computing from blockchain...\n");
-        usedFallback = true;
-
-        if (!ComputeWitnessForZKHUNote(targetCm, targetNote->nConfirmedHeight, witness, anchor)) {
-            throw JSONRPCError(RPC_WALLET_ERROR,
-                "Failed to compute witness for ZKHU note. The note may not exist in the blockchain. "
-                "Try running 'khurescannotes' or restarting the wallet.");
-        }
-    } else {
-        LogPrintf("khuunstake: WITNESS_SOURCE=STANDARD_PIPELINE (wallet cache hit)\n");
-        witness = witnesses[0].get();
+        SetZKHUNoteWitness(pwallet, targetCm, nCurrentHeight, witness);
     }
 
     // Build transaction using TransactionBuilder
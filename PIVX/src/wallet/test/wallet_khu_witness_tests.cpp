@@ -0,0 +1,136 @@
+// Copyright (c) 2025 The PIVX Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or https://www.opensource.org/licenses/mit-license.php.
+
+#include "wallet/test/wallet_test_fixture.h"
+
+#include "chain.h"
+#include "primitives/block.h"
+#include "sapling/note.h"
+#include "test/librust/utiltest.h"
+#include "wallet/khu_wallet.h"
+#include "wallet/wallet.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(wallet_khu_witness_tests, WalletTestingSetup)
+
+static uint256 GetTestCommitment(CAmount value)
+{
+    libzcash::SaplingNote note(GetTestMasterSaplingSpendingKey().DefaultAddress(), value);
+    return note.cmu().get();
+}
+
+static CBlock GetBlockWithOutputs(const std::vector<uint256>& vCm, CTransaction::TxType nType)
+{
+    CMutableTransaction mtx;
+    mtx.nVersion = CTransaction::TxVersion::SAPLING;
+    mtx.nType = nType;
+    mtx.sapData = SaplingTxData();
+    for (const uint256& cm : vCm) {
+        OutputDescription od;
+        od.cmu = cm;
+        mtx.sapData->vShieldedOutput.emplace_back(od);
+    }
+    CBlock block;
+    block.vtx.emplace_back(MakeTransactionRef(mtx));
+    return block;
+}
+
+BOOST_AUTO_TEST_CASE(zkhu_witness_cache_increment_decrement)
+{
+    const uint256 cmOther = GetTestCommitment(1 * COIN);
+    const uint256 cmStake = GetTestCommitment(100 * COIN);
+    const uint256 cmNext = GetTestCommitment(7 * COIN);
+
+    {
+        LOCK(m_wallet.cs_wallet);
+        m_wallet.khuData.mapZKHUNotes[cmStake] =
+            ZKHUNoteEntry(SaplingOutPoint(uint256(), 0), cmStake, 10, 100 * COIN, uint256(), 10);
+    }
+
+    // Block 10: unrelated output, then our KHU_STAKE note
+    SaplingMerkleTree tree;
+    CBlock block10 = GetBlockWithOutputs({cmOther}, CTransaction::TxType::NORMAL);
+    block10.vtx.emplace_back(GetBlockWithOutputs({cmStake}, CTransaction::TxType::KHU_STAKE).vtx[0]);
+    CBlockIndex index10;
+    index10.nHeight = 10;
+    IncrementZKHUNoteWitnesses(&m_wallet, &index10, &block10, tree);
+    tree.append(cmOther);
+    tree.append(cmStake);
+
+    SaplingWitness witness;
+    uint256 anchor;
+    BOOST_CHECK(GetZKHUNoteWitness(&m_wallet, cmStake, 10, witness, anchor));
+    BOOST_CHECK(anchor == tree.root());
+    BOOST_CHECK_EQUAL(witness.position(), 1);
+    BOOST_CHECK(!GetZKHUNoteWitness(&m_wallet, cmStake, 11, witness, anchor));
+
+    // Block 11: the witness follows the tree without rescanning
+    const SaplingMerkleTree tree10 = tree;
+    CBlock block11 = GetBlockWithOutputs({cmNext}, CTransaction::TxType::NORMAL);
+    CBlockIndex index11;
+    index11.nHeight = 11;
+    IncrementZKHUNoteWitnesses(&m_wallet, &index11, &block11, tree);
+    tree.append(cmNext);
+
+    BOOST_CHECK(GetZKHUNoteWitness(&m_wallet, cmStake, 11, witness, anchor));
+    BOOST_CHECK(anchor == tree.root());
+    BOOST_CHECK_EQUAL(m_wallet.khuData.setZKHUWitnessesDirty.count(cmStake), 1);
+
+    // Disconnect block 11: back to the block 10 witness
+    DecrementZKHUNoteWitnesses(&m_wallet, 11);
+    BOOST_CHECK(GetZKHUNoteWitness(&m_wallet, cmStake, 10, witness, anchor));
+    BOOST_CHECK(anchor == tree10.root());
+
+    // Disconnect block 10: the note never existed, cache entry is dropped
+    DecrementZKHUNoteWitnesses(&m_wallet, 10);
+    BOOST_CHECK(!GetZKHUNoteWitness(&m_wallet, cmStake, 9, witness, anchor));
+    BOOST_CHECK_EQUAL(m_wallet.khuData.mapZKHUWitnesses.count(cmStake), 0);
+    BOOST_CHECK_EQUAL(m_wallet.khuData.setZKHUWitnessesErased.count(cmStake), 1);
+    BOOST_CHECK_EQUAL(m_wallet.khuData.setZKHUWitnessesDirty.count(cmStake), 0);
+}
+
+BOOST_AUTO_TEST_CASE(zkhu_witness_cache_skips_spent_notes)
+{
+    const uint256 cmStake = GetTestCommitment(50 * COIN);
+    const uint256 cmNext = GetTestCommitment(3 * COIN);
+
+    {
+        LOCK(m_wallet.cs_wallet);
+        m_wallet.khuData.mapZKHUNotes[cmStake] =
+            ZKHUNoteEntry(SaplingOutPoint(uint256(), 0), cmStake, 20, 50 * COIN, uint256(), 20);
+    }
+
+    SaplingMerkleTree tree;
+    CBlock block20 = GetBlockWithOutputs({cmStake}, CTransaction::TxType::KHU_STAKE);
+    CBlockIndex index20;
+    index20.nHeight = 20;
+    IncrementZKHUNoteWitnesses(&m_wallet, &index20, &block20, tree);
+    tree.append(cmStake);
+
+    SaplingWitness witness;
+    uint256 anchor;
+    BOOST_CHECK(GetZKHUNoteWitness(&m_wallet, cmStake, 20, witness, anchor));
+
+    // Once unstaked, the note is no longer advanced
+    WITH_LOCK(m_wallet.cs_wallet, m_wallet.khuData.mapZKHUNotes[cmStake].fSpent = true);
+    CBlock block21 = GetBlockWithOutputs({cmNext}, CTransaction::TxType::NORMAL);
+    CBlockIndex index21;
+    index21.nHeight = 21;
+    WITH_LOCK(m_wallet.cs_wallet, m_wallet.khuData.setZKHUWitnessesDirty.clear());
+    IncrementZKHUNoteWitnesses(&m_wallet, &index21, &block21, tree);
+    BOOST_CHECK(!GetZKHUNoteWitness(&m_wallet, cmStake, 21, witness, anchor));
+    // Untouched caches are not rewritten on the next flush
+    BOOST_CHECK(m_wallet.khuData.setZKHUWitnessesDirty.empty());
+
+    // A cache seeded by the rebuild fallback is served at its height
+    tree.append(cmNext);
+    SaplingWitness rebuilt = witness;
+    rebuilt.append(cmNext);
+    SetZKHUNoteWitness(&m_wallet, cmStake, 21, rebuilt);
+    BOOST_CHECK(GetZKHUNoteWitness(&m_wallet, cmStake, 21, witness, anchor));
+    BOOST_CHECK(anchor == tree.root());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,6 +7,7 @@
 #include "primitives/block.h"
 #include "sapling/transaction_builder.h"
 #include "sapling/sapling_operation.h"
+#include "sapling/sapling_validation.h"
 #include "wallet/wallet.h"
 
 #include <boost/test/unit_test.hpp>
@@ -164,4 +165,42 @@ BOOST_AUTO_TEST_CASE(test_in_block_and_mempool_notes_double_spend)
     }
 }
 
+// Proof verifications cached by the mempool survive block template checks and are dropped once mined
+BOOST_AUTO_TEST_CASE(test_proof_cache_mempool_to_block)
+{
+    auto ret = pwalletMain->getNewAddress("coinbase");
+    BOOST_ASSERT_MSG(ret, "cannot create address");
+    const CScript& scriptPubKey = GetScriptForDestination(*ret.getObjResult());
+    for (int i = 0; i < 10; ++i) {
+        CreateAndProcessBlock({}, scriptPubKey);
+        SyncWithValidationInterfaceQueue();
+    }
+
+    std::vector<SendManyRecipient> recipients;
+    libzcash::SaplingPaymentAddress pa = pwalletMain->GenerateNewSaplingZKey("sapling1");
+    recipients.emplace_back(pa, CAmount(100 * COIN), "", false);
+    SaplingOperation operation = createOperationAndBuildTx(pwalletMain, recipients, true);
+    const CTransaction tx = operation.getFinalTx();
+    BOOST_CHECK(!SaplingValidation::HasCachedProofs(tx));
+
+    // Accepted to the mempool: the verification is cached, and served from there the second time
+    std::string retHash;
+    BOOST_ASSERT_MSG(operation.send(retHash), "error committing and broadcasting the transaction");
+    BOOST_CHECK(SaplingValidation::HasCachedProofs(tx));
+    CValidationState state;
+    BOOST_CHECK(SaplingValidation::ContextualCheckTransaction(tx, state, Params(), WITH_LOCK(cs_main, return chainActive.Height() + 1), false, false));
+    BOOST_CHECK(SaplingValidation::HasCachedProofs(tx));
+
+    // A block template including it (TestBlockValidity) only looks the entry up
+    const CBlock blockTemplate = CreateBlock({}, scriptPubKey, false /*fNoMempoolTx*/, true /*fTestBlockValidity*/);
+    BOOST_CHECK_EQUAL(blockTemplate.vtx.size(), 2);
+    BOOST_CHECK(SaplingValidation::HasCachedProofs(tx));
+
+    // Connected in a block: the entry is dropped
+    const CBlock& block = CreateAndProcessBlock({}, scriptPubKey, false /*fNoMempoolTx*/);
+    BOOST_CHECK_EQUAL(block.vtx.size(), 2);
+    BOOST_CHECK(WITH_LOCK(cs_main, return chainActive.Tip()->GetBlockHash()) == block.GetHash());
+    BOOST_CHECK(!SaplingValidation::HasCachedProofs(tx));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
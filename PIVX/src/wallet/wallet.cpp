@@ -505,6 +505,8 @@ void CWallet::ChainTipAdded(const CBlockIndex *pindex,
                             const CBlock *pblock,
                             SaplingMerkleTree saplingTree)
 {
+    // KHU: advance ZKHU note witnesses from the pre-block tree
+    IncrementZKHUNoteWitnesses(this, pindex, pblock, saplingTree);
     IncrementNoteWitnesses(pindex, pblock, saplingTree);
     m_sspk_man->UpdateSaplingNullifierNoteMapForBlock(pblock);
 }
@@ -566,6 +568,13 @@ void CWallet::SetBestChainInternal(WalletBatch& batch, const CBlockLocator& loc)
         }
     }
 
+    // Store ZKHU note witness caches
+    if (!WriteZKHUWitnessesToDB(this, batch)) {
+        LogPrintf("%s: Failed to write ZKHU witness cache\n", __func__);
+        batch.TxnAbort();
+        return;
+    }
+
     if (!batch.TxnCommit()) {
         // Couldn't commit all to db, but in-memory state is fine
         LogPrintf("%s: Couldn't commit atomic write\n", __func__);
@@ -576,6 +585,11 @@ void CWallet::SetBestChainInternal(WalletBatch& batch, const CBlockLocator& loc)
     if (m_sspk_man->nWitnessCacheNeedsUpdate) {
         m_sspk_man->nWitnessCacheNeedsUpdate = false;
     }
+    {
+        LOCK(cs_wallet);
+        khuData.setZKHUWitnessesDirty.clear();
+        khuData.setZKHUWitnessesErased.clear();
+    }
 }
 
 bool CWallet::SetMinVersion(enum WalletFeature nVersion, WalletBatch* batch_in, bool fExplicit)
@@ -1319,6 +1333,10 @@ void CWallet::TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolR
 
 void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex *pindex)
 {
+    // Sapling: trial-decrypt the whole block before taking the wallet lock
+    if (HasSaplingSPKM()) {
+        m_sspk_man->BatchDecryptBlock(*pblock);
+    }
     {
         LOCK2(cs_main, cs_wallet);
 
@@ -1351,6 +1369,9 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
         // Sapling: Update cached incremental witnesses
         ChainTipAdded(pindex, pblock.get(), oldSaplingTree);
     } // cs_wallet lock end
+    if (HasSaplingSPKM()) {
+        m_sspk_man->ClearBatchDecryptions();
+    }
 
     // Auto-combine functionality
     // If turned on Auto Combine will scan wallet for dust to combine
@@ -1381,6 +1402,7 @@ void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock, con
         // Update Sapling cached incremental witnesses
         m_sspk_man->DecrementNoteWitnesses(mapBlockIndex[blockHash]);
         m_sspk_man->UpdateSaplingNullifierNoteMapForBlock(pblock.get());
+        DecrementZKHUNoteWitnesses(this, nBlockHeight);
     }
 }
 
@@ -1937,6 +1959,10 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
 
             CBlock block;
             if (ReadBlockFromDisk(block, pindex)) {
+                // Sapling: trial-decrypt the whole block before taking the wallet lock
+                if (HasSaplingSPKM()) {
+                    m_sspk_man->BatchDecryptBlock(block);
+                }
                 LOCK2(cs_main, cs_wallet);
                 if (pindex && !chainActive.Contains(pindex)) {
                      // Abort scan if current block is no longer active, to prevent
@@ -1979,6 +2005,9 @@ CBlockIndex* CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, CBlock
                 }
             }
         }
+        if (HasSaplingSPKM()) {
+            m_sspk_man->ClearBatchDecryptions();
+        }
 
         // Sapling
         // After rescanning, persist Sapling note data that might have changed, e.g. nullifiers.
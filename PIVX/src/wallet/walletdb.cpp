@@ -57,6 +57,7 @@ namespace DBKeys {
     // KHU (Phase 8)
     const std::string KHUCOIN{"khucoin"};
     const std::string ZKHUNOTE{"zkhunote"};
+    const std::string ZKHUWITNESS{"zkhuwitness"};
 
     // Wallet custom settings
     const std::string AUTOCOMBINE{"autocombinesettings"};
@@ -646,6 +647,14 @@ bool ReadKeyValue(CWallet* pwallet, CDataStream& ssKey, CDataStream& ssValue, CW
             if (!entry.nullifier.IsNull()) {
                 pwallet->khuData.mapZKHUNullifiers[entry.nullifier] = cm;
             }
+        } else if (strType == DBKeys::ZKHUWITNESS) {
+            // ZKHU note witness cache
+            uint256 cm;
+            ssKey >> cm;
+            ZKHUWitnessData witnessData;
+            ssValue >> witnessData;
+
+            pwallet->khuData.mapZKHUWitnesses[cm] = witnessData;
         }
     } catch (...) {
         return false;
@@ -1022,6 +1031,16 @@ bool WalletBatch::EraseZKHUNote(const uint256& cm)
     return EraseIC(std::make_pair(std::string("zkhunote"), cm));
 }
 
+bool WalletBatch::WriteZKHUWitness(const uint256& cm, const ZKHUWitnessData& witnessData)
+{
+    return WriteIC(std::make_pair(std::string(DBKeys::ZKHUWITNESS), cm), witnessData);
+}
+
+bool WalletBatch::EraseZKHUWitness(const uint256& cm)
+{
+    return EraseIC(std::make_pair(std::string(DBKeys::ZKHUWITNESS), cm));
+}
+
 bool WalletBatch::TxnBegin()
 {
     return m_batch.TxnBegin();
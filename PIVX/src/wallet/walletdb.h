@@ -38,6 +38,7 @@ static const bool DEFAULT_FLUSHWALLET = true;
 struct CBlockLocator;
 struct KHUCoinEntry;
 struct ZKHUNoteEntry;
+struct ZKHUWitnessData;
 class CKeyPool;
 class CMasterKey;
 class CScript;
@@ -213,6 +214,11 @@ public:
     //! Erase ZKHU note from wallet database
     bool EraseZKHUNote(const uint256& cm);
 
+    //! Write ZKHU note witness cache to wallet database
+    bool WriteZKHUWitness(const uint256& cm, const ZKHUWitnessData& witnessData);
+    //! Erase ZKHU note witness cache from wallet database
+    bool EraseZKHUWitness(const uint256& cm);
+
     DBErrors ReorderTransactions(CWallet* pwallet);
     DBErrors LoadWallet(CWallet* pwallet);
     DBErrors FindWalletTx(CWallet* pwallet, std::vector<uint256>& vTxHash, std::vector<CWalletTx>& vWtx);
@@ -9,6 +9,7 @@ import random
 from test_framework.test_framework import PivxTestFramework
 from test_framework.util import (
     assert_equal,
+    wait_until,
 )
 
 
@@ -17,7 +18,8 @@ class BlockIndexStatsTest(PivxTestFramework):
     def set_test_params(self):
         self.num_nodes = 2
         saplingUpgrade = ['-nuparams=v5_shield:201']
-        self.extra_args = [saplingUpgrade] * self.num_nodes
+        # the miner serves the stats from the block statistics index, alice reads the blocks
+        self.extra_args = [saplingUpgrade + ['-blockstatsindex'], saplingUpgrade]
 
     def send_tx(self, node_from, node_to, fee, fFromShield, fToShield):
         if not fFromShield and not fToShield:
@@ -100,6 +102,7 @@ class BlockIndexStatsTest(PivxTestFramework):
         count_tx = 0
         count_bytes = 0
         count_fees = 0.0
+        count_shield = 0
 
         # Mine 30 blocks. Send a tx (either t->t, z->t, t->z, or z->z) each block, with random fee.
         NUM_BLOCKS = 30
@@ -128,6 +131,7 @@ class BlockIndexStatsTest(PivxTestFramework):
             count_tx += 1
             count_bytes += txsize
             count_fees += fee
+            count_shield += (1 if tx_kind > 4 else 0)
 
         count_fees = round(count_fees, 8)
         feePerK = round(1000 * count_fees / count_bytes, 8)
@@ -140,6 +144,17 @@ class BlockIndexStatsTest(PivxTestFramework):
         assert_equal(count_bytes, alice_stats['txbytes'])
         assert_equal(count_fees, float(alice_stats['ttlfee']))
 
+        # Same results from the index (once the last block notification is processed)
+        self.log.info("Checking the block statistics index...")
+        wait_until(lambda: 'khu_txcount' in miner.getblockindexstats(start_block+1, NUM_BLOCKS), timeout=30)
+        miner_stats = miner.getblockindexstats(start_block+1, NUM_BLOCKS)
+        for key in ['txcount', 'txcount_all', 'txbytes', 'ttlfee', 'feeperkb']:
+            assert_equal(alice_stats[key], miner_stats[key])
+        assert_equal(count_shield, miner_stats['shield_txcount'])
+        assert_equal(0, miner_stats['khu_txcount'])
+        # Before V6 the KHU state is known (and empty)
+        assert_equal({'C': 0, 'U': 0, 'Z': 0}, miner_stats['khu_delta'])
+
 
 
 if __name__ == '__main__':
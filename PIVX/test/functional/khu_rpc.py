@@ -11,6 +11,8 @@ This test verifies:
 4. khurescan - rescans blockchain for KHU coins
 5. getkhustate - returns global KHU state (non-wallet)
 6. getkhustatecommitment - returns KHU state commitment hash
+7. getkhustate / getsupplyinfo - follow the tip across invalidateblock
+8. khurescan - finds the same KHU coins with and without -khutxindex
 
 Note: Full transaction tests (khumint, khuredeem, khusend) require
 KHU consensus activation which is not yet enabled on testnet.
@@ -29,9 +31,10 @@ class KHURPCTest(PivxTestFramework):
     def set_test_params(self):
         self.num_nodes = 2
         self.setup_clean_chain = True
+        self.extra_args = [[], ["-khutxindex"]]
 
     def setup_network(self):
-        self.add_nodes(2)
+        self.add_nodes(2, self.extra_args)
         self.start_node(0)
         self.start_node(1)
         self.connect_nodes(0, 1)
@@ -63,6 +66,12 @@ class KHURPCTest(PivxTestFramework):
         # Test getkhustatecommitment
         self.test_getkhustatecommitment()
 
+        # Test the KHU state at the tip after invalidateblock
+        self.test_khustate_invalidateblock()
+
+        # Test khurescan over real KHU coins, with and without the index
+        self.test_khurescan_khutxindex()
+
         self.log.info("All KHU RPC tests passed!")
 
     def test_khugetinfo(self):
@@ -172,6 +181,11 @@ class KHURPCTest(PivxTestFramework):
         result = self.nodes[0].khurescan(50)
         assert_greater_than_or_equal(result["scanned_blocks"], 60)
 
+        # Same result through the KHU tx index
+        result = self.nodes[1].khurescan(0)
+        assert_greater_than_or_equal(result["scanned_blocks"], 110)
+        assert_equal(result["khu_coins_found"], 0)
+
         # Invalid start height should fail
         assert_raises_rpc_error(-8, None, self.nodes[0].khurescan, 999999999)
         assert_raises_rpc_error(-8, None, self.nodes[0].khurescan, -1)
@@ -246,6 +260,76 @@ class KHURPCTest(PivxTestFramework):
             else:
                 raise
 
+    def test_khustate_invalidateblock(self):
+        """Test that the tip KHU state follows invalidateblock/reconsiderblock."""
+        self.log.info("Testing KHU tip state across invalidateblock...")
+
+        node = self.nodes[0]
+        # Past the V6 activation (height 200 on regtest)
+        node.generate(210 - node.getblockcount())
+        self.sync_all()
+
+        def assert_tip_state():
+            tip_hash = node.getbestblockhash()
+            tip_height = node.getblockcount()
+            state = node.getkhustate()
+            assert_equal(state["height"], tip_height)
+            assert_equal(state["blockhash"], tip_hash)
+            assert_equal(node.getsupplyinfo()["khusupply"]["height"], tip_height)
+
+        assert_tip_state()
+        tip = node.getbestblockhash()
+        node.invalidateblock(tip)
+        assert_equal(node.getblockcount(), 209)
+        assert_tip_state()
+
+        node.reconsiderblock(tip)
+        assert_equal(node.getbestblockhash(), tip)
+        assert_tip_state()
+
+        self.log.info("KHU tip state across invalidateblock OK")
+
+    def test_khurescan_khutxindex(self):
+        """Test that khurescan finds the same KHU coins with and without -khutxindex."""
+        self.log.info("Testing khurescan with and without -khutxindex...")
+
+        node = self.nodes[1]
+        self.nodes[0].sendtoaddress(node.getnewaddress(), 100)
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        # Two mints, then a KHU spend of one of them
+        node.khumint(20)
+        node.khumint(10)
+        self.sync_all()
+        self.nodes[0].generate(1)
+        self.sync_all()
+        node.khusend(node.getnewaddress(), 5)
+        self.sync_all()
+        self.nodes[0].generate(1)
+        self.sync_all()
+
+        def khu_coins():
+            return sorted((c["txid"], c["vout"], c["amount"]) for c in node.khulistunspent())
+
+        expected = khu_coins()
+        assert_greater_than_or_equal(len(expected), 2)
+
+        # Through the KHU tx index (node 1 ran with -khutxindex from genesis)
+        result = node.khurescan(0)
+        assert_equal(result["khu_coins_found"], len(expected))
+        assert_equal(khu_coins(), expected)
+        indexed_balance = result["khu_balance"]
+
+        # Full block scan, same wallet without the index
+        self.restart_node(1, extra_args=[])
+        result = node.khurescan(0)
+        assert_equal(result["khu_coins_found"], len(expected))
+        assert_equal(result["khu_balance"], indexed_balance)
+        assert_equal(khu_coins(), expected)
+
+        self.log.info("khurescan with and without -khutxindex OK")
+
 
 if __name__ == '__main__':
     KHURPCTest().main()
@@ -48,9 +48,13 @@ class ReorgStakeTest(PivxTestFramework):
         return wi['balance'] + wi['immature_balance']
 
     def check_money_supply(self, expected_piv):
-        # verify that nodes have the expected PIV supply
+        # verify that nodes have the expected PIV supply, both the value kept
+        # current across connects/disconnects and the one of a full rescan
+        cached_supply = [self.nodes[i].getsupplyinfo()['transparentsupply']
+                         for i in range(self.num_nodes)]
         piv_supply = [self.nodes[i].getsupplyinfo(True)['transparentsupply']
                       for i in range(self.num_nodes)]
+        assert_equal(cached_supply, piv_supply)
         assert_equal(piv_supply, [DecimalAmt(expected_piv)] * self.num_nodes)
 
 
@@ -164,6 +168,16 @@ class ReorgStakeTest(PivxTestFramework):
         self.check_money_supply(expected_money_supply)
         self.log.info("Supply checks out.")
 
+        # Level 4 checks reconnect the top blocks on a scratch view: at startup and
+        # with verifychain, the cached supply must not count them twice
+        self.log.info("Check PIV supply after level 4 block verifications...")
+        self.restart_node(0, extra_args=self.extra_args[0] + ['-checklevel=4', '-checkblocks=20'])
+        assert_equal(self.nodes[0].getsupplyinfo()['transparentsupply'], DecimalAmt(expected_money_supply))
+        assert self.nodes[0].verifychain(20)
+        assert_equal(self.nodes[0].getsupplyinfo()['transparentsupply'], DecimalAmt(expected_money_supply))
+        assert_equal(self.nodes[0].gettxoutsetinfo()['total_amount'], DecimalAmt(expected_money_supply))
+        self.log.info("Supply checks out after verification.")
+
 
 if __name__ == '__main__':
     ReorgStakeTest().main()
@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# Copyright (c) 2016-2018 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test compact block relay (BIP152).
+
+1) The node announces compact block version 1 support with a sendcmpct.
+2) An unrequested cmpctblock from a low bandwidth peer is ignored.
+3) A single announced tip block is requested with a MSG_CMPCT_BLOCK getdata,
+   the missing transactions are requested with a getblocktxn and the
+   blocktxn answer completes the block.
+4) The node serves cmpctblock and getblocktxn requests for its tip.
+5) A block received elsewhere while its getblocktxn is unanswered does not
+   stop the next compact block from being reconstructed.
+"""
+
+from test_framework.blocktools import create_block, create_coinbase, create_transaction
+from test_framework.messages import (
+    BlockTransactions,
+    BlockTransactionsRequest,
+    CInv,
+    CTransaction,
+    FromHex,
+    HeaderAndShortIDs,
+    MSG_BLOCK,
+    MSG_CMPCT_BLOCK,
+    msg_blocktxn,
+    msg_cmpctblock,
+    msg_getblocktxn,
+    msg_getdata,
+    msg_inv,
+    msg_sendcmpct,
+)
+from test_framework.mininode import P2PInterface, mininode_lock
+from test_framework.script import CScript, OP_TRUE
+from test_framework.test_framework import PivxTestFramework
+from test_framework.util import assert_equal, wait_until
+
+
+class CompactBlocksTest(PivxTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [["-whitelist=127.0.0.1"]]
+
+    def build_block(self, node, txs):
+        best_block = node.getblock(node.getbestblockhash())
+        block = create_block(int(best_block["hash"], 16), create_coinbase(best_block["height"] + 1), best_block["time"] + 1)
+        block.vtx.extend(txs)
+        block.hashMerkleRoot = block.calc_merkle_root()
+        block.solve()
+        return block
+
+    def run_test(self):
+        node = self.nodes[0]
+        peer = node.add_p2p_connection(P2PInterface())
+        peer.wait_for_verack()
+
+        self.log.info("Check that the node announces compact block version 1...")
+        wait_until(lambda: "sendcmpct" in peer.last_message, timeout=30, lock=mininode_lock)
+        with mininode_lock:
+            assert_equal(peer.last_message["sendcmpct"].version, 1)
+            assert not peer.last_message["sendcmpct"].announce
+        peer.send_and_ping(msg_sendcmpct())
+
+        self.log.info("Create an anyone-can-spend coinbase and mature it...")
+        block1 = self.build_block(node, [])
+        node.submitblock(block1.serialize().hex())
+        assert_equal(node.getbestblockhash(), block1.hash)
+        node.generate(101)
+
+        # One transaction in the node's mempool, one only known by the peer
+        mempool_txid = node.sendtoaddress(node.getnewaddress(), 1)
+        mempool_tx = FromHex(CTransaction(), node.getrawtransaction(mempool_txid))
+        mempool_tx.rehash()
+        missing_tx = create_transaction(block1.vtx[0], 0, b"", block1.vtx[0].vout[0].nValue - 10000, CScript([OP_TRUE]))
+        block = self.build_block(node, [mempool_tx, missing_tx])
+
+        self.log.info("Check that an unrequested cmpctblock is ignored...")
+        peer.send_and_ping(msg_cmpctblock(self.compact(block)))
+        with mininode_lock:
+            assert "getblocktxn" not in peer.last_message
+        assert node.getbestblockhash() != block.hash
+
+        self.log.info("Check that an announced tip block is fetched as a compact block...")
+        with mininode_lock:
+            peer.last_message.pop("getdata", None)
+        peer.send_message(msg_inv([CInv(MSG_BLOCK, block.sha256)]))
+        peer.wait_for_getdata()
+        with mininode_lock:
+            assert_equal(peer.last_message["getdata"].inv[0].type, MSG_CMPCT_BLOCK)
+            assert_equal(peer.last_message["getdata"].inv[0].hash, block.sha256)
+
+        self.log.info("Check that the missing transaction is requested...")
+        peer.send_message(msg_cmpctblock(self.compact(block)))
+        wait_until(lambda: "getblocktxn" in peer.last_message, timeout=30, lock=mininode_lock)
+        with mininode_lock:
+            request = peer.last_message["getblocktxn"].block_txn_request
+            assert_equal(request.blockhash, block.sha256)
+            assert_equal(request.to_absolute(), [2])
+        assert node.getbestblockhash() != block.hash
+
+        blocktxn = msg_blocktxn()
+        blocktxn.block_transactions = BlockTransactions(block.sha256, [missing_tx])
+        peer.send_and_ping(blocktxn)
+        assert_equal(node.getbestblockhash(), block.hash)
+        assert mempool_txid not in node.getrawmempool()
+
+        self.log.info("Check that the node serves its tip as a compact block...")
+        peer.send_message(msg_getdata([CInv(MSG_CMPCT_BLOCK, block.sha256)]))
+        wait_until(lambda: "cmpctblock" in peer.last_message, timeout=30, lock=mininode_lock)
+        with mininode_lock:
+            served = HeaderAndShortIDs(peer.last_message["cmpctblock"].header_and_shortids)
+        served.header.calc_sha256()
+        assert_equal(served.header.sha256, block.sha256)
+        assert_equal(len(served.prefilled_txn), 1)
+        assert_equal(served.prefilled_txn[0].index, 0)
+        assert_equal(len(served.shortids), 2)
+
+        self.log.info("Check that the node answers a getblocktxn for its tip...")
+        getblocktxn = msg_getblocktxn()
+        getblocktxn.block_txn_request = BlockTransactionsRequest(block.sha256)
+        getblocktxn.block_txn_request.from_absolute([1, 2])
+        peer.send_message(getblocktxn)
+        wait_until(lambda: "blocktxn" in peer.last_message, timeout=30, lock=mininode_lock)
+        with mininode_lock:
+            answer = peer.last_message["blocktxn"].block_transactions
+        assert_equal(answer.blockhash, block.sha256)
+        for tx in answer.transactions:
+            tx.calc_sha256()
+        assert_equal([tx.sha256 for tx in answer.transactions], [mempool_tx.sha256, missing_tx.sha256])
+
+        self.log.info("Check that a block received elsewhere drops its pending getblocktxn...")
+        missing_tx2 = create_transaction(missing_tx, 0, b"", missing_tx.vout[0].nValue - 10000, CScript([OP_TRUE]))
+        block2 = self.build_block(node, [missing_tx2])
+        assert_equal(self.fetch_compact(peer, block2), [1])
+        node.submitblock(block2.serialize().hex())
+        assert_equal(node.getbestblockhash(), block2.hash)
+
+        missing_tx3 = create_transaction(missing_tx2, 0, b"", missing_tx2.vout[0].nValue - 10000, CScript([OP_TRUE]))
+        block3 = self.build_block(node, [missing_tx3])
+        assert_equal(self.fetch_compact(peer, block3), [1])
+        blocktxn = msg_blocktxn()
+        blocktxn.block_transactions = BlockTransactions(block3.sha256, [missing_tx3])
+        peer.send_and_ping(blocktxn)
+        assert_equal(node.getbestblockhash(), block3.hash)
+
+    def fetch_compact(self, peer, block):
+        """Announce block, answer the getdata with a cmpctblock and return the requested tx indexes"""
+        with mininode_lock:
+            peer.last_message.pop("getdata", None)
+            peer.last_message.pop("getblocktxn", None)
+        peer.send_message(msg_inv([CInv(MSG_BLOCK, block.sha256)]))
+        peer.wait_for_getdata()
+        with mininode_lock:
+            assert_equal(peer.last_message["getdata"].inv[0].type, MSG_CMPCT_BLOCK)
+        peer.send_message(msg_cmpctblock(self.compact(block)))
+        wait_until(lambda: "getblocktxn" in peer.last_message, timeout=30, lock=mininode_lock)
+        with mininode_lock:
+            request = peer.last_message["getblocktxn"].block_txn_request
+            assert_equal(request.blockhash, block.sha256)
+            return request.to_absolute()
+
+    def compact(self, block):
+        header_and_shortids = HeaderAndShortIDs()
+        header_and_shortids.initialize_from_block(block, nonce=block.nNonce)
+        return header_and_shortids.to_p2p()
+
+
+if __name__ == '__main__':
+    CompactBlocksTest().main()
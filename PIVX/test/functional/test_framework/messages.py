@@ -47,6 +47,7 @@ NODE_BLOOM = (1 << 2)
 
 MSG_TX = 1
 MSG_BLOCK = 2
+MSG_CMPCT_BLOCK = 24
 MSG_TYPE_MASK = 0xffffffff >> 2
 
 
@@ -305,7 +306,8 @@ class CInv:
         13: "MSG_MASTERNODE_QUORUM",
         15: "MSG_MASTERNODE_ANNOUNCE",
         16: "MSG_MASTERNODE_PING",
-        17: "MSG_DSTX"
+        17: "MSG_DSTX",
+        24: "MSG_CMPCT_BLOCK"
     }
 
     def __init__(self, t=0, h=0):
@@ -770,10 +772,11 @@ class PrefilledTransaction:
 # This is what we send on the wire, in a cmpctblock message.
 class P2PHeaderAndShortIDs:
     __slots__ = ("header", "nonce", "prefilled_txn", "prefilled_txn_length",
-                 "shortids", "shortids_length")
+                 "shortids", "shortids_length", "vchBlockSig")
 
     def __init__(self):
         self.header = CBlockHeader()
+        self.vchBlockSig = b""
         self.nonce = 0
         self.shortids_length = 0
         self.shortids = []
@@ -782,6 +785,7 @@ class P2PHeaderAndShortIDs:
 
     def deserialize(self, f):
         self.header.deserialize(f)
+        self.vchBlockSig = deser_string(f)
         self.nonce = struct.unpack("<Q", f.read(8))[0]
         self.shortids_length = deser_compact_size(f)
         for i in range(self.shortids_length):
@@ -795,6 +799,7 @@ class P2PHeaderAndShortIDs:
     def serialize(self, with_witness=False):
         r = b""
         r += self.header.serialize()
+        r += ser_string(self.vchBlockSig)
         r += struct.pack("<Q", self.nonce)
         r += ser_compact_size(self.shortids_length)
         for x in self.shortids:
@@ -829,10 +834,11 @@ def calculate_shortid(k0, k1, tx_hash):
 # This version gets rid of the array lengths, and reinterprets the differential
 # encoding into indices that can be used for lookup.
 class HeaderAndShortIDs:
-    __slots__ = ("header", "nonce", "prefilled_txn", "shortids", "use_witness")
+    __slots__ = ("header", "nonce", "prefilled_txn", "shortids", "use_witness", "vchBlockSig")
 
     def __init__(self, p2pheaders_and_shortids=None):
         self.header = CBlockHeader()
+        self.vchBlockSig = b""
         self.nonce = 0
         self.shortids = []
         self.prefilled_txn = []
@@ -840,6 +846,7 @@ class HeaderAndShortIDs:
 
         if p2pheaders_and_shortids is not None:
             self.header = p2pheaders_and_shortids.header
+            self.vchBlockSig = p2pheaders_and_shortids.vchBlockSig
             self.nonce = p2pheaders_and_shortids.nonce
             self.shortids = p2pheaders_and_shortids.shortids
             last_index = -1
@@ -853,6 +860,7 @@ class HeaderAndShortIDs:
         else:
             ret = P2PHeaderAndShortIDs()
         ret.header = self.header
+        ret.vchBlockSig = self.vchBlockSig
         ret.nonce = self.nonce
         ret.shortids_length = len(self.shortids)
         ret.shortids = self.shortids
@@ -877,6 +885,7 @@ class HeaderAndShortIDs:
         if prefill_list is None:
             prefill_list = [0]
         self.header = CBlockHeader(block)
+        self.vchBlockSig = getattr(block, "vchBlockSig", b"")
         self.nonce = nonce
         self.prefilled_txn = [PrefilledTransaction(i, block.vtx[i]) for i in prefill_list]
         self.shortids = []
@@ -73,6 +73,7 @@ BASE_SCRIPTS= [
     'mining_pos_coldStaking.py',                # ~ 220 sec
     'wallet_import_rescan.py',                  # ~ 204 sec
     'p2p_invalid_block.py',                     # ~ 213 sec
+    'p2p_compactblocks.py',
     'feature_reindex.py',                       # ~ 205 sec
     'rpc_scantxoutset.py',
     'feature_logging.py',                       # ~ 195 sec
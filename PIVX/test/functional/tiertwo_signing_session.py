@@ -69,6 +69,17 @@ class SigningSessionTest(PivxDMNTestFramework):
 
         self.log.info("Threshold signature successfully generated and propagated!")
 
+        # The members verified each other's sig shares, none of them invalid
+        self.log.info("Checking sig shares verification stats...")
+        verified = 0
+        for i in range(len(self.nodes)):
+            stats = self.nodes[i].quorumsigsharesstats()
+            assert_equal(stats["pending"], 0)
+            assert_equal(stats["bad_sources"], 0)
+            assert stats["max_sessions"] >= 32
+            verified += stats["verified"]
+        assert verified > 0
+
         # Second scenario, let's select a new signing session (i.e. a new id) and this time nodes will not agree on the msgHash
         self.log.info("----------------------------------")
         self.log.info("----- (2) Second signing session started -----")